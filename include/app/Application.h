@@ -1,47 +1,77 @@
 ﻿#pragma once
 
+#include <memory>
 #include <string>
 #include "d3dHead.h"
+#include "core/FixedTimestep.h"
+#include "core/JobSystem.h"
+#include "core/Profiler.h"
+#include "d3d/DescriptorAllocator.h"
 #include "d3d/Timer.h"
+#include "d3d/HeapAllocator.h"
+#include "d3d/UploadBatcher.h"
+#include "render/RenderDevice.h"
 
 namespace RainDX
 {
     class Application
     {
     public:
-        Application(HINSTANCE instance);
+        // 传入 device 时不创建窗口和 DXGI 对象, 直接使用该后端
+        Application(HINSTANCE instance, std::unique_ptr<RenderDevice> device = nullptr);
         Application(const Application& app) = delete;
         Application& operator=(const Application& app) = delete;
         virtual ~Application();
 
         virtual bool Init();
         virtual bool Run();
+        // 不经过消息循环, 连续执行若干帧
+        bool RunFrames(int frameCount);
         virtual LRESULT MsgHandler(HWND wnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
     protected:
         virtual void OnResize();
+        // 模拟更新, 以固定步长调用, 每帧可能调用零次或多次
+        virtual void FixedUpdate(float dt);
+        // 每帧调用一次, 准备渲染数据, 可用 StepAlpha 在模拟状态之间插值
         virtual void Update() = 0;
         virtual void Draw() = 0;
         virtual void OnMouseDown(WPARAM btnState, int x, int y);
         virtual void OnMouseUp(WPARAM btnState, int x, int y);
         virtual void OnMouseMove(WPARAM btnState, int x, int y);
+        // 基类没有处理的按键
+        virtual void OnKeyUp(WPARAM key);
 
 
         bool InitWnd();
         bool InitDirectX();
+        bool InitHeadless();
         void CreateDevice();
         void CreateCmd();
         void CreateSwapChain();
         void CheckMsaa();
         void CreateRtvAndDsv();
         void ClearCmdQueue();
-        void FrameRate() const;
+        void Present();
+        // 按本帧间隔执行若干次 FixedUpdate
+        void Simulate();
+        // 每秒在标题栏显示一次帧率和帧耗时分位数
+        void UpdateTitle();
+        // 开始或结束 CPU 性能捕获, 结束时写出 Chrome trace 文件
+        void ToggleProfileCapture();
+        // 把最近的帧耗时写出为 CSV
+        void DumpFrameTimes();
 
     public:
         HINSTANCE Inst() const;
         HWND Wnd() const;
         const std::wstring& Title() const;
         float AspectRatio() const;
+        bool IsHeadless() const;
+        const FrameStats& FrameTimes() const;
+        const FixedTimestep& Timestep() const;
+        // 上一步模拟之后经过的时间占步长的比例
+        float StepAlpha() const;
         ID3D12Resource* CurBuf() const;
         D3D12_CPU_DESCRIPTOR_HANDLE CurBufView() const;
         D3D12_CPU_DESCRIPTOR_HANDLE DepthView() const;
@@ -58,14 +88,23 @@ namespace RainDX
         Microsoft::WRL::ComPtr<IDXGIFactory4> m_Factory;
         Microsoft::WRL::ComPtr<IDXGISwapChain> m_Swap;
         Microsoft::WRL::ComPtr<ID3D12Device> m_Device;
+        // 任务系统, 主线程等待时也参与执行
+        std::unique_ptr<JobSystem> m_Jobs;
+        // 渲染后端, 资源创建和命令提交都经过它
+        std::unique_ptr<RenderDevice> m_Render;
 
 
         Microsoft::WRL::ComPtr<ID3D12Fence> m_Fence;
-        UINT64 m_CurFence = 0;
 
         Microsoft::WRL::ComPtr<ID3D12CommandQueue> m_CmdQueue;
         Microsoft::WRL::ComPtr<ID3D12CommandAllocator> m_CmdAlloc;
-        Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> m_CmdList;
+        std::unique_ptr<RenderCmdList> m_CmdList;
+        // 默认堆缓冲区的放置分配器, 必须比上传器和使用它的资源活得更久
+        std::unique_ptr<HeapAllocator> m_BufferHeap;
+        // 上传堆的放置分配器, 上传器的暂存环和每帧的上传环都从这里分配
+        std::unique_ptr<HeapAllocator> m_UploadHeap;
+        // 默认堆资源的批量上传
+        std::unique_ptr<UploadBatcher> m_Uploader;
 
 
         // 后台缓冲区数量
@@ -77,20 +116,18 @@ namespace RainDX
         // 深度模板缓冲区
         Microsoft::WRL::ComPtr<ID3D12Resource> m_DepthBuf;
 
-        // 渲染目标描述符堆
-        Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_RtvHeap;
-        // 深度模板描述符堆
-        Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_DsvHeap;
-        // 常量描述符堆
-        Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_CbvHeap = nullptr;
+        // CPU 描述符堆, 视图都在这里创建
+        std::unique_ptr<DescriptorStagingHeap> m_RtvHeap;
+        std::unique_ptr<DescriptorStagingHeap> m_DsvHeap;
+        std::unique_ptr<DescriptorStagingHeap> m_CbvSrvUavHeap;
+        // 着色器可见的描述符环, 每帧用到的描述符表从暂存堆复制过来
+        std::unique_ptr<DescriptorRing> m_Descriptors;
+        D3D12_CPU_DESCRIPTOR_HANDLE m_SwapBufView[m_SwapBufCount] = {};
+        D3D12_CPU_DESCRIPTOR_HANDLE m_DepthBufView = {};
 
         D3D12_VIEWPORT m_ScreenView;
         D3D12_RECT m_ScissorRect;
 
-        UINT m_RtvSize = 0;
-        UINT m_DsvSize = 0;
-        UINT m_CbvSrvUavSize = 0;
-
         D3D_DRIVER_TYPE m_d3d_driver_t = D3D_DRIVER_TYPE_HARDWARE;
         // 后台缓冲区格式
         DXGI_FORMAT m_BufType = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -102,12 +139,21 @@ namespace RainDX
         UINT m_4xMsaaQuality = 0;
         // 计时器
         Timer m_Timer;
+        // 标题栏统计的帧数和起始时间
+        int m_TitleFrames = 0;
+        float m_TitleTime = 0.0f;
+        // 模拟的固定步长, 默认 60Hz, 每帧最多追赶 5 步
+        FixedTimestep m_Timestep;
+        std::string m_ProfilePath = "profile.json";
+        std::string m_FrameTimePath = "frametimes.csv";
 
         bool m_IsPaused = false;
         bool m_IsMin = false;
         bool m_IsMax = false;
         bool m_IsResizing = false; // are the resize bars being dragged?
         bool m_IsFullScreen = false;
+        // 无窗口, 无原生设备
+        bool m_Headless = false;
 
     private:
         static std::wstring m_WndTitle;
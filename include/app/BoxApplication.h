@@ -6,8 +6,20 @@
 
 #include "Application.h"
 #include "d3d/d3dUtil.h"
+#include "d3d/FrameResource.h"
+#include "d3d/PipelineCache.h"
+#include "d3d/RootSignatureRegistry.h"
+#include "d3d/UploadRing.h"
 #include "d3d/MathHelper.h"
-#include "d3d/UploadBuffer.h"
+#include "mesh/MeshletBuilder.h"
+#include "mesh/MeshOptimizer.h"
+#include "mesh/MeshSimplifier.h"
+#include "mesh/VertexFormat.h"
+#include "scene/Bvh.h"
+#include "scene/FrustumCuller.h"
+#include "scene/OcclusionCuller.h"
+#include "shader/ShaderCache.h"
+#include "shader/ShaderPermutations.h"
 
 namespace RainDX
 {
@@ -18,51 +30,122 @@ namespace RainDX
         DirectX::XMFLOAT4 Color;
     };
 
-    // 物体常量
-    struct ObjConst
+    // 每帧常量
+    struct PassConst
     {
-        DirectX::XMFLOAT4X4 WorldViewProj = MathHelper::Identity4x4();
+        DirectX::XMFLOAT4X4 ViewProj = MathHelper::Identity4x4();
         DirectX::XMFLOAT4 PulseColor = DirectX::XMFLOAT4(DirectX::Colors::Navy);
+        // 量化位置的还原参数, 与 color.hlsl 的打包方式一致
+        DirectX::XMFLOAT3 PosScale = DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f);
         float Time;
+        DirectX::XMFLOAT3 PosBias = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+    };
+
+    // 每个实例的数据, 与 color.hlsl 中的 InstanceData 布局一致
+    struct InstanceData
+    {
+        // 已转置, 可直接被着色器读取
+        DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
+        DirectX::XMFLOAT4 Color = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
     };
 
     class BoxApplication : public Application
     {
     public:
-        BoxApplication(HINSTANCE inst);
+        BoxApplication(HINSTANCE inst, std::unique_ptr<RenderDevice> device = nullptr);
         ~BoxApplication() override;
 
         bool Init() override;
+        // 盒子的数量, 在 Init 之前设置
+        void SetDrawCount(int drawCount);
+        // 实例化时每次绘制最多 InstancesPerDraw 个盒子, 否则每个盒子一次绘制, 物体数据放在根常量中
+        // 根签名和着色器随之不同, 在 Init 之前设置
+        void SetInstancing(bool instancing);
+        // 视锥裁剪之后再用最近的盒子做软件遮挡剔除
+        void SetOcclusion(bool occlusion);
+        // 按屏幕误差为每个盒子选择 LOD, 关闭时总是绘制原网格
+        void SetLod(bool lod);
+        // 默认量化位置和颜色, 关闭时使用 32 位浮点, 在 Init 之前设置
+        void SetCompactVertices(bool compact);
+        UINT VertexStride() const;
+        // 盒子网格上传之前的优化结果
+        const MeshOptimizeReport& MeshReport() const;
+        // 盒子网格的 LOD 级数, 包括原网格
+        std::size_t LodCount() const;
 
     protected:
         void OnResize() override;
+        void FixedUpdate(float dt) override;
         void Update() override;
         void Draw() override;
         void OnMouseDown(WPARAM btnState, int x, int y) override;
         void OnMouseMove(WPARAM btnState, int x, int y) override;
         void OnMouseUp(WPARAM btnState, int x, int y) override;
+        // F5 切换线框模式
+        void OnKeyUp(WPARAM key) override;
 
         void CreateCbv();
         void CreateRootSign();
         void BuildShadersAndInputLayout();
         void BuildBoxGeometry();
+        // 在后台创建实体和线框两种 PSO, Init 结束前等待实体 PSO 完成
         void BuildPso();
+        // 线框 PSO 未完成时返回实体 PSO, 无 GPU 的后端返回 nullptr
+        ID3D12PipelineState* CurrentPso() const;
+        // 盒子排成立方体网格, 整体占据单个盒子的范围, 同时记录每个盒子的世界包围盒
+        void BuildInstances();
+        // 工作线程录制的命令列表不继承状态, 每个列表都要重新设置
+        void SetDrawState(RenderCmdList& list) const;
+        // 从屏幕坐标发出射线, 高亮最近的盒子
+        void Pick(int x, int y);
+        // 离相机最近的若干可见盒子作为遮挡物, 从 m_Visible 中去掉被它们挡住的盒子
+        void CullOccluded(const DirectX::XMFLOAT4X4& viewProj, const DirectX::XMFLOAT3& eye);
+        // 为每个可见盒子选择 LOD, 把 m_Visible 按 LOD 分组, 组内保持原顺序
+        void SortByLod(const DirectX::XMFLOAT3& eye);
 
     private:
-        // 根签名
+        std::unique_ptr<RootSignatureRegistry> m_RootSignatures;
+        // 根签名, 由 m_RootSignatures 创建, 实例化和单独绘制使用不同的布局
         Microsoft::WRL::ComPtr<ID3D12RootSignature> m_RootSign = nullptr;
-        // 常量上传缓冲区
-        std::unique_ptr<UploadBuffer<ObjConst>> m_ConstBuf = nullptr;
+        // 根签名布局的哈希, 参与 PSO 的键
+        std::uint64_t m_RootSignHash = 0;
+        // 帧资源环, 每帧独占命令分配器
+        std::unique_ptr<FrameRing<FrameResource>> m_FrameRing = nullptr;
+        // 每帧常量数据的上传环
+        std::unique_ptr<UploadRing> m_UploadRing = nullptr;
+        // 每个帧资源的常量缓冲区视图, 在暂存堆中
+        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_PassCbv;
+        // 当前帧复制到描述符环中的常量描述符表
+        DescriptorTable m_PassTable;
 
         std::unique_ptr<MeshGeometry> m_BoxGeo = nullptr;
-        // 编译的顶点着色器字节码
-        Microsoft::WRL::ComPtr<ID3DBlob> m_VertexShader = nullptr;
-        // 编译的像素着色器字节码
-        Microsoft::WRL::ComPtr<ID3DBlob> m_PixelShader = nullptr;
+        MeshOptimizeReport m_MeshReport;
+        // 顶点缓冲区的格式, Vertex 只用于生成数据
+        VertexFormat m_VertexFormat = VertexFormat::CompactPositionColor();
+        PositionDequant m_PosDequant;
+        // 优化后顺序的浮点位置, 供遮挡剔除光栅化
+        std::vector<DirectX::XMFLOAT3> m_BoxPositions;
+        // 盒子网格的 LOD 链, 第 0 级为原网格
+        std::vector<MeshLod> m_BoxLods;
+        std::vector<SubmeshGeometry> m_BoxLodSubmeshes;
+        // 顶点和索引缓冲区在堆中的位置
+        HeapAllocation m_VertexAlloc;
+        HeapAllocation m_IndexAlloc;
+        // 着色器字节码的磁盘缓存
+        ShaderCache m_ShaderCache{L"shaders\\cache", d3dUtil::CompilerVersion()};
+        // 清单中全部着色器排列的字节码
+        ShaderArchive m_Shaders;
+        // 按顶点格式选出的排列, 指向 m_Shaders 中的数据
+        D3D12_SHADER_BYTECODE m_VertexShader = {};
+        D3D12_SHADER_BYTECODE m_PixelShader = {};
         // 输入布局
         std::vector<D3D12_INPUT_ELEMENT_DESC> m_InputLayout;
 
-        Microsoft::WRL::ComPtr<ID3D12PipelineState> m_Pso = nullptr;
+        // PSO 缓存, 管线库保存在着色器缓存目录中
+        std::unique_ptr<PipelineCache> m_Pipelines;
+        std::uint64_t m_SolidPso = 0;
+        std::uint64_t m_WireframePso = 0;
+        bool m_Wireframe = false;
 
         DirectX::XMFLOAT4X4 m_World = MathHelper::Identity4x4();
         DirectX::XMFLOAT4X4 m_View = MathHelper::Identity4x4();
@@ -72,6 +155,41 @@ namespace RainDX
         float m_Phi = DirectX::XM_PIDIV4;
         float m_Radius = 5.0f;
 
+        // 模拟时间, 只在 FixedUpdate 中推进, 渲染时在前后两步之间插值
+        float m_SimTime = 0.0f;
+        float m_PrevSimTime = 0.0f;
+
+        int m_DrawCount = 1;
+        bool m_Instancing = true;
+        std::vector<InstanceData> m_Instances;
+        // 实例的世界包围盒, 编号与 m_Instances 一致
+        std::vector<DirectX::BoundingBox> m_Bounds;
+        FrustumCuller m_Culler;
+        bool m_Occlusion = true;
+        OcclusionCuller m_Occluder;
+        // 每个可见实例是否通过遮挡测试
+        std::vector<std::uint8_t> m_Unoccluded;
+        // 当前帧可见的实例编号
+        std::vector<std::uint32_t> m_Visible;
+        bool m_Lod = true;
+        // 实例相对网格的缩放, LOD 的误差按它换算到世界空间
+        float m_InstanceScale = 1.0f;
+        // 每个可见实例选中的 LOD 和分组用的临时数组
+        std::vector<std::uint8_t> m_VisibleLod;
+        std::vector<std::uint32_t> m_LodSorted;
+        // m_Visible 中第 i 级 LOD 的区间为 [m_LodFirst[i], m_LodFirst[i + 1])
+        std::vector<std::size_t> m_LodFirst;
+        // 实例世界包围盒的层次结构, 用于拾取
+        Bvh m_Bvh;
+        // 被选中的实例及其原来的颜色
+        int m_Picked = -1;
+        DirectX::XMFLOAT4 m_PickedColor;
+        // 当前帧实例缓冲区在上传环中的地址
+        D3D12_GPU_VIRTUAL_ADDRESS m_InstanceGpu = 0;
+
         POINT m_LastMousePos;
+        // 按下时的位置和按键, 松开时没有移动则视为点击
+        POINT m_MouseDownPos;
+        WPARAM m_MouseDownState = 0;
     };
 }
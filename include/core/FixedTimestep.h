@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+
+namespace RainDX
+{
+    // 固定步长累加器
+    // 帧间隔累加后按固定步长切分, 模拟开销与帧率无关; 每帧步数有上限, 慢帧不会越积越多
+    class FixedTimestep
+    {
+    public:
+        explicit FixedTimestep(double step = 1.0 / 60.0, int maxSteps = 5);
+
+        // 累加一帧的间隔, 返回本帧需要执行的步数
+        // 超过上限的部分直接丢弃, 模拟时间会落后于真实时间
+        int Advance(double deltaSeconds);
+        void Reset();
+
+        double Step() const;
+        // 剩余时间超过新步长的整步部分计入 DroppedTime
+        void SetStep(double step);
+        int MaxSteps() const;
+        void SetMaxSteps(int maxSteps);
+
+        // 未满一步的剩余时间占步长的比例, 取值 [0, 1), 用于在上一步和当前步的状态之间插值
+        double Alpha() const;
+        // 累计执行的步数
+        std::uint64_t StepCount() const;
+        // 因步数上限丢弃的时间, 单位为秒
+        double DroppedTime() const;
+
+    private:
+        double m_Step = 0.0;
+        int m_MaxSteps = 0;
+        double m_Accumulator = 0.0;
+        std::uint64_t m_StepCount = 0;
+        double m_Dropped = 0.0;
+    };
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace RainDX
+{
+    // 一次卡顿: 帧耗时明显超过最近的中位数
+    struct FrameHitch
+    {
+        std::uint64_t Frame = 0;
+        double Ms = 0.0;
+        double MedianMs = 0.0;
+    };
+
+    // 滑动窗口内的帧耗时统计
+    struct FrameSummary
+    {
+        std::size_t Frames = 0;
+        double AverageMs = 0.0;
+        double MinMs = 0.0;
+        double MaxMs = 0.0;
+        double P50Ms = 0.0;
+        double P95Ms = 0.0;
+        double P99Ms = 0.0;
+        // 最慢的 1% 帧的平均耗时, 以及对应的帧率
+        double OnePercentLowMs = 0.0;
+        double OnePercentLowFps = 0.0;
+        // 自 Clear 以来的卡顿总数
+        std::uint64_t Hitches = 0;
+    };
+
+    // 帧耗时统计
+    // 最近 window 帧同时保存在环形缓冲区和固定精度的直方图中, 分位数查询与帧数无关
+    class FrameStats
+    {
+    public:
+        // 直方图精度和上限, 超过上限的帧单独处理
+        static constexpr double BinMs = 0.05;
+        static constexpr std::size_t BinCount = 4000;
+
+        // 超过中位数 hitchFactor 倍且至少慢 hitchMinMs 的帧记为卡顿
+        explicit FrameStats(std::size_t window = 1024, double hitchFactor = 2.0, double hitchMinMs = 4.0);
+
+        void AddFrame(double ms);
+        void Clear();
+
+        // p 取 [0, 1], 窗口为空时返回 0
+        double Percentile(double p) const;
+        FrameSummary Summarize() const;
+
+        // 最近的卡顿, 最多保留 MaxHitches 条
+        const std::deque<FrameHitch>& Hitches() const;
+        std::uint64_t FrameCount() const;
+        std::size_t WindowSize() const;
+
+        // 每行一帧: frame,ms,hitch
+        bool WriteCsv(const std::string& path) const;
+
+        static constexpr std::size_t MaxHitches = 256;
+
+    private:
+        std::size_t Bin(double ms) const;
+        // 卡顿判断用的中位数, 从上一帧的位置增量移动, 不扫描整个直方图
+        double RunningMedian();
+
+        std::size_t m_Window = 0;
+        double m_HitchFactor = 0.0;
+        double m_HitchMinMs = 0.0;
+
+        // 环形缓冲区, 按帧序号取模
+        std::vector<double> m_Samples;
+        std::vector<std::uint32_t> m_Histogram;
+        // 超出直方图范围的帧数
+        std::uint32_t m_Overflow = 0;
+        double m_Sum = 0.0;
+        // 中位数所在的桶, BinCount 表示超出范围, 以及更低的桶中的帧数
+        std::size_t m_MedianBin = 0;
+        std::size_t m_BelowMedian = 0;
+
+        std::uint64_t m_FrameCount = 0;
+        std::uint64_t m_HitchCount = 0;
+        std::deque<FrameHitch> m_Hitches;
+    };
+}
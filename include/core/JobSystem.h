@@ -0,0 +1,157 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace RainDX
+{
+    // 任务计数器, 提交时加一, 任务完成时减一
+    // 任务内部用同一个计数器提交的子任务会延长等待, 形成父子关系
+    class JobCounter
+    {
+    public:
+        void Add(int count = 1) { m_Count.fetch_add(count, std::memory_order_relaxed); }
+        void Done() { m_Count.fetch_sub(1, std::memory_order_release); }
+        bool IsDone() const { return m_Count.load(std::memory_order_acquire) == 0; }
+        int Value() const { return m_Count.load(std::memory_order_acquire); }
+
+        // 只保留第一个异常, 必须在 Done 之前调用
+        void Fail(std::exception_ptr error)
+        {
+            bool expected = false;
+            if (m_Failed.compare_exchange_strong(expected, true, std::memory_order_relaxed))
+                m_Error = std::move(error);
+        }
+        std::exception_ptr Error() const { return m_Error; }
+
+    private:
+        std::atomic<int> m_Count{0};
+        std::atomic<bool> m_Failed{false};
+        std::exception_ptr m_Error;
+    };
+
+    struct Job
+    {
+        std::function<void()> Func;
+        JobCounter* Counter = nullptr;
+        // 槽位正在使用中
+        std::atomic<bool> Busy{false};
+    };
+
+    // Chase-Lev 工作窃取双端队列, 容量固定
+    // 所有者在底部压入和弹出, 其他线程从顶部窃取
+    class JobDeque
+    {
+    public:
+        static constexpr std::int64_t Capacity = 4096;
+
+        // 队列已满时返回 false
+        bool Push(Job* job);
+        // 仅所有者线程调用
+        Job* Pop();
+        // 任意线程调用, 竞争失败时返回 nullptr
+        Job* Steal();
+
+    private:
+        alignas(64) std::atomic<std::int64_t> m_Top{0};
+        alignas(64) std::atomic<std::int64_t> m_Bottom{0};
+        std::atomic<Job*> m_Jobs[Capacity] = {};
+    };
+
+    // 工作窃取任务系统
+    // 每个线程一个双端队列, 空闲线程随机窃取其他队列的任务, 主线程等待时也执行任务
+    class JobSystem
+    {
+    public:
+        // workerCount 为负时使用硬件线程数减一, 主线程占一个
+        // 创建者所在的线程成为 0 号线程
+        explicit JobSystem(int workerCount = -1);
+        JobSystem(const JobSystem& rhs) = delete;
+        JobSystem& operator=(const JobSystem& rhs) = delete;
+        ~JobSystem();
+
+        // 只能从主线程或任务内部调用, 队列满时直接在当前线程执行
+        void Run(std::function<void()> func, JobCounter* counter = nullptr);
+        // 等待期间当前线程继续执行其他任务
+        // 计数器上的任务抛出异常时在这里重新抛出, 没有计数器的任务的异常由下一次 Wait 抛出
+        void Wait(const JobCounter& counter);
+
+        // 把 [begin, end) 切成不大于 grain 的区间并行执行 func(first, last)
+        template <typename F>
+        void ParallelFor(std::size_t begin, std::size_t end, std::size_t grain, const F& func)
+        {
+            if (begin >= end)
+                return;
+            if (grain == 0)
+                grain = 1;
+
+            JobCounter counter;
+            try
+            {
+                Split(begin, end, grain, func, counter);
+            }
+            catch (...)
+            {
+                // 已经提交的区间仍然引用 counter, 必须等它们结束
+                counter.Fail(std::current_exception());
+            }
+            Wait(counter);
+        }
+
+        // 包括主线程在内的线程数
+        unsigned ThreadCount() const;
+        // 当前线程的编号, 主线程为 0, 不属于本系统的线程为 -1
+        int ThreadIndex() const;
+
+    private:
+        template <typename F>
+        void Split(std::size_t begin, std::size_t end, std::size_t grain, const F& func, JobCounter& counter)
+        {
+            // 后半段交给其他线程窃取, 前半段继续在当前线程切分
+            while (end - begin > grain)
+            {
+                std::size_t mid = begin + (end - begin) / 2;
+                Run([this, mid, end, grain, &func, &counter] { Split(mid, end, grain, func, counter); }, &counter);
+                end = mid;
+            }
+            func(begin, end);
+        }
+
+        struct Worker
+        {
+            JobDeque Queue;
+            // 环形复用的任务槽
+            std::unique_ptr<Job[]> Pool;
+            std::size_t NextJob = 0;
+            std::uint32_t Random = 0;
+        };
+
+        Job* AllocateJob(Worker& worker);
+        void Execute(Job* job);
+        // 执行一个本地或窃取到的任务, 没有任务时返回 false
+        bool TryRunOne(int index);
+        Job* StealFrom(int thief);
+        void WorkerLoop(int index);
+
+        std::vector<std::unique_ptr<Worker>> m_Workers;
+        std::vector<std::thread> m_Threads;
+        std::atomic<bool> m_Running{true};
+
+        // 队列中尚未被取走的任务数, 为 0 时工作线程休眠
+        std::atomic<int> m_Queued{0};
+        std::atomic<int> m_Sleeping{0};
+        std::mutex m_SleepMutex;
+        std::condition_variable m_WakeUp;
+
+        // 没有计数器的任务抛出的第一个异常
+        std::mutex m_ErrorMutex;
+        std::exception_ptr m_Error;
+    };
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace RainDX
+{
+    // 线性分配器, 只能整体重置
+    // 当前块用完时追加新块, 已分配的指针保持有效
+    // Reset 时把多个块合并为一块, 稳定运行后不再申请内存
+    class LinearArena
+    {
+    public:
+        static constexpr std::size_t DefaultChunkBytes = 1024 * 1024;
+
+        explicit LinearArena(std::size_t chunkBytes = DefaultChunkBytes);
+        LinearArena(const LinearArena& rhs) = delete;
+        LinearArena& operator=(const LinearArena& rhs) = delete;
+
+        // alignment 必须是 2 的幂, 返回的内存未初始化
+        void* Allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t));
+
+        // 只用于不需要析构的类型
+        template <typename T>
+        T* Allocate(std::size_t count)
+        {
+            static_assert(std::is_trivially_destructible<T>::value, "arena does not run destructors");
+            return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+        }
+
+        // 之前分配的内存全部失效
+        void Reset();
+
+        // 已分配的字节数, 包括对齐
+        std::size_t Used() const;
+        std::size_t Capacity() const;
+        std::size_t ChunkCount() const;
+
+    private:
+        struct Chunk
+        {
+            std::unique_ptr<char[]> Memory;
+            std::size_t Size = 0;
+        };
+
+        void AddChunk(std::size_t bytes);
+
+        std::vector<Chunk> m_Chunks;
+        std::size_t m_ChunkBytes = 0;
+        // 最后一块中的偏移
+        std::size_t m_Offset = 0;
+        std::size_t m_Used = 0;
+    };
+}
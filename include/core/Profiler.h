@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// 为 0 时所有性能分析宏展开为空, 不产生任何开销
+#ifndef RAINDX_PROFILE
+#define RAINDX_PROFILE 1
+#endif
+
+namespace RainDX
+{
+    // 一段计时区间, 时间单位为纳秒
+    struct ProfileEvent
+    {
+        const char* Name = nullptr;
+        std::int64_t Begin = 0;
+        std::int64_t End = 0;
+        // 嵌套深度, 帧标记为 FrameDepth
+        std::uint32_t Depth = 0;
+
+        static constexpr std::uint32_t FrameDepth = 0xffffffffu;
+    };
+
+    // CPU 性能分析器
+    // 每个线程写自己的事件缓冲区, 写入不加锁; 只在捕获期间记录
+    class Profiler
+    {
+    public:
+        // 每个线程最多保留的事件数, 超过后覆盖最早的事件
+        static constexpr std::uint32_t EventsPerThread = 1 << 16;
+
+        // 开始新的捕获, 丢弃之前记录的事件
+        static void BeginCapture();
+        static void EndCapture();
+        static bool IsCapturing()
+        {
+            return s_Capturing.load(std::memory_order_relaxed);
+        }
+
+        // 导出为 Chrome trace 格式, 可在 chrome://tracing 或 Perfetto 中查看
+        // 应在 EndCapture 之后调用
+        static bool WriteChromeTrace(const std::string& path);
+
+        static void SetThreadName(const char* name);
+        // 在当前线程记录帧分界
+        static void FrameMark();
+
+        static std::int64_t Now();
+        // 进入区间, 返回嵌套深度
+        static std::uint32_t EnterZone();
+        static void LeaveZone(const char* name, std::int64_t begin, std::uint32_t depth);
+
+    private:
+        static std::atomic<bool> s_Capturing;
+    };
+
+    // 作用域计时, 构造时开始, 析构时记录
+    class ProfileScope
+    {
+    public:
+        explicit ProfileScope(const char* name)
+        {
+            if (Profiler::IsCapturing())
+            {
+                m_Name = name;
+                m_Depth = Profiler::EnterZone();
+                m_Begin = Profiler::Now();
+            }
+        }
+
+        ProfileScope(const ProfileScope& rhs) = delete;
+        ProfileScope& operator=(const ProfileScope& rhs) = delete;
+
+        ~ProfileScope()
+        {
+            if (m_Name != nullptr)
+                Profiler::LeaveZone(m_Name, m_Begin, m_Depth);
+        }
+
+    private:
+        const char* m_Name = nullptr;
+        std::int64_t m_Begin = 0;
+        std::uint32_t m_Depth = 0;
+    };
+}
+
+#define RAINDX_PROFILE_CONCAT_IMPL(a, b) a##b
+#define RAINDX_PROFILE_CONCAT(a, b) RAINDX_PROFILE_CONCAT_IMPL(a, b)
+
+#if RAINDX_PROFILE
+// name 必须是在整个捕获期间有效的字符串, 一般为字面量
+#define RAINDX_PROFILE_SCOPE(name) ::RainDX::ProfileScope RAINDX_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define RAINDX_PROFILE_FUNCTION() RAINDX_PROFILE_SCOPE(__FUNCTION__)
+#define RAINDX_PROFILE_FRAME() ::RainDX::Profiler::FrameMark()
+#define RAINDX_PROFILE_THREAD(name) ::RainDX::Profiler::SetThreadName(name)
+#else
+#define RAINDX_PROFILE_SCOPE(name) ((void)0)
+#define RAINDX_PROFILE_FUNCTION() ((void)0)
+#define RAINDX_PROFILE_FRAME() ((void)0)
+#define RAINDX_PROFILE_THREAD(name) ((void)0)
+#endif
@@ -0,0 +1,106 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace RainDX
+{
+    // 分配结果, Block 是分配器内部块的索引, 释放时使用
+    struct TlsfAllocation
+    {
+        static constexpr std::uint32_t InvalidBlock = 0xffffffffu;
+
+        std::uint64_t Offset = 0;
+        std::uint64_t Size = 0;
+        std::uint32_t Block = InvalidBlock;
+
+        bool IsValid() const { return Block != InvalidBlock; }
+    };
+
+    // 分配器的占用和碎片统计
+    struct TlsfStats
+    {
+        std::uint64_t Capacity = 0;
+        std::uint64_t UsedBytes = 0;
+        std::uint64_t FreeBytes = 0;
+        std::uint64_t LargestFreeBlock = 0;
+        std::uint32_t Allocations = 0;
+        std::uint32_t FreeBlocks = 0;
+
+        // 0 表示空闲空间连续, 越接近 1 碎片越多
+        double Fragmentation() const
+        {
+            if (FreeBytes == 0)
+                return 0.0;
+            return 1.0 - static_cast<double>(LargestFreeBlock) / static_cast<double>(FreeBytes);
+        }
+    };
+
+    // 两级分离适配 (TLSF) 的区间分配器
+    // 只管理 [0, capacity) 的偏移, 不接触实际内存, 分配和释放都是 O(1)
+    // 块的元数据保存在数组中并复用, 稳定运行时不再申请内存
+    class TlsfAllocator
+    {
+    public:
+        // granularity 是最小分配单位, 必须是 2 的幂
+        explicit TlsfAllocator(std::uint64_t capacity, std::uint64_t granularity = 256);
+
+        // alignment 必须是 2 的幂, 失败时返回无效的分配
+        TlsfAllocation Allocate(std::uint64_t size, std::uint64_t alignment = 1);
+        void Free(const TlsfAllocation& allocation);
+        // 释放所有分配
+        void Reset();
+
+        std::uint64_t Capacity() const;
+        std::uint64_t Granularity() const;
+        std::uint64_t UsedBytes() const;
+        std::uint32_t AllocationCount() const;
+        bool Empty() const;
+        // 遍历所有块, 开销与块数成正比
+        TlsfStats Stats() const;
+
+    private:
+        // 一级按 2 的幂划分, 二级在每个区间内线性划分为 2^SlBits 份
+        static constexpr std::uint32_t SlBits = 4;
+        static constexpr std::uint32_t SlCount = 1u << SlBits;
+        static constexpr std::uint32_t FlCount = 64 - SlBits + 1;
+        static constexpr std::uint32_t Null = TlsfAllocation::InvalidBlock;
+
+        struct Block
+        {
+            std::uint64_t Offset = 0;
+            std::uint64_t Size = 0;
+            // 物理相邻的块
+            std::uint32_t PrevPhys = Null;
+            std::uint32_t NextPhys = Null;
+            // 同一空闲链表中的块
+            std::uint32_t PrevFree = Null;
+            std::uint32_t NextFree = Null;
+            bool Free = false;
+        };
+
+        void Mapping(std::uint64_t units, std::uint32_t& fl, std::uint32_t& sl) const;
+        bool FindFree(std::uint64_t units, std::uint32_t& fl, std::uint32_t& sl) const;
+        void InsertFree(std::uint32_t index);
+        void RemoveFree(std::uint32_t index);
+        // 从 index 的头部切出 size 字节, 剩余部分成为新的空闲块
+        std::uint32_t Split(std::uint32_t index, std::uint64_t size);
+        // 与后面的物理相邻块合并, 被合并的块回收
+        void MergeNext(std::uint32_t index);
+        std::uint32_t NewBlock();
+        void DeleteBlock(std::uint32_t index);
+
+        std::uint64_t m_Capacity = 0;
+        std::uint64_t m_Granularity = 0;
+        std::uint32_t m_GranularityShift = 0;
+        std::uint64_t m_UsedBytes = 0;
+        std::uint32_t m_Allocations = 0;
+
+        std::uint64_t m_FlBitmap = 0;
+        std::uint32_t m_SlBitmap[FlCount] = {};
+        std::uint32_t m_FreeHeads[FlCount][SlCount];
+
+        std::vector<Block> m_Blocks;
+        // 可复用的块元数据
+        std::vector<std::uint32_t> m_UnusedBlocks;
+    };
+}
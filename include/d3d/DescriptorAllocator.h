@@ -0,0 +1,115 @@
+#pragma once
+#include <deque>
+#include <vector>
+#include "d3dHead.h"
+#include "render/RenderDevice.h"
+
+namespace RainDX
+{
+    // CPU 描述符堆, 着色器不可见
+    // 描述符按页分配, 空闲的描述符组成空闲链表, 用完时追加新页, 已分配的句柄不会移动
+    // 命令列表和 CopyDescriptors 在录制或调用时就读取了 CPU 描述符, 因此 Free 后可以立即重用
+    // 只能从主线程调用
+    class DescriptorStagingHeap
+    {
+    public:
+        DescriptorStagingHeap(RenderDevice* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT pageSize = 256);
+        DescriptorStagingHeap(const DescriptorStagingHeap& rhs) = delete;
+        DescriptorStagingHeap& operator=(const DescriptorStagingHeap& rhs) = delete;
+
+        D3D12_CPU_DESCRIPTOR_HANDLE Allocate();
+        void Free(D3D12_CPU_DESCRIPTOR_HANDLE handle);
+
+        D3D12_DESCRIPTOR_HEAP_TYPE Type() const;
+        UINT PageCount() const;
+        // 所有页的描述符总数
+        UINT Capacity() const;
+        // 已分配的描述符数
+        UINT Allocated() const;
+
+    private:
+        void AddPage();
+
+        RenderDevice* m_Device = nullptr;
+        D3D12_DESCRIPTOR_HEAP_TYPE m_Type;
+        UINT m_PageSize = 0;
+        UINT m_DescriptorSize = 0;
+        std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> m_Pages;
+        // 每页的起始句柄, 释放时据此找到所在的页
+        std::vector<SIZE_T> m_PageStarts;
+        // 空闲描述符的全局编号, 页号乘页大小加页内编号, 从末尾取出
+        std::vector<UINT> m_FreeList;
+        // 按全局编号记录是否已分配, 用于发现重复释放
+        std::vector<bool> m_Allocated;
+    };
+
+    // 着色器可见堆中的一段连续描述符, 作为描述符表绑定
+    struct DescriptorTable
+    {
+        D3D12_CPU_DESCRIPTOR_HANDLE Cpu = {0};
+        D3D12_GPU_DESCRIPTOR_HANDLE Gpu = {0};
+        UINT Count = 0;
+    };
+
+    // 着色器可见的描述符环
+    // 每帧从环中分配描述符表, 帧的围栏完成后回收该帧分配的所有描述符, 与 UploadRing 相同
+    // 描述符先在 DescriptorStagingHeap 中创建, Stage 只记录复制, Flush 把本帧的复制合并为一次 CopyDescriptors
+    class DescriptorRing
+    {
+    public:
+        // type 只能是 CBV_SRV_UAV 或 SAMPLER
+        DescriptorRing(RenderDevice* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT count);
+        DescriptorRing(const DescriptorRing& rhs) = delete;
+        DescriptorRing& operator=(const DescriptorRing& rhs) = delete;
+
+        // 分配 count 个连续的描述符, 不回绕, 环已满时等待最早的帧完成
+        // 等待所有帧完成后仍放不下时 (表或当前帧超过容量) 抛出 DxException
+        DescriptorTable Allocate(UINT count);
+        // 分配一张表, 依次复制 src 中的 CPU 描述符, 复制推迟到 Flush, 在此之前源描述符不能改写或释放
+        DescriptorTable Stage(const D3D12_CPU_DESCRIPTOR_HANDLE* src, UINT count);
+        // 执行所有暂存的复制, 必须在提交引用这些表的命令列表之前调用
+        void Flush();
+
+        // 当前帧分配完毕, 记录提交该帧时的围栏值
+        void FinishFrame(std::uint64_t fence);
+        // 回收围栏值不大于 completedFence 的帧
+        void Retire(std::uint64_t completedFence);
+
+        ID3D12DescriptorHeap* Heap() const;
+        UINT Capacity() const;
+        // 尚未回收的描述符数
+        UINT Used() const;
+        // 暂存中尚未复制的描述符数
+        UINT Pending() const;
+
+    private:
+        // 在必要时回绕后的写位置
+        UINT64 WrappedHead(UINT count) const;
+
+        struct FrameMark
+        {
+            std::uint64_t Fence;
+            // 该帧结束时的写位置
+            UINT64 Head;
+        };
+
+        RenderDevice* m_Device = nullptr;
+        FrameFence* m_Fence = nullptr;
+        D3D12_DESCRIPTOR_HEAP_TYPE m_Type;
+        Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_Heap;
+        D3D12_CPU_DESCRIPTOR_HANDLE m_CpuBase = {0};
+        D3D12_GPU_DESCRIPTOR_HANDLE m_GpuBase = {0};
+        UINT m_DescriptorSize = 0;
+        UINT m_Capacity = 0;
+
+        // 单调递增的写位置和回收位置, 取模得到下标
+        UINT64 m_Head = 0;
+        UINT64 m_Tail = 0;
+        std::deque<FrameMark> m_Frames;
+
+        // 等待 Flush 的复制, 目标是每张表一个范围, 源是每个描述符一个范围
+        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_DstStarts;
+        std::vector<UINT> m_DstSizes;
+        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_SrcStarts;
+    };
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <memory>
+#include "d3dHead.h"
+#include "FrameRing.h"
+#include "render/CmdListPool.h"
+#include "render/RenderDevice.h"
+
+namespace RainDX
+{
+    // 基于 ID3D12Fence 的围栏
+    class D3D12FrameFence : public FrameFence
+    {
+    public:
+        D3D12FrameFence(ID3D12CommandQueue* queue, ID3D12Fence* fence);
+        ~D3D12FrameFence() override;
+
+        std::uint64_t Signal() override;
+        std::uint64_t CompletedValue() const override;
+        void Wait(std::uint64_t value) override;
+
+    private:
+        ID3D12CommandQueue* m_Queue = nullptr;
+        ID3D12Fence* m_Fence = nullptr;
+        // 最近一次提交的围栏值
+        UINT64 m_Value = 0;
+        // 复用的等待事件
+        HANDLE m_Event = nullptr;
+    };
+
+    // 每帧独占的资源: 命令列表池和围栏值
+    // 每帧的常量数据从 UploadRing 分配, 随围栏一起回收
+    struct FrameResource
+    {
+        explicit FrameResource(RenderDevice* device) : Lists(device)
+        {
+        }
+
+        FrameResource(const FrameResource& rhs) = delete;
+        FrameResource& operator=(const FrameResource& rhs) = delete;
+
+        // GPU 执行完该帧命令前不能重置
+        CmdListPool Lists;
+        // 该帧提交时的围栏值, 0 表示从未提交
+        std::uint64_t Fence = 0;
+    };
+}
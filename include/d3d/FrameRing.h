@@ -0,0 +1,102 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace RainDX
+{
+    // 围栏抽象: GPU 时间线上单调递增的计数
+    // 帧环只依赖该接口, 因此可以用按计划完成的假围栏测试
+    class FrameFence
+    {
+    public:
+        virtual ~FrameFence() = default;
+
+        // 在队列末尾插入新的围栏点, 返回该围栏值
+        virtual std::uint64_t Signal() = 0;
+        // GPU 已经完成的围栏值
+        virtual std::uint64_t CompletedValue() const = 0;
+        // 阻塞直到 GPU 完成该围栏值
+        virtual void Wait(std::uint64_t value) = 0;
+
+        // 等待 GPU 空闲
+        void Flush()
+        {
+            Wait(Signal());
+        }
+    };
+
+    // N 帧循环使用的帧资源环
+    // TRes 需要包含 std::uint64_t Fence 成员, 记录最后一次使用该槽位的帧
+    template <typename TRes>
+    class FrameRing
+    {
+    public:
+        explicit FrameRing(FrameFence* fence) : m_Fence(fence)
+        {
+        }
+
+        FrameRing(const FrameRing& rhs) = delete;
+        FrameRing& operator=(const FrameRing& rhs) = delete;
+
+        void Add(std::unique_ptr<TRes> res)
+        {
+            m_Res.push_back(std::move(res));
+        }
+
+        // 进入下一帧, 只有当 CPU 领先 GPU 一整圈时才会阻塞
+        TRes& Begin()
+        {
+            assert(!m_Res.empty());
+            m_Index = (m_Index + 1) % Count();
+
+            TRes& res = *m_Res[m_Index];
+            if (res.Fence != 0 && m_Fence->CompletedValue() < res.Fence)
+            {
+                ++m_StallCount;
+                m_Fence->Wait(res.Fence);
+            }
+            return res;
+        }
+
+        // 当前帧的命令已提交, 记录围栏值
+        void End()
+        {
+            Current().Fence = m_Fence->Signal();
+        }
+
+        TRes& Current()
+        {
+            assert(m_Index >= 0);
+            return *m_Res[m_Index];
+        }
+
+        TRes& At(int index)
+        {
+            return *m_Res[index];
+        }
+
+        int Index() const
+        {
+            return m_Index;
+        }
+
+        int Count() const
+        {
+            return static_cast<int>(m_Res.size());
+        }
+
+        // CPU 追上 GPU 而等待的次数
+        std::uint64_t StallCount() const
+        {
+            return m_StallCount;
+        }
+
+    private:
+        FrameFence* m_Fence = nullptr;
+        std::vector<std::unique_ptr<TRes>> m_Res;
+        int m_Index = -1;
+        std::uint64_t m_StallCount = 0;
+    };
+}
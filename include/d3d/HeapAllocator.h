@@ -0,0 +1,83 @@
+#pragma once
+#include <deque>
+#include <memory>
+#include <vector>
+#include "d3dHead.h"
+#include "core/TlsfAllocator.h"
+#include "render/RenderDevice.h"
+
+namespace RainDX
+{
+    // 放置在堆中的资源及其所占的区间
+    struct HeapAllocation
+    {
+        Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+        UINT Heap = 0;
+        TlsfAllocation Range;
+
+        bool IsValid() const { return Resource != nullptr; }
+    };
+
+    // 单个堆的占用和碎片统计
+    struct HeapStats
+    {
+        UINT Heap = 0;
+        TlsfStats Range;
+    };
+
+    // 放置资源的堆子分配器
+    // 预先创建大块 ID3D12Heap, 用 TLSF 在其中分配区间, 再把资源放置到对应偏移
+    // 超过单个堆大小的资源使用独立的堆
+    class HeapAllocator
+    {
+    public:
+        HeapAllocator(RenderDevice* device, D3D12_HEAP_TYPE heapType, D3D12_HEAP_FLAGS heapFlags,
+                      UINT64 heapSize = 64 * 1024 * 1024);
+        HeapAllocator(const HeapAllocator& rhs) = delete;
+        HeapAllocator& operator=(const HeapAllocator& rhs) = delete;
+
+        HeapAllocation CreateBuffer(UINT64 byteSize, D3D12_RESOURCE_STATES initState);
+        // 纹理会先尝试 4KB 的小资源对齐
+        HeapAllocation CreateResource(const D3D12_RESOURCE_DESC& desc, D3D12_RESOURCE_STATES initState,
+                                      const D3D12_CLEAR_VALUE* clearValue = nullptr);
+
+        // 立即释放, 调用者保证 GPU 不再使用该资源
+        void Free(HeapAllocation& allocation);
+        // 围栏达到 fence 之后才真正释放
+        void Free(HeapAllocation& allocation, std::uint64_t fence);
+        // 处理已经完成的延迟释放
+        void Retire();
+
+        UINT HeapCount() const;
+        std::vector<HeapStats> Stats() const;
+
+    private:
+        struct Heap
+        {
+            Heap(UINT64 size, UINT64 granularity) : Range(size, granularity)
+            {
+            }
+
+            Microsoft::WRL::ComPtr<ID3D12Heap> Native;
+            TlsfAllocator Range;
+        };
+
+        struct PendingFree
+        {
+            std::uint64_t Fence;
+            HeapAllocation Allocation;
+        };
+
+        UINT AddHeap(UINT64 size);
+
+        RenderDevice* m_Device = nullptr;
+        D3D12_HEAP_TYPE m_HeapType;
+        D3D12_HEAP_FLAGS m_HeapFlags;
+        UINT64 m_HeapSize = 0;
+        UINT64 m_HeapAlignment = 0;
+
+        // 释放后的位置置空, 保证 HeapAllocation::Heap 始终有效
+        std::vector<std::unique_ptr<Heap>> m_Heaps;
+        std::deque<PendingFree> m_PendingFrees;
+    };
+}
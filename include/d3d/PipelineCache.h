@@ -0,0 +1,93 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "d3dHead.h"
+#include "core/JobSystem.h"
+
+namespace RainDX
+{
+    struct PipelineCacheStats
+    {
+        // 从管线库中直接取出的 PSO
+        std::size_t LibraryHits = 0;
+        // 由驱动完整编译的 PSO
+        std::size_t Compiled = 0;
+        std::size_t Failed = 0;
+        std::size_t Pending = 0;
+    };
+
+    // 图形 PSO 缓存
+    // 键是整个描述的稳定哈希: 着色器字节码的内容, 输入布局的语义名和各字段, 根签名的哈希以及全部固定功能状态
+    // 创建在任务系统的工作线程上进行, 完成前 Get 返回调用者给的回退 PSO
+    // 新创建的 PSO 存入 ID3D12PipelineLibrary, Save 时序列化到磁盘, 下次启动时跳过驱动编译
+    class PipelineCache
+    {
+    public:
+        // 设备不支持管线库或文件与驱动不匹配时只在内存中缓存
+        PipelineCache(ID3D12Device* device, JobSystem& jobs, const std::wstring& libraryPath);
+        PipelineCache(const PipelineCache& rhs) = delete;
+        PipelineCache& operator=(const PipelineCache& rhs) = delete;
+        // 等待所有创建任务结束
+        ~PipelineCache();
+
+        // rootSignatureHash 为根签名布局的哈希, 见 RootSignatureHandle, 根签名对象本身无法比较
+        // 返回键, 键已存在时不做任何事, 否则复制描述引用的全部数据并提交创建任务
+        // 只能从主线程调用
+        std::uint64_t Request(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, std::uint64_t rootSignatureHash);
+        // 尚未完成, 创建失败或键不存在时返回 fallback
+        ID3D12PipelineState* Get(std::uint64_t key, ID3D12PipelineState* fallback = nullptr) const;
+        bool IsReady(std::uint64_t key) const;
+        // 等待期间当前线程也执行任务, 创建失败时抛出 DxException
+        ID3D12PipelineState* Wait(std::uint64_t key);
+        void WaitAll();
+
+        // 没有新的 PSO 时不写文件, 先写临时文件再改名, 写入失败时返回 false
+        bool Save();
+        PipelineCacheStats Stats() const;
+
+        static std::uint64_t ComputeKey(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, std::uint64_t rootSignatureHash);
+
+    private:
+        // 描述引用的数据都复制到这里, 调用者的缓冲区在 Request 返回后即可释放
+        struct Entry
+        {
+            std::vector<char> Shaders[5];
+            std::vector<std::string> SemanticNames;
+            std::vector<D3D12_INPUT_ELEMENT_DESC> InputLayout;
+            Microsoft::WRL::ComPtr<ID3D12RootSignature> RootSignature;
+            D3D12_GRAPHICS_PIPELINE_STATE_DESC Desc = {};
+
+            Microsoft::WRL::ComPtr<ID3D12PipelineState> Pso;
+            HRESULT Result = S_OK;
+            // 工作线程写完 Pso 和 Result 后置位
+            std::atomic<bool> Ready{false};
+            JobCounter Counter;
+        };
+
+        void Create(std::uint64_t key, Entry& entry);
+        Entry* Find(std::uint64_t key) const;
+
+        Microsoft::WRL::ComPtr<ID3D12Device> m_Device;
+        JobSystem& m_Jobs;
+        std::wstring m_LibraryPath;
+        // 管线库引用这块内存, 必须和它活得一样久
+        std::vector<char> m_LibraryBlob;
+        Microsoft::WRL::ComPtr<ID3D12PipelineLibrary> m_Library;
+        // 管线库的读写都加锁, 驱动编译不加锁
+        std::mutex m_LibraryMutex;
+        bool m_LibraryDirty = false;
+
+        mutable std::mutex m_EntryMutex;
+        std::unordered_map<std::uint64_t, std::unique_ptr<Entry>> m_Entries;
+
+        std::atomic<std::size_t> m_LibraryHits{0};
+        std::atomic<std::size_t> m_Compiled{0};
+        std::atomic<std::size_t> m_Failed{0};
+    };
+}
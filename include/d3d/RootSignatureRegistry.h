@@ -0,0 +1,105 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "d3dHead.h"
+
+namespace RainDX
+{
+    // 根签名布局, 根参数的编号就是添加的顺序
+    // 小块的每次绘制数据用根常量或根描述符, 设置时不需要写描述符
+    class RootSignatureLayout
+    {
+    public:
+        // 根签名的总大小上限, 单位为 DWORD
+        static constexpr UINT MaxSize = 64;
+
+        // num32BitValues 个 32 位常量, 由 SetGraphicsRoot32BitConstants 设置
+        RootSignatureLayout& AddConstants(UINT num32BitValues, UINT shaderRegister, UINT space = 0,
+                                          D3D12_SHADER_VISIBILITY visibility = D3D12_SHADER_VISIBILITY_ALL);
+        // 根描述符, 直接绑定 GPU 虚拟地址
+        RootSignatureLayout& AddCbv(UINT shaderRegister, UINT space = 0,
+                                    D3D12_SHADER_VISIBILITY visibility = D3D12_SHADER_VISIBILITY_ALL);
+        RootSignatureLayout& AddSrv(UINT shaderRegister, UINT space = 0,
+                                    D3D12_SHADER_VISIBILITY visibility = D3D12_SHADER_VISIBILITY_ALL);
+        RootSignatureLayout& AddUav(UINT shaderRegister, UINT space = 0,
+                                    D3D12_SHADER_VISIBILITY visibility = D3D12_SHADER_VISIBILITY_ALL);
+        // 描述符表, 范围在表中依次排列
+        RootSignatureLayout& AddTable(const std::vector<D3D12_DESCRIPTOR_RANGE>& ranges,
+                                      D3D12_SHADER_VISIBILITY visibility = D3D12_SHADER_VISIBILITY_ALL);
+        RootSignatureLayout& SetFlags(D3D12_ROOT_SIGNATURE_FLAGS flags);
+
+        UINT ParameterCount() const;
+        // 根常量每个值占 1, 根描述符占 2, 描述符表占 1
+        UINT Size() const;
+        // 与描述中的指针无关的规范编码, 相同的布局得到相同的编码
+        std::vector<std::uint32_t> Encoding() const;
+        std::uint64_t Hash() const;
+
+        // 序列化为 1.0 版本的根签名, 失败时抛出 DxException
+        Microsoft::WRL::ComPtr<ID3DBlob> Serialize() const;
+
+    private:
+        struct Parameter
+        {
+            D3D12_ROOT_PARAMETER_TYPE Type = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+            D3D12_SHADER_VISIBILITY Visibility = D3D12_SHADER_VISIBILITY_ALL;
+            UINT Num32BitValues = 0;
+            UINT ShaderRegister = 0;
+            UINT Space = 0;
+            std::vector<D3D12_DESCRIPTOR_RANGE> Ranges;
+        };
+
+        RootSignatureLayout& AddDescriptor(D3D12_ROOT_PARAMETER_TYPE type, UINT shaderRegister, UINT space,
+                                           D3D12_SHADER_VISIBILITY visibility);
+
+        std::vector<Parameter> m_Parameters;
+        D3D12_ROOT_SIGNATURE_FLAGS m_Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+    };
+
+    struct RootSignatureHandle
+    {
+        ID3D12RootSignature* Signature = nullptr;
+        // 布局的哈希, 作为 PSO 缓存键的一部分
+        std::uint64_t Hash = 0;
+    };
+
+    struct RootSignatureStats
+    {
+        std::size_t Created = 0;
+        // 命中已有根签名的请求
+        std::size_t Reused = 0;
+    };
+
+    // 根签名注册表
+    // 按布局的哈希去重, 哈希相同时再比较完整的编码, 相同的布局只序列化和创建一次
+    class RootSignatureRegistry
+    {
+    public:
+        explicit RootSignatureRegistry(ID3D12Device* device);
+        RootSignatureRegistry(const RootSignatureRegistry& rhs) = delete;
+        RootSignatureRegistry& operator=(const RootSignatureRegistry& rhs) = delete;
+
+        // 可以在多个线程上同时调用, 创建失败时抛出 DxException
+        RootSignatureHandle Get(const RootSignatureLayout& layout);
+
+        std::size_t Count() const;
+        RootSignatureStats Stats() const;
+
+    private:
+        struct Entry
+        {
+            std::vector<std::uint32_t> Encoding;
+            Microsoft::WRL::ComPtr<ID3D12RootSignature> Signature;
+        };
+
+        Microsoft::WRL::ComPtr<ID3D12Device> m_Device;
+        mutable std::mutex m_Mutex;
+        // 同一哈希下的布局, 碰撞时有多个
+        std::unordered_map<std::uint64_t, std::vector<Entry>> m_Entries;
+        RootSignatureStats m_Stats;
+    };
+}
@@ -1,4 +1,5 @@
 ﻿#pragma once
+#include "core/FrameStats.h"
 
 class Timer
 {
@@ -13,6 +14,10 @@ public:
     void Stop(); // Call when paused.
     void Tick(); // Call every frame.
 
+    // 最近若干帧的帧耗时统计, 暂停期间不记录
+    const RainDX::FrameStats& Stats() const;
+    RainDX::FrameStats& Stats();
+
 private:
     double m_SecondsPerCount;
     double m_DeltaTime;
@@ -29,4 +34,5 @@ private:
     __int64 m_CurTime;
     // 是否暂停
     bool m_IsStop;
+    RainDX::FrameStats m_Stats;
 };
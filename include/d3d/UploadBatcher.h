@@ -0,0 +1,95 @@
+#pragma once
+#include <deque>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+#include "d3dHead.h"
+#include "d3d/HeapAllocator.h"
+#include "d3d/UploadRing.h"
+#include "render/RenderDevice.h"
+
+namespace RainDX
+{
+    // 批量上传器
+    // 所有待上传的数据写入同一个暂存环, 复制命令记录到自有的命令列表
+    // Submit 时把所有状态转换合并成一次 ResourceBarrier, 围栏完成后自动回收暂存内存
+    class UploadBatcher
+    {
+    public:
+        // uploadHeap 不为空时暂存环和超大的暂存缓冲区都从上传堆子分配, 它必须比上传器活得更久
+        UploadBatcher(RenderDevice* device, UINT64 arenaSize, HeapAllocator* uploadHeap = nullptr);
+        UploadBatcher(const UploadBatcher& rhs) = delete;
+        UploadBatcher& operator=(const UploadBatcher& rhs) = delete;
+        ~UploadBatcher();
+
+        // 创建默认堆缓冲区并排队上传, Submit 之后才可以在 GPU 上使用
+        Microsoft::WRL::ComPtr<ID3D12Resource> CreateBuffer(
+            const void* data,
+            UINT64 byteSize,
+            D3D12_RESOURCE_STATES finalState = D3D12_RESOURCE_STATE_GENERIC_READ);
+
+        // 排队上传到已有的缓冲区, dst 必须处于 COMMON 状态
+        // 同一批次中多次上传到同一个缓冲区时只转换一次状态, finalState 以第一次为准
+        void UploadBuffer(
+            ID3D12Resource* dst,
+            UINT64 dstOffset,
+            const void* data,
+            UINT64 byteSize,
+            D3D12_RESOURCE_STATES finalState = D3D12_RESOURCE_STATE_GENERIC_READ);
+
+        // 排队上传纹理的若干子资源, dst 必须处于 COMMON 状态
+        void UploadTexture(
+            ID3D12Resource* dst,
+            UINT firstSubresource,
+            UINT numSubresources,
+            const D3D12_SUBRESOURCE_DATA* data,
+            D3D12_RESOURCE_STATES finalState = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+        // 提交当前批次, 返回该批次的围栏值, 没有待上传数据时返回上一次的围栏值
+        std::uint64_t Submit();
+        // 提交并等待所有上传完成
+        void Flush();
+        // 回收 GPU 已经完成的批次
+        void Retire();
+
+        // 当前批次中排队的上传数量
+        std::size_t PendingCount() const;
+        // 尚未完成的批次数量
+        std::size_t InFlightCount() const;
+
+    private:
+        // 分配暂存内存, 超过暂存环大小时使用独立的上传缓冲区
+        BYTE* Stage(UINT64 byteSize, UINT64 alignment, ID3D12Resource** src, UINT64* srcOffset);
+        void BeginBatch();
+
+        struct Batch
+        {
+            std::uint64_t Fence = 0;
+            Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CmdAlloc;
+            // GPU 读取完成之前必须存活的资源
+            std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> KeepAlive;
+            // 放置在上传堆中的超大暂存缓冲区, 提交时按批次的围栏延迟释放
+            std::vector<HeapAllocation> Placed;
+        };
+
+        RenderDevice* m_Device = nullptr;
+        FrameFence* m_Fence = nullptr;
+        HeapAllocator* m_UploadHeap = nullptr;
+        UploadRing m_Arena;
+
+        std::unique_ptr<RenderCmdList> m_CmdList;
+        // 正在记录的批次
+        Batch m_Current;
+        std::vector<D3D12_RESOURCE_BARRIER> m_Barriers;
+        // 本批次已经记录了状态转换的资源和子资源, 缓冲区的子资源为 ALL_SUBRESOURCES
+        std::set<std::pair<ID3D12Resource*, UINT>> m_Transitioned;
+        std::size_t m_Pending = 0;
+        bool m_Recording = false;
+
+        std::deque<Batch> m_InFlight;
+        // 已完成批次的命令分配器, 下次直接复用
+        std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> m_FreeAllocs;
+        std::uint64_t m_LastFence = 0;
+    };
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstring>
+#include <deque>
+#include "d3dHead.h"
+#include "d3d/HeapAllocator.h"
+#include "render/RenderDevice.h"
+
+namespace RainDX
+{
+    // 从上传环中分配的一段内存
+    struct UploadSlice
+    {
+        // 绑定到流水线使用的 GPU 地址
+        D3D12_GPU_VIRTUAL_ADDRESS Gpu = 0;
+        // CPU 写指针
+        BYTE* Cpu = nullptr;
+        // 在上传缓冲区中的偏移
+        UINT64 Offset = 0;
+        UINT64 Size = 0;
+    };
+
+    // 持久映射的上传环形缓冲区
+    // 每次分配 256 字节对齐的一段, 帧的围栏完成后回收该帧分配的所有内存
+    class UploadRing
+    {
+    public:
+        // heap 不为空时环放置在上传堆的子分配器中, 否则单独创建提交资源
+        // heap 必须比环活得更久, 析构时 GPU 不能再读取环中的数据
+        UploadRing(RenderDevice* device, UINT64 byteSize, HeapAllocator* heap = nullptr);
+        UploadRing(const UploadRing& rhs) = delete;
+        UploadRing& operator=(const UploadRing& rhs) = delete;
+        ~UploadRing();
+
+        // 分配常量数据, 环已满时等待最早的帧完成
+        // 等待所有帧完成后仍放不下时 (单次分配或当前帧超过容量) 抛出 DxException
+        UploadSlice Allocate(UINT byteSize);
+        // 按指定对齐分配, alignment 必须是不超过 64KB 的 2 的幂
+        UploadSlice Allocate(UINT64 byteSize, UINT64 alignment);
+
+        // 分配并写入一个常量结构
+        template <typename T>
+        UploadSlice Push(const T& data)
+        {
+            UploadSlice slice = Allocate(sizeof(T));
+            memcpy(slice.Cpu, &data, sizeof(T));
+            return slice;
+        }
+
+        // 当前帧分配完毕, 记录提交该帧时的围栏值
+        void FinishFrame(std::uint64_t fence);
+        // 回收围栏值不大于 completedFence 的帧
+        void Retire(std::uint64_t completedFence);
+
+        ID3D12Resource* Resource() const;
+        UINT64 Capacity() const;
+        // 尚未回收的字节数
+        UINT64 Used() const;
+        // 不等待 GPU 能否放下这次分配
+        bool CanAllocate(UINT64 byteSize, UINT64 alignment) const;
+
+    private:
+        // 对齐并在必要时回绕后的写位置
+        UINT64 AlignedHead(UINT64 byteSize, UINT64 alignment) const;
+
+        struct FrameMark
+        {
+            std::uint64_t Fence;
+            // 该帧结束时的写位置
+            UINT64 Head;
+        };
+
+        FrameFence* m_Fence = nullptr;
+        HeapAllocator* m_Heap = nullptr;
+        HeapAllocation m_Placed;
+        Microsoft::WRL::ComPtr<ID3D12Resource> m_UploadBuf;
+        BYTE* m_MappedPtr = nullptr;
+        D3D12_GPU_VIRTUAL_ADDRESS m_GpuBase = 0;
+        UINT64 m_Capacity = 0;
+
+        // 单调递增的写位置和回收位置, 取模得到偏移
+        UINT64 m_Head = 0;
+        UINT64 m_Tail = 0;
+        // 已提交但 GPU 可能仍在读取的帧
+        std::deque<FrameMark> m_Frames;
+    };
+}
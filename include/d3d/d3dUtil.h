@@ -15,9 +15,15 @@
 #include <sstream>
 #include "d3dx12.h"
 #include "MathHelper.h"
+#include "render/RenderDevice.h"
 
 extern const int gNumFrameResources;
 
+namespace RainDX
+{
+    struct ShaderRequest;
+}
+
 inline void d3dSetDebugName(IDXGIObject* obj, const char* name)
 {
     if (obj)
@@ -57,18 +63,20 @@ public:
 
     static Microsoft::WRL::ComPtr<ID3DBlob> LoadBinary(const std::wstring& filename);
 
-    static Microsoft::WRL::ComPtr<ID3D12Resource> CreateDefaultBuffer(
-        ID3D12Device* device,
-        ID3D12GraphicsCommandList* cmdList,
-        const void* initData,
-        UINT64 byteSize,
-        Microsoft::WRL::ComPtr<ID3D12Resource>& uploadBuffer);
-
     static Microsoft::WRL::ComPtr<ID3DBlob> CompileShader(
         const std::wstring& filename,
         const D3D_SHADER_MACRO* defines,
         const std::string& entrypoint,
         const std::string& target);
+
+    // 按请求中的路径, 宏和标志编译, 失败时抛出 DxException, 可以在多个线程上同时调用
+    static std::vector<char> CompileBytecode(const RainDX::ShaderRequest& request);
+
+    // 调试版本跳过优化
+    static UINT DefaultCompileFlags();
+
+    // 头文件中的编译器版本加上实际加载的 d3dcompiler 模块的文件版本, 作为着色器缓存键的一部分
+    static std::string CompilerVersion();
 };
 
 // Defines a subrange of geometry in a MeshGeometry.  This is for when multiple
@@ -80,6 +88,9 @@ struct SubmeshGeometry
     UINT IndexCount = 0;
     UINT StartIndexLocation = 0;
     INT BaseVertexLocation = 0;
+    // 子网格自己的索引格式, StartIndexLocation 以该格式的元素为单位, 从索引缓冲区起点算起
+    // 为 UNKNOWN 时使用 MeshGeometry::IndexFormat
+    DXGI_FORMAT IndexFormat = DXGI_FORMAT_UNKNOWN;
 
     // Bounding box of the geometry defined by this submesh. 
     // This is used in later chapters of the book.
@@ -123,14 +134,27 @@ struct MeshGeometry
 
     D3D12_INDEX_BUFFER_VIEW IndexBufferView() const
     {
+        return IndexBufferView(IndexFormat);
+    }
+
+    // 同一个索引缓冲区可以同时存放 16 位和 32 位的子网格, 按子网格的格式取对应的视图
+    D3D12_INDEX_BUFFER_VIEW IndexBufferView(DXGI_FORMAT format) const
+    {
+        const UINT elementSize = format == DXGI_FORMAT_R32_UINT ? 4 : 2;
+
         D3D12_INDEX_BUFFER_VIEW ibv;
         ibv.BufferLocation = IndexBufferGPU->GetGPUVirtualAddress();
-        ibv.Format = IndexFormat;
-        ibv.SizeInBytes = IndexBufferByteSize;
+        ibv.Format = format;
+        ibv.SizeInBytes = IndexBufferByteSize / elementSize * elementSize;
 
         return ibv;
     }
 
+    DXGI_FORMAT SubmeshIndexFormat(const SubmeshGeometry& submesh) const
+    {
+        return submesh.IndexFormat != DXGI_FORMAT_UNKNOWN ? submesh.IndexFormat : IndexFormat;
+    }
+
     // We can free this memory after we finish upload to the GPU.
     void DisposeUploaders()
     {
@@ -6,5 +6,6 @@
 #include <wrl.h>
 
 #pragma comment(lib,"d3dcompiler.lib")
+#pragma comment(lib, "version.lib")
 #pragma comment(lib, "D3D12.lib")
 #pragma comment(lib, "dxgi.lib")
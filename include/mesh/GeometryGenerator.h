@@ -0,0 +1,87 @@
+#pragma once
+#include <DirectXCollision.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace RainDX
+{
+    class JobSystem;
+    class LinearArena;
+
+    // 生成器输出的顶点, 前 12 字节为 float3 位置, 可以直接交给 MeshOptimizer 和 MeshletBuilder
+    struct GeometryVertex
+    {
+        DirectX::XMFLOAT3 Position;
+        DirectX::XMFLOAT3 Normal;
+        DirectX::XMFLOAT3 TangentU;
+        DirectX::XMFLOAT2 TexC;
+    };
+
+    // 形状需要的顶点数和索引数
+    struct GeometrySize
+    {
+        std::uint32_t VertexCount = 0;
+        std::uint32_t IndexCount = 0;
+    };
+
+    // 输出位置, 由调用者提供或从 LinearArena 分配, 容量不能小于对应的 GeometrySize
+    template <typename Index>
+    struct GeometrySpans
+    {
+        GeometryVertex* Vertices = nullptr;
+        std::uint32_t VertexCount = 0;
+        Index* Indices = nullptr;
+        std::uint32_t IndexCount = 0;
+    };
+
+    // 程序化生成基本形状
+    // 先用 *Size 求出顶点数和索引数, 再把结果直接写入调用者的内存, 过程中不申请内存
+    // 索引相对于第一个顶点, 三角形从外侧看为顺时针, 与左手坐标系下的默认正面一致
+    class GeometryGenerator
+    {
+    public:
+        // 网格每个任务处理的顶点数
+        static constexpr std::size_t GridVerticesPerJob = 64 * 1024;
+
+        template <typename Index>
+        static GeometrySpans<Index> Allocate(LinearArena& arena, const GeometrySize& size);
+
+        // 每个面是 2^subdivisions x 2^subdivisions 的网格, 面之间不共享顶点
+        static GeometrySize BoxSize(std::uint32_t subdivisions);
+        template <typename Index>
+        static GeometrySize Box(float width, float height, float depth, std::uint32_t subdivisions,
+                                const GeometrySpans<Index>& out);
+
+        // 经纬球, 两极各一个顶点
+        static GeometrySize SphereSize(std::uint32_t sliceCount, std::uint32_t stackCount);
+        template <typename Index>
+        static GeometrySize Sphere(float radius, std::uint32_t sliceCount, std::uint32_t stackCount,
+                                   const GeometrySpans<Index>& out);
+
+        // 二十面体细分的球, 每个面切成 2^subdivisions 段的三角网格后投影到球面
+        static GeometrySize GeosphereSize(std::uint32_t subdivisions);
+        template <typename Index>
+        static GeometrySize Geosphere(float radius, std::uint32_t subdivisions, const GeometrySpans<Index>& out);
+
+        // 以原点为中心, 沿 y 轴, 带上下底面
+        static GeometrySize CylinderSize(std::uint32_t sliceCount, std::uint32_t stackCount);
+        template <typename Index>
+        static GeometrySize Cylinder(float bottomRadius, float topRadius, float height,
+                                     std::uint32_t sliceCount, std::uint32_t stackCount,
+                                     const GeometrySpans<Index>& out);
+
+        // xz 平面上 rows x columns 个顶点, 行沿 -z 方向
+        // jobs 不为空时按行带并行生成, 结果与串行相同
+        static GeometrySize GridSize(std::uint32_t rows, std::uint32_t columns);
+        template <typename Index>
+        static GeometrySize Grid(float width, float depth, std::uint32_t rows, std::uint32_t columns,
+                                 const GeometrySpans<Index>& out, JobSystem* jobs = nullptr);
+
+        // 在 xz 平面上绕 y 轴, ringSegments 为大圆的分段数, tubeSegments 为截面的分段数
+        static GeometrySize TorusSize(std::uint32_t ringSegments, std::uint32_t tubeSegments);
+        template <typename Index>
+        static GeometrySize Torus(float majorRadius, float minorRadius,
+                                  std::uint32_t ringSegments, std::uint32_t tubeSegments,
+                                  const GeometrySpans<Index>& out);
+    };
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "d3d/d3dUtil.h"
+
+namespace RainDX
+{
+    struct GeometryPackStats
+    {
+        std::size_t Pages = 0;
+        std::size_t Submeshes16 = 0;
+        std::size_t Submeshes32 = 0;
+        std::uint64_t VertexBytes = 0;
+        // 包括 16 位和 32 位区域之间以及末尾的对齐
+        std::uint64_t IndexBytes = 0;
+        // 所有索引都使用 32 位时的大小, 用于对比
+        std::uint64_t IndexBytes32 = 0;
+    };
+
+    // 几何打包器
+    // 把顶点格式相同的多个网格合并到共享的顶点和索引缓冲区, 每个网格成为一个子网格
+    // 子网格的索引相对于自己的 BaseVertexLocation, 顶点数不超过 65536 时使用 16 位索引
+    // 同一个索引缓冲区中 16 位索引在前, 32 位索引在后, 按子网格的格式取不同的视图
+    class GeometryPacker
+    {
+    public:
+        // 每页缓冲区的默认上限, 超出后开始新的 MeshGeometry
+        static constexpr std::uint64_t DefaultPageBytes = 64ull * 1024 * 1024;
+
+        explicit GeometryPacker(UINT vertexStride, std::uint64_t pageBytes = DefaultPageBytes);
+
+        // 复制网格数据, 索引相对于 vertices 的第一个顶点
+        // bounds 为空时按顶点前 12 字节的 float3 位置计算
+        template <typename Index>
+        void Add(const std::string& name, const void* vertices, std::size_t vertexCount,
+                 const Index* indices, std::size_t indexCount, const DirectX::BoundingBox* bounds = nullptr);
+
+        // 按添加顺序分页打包, 只填充 CPU 端数据, 由调用者上传
+        // 页的名字为 name 加页号
+        std::vector<std::unique_ptr<MeshGeometry>> Pack(const std::string& name);
+        // 清空已添加的网格
+        void Clear();
+
+        std::size_t MeshCount() const;
+        // 最近一次 Pack 的统计
+        const GeometryPackStats& Stats() const;
+
+    private:
+        struct Mesh
+        {
+            std::string Name;
+            std::size_t FirstVertexByte = 0;
+            std::uint32_t VertexCount = 0;
+            std::size_t FirstIndex = 0;
+            std::uint32_t IndexCount = 0;
+            std::uint32_t MaxIndex = 0;
+            DirectX::BoundingBox Bounds;
+
+            bool Wide() const { return MaxIndex > 0xffff; }
+            std::uint64_t IndexBytes() const { return static_cast<std::uint64_t>(IndexCount) * (Wide() ? 4 : 2); }
+        };
+
+        // 把 [first, last) 之间的网格写成一页
+        std::unique_ptr<MeshGeometry> BuildPage(const std::string& name, std::size_t first, std::size_t last);
+
+        UINT m_VertexStride = 0;
+        std::uint64_t m_PageBytes = 0;
+        std::vector<Mesh> m_Meshes;
+        std::vector<char> m_Vertices;
+        // 添加时统一转为 32 位
+        std::vector<std::uint32_t> m_Indices;
+        GeometryPackStats m_Stats;
+    };
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct MeshGeometry;
+
+namespace RainDX
+{
+    // 顶点后变换缓存的模拟结果
+    struct VertexCacheStats
+    {
+        std::size_t Triangles = 0;
+        // 被引用的不同顶点数
+        std::size_t Vertices = 0;
+        std::size_t Misses = 0;
+        // 平均每个三角形的缓存未命中数 (ACMR), 理想值约为 0.5
+        float Acmr = 0.0f;
+        // 平均每个顶点被变换的次数 (ATVR), 理想值为 1
+        float Atvr = 0.0f;
+    };
+
+    // 优化前后的对比
+    struct MeshOptimizeReport
+    {
+        VertexCacheStats Before;
+        VertexCacheStats After;
+    };
+
+    // 网格优化
+    // 依次重排三角形提高顶点缓存命中率 (Tipsify), 按簇重排三角形减少过度绘制,
+    // 最后按首次使用的顺序重排顶点提高顶点读取的局部性
+    // 同一个输入总是得到同一个结果, 可以离线执行也可以在上传之前执行
+    class MeshOptimizer
+    {
+    public:
+        // 模拟的 FIFO 缓存大小
+        static constexpr std::uint32_t CacheSize = 16;
+        // 软簇边界的阈值, 簇内前缀的 ACMR 不超过整簇的这个倍数时断开
+        static constexpr float OverdrawThreshold = 1.05f;
+
+        // 用 FIFO 缓存模拟索引序列
+        template <typename Index>
+        static VertexCacheStats AnalyzeVertexCache(
+            const Index* indices, std::size_t indexCount, std::size_t vertexCount,
+            std::uint32_t cacheSize = CacheSize);
+
+        // Tipsify 三角形重排, clusters 不为空时输出硬簇的起始三角形 (缓存被打断的位置)
+        template <typename Index>
+        static void OptimizeVertexCache(
+            Index* indices, std::size_t indexCount, std::size_t vertexCount,
+            std::uint32_t cacheSize = CacheSize, std::vector<std::uint32_t>* clusters = nullptr);
+
+        // 在硬簇内再按 ACMR 切出软簇, 按簇的朝外程度排序, 朝外的簇先画, 与视角无关
+        // positions 指向第一个顶点的 float3 位置
+        template <typename Index>
+        static void OptimizeOverdraw(
+            Index* indices, std::size_t indexCount,
+            const float* positions, std::size_t stride, std::size_t vertexCount,
+            const std::vector<std::uint32_t>& clusters,
+            std::uint32_t cacheSize = CacheSize, float threshold = OverdrawThreshold);
+
+        // 按首次使用的顺序重排顶点并改写索引, 未被引用的顶点移到末尾
+        // 返回被引用的顶点数
+        template <typename Index>
+        static std::size_t OptimizeVertexFetch(
+            void* vertices, std::size_t stride, std::size_t vertexCount,
+            Index* indices, std::size_t indexCount);
+
+        // 依次执行以上三步, 顶点的前 12 字节必须是 float3 位置
+        template <typename Index>
+        static MeshOptimizeReport Optimize(
+            void* vertices, std::size_t stride, std::size_t vertexCount,
+            Index* indices, std::size_t indexCount, std::uint32_t cacheSize = CacheSize);
+
+        // 在 CPU 端的顶点和索引数据上逐个子网格优化, 必须在创建 GPU 缓冲区之前调用
+        // 子网格的顶点区间互相重叠时不重排顶点
+        static MeshOptimizeReport Optimize(MeshGeometry& geo, std::uint32_t cacheSize = CacheSize);
+    };
+}
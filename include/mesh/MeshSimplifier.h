@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct MeshGeometry;
+
+namespace RainDX
+{
+    // LOD 链中的一级, Submesh 是 DrawArgs 中的名字
+    struct MeshLod
+    {
+        std::string Submesh;
+        // 与原网格的最大偏离, 物体空间的距离
+        float Error = 0.0f;
+    };
+
+    // 子网格名字到 LOD 链的映射, 与 MeshGeometry::DrawArgs 同名
+    using MeshLodMap = std::unordered_map<std::string, std::vector<MeshLod>>;
+
+    // 二次误差度量 (QEM) 网格简化和 LOD 选择
+    // 只把顶点合并到已有的邻接顶点上, 不产生新顶点, 所有 LOD 共用原来的顶点缓冲区
+    // 边界顶点只沿边界移动, 位置相同的多个顶点 (接缝) 不移动
+    class MeshSimplifier
+    {
+    public:
+        // 包括原网格在内的最大级数
+        static constexpr std::size_t MaxLods = 4;
+        // 每一级的目标三角形数相对上一级的比例
+        static constexpr float LodReduction = 0.5f;
+        // 三角形数减少不到这个比例时不再生成下一级
+        static constexpr float MinLodReduction = 0.8f;
+        // 屏幕上允许的误差, 像素
+        static constexpr float PixelThreshold = 1.0f;
+
+        // 把 indices 简化到不超过 targetIndexCount 个索引, 或误差达到 maxError 为止
+        // 结果写入 destination, 容量不小于 indexCount, 返回写入的索引数
+        // error 不为空时输出实际的误差
+        template <typename Index>
+        static std::size_t Simplify(
+            Index* destination, const Index* indices, std::size_t indexCount,
+            const float* positions, std::size_t stride, std::size_t vertexCount,
+            std::size_t targetIndexCount, float maxError, float* error = nullptr);
+
+        // 为每个子网格生成 LOD 链, 简化后的索引追加到索引缓冲区末尾, 格式和 BaseVertexLocation 与原子网格相同
+        // 第 k 级的子网格名为原名加 "_lod" + k, 返回按原子网格名字索引的 LOD 链, 第 0 级是原子网格
+        // maxRelativeError 相对于子网格包围盒的半对角线长度
+        // 顶点的前 12 字节必须是 float3 位置, 要在压缩顶点格式和创建 GPU 缓冲区之前调用, 每个 geo 只调用一次
+        static MeshLodMap BuildLods(MeshGeometry& geo, std::size_t maxLods = MaxLods, float maxRelativeError = 0.1f);
+
+        // 选择屏幕误差不超过 threshold 像素的最粗一级
+        // scale 为物体到世界的缩放, distance 为相机到物体的距离, pixelsPerUnit 为单位距离处一个单位长度的像素数
+        static std::size_t SelectLod(const MeshLod* lods, std::size_t count, float scale, float distance,
+                                     float pixelsPerUnit, float threshold = PixelThreshold);
+    };
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <DirectXCollision.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "scene/FrustumCuller.h"
+
+struct MeshGeometry;
+
+namespace RainDX
+{
+    // 网格簇: 索引缓冲区中连续的一段三角形, 带有包围球和法线锥
+    struct Meshlet
+    {
+        // 在整个索引缓冲区中的位置, 与 SubmeshGeometry 的含义相同
+        std::uint32_t StartIndexLocation = 0;
+        std::uint32_t IndexCount = 0;
+        std::uint32_t VertexCount = 0;
+
+        DirectX::XMFLOAT3 Center = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+        float Radius = 0.0f;
+        // 三角形法线的平均方向, 所有法线与它的夹角不超过锥的半角
+        DirectX::XMFLOAT3 ConeAxis = DirectX::XMFLOAT3(0.0f, 0.0f, 1.0f);
+        // 半角的正弦, 为 1 时整簇不可能同时背向相机
+        float ConeCutoff = 1.0f;
+    };
+
+    // 裁剪后留下的一段索引, 相邻的簇合并为一段
+    struct MeshletRange
+    {
+        std::uint32_t StartIndexLocation = 0;
+        std::uint32_t IndexCount = 0;
+    };
+
+    struct MeshletCullStats
+    {
+        std::size_t Visible = 0;
+        std::size_t FrustumCulled = 0;
+        std::size_t BackfaceCulled = 0;
+    };
+
+    // 子网格名字到网格簇的映射, 与 MeshGeometry::DrawArgs 同名
+    using MeshletMap = std::unordered_map<std::string, std::vector<Meshlet>>;
+
+    // 网格簇的构建和裁剪
+    // 构建时从种子三角形开始贪心生长, 优先选择不增加顶点的相邻三角形, 结果只取决于输入
+    class MeshletBuilder
+    {
+    public:
+        static constexpr std::uint32_t MaxVertices = 64;
+        static constexpr std::uint32_t MaxTriangles = 124;
+
+        // 重排 indices 使每个簇的三角形连续, 簇追加到 meshlets
+        // startIndex 为 indices 在整个索引缓冲区中的位置, positions 指向第一个顶点的 float3 位置
+        template <typename Index>
+        static void Build(
+            Index* indices, std::size_t indexCount,
+            const float* positions, std::size_t stride, std::size_t vertexCount,
+            std::uint32_t startIndex, std::vector<Meshlet>& meshlets);
+
+        // 为每个子网格构建网格簇, 重排 geo 的索引缓冲区, 返回按子网格名字索引的网格簇
+        // 顶点的前 12 字节必须是 float3 位置, 因此要在压缩顶点格式之前调用
+        static MeshletMap Build(MeshGeometry& geo);
+
+        // frustum 和 eye 与网格处于同一空间, 一般为物体空间
+        // 留下的索引区间追加到 ranges, 按位置递增
+        static MeshletCullStats Cull(
+            const Meshlet* meshlets, std::size_t count,
+            const CullFrustum& frustum, const DirectX::XMFLOAT3& eye,
+            std::vector<MeshletRange>& ranges);
+    };
+}
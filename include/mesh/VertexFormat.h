@@ -0,0 +1,115 @@
+#pragma once
+#include <DirectXCollision.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "d3dHead.h"
+
+namespace RainDX
+{
+    enum class VertexAttribute
+    {
+        Position,
+        Normal,
+        Color,
+    };
+
+    // 属性在顶点缓冲区中的编码
+    enum class VertexEncoding
+    {
+        // 32 位浮点, 不压缩
+        Float3,
+        Float4,
+        // 位置: 相对包围盒归一化到 [-1, 1] 的 16 位 snorm, 第 4 个分量补 0
+        Snorm16x4,
+        // 位置: 相对包围盒归一化到 [-1, 1] 的半精度浮点
+        Half16x4,
+        // 颜色: 每通道 8 位
+        Unorm8x4,
+        // 法线: 八面体映射到二维后的 16 位 snorm
+        Oct16x2,
+    };
+
+    // 交错顶点中的一个属性
+    struct VertexElement
+    {
+        VertexAttribute Attribute = VertexAttribute::Position;
+        VertexEncoding Encoding = VertexEncoding::Float3;
+        UINT Offset = 0;
+    };
+
+    // 按步长读取的源数据, Data 指向第一个顶点的该属性
+    struct VertexStream
+    {
+        const void* Data = nullptr;
+        std::size_t Stride = 0;
+
+        const float* At(std::size_t i) const
+        {
+            return reinterpret_cast<const float*>(static_cast<const char*>(Data) + i * Stride);
+        }
+    };
+
+    // 编码前的浮点顶点数据, 格式中没有的属性可以为空
+    struct VertexStreams
+    {
+        // float3
+        VertexStream Position;
+        // float3, 需已归一化
+        VertexStream Normal;
+        // float4
+        VertexStream Color;
+    };
+
+    // 着色器中的位置还原为 pos * Scale + Bias
+    struct PositionDequant
+    {
+        DirectX::XMFLOAT3 Scale = DirectX::XMFLOAT3(1.0f, 1.0f, 1.0f);
+        DirectX::XMFLOAT3 Bias = DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f);
+    };
+
+    // 顶点格式描述
+    // 由属性和编码决定偏移和步长, 生成对应的输入布局, 并把浮点数据编码到交错的顶点缓冲区
+    class VertexFormat
+    {
+    public:
+        // 依次追加属性, 偏移按 4 字节对齐
+        VertexFormat& Add(VertexAttribute attribute, VertexEncoding encoding);
+
+        UINT Stride() const;
+        const std::vector<VertexElement>& Elements() const;
+        // 不包含该属性时返回 nullptr
+        const VertexElement* Find(VertexAttribute attribute) const;
+
+        // 语义名与 shaders 中的 POSITION, NORMAL, COLOR 一致
+        std::vector<D3D12_INPUT_ELEMENT_DESC> InputLayout(UINT slot = 0) const;
+
+        // 把 count 个顶点编码到 dst, dst 至少 count * Stride() 字节
+        // 位置的量化范围取 bounds, bounds 必须包含所有位置
+        void Encode(const VertexStreams& src, std::size_t count,
+                    const DirectX::BoundingBox& bounds, void* dst) const;
+        // bounds 与 Encode 时一致
+        PositionDequant Dequant(const DirectX::BoundingBox& bounds) const;
+
+        static UINT EncodingSize(VertexEncoding encoding);
+        static DXGI_FORMAT EncodingFormat(VertexEncoding encoding);
+
+        // 未压缩的位置和颜色, 28 字节
+        static VertexFormat PositionColor();
+        // 量化的位置和颜色, 12 字节
+        static VertexFormat CompactPositionColor();
+
+    private:
+        std::vector<VertexElement> m_Elements;
+        UINT m_Stride = 0;
+    };
+
+    // 单个数值的编码, 超出范围时截断
+    std::uint16_t FloatToHalf(float value);
+    float HalfToFloat(std::uint16_t value);
+    std::int16_t FloatToSnorm16(float value);
+    std::uint8_t FloatToUnorm8(float value);
+    // 单位向量的八面体映射, 结果在 [-1, 1]^2
+    void OctEncode(const float* normal, float& u, float& v);
+    void OctDecode(float u, float v, float* normal);
+}
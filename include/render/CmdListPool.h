@@ -0,0 +1,72 @@
+#pragma once
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include "d3dHead.h"
+#include "core/JobSystem.h"
+#include "core/Profiler.h"
+#include "render/RenderDevice.h"
+
+namespace RainDX
+{
+    // 一帧使用的命令分配器和命令列表, 每个列表独占一个分配器
+    // 只在 GPU 完成该帧之后 Reset, 列表按需增加并跨帧复用
+    class CmdListPool
+    {
+    public:
+        explicit CmdListPool(RenderDevice* device);
+        CmdListPool(const CmdListPool& rhs) = delete;
+        CmdListPool& operator=(const CmdListPool& rhs) = delete;
+
+        // 帧开始时调用, 之前取出的列表全部归还
+        void Reset();
+        // 取出下一个列表并重置为记录状态, 只能在提交线程调用
+        RenderCmdList* Acquire(ID3D12PipelineState* pso = nullptr);
+
+        // 把 count 个对象按每 chunkSize 个一组分给工作线程录制
+        // 第 i 组总是录制到第 i 个列表, 按组的顺序追加到 lists, 与线程调度无关
+        // record(list, first, last) 只录制命令, 关闭由本函数完成
+        template <typename F>
+        void Record(JobSystem& jobs, std::size_t count, std::size_t chunkSize, ID3D12PipelineState* pso,
+                    const F& record, std::vector<RenderCmdList*>& lists)
+        {
+            if (count == 0)
+                return;
+            if (chunkSize == 0)
+                chunkSize = count;
+
+            // 设备对象在提交线程上创建, 工作线程只录制
+            std::size_t chunks = (count + chunkSize - 1) / chunkSize;
+            std::size_t first = lists.size();
+            for (std::size_t i = 0; i < chunks; ++i)
+                lists.push_back(Acquire(pso));
+
+            RenderCmdList* const* chunkLists = lists.data() + first;
+            jobs.ParallelFor(0, chunks, 1, [&](std::size_t begin, std::size_t end)
+            {
+                for (std::size_t i = begin; i < end; ++i)
+                {
+                    RAINDX_PROFILE_SCOPE("RecordCmdList");
+                    std::size_t last = (std::min)(count, (i + 1) * chunkSize);
+                    record(*chunkLists[i], i * chunkSize, last);
+                    chunkLists[i]->Close();
+                }
+            });
+        }
+
+        // 池中的列表总数和本帧已取出的数量
+        UINT Count() const;
+        UINT Used() const;
+
+    private:
+        struct Entry
+        {
+            Microsoft::WRL::ComPtr<ID3D12CommandAllocator> Alloc;
+            std::unique_ptr<RenderCmdList> List;
+        };
+
+        RenderDevice* m_Device = nullptr;
+        std::vector<Entry> m_Entries;
+        UINT m_Used = 0;
+    };
+}
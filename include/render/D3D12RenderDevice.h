@@ -0,0 +1,97 @@
+#pragma once
+#include "render/RenderDevice.h"
+#include "d3d/FrameResource.h"
+
+namespace RainDX
+{
+    // 直接转发到 ID3D12GraphicsCommandList
+    class D3D12RenderCmdList : public RenderCmdList
+    {
+    public:
+        explicit D3D12RenderCmdList(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> list);
+
+        void Reset(ID3D12CommandAllocator* alloc, ID3D12PipelineState* pso) override;
+        void Close() override;
+
+        void ResourceBarrier(UINT count, const D3D12_RESOURCE_BARRIER* barriers) override;
+        void CopyBufferRegion(ID3D12Resource* dst, UINT64 dstOffset,
+                              ID3D12Resource* src, UINT64 srcOffset, UINT64 byteSize) override;
+        void CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION* dst,
+                               const D3D12_TEXTURE_COPY_LOCATION* src) override;
+
+        void RSSetViewports(UINT count, const D3D12_VIEWPORT* viewports) override;
+        void RSSetScissorRects(UINT count, const D3D12_RECT* rects) override;
+        void ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE rtv, const FLOAT color[4]) override;
+        void ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE dsv, D3D12_CLEAR_FLAGS flags,
+                                   FLOAT depth, UINT8 stencil) override;
+        void OMSetRenderTargets(UINT count, const D3D12_CPU_DESCRIPTOR_HANDLE* rtvs,
+                                BOOL singleHandle, const D3D12_CPU_DESCRIPTOR_HANDLE* dsv) override;
+
+        void SetPipelineState(ID3D12PipelineState* pso) override;
+        void SetDescriptorHeaps(UINT count, ID3D12DescriptorHeap* const* heaps) override;
+        void SetGraphicsRootSignature(ID3D12RootSignature* rootSign) override;
+        void SetGraphicsRootDescriptorTable(UINT index, D3D12_GPU_DESCRIPTOR_HANDLE table) override;
+        void SetGraphicsRootShaderResourceView(UINT index, D3D12_GPU_VIRTUAL_ADDRESS address) override;
+        void SetGraphicsRootConstantBufferView(UINT index, D3D12_GPU_VIRTUAL_ADDRESS address) override;
+        void SetGraphicsRoot32BitConstants(UINT index, UINT count, const void* data, UINT offset) override;
+
+        void IASetVertexBuffers(UINT slot, UINT count, const D3D12_VERTEX_BUFFER_VIEW* views) override;
+        void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view) override;
+        void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology) override;
+        void DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex,
+                                  INT baseVertex, UINT startInstance) override;
+
+        ID3D12GraphicsCommandList* Native() const override;
+
+    private:
+        Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> m_List;
+    };
+
+    // 基于 ID3D12Device 和直接命令队列的后端
+    class D3D12RenderDevice : public RenderDevice
+    {
+    public:
+        D3D12RenderDevice(ID3D12Device* device, ID3D12CommandQueue* queue, ID3D12Fence* fence);
+
+        Microsoft::WRL::ComPtr<ID3D12Resource> CreateBuffer(
+            D3D12_HEAP_TYPE heapType,
+            UINT64 byteSize,
+            D3D12_RESOURCE_STATES initState) override;
+
+        Microsoft::WRL::ComPtr<ID3D12Heap> CreateHeap(const D3D12_HEAP_DESC& desc) override;
+        Microsoft::WRL::ComPtr<ID3D12Resource> CreatePlacedResource(
+            ID3D12Heap* heap,
+            UINT64 heapOffset,
+            const D3D12_RESOURCE_DESC& desc,
+            D3D12_RESOURCE_STATES initState,
+            const D3D12_CLEAR_VALUE* clearValue) override;
+        D3D12_RESOURCE_ALLOCATION_INFO GetResourceAllocationInfo(const D3D12_RESOURCE_DESC& desc) override;
+
+        Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> CreateDescriptorHeap(
+            const D3D12_DESCRIPTOR_HEAP_DESC& desc) override;
+        UINT DescriptorSize(D3D12_DESCRIPTOR_HEAP_TYPE type) const override;
+        void CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC& desc,
+                                      D3D12_CPU_DESCRIPTOR_HANDLE handle) override;
+        void CopyDescriptors(UINT dstRangeCount, const D3D12_CPU_DESCRIPTOR_HANDLE* dstStarts,
+                             const UINT* dstSizes, UINT srcRangeCount,
+                             const D3D12_CPU_DESCRIPTOR_HANDLE* srcStarts, const UINT* srcSizes,
+                             D3D12_DESCRIPTOR_HEAP_TYPE type) override;
+
+        void GetCopyableFootprints(const D3D12_RESOURCE_DESC& desc,
+                                   UINT firstSubresource, UINT numSubresources, UINT64 baseOffset,
+                                   D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts, UINT* numRows,
+                                   UINT64* rowSizes, UINT64* totalBytes) override;
+
+        Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CreateCmdAlloc() override;
+        std::unique_ptr<RenderCmdList> CreateCmdList(ID3D12CommandAllocator* alloc) override;
+        void Execute(UINT count, RenderCmdList* const* lists) override;
+
+        FrameFence* Fence() override;
+        ID3D12Device* Native() const override;
+
+    private:
+        ID3D12Device* m_Device = nullptr;
+        ID3D12CommandQueue* m_Queue = nullptr;
+        D3D12FrameFence m_Fence;
+    };
+}
@@ -0,0 +1,194 @@
+#pragma once
+#include <vector>
+#include "render/RenderDevice.h"
+
+namespace RainDX
+{
+    // 空后端记录的命令类型
+    enum class NullCmdType : UINT8
+    {
+        Reset,
+        Close,
+        ResourceBarrier,
+        CopyBufferRegion,
+        CopyTextureRegion,
+        SetViewports,
+        SetScissorRects,
+        ClearRenderTarget,
+        ClearDepthStencil,
+        SetRenderTargets,
+        SetPipelineState,
+        SetDescriptorHeaps,
+        SetRootSignature,
+        SetRootDescriptorTable,
+        SetRootShaderResourceView,
+        SetRootConstantBufferView,
+        SetRoot32BitConstants,
+        SetVertexBuffers,
+        SetIndexBuffer,
+        SetPrimitiveTopology,
+        DrawIndexedInstanced,
+    };
+
+    // 记录的一条命令, 参数含义随类型而定
+    struct NullCmd
+    {
+        NullCmdType Type;
+        UINT64 Arg0 = 0;
+        UINT64 Arg1 = 0;
+    };
+
+    // 命令流统计
+    struct RenderStats
+    {
+        UINT64 Commands = 0;
+        UINT64 Draws = 0;
+        UINT64 Instances = 0;
+        UINT64 Indices = 0;
+        UINT64 Barriers = 0;
+        UINT64 BytesUploaded = 0;
+        UINT64 CmdLists = 0;
+        UINT64 Submits = 0;
+        UINT64 BuffersCreated = 0;
+        UINT64 HeapsCreated = 0;
+        UINT64 PlacedResources = 0;
+        UINT64 DescriptorWrites = 0;
+        // CopyDescriptors 的调用次数, 复制的描述符计入 DescriptorWrites
+        UINT64 DescriptorCopies = 0;
+
+        RenderStats& operator+=(const RenderStats& rhs);
+    };
+
+    // 假围栏: 每个围栏值在之后再提交 Latency 次才视为完成
+    // Latency 为 0 时立即完成, Wait 会强制完成到指定值
+    class NullFrameFence : public FrameFence
+    {
+    public:
+        explicit NullFrameFence(std::uint64_t latency = 0);
+
+        std::uint64_t Signal() override;
+        std::uint64_t CompletedValue() const override;
+        void Wait(std::uint64_t value) override;
+
+        // Wait 实际阻塞的次数
+        std::uint64_t WaitCount() const;
+
+    private:
+        std::uint64_t m_Latency = 0;
+        std::uint64_t m_Value = 0;
+        std::uint64_t m_Forced = 0;
+        std::uint64_t m_WaitCount = 0;
+    };
+
+    // 把命令记录到内存中的命令列表
+    class NullRenderCmdList : public RenderCmdList
+    {
+    public:
+        void Reset(ID3D12CommandAllocator* alloc, ID3D12PipelineState* pso) override;
+        void Close() override;
+
+        void ResourceBarrier(UINT count, const D3D12_RESOURCE_BARRIER* barriers) override;
+        void CopyBufferRegion(ID3D12Resource* dst, UINT64 dstOffset,
+                              ID3D12Resource* src, UINT64 srcOffset, UINT64 byteSize) override;
+        void CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION* dst,
+                               const D3D12_TEXTURE_COPY_LOCATION* src) override;
+
+        void RSSetViewports(UINT count, const D3D12_VIEWPORT* viewports) override;
+        void RSSetScissorRects(UINT count, const D3D12_RECT* rects) override;
+        void ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE rtv, const FLOAT color[4]) override;
+        void ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE dsv, D3D12_CLEAR_FLAGS flags,
+                                   FLOAT depth, UINT8 stencil) override;
+        void OMSetRenderTargets(UINT count, const D3D12_CPU_DESCRIPTOR_HANDLE* rtvs,
+                                BOOL singleHandle, const D3D12_CPU_DESCRIPTOR_HANDLE* dsv) override;
+
+        void SetPipelineState(ID3D12PipelineState* pso) override;
+        void SetDescriptorHeaps(UINT count, ID3D12DescriptorHeap* const* heaps) override;
+        void SetGraphicsRootSignature(ID3D12RootSignature* rootSign) override;
+        void SetGraphicsRootDescriptorTable(UINT index, D3D12_GPU_DESCRIPTOR_HANDLE table) override;
+        void SetGraphicsRootShaderResourceView(UINT index, D3D12_GPU_VIRTUAL_ADDRESS address) override;
+        void SetGraphicsRootConstantBufferView(UINT index, D3D12_GPU_VIRTUAL_ADDRESS address) override;
+        void SetGraphicsRoot32BitConstants(UINT index, UINT count, const void* data, UINT offset) override;
+
+        void IASetVertexBuffers(UINT slot, UINT count, const D3D12_VERTEX_BUFFER_VIEW* views) override;
+        void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view) override;
+        void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology) override;
+        void DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex,
+                                  INT baseVertex, UINT startInstance) override;
+
+        ID3D12GraphicsCommandList* Native() const override;
+
+        const std::vector<NullCmd>& Commands() const;
+        const RenderStats& Stats() const;
+
+    private:
+        void Record(NullCmdType type, UINT64 arg0 = 0, UINT64 arg1 = 0);
+
+        std::vector<NullCmd> m_Cmds;
+        RenderStats m_Stats;
+        bool m_IsOpen = false;
+    };
+
+    // 不需要 GPU 的后端
+    // 资源和描述符堆是只存在于内存中的假对象, 命令只记录不执行
+    // 接口类型仍来自 d3d12.h/dxgi1_4.h, 编译时需要 Windows SDK, 运行时不需要 GPU 和调试层
+    class NullRenderDevice : public RenderDevice
+    {
+    public:
+        explicit NullRenderDevice(std::uint64_t fenceLatency = 0);
+
+        Microsoft::WRL::ComPtr<ID3D12Resource> CreateBuffer(
+            D3D12_HEAP_TYPE heapType,
+            UINT64 byteSize,
+            D3D12_RESOURCE_STATES initState) override;
+
+        Microsoft::WRL::ComPtr<ID3D12Heap> CreateHeap(const D3D12_HEAP_DESC& desc) override;
+        Microsoft::WRL::ComPtr<ID3D12Resource> CreatePlacedResource(
+            ID3D12Heap* heap,
+            UINT64 heapOffset,
+            const D3D12_RESOURCE_DESC& desc,
+            D3D12_RESOURCE_STATES initState,
+            const D3D12_CLEAR_VALUE* clearValue) override;
+        D3D12_RESOURCE_ALLOCATION_INFO GetResourceAllocationInfo(const D3D12_RESOURCE_DESC& desc) override;
+
+        Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> CreateDescriptorHeap(
+            const D3D12_DESCRIPTOR_HEAP_DESC& desc) override;
+        UINT DescriptorSize(D3D12_DESCRIPTOR_HEAP_TYPE type) const override;
+        void CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC& desc,
+                                      D3D12_CPU_DESCRIPTOR_HANDLE handle) override;
+        void CopyDescriptors(UINT dstRangeCount, const D3D12_CPU_DESCRIPTOR_HANDLE* dstStarts,
+                             const UINT* dstSizes, UINT srcRangeCount,
+                             const D3D12_CPU_DESCRIPTOR_HANDLE* srcStarts, const UINT* srcSizes,
+                             D3D12_DESCRIPTOR_HEAP_TYPE type) override;
+
+        void GetCopyableFootprints(const D3D12_RESOURCE_DESC& desc,
+                                   UINT firstSubresource, UINT numSubresources, UINT64 baseOffset,
+                                   D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts, UINT* numRows,
+                                   UINT64* rowSizes, UINT64* totalBytes) override;
+
+        Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CreateCmdAlloc() override;
+        std::unique_ptr<RenderCmdList> CreateCmdList(ID3D12CommandAllocator* alloc) override;
+        void Execute(UINT count, RenderCmdList* const* lists) override;
+
+        FrameFence* Fence() override;
+        ID3D12Device* Native() const override;
+
+        // 所有已提交命令的累计统计
+        const RenderStats& Stats() const;
+        void ResetStats();
+
+        // 开启后提交的命令流会按顺序保存下来
+        void SetCapture(bool capture);
+        const std::vector<NullCmd>& Captured() const;
+        void ClearCaptured();
+
+    private:
+        NullFrameFence m_Fence;
+        RenderStats m_Stats;
+        // 假的 GPU 虚拟地址和描述符地址
+        UINT64 m_NextGpuAddress = 0x10000;
+        UINT64 m_NextDescriptorAddress = 0x10000;
+
+        bool m_Capture = false;
+        std::vector<NullCmd> m_Captured;
+    };
+}
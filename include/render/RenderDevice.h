@@ -0,0 +1,105 @@
+#pragma once
+#include <memory>
+#include "d3dHead.h"
+#include "d3d/FrameRing.h"
+
+namespace RainDX
+{
+    // 命令列表接口, 对应 ID3D12GraphicsCommandList 中本项目用到的部分
+    class RenderCmdList
+    {
+    public:
+        virtual ~RenderCmdList() = default;
+
+        virtual void Reset(ID3D12CommandAllocator* alloc, ID3D12PipelineState* pso) = 0;
+        virtual void Close() = 0;
+
+        virtual void ResourceBarrier(UINT count, const D3D12_RESOURCE_BARRIER* barriers) = 0;
+        virtual void CopyBufferRegion(ID3D12Resource* dst, UINT64 dstOffset,
+                                      ID3D12Resource* src, UINT64 srcOffset, UINT64 byteSize) = 0;
+        // 复制整个子资源, 不指定区域
+        virtual void CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION* dst,
+                                       const D3D12_TEXTURE_COPY_LOCATION* src) = 0;
+
+        virtual void RSSetViewports(UINT count, const D3D12_VIEWPORT* viewports) = 0;
+        virtual void RSSetScissorRects(UINT count, const D3D12_RECT* rects) = 0;
+        virtual void ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE rtv, const FLOAT color[4]) = 0;
+        virtual void ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE dsv, D3D12_CLEAR_FLAGS flags,
+                                           FLOAT depth, UINT8 stencil) = 0;
+        virtual void OMSetRenderTargets(UINT count, const D3D12_CPU_DESCRIPTOR_HANDLE* rtvs,
+                                        BOOL singleHandle, const D3D12_CPU_DESCRIPTOR_HANDLE* dsv) = 0;
+
+        virtual void SetPipelineState(ID3D12PipelineState* pso) = 0;
+        virtual void SetDescriptorHeaps(UINT count, ID3D12DescriptorHeap* const* heaps) = 0;
+        virtual void SetGraphicsRootSignature(ID3D12RootSignature* rootSign) = 0;
+        virtual void SetGraphicsRootDescriptorTable(UINT index, D3D12_GPU_DESCRIPTOR_HANDLE table) = 0;
+        // 根描述符直接绑定缓冲区地址, 不经过描述符堆
+        virtual void SetGraphicsRootShaderResourceView(UINT index, D3D12_GPU_VIRTUAL_ADDRESS address) = 0;
+        virtual void SetGraphicsRootConstantBufferView(UINT index, D3D12_GPU_VIRTUAL_ADDRESS address) = 0;
+        // 根常量直接写在命令列表中
+        virtual void SetGraphicsRoot32BitConstants(UINT index, UINT count, const void* data, UINT offset) = 0;
+
+        virtual void IASetVertexBuffers(UINT slot, UINT count, const D3D12_VERTEX_BUFFER_VIEW* views) = 0;
+        virtual void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view) = 0;
+        virtual void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology) = 0;
+        virtual void DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex,
+                                          INT baseVertex, UINT startInstance) = 0;
+
+        // 原生命令列表, 无 GPU 的后端返回 nullptr
+        virtual ID3D12GraphicsCommandList* Native() const = 0;
+    };
+
+    // 渲染设备接口, Application 通过它创建资源和提交命令
+    // 流水线状态, 根签名等只在原生设备上创建
+    class RenderDevice
+    {
+    public:
+        virtual ~RenderDevice() = default;
+
+        // 在指定类型的堆上创建缓冲区
+        virtual Microsoft::WRL::ComPtr<ID3D12Resource> CreateBuffer(
+            D3D12_HEAP_TYPE heapType,
+            UINT64 byteSize,
+            D3D12_RESOURCE_STATES initState) = 0;
+
+        // 显式创建堆, 再把资源放置到堆中的偏移处
+        virtual Microsoft::WRL::ComPtr<ID3D12Heap> CreateHeap(const D3D12_HEAP_DESC& desc) = 0;
+        virtual Microsoft::WRL::ComPtr<ID3D12Resource> CreatePlacedResource(
+            ID3D12Heap* heap,
+            UINT64 heapOffset,
+            const D3D12_RESOURCE_DESC& desc,
+            D3D12_RESOURCE_STATES initState,
+            const D3D12_CLEAR_VALUE* clearValue) = 0;
+        // 资源在堆中占用的大小和对齐
+        virtual D3D12_RESOURCE_ALLOCATION_INFO GetResourceAllocationInfo(const D3D12_RESOURCE_DESC& desc) = 0;
+
+        virtual Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> CreateDescriptorHeap(
+            const D3D12_DESCRIPTOR_HEAP_DESC& desc) = 0;
+        virtual UINT DescriptorSize(D3D12_DESCRIPTOR_HEAP_TYPE type) const = 0;
+        virtual void CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC& desc,
+                                              D3D12_CPU_DESCRIPTOR_HANDLE handle) = 0;
+        // 在 CPU 时间线上立即复制, 目标和源各自由若干连续范围组成, 总数必须相同
+        virtual void CopyDescriptors(UINT dstRangeCount, const D3D12_CPU_DESCRIPTOR_HANDLE* dstStarts,
+                                     const UINT* dstSizes, UINT srcRangeCount,
+                                     const D3D12_CPU_DESCRIPTOR_HANDLE* srcStarts, const UINT* srcSizes,
+                                     D3D12_DESCRIPTOR_HEAP_TYPE type) = 0;
+
+        // 子资源在上传缓冲区中的布局
+        virtual void GetCopyableFootprints(const D3D12_RESOURCE_DESC& desc,
+                                           UINT firstSubresource, UINT numSubresources, UINT64 baseOffset,
+                                           D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts, UINT* numRows,
+                                           UINT64* rowSizes, UINT64* totalBytes) = 0;
+
+        virtual Microsoft::WRL::ComPtr<ID3D12CommandAllocator> CreateCmdAlloc() = 0;
+        // 创建的命令列表处于关闭状态
+        virtual std::unique_ptr<RenderCmdList> CreateCmdList(ID3D12CommandAllocator* alloc) = 0;
+        // 按顺序提交命令列表
+        virtual void Execute(UINT count, RenderCmdList* const* lists) = 0;
+
+        // 命令队列的围栏
+        virtual FrameFence* Fence() = 0;
+
+        // 原生设备, 无 GPU 的后端返回 nullptr
+        virtual ID3D12Device* Native() const = 0;
+    };
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <DirectXCollision.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "core/JobSystem.h"
+#include "scene/FrustumCuller.h"
+
+namespace RainDX
+{
+    // 扁平化的 BVH 节点, 32 字节, 按深度优先顺序排列
+    // 左子节点紧跟在父节点之后, 只需要记录右子节点的位置
+    struct BvhNode
+    {
+        DirectX::XMFLOAT3 Min;
+        // 内部节点为右子节点的位置, 叶节点为第一个图元在图元顺序表中的位置
+        std::uint32_t Offset = 0;
+        DirectX::XMFLOAT3 Max;
+        // 叶节点的图元数, 内部节点为 0
+        std::uint32_t Count = 0;
+
+        bool IsLeaf() const { return Count != 0; }
+    };
+
+    // 射线查询的结果
+    struct BvhHit
+    {
+        std::uint32_t Index = 0;
+        float Distance = 0.0f;
+    };
+
+    // 包围盒层次结构
+    // 用分桶的表面积启发式 (SAH) 构建, 子树足够大时交给任务系统并行构建
+    // 物体移动后可以只重新计算包围盒 (Refit), 不改变树的结构
+    class Bvh
+    {
+    public:
+        // 叶节点最多的图元数
+        static constexpr std::uint32_t MaxLeafSize = 4;
+        // SAH 在每个轴上的桶数
+        static constexpr int BinCount = 12;
+        // 遍历一个节点相对于测试一个图元的代价
+        static constexpr float TraversalCost = 1.0f;
+        // 不小于这个图元数的子树并行构建
+        static constexpr std::uint32_t ParallelThreshold = 4096;
+
+        // jobs 为空时单线程构建
+        void Build(const DirectX::BoundingBox* boxes, std::size_t count, JobSystem* jobs = nullptr);
+        // boxes 的数量和顺序必须与构建时一致
+        void Refit(const DirectX::BoundingBox* boxes);
+        void Clear();
+
+        // 把与视锥相交的图元编号追加到 visible, 顺序不固定
+        void QueryFrustum(const CullFrustum& frustum, std::vector<std::uint32_t>& visible) const;
+        // 最近的相交图元, direction 不需要归一化, 距离以 direction 的长度为单位
+        bool Raycast(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction,
+                     float maxDistance, BvhHit& hit) const;
+
+        std::size_t Size() const;
+        const std::vector<BvhNode>& Nodes() const;
+        // 叶节点引用的图元编号, 每个子树的图元在这里是连续的
+        const std::vector<std::uint32_t>& Indices() const;
+        // 树的最大深度, 根为 1
+        std::uint32_t Depth() const;
+
+    private:
+        struct BuildNode
+        {
+            DirectX::XMFLOAT3 Min;
+            DirectX::XMFLOAT3 Max;
+            std::uint32_t First = 0;
+            std::uint32_t Count = 0;
+            // 两个子节点相邻分配, 叶节点为 0
+            std::uint32_t Left = 0;
+        };
+
+        void Subdivide(std::uint32_t node, JobSystem* jobs, JobCounter* counter);
+        std::uint32_t Flatten(std::uint32_t node, std::uint32_t depth);
+        // 子树的图元在 m_Indices 中的区间
+        void SubtreeRange(std::uint32_t node, std::uint32_t& first, std::uint32_t& last) const;
+
+        std::vector<BvhNode> m_Nodes;
+        std::vector<std::uint32_t> m_Indices;
+        // 图元的包围盒, 按原始编号
+        std::vector<DirectX::XMFLOAT3> m_PrimMin;
+        std::vector<DirectX::XMFLOAT3> m_PrimMax;
+        std::uint32_t m_Depth = 0;
+
+        // 仅在构建期间使用
+        std::vector<BuildNode> m_BuildNodes;
+        std::vector<DirectX::XMFLOAT3> m_Centers;
+        std::atomic<std::uint32_t> m_BuildCount{0};
+    };
+}
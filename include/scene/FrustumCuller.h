@@ -0,0 +1,73 @@
+#pragma once
+#include <DirectXCollision.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "core/JobSystem.h"
+
+namespace RainDX
+{
+    // 视锥的六个平面, 法线朝内, 点 p 在平面内侧时 dot(n, p) + w >= 0
+    struct CullFrustum
+    {
+        DirectX::XMFLOAT4 Planes[6];
+
+        // 从行向量约定的 view * proj 矩阵提取, 深度范围为 D3D 的 [0, w]
+        static CullFrustum FromViewProj(const DirectX::XMFLOAT4X4& viewProj);
+    };
+
+    // 裁剪使用的指令集
+    enum class CullSimd
+    {
+        Scalar,
+        Sse,
+        Avx,
+    };
+
+    // 视锥裁剪
+    // 包围盒按中心和半长以 SoA 形式保存, 一条指令同时测试 4 个 (SSE) 或 8 个 (AVX) 盒子
+    // 输出可见物体的编号, 按编号递增排列
+    class FrustumCuller
+    {
+    public:
+        // 每组盒子数, 存储按组补齐, 补齐的盒子总是被裁掉
+        static constexpr std::size_t GroupSize = 8;
+        // 并行裁剪时每个任务处理的盒子数
+        static constexpr std::size_t BoxesPerJob = 16384;
+
+        FrustumCuller();
+
+        void Clear();
+        void Reserve(std::size_t count);
+        // 返回新盒子的编号
+        std::uint32_t Add(const DirectX::BoundingBox& box);
+        void Set(std::uint32_t index, const DirectX::BoundingBox& box);
+        std::size_t Size() const;
+
+        // 单线程裁剪, visible 至少要有 Size() + GroupSize 个元素, 返回可见数量
+        std::size_t Cull(const CullFrustum& frustum, std::uint32_t* visible) const;
+        // 按块并行裁剪后拼接, visible 的大小调整为可见数量
+        std::size_t Cull(JobSystem& jobs, const CullFrustum& frustum, std::vector<std::uint32_t>& visible) const;
+
+        // 默认使用当前 CPU 支持的最宽指令集, 可以强制降级用于对比
+        CullSimd Simd() const;
+        void SetSimd(CullSimd simd);
+        static CullSimd BestSimd();
+
+    private:
+        // 裁剪 [first, last) 之间的组, 返回写入的数量
+        std::size_t CullGroups(const CullFrustum& frustum, std::size_t firstGroup, std::size_t lastGroup,
+                               std::uint32_t* visible) const;
+
+        std::size_t m_Count = 0;
+        CullSimd m_Simd = CullSimd::Scalar;
+
+        // SoA 存储, 长度按 GroupSize 补齐
+        std::vector<float> m_CenterX;
+        std::vector<float> m_CenterY;
+        std::vector<float> m_CenterZ;
+        std::vector<float> m_ExtentX;
+        std::vector<float> m_ExtentY;
+        std::vector<float> m_ExtentZ;
+    };
+}
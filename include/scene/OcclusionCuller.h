@@ -0,0 +1,62 @@
+#pragma once
+#include <DirectXCollision.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace RainDX
+{
+    // 软件遮挡剔除
+    // 遮挡物的三角形用 SSE 光栅化到低分辨率深度缓冲区, 再生成取最大深度的层级 Z 金字塔
+    // 被测物体最近的深度比其屏幕范围内遮挡物最远的深度还远时, 视为被完全遮挡
+    // 完全在 CPU 上运行, 不依赖任何图形设备
+    class OcclusionCuller
+    {
+    public:
+        // 宽度会补齐到 4 的倍数
+        OcclusionCuller(int width = 256, int height = 128);
+
+        // 清空深度, viewProj 为行向量约定的 view * proj, 深度范围为 [0, 1]
+        void Begin(const DirectX::XMFLOAT4X4& viewProj);
+        // 光栅化一个遮挡物, 顶点从 vertices 开始按 stride 字节读取位置
+        // 顺时针为正面, 背面和穿过近平面的三角形被跳过
+        void AddOccluder(const void* vertices, std::size_t stride, const std::uint16_t* indices,
+                         std::size_t indexCount, const DirectX::XMFLOAT4X4& world);
+        void AddOccluder(const void* vertices, std::size_t stride, const std::uint32_t* indices,
+                         std::size_t indexCount, const DirectX::XMFLOAT4X4& world);
+        // 所有遮挡物提交完毕, 生成层级深度
+        void End();
+
+        // 世界空间包围盒是否可能可见, 穿过近平面时总是可见
+        bool IsVisible(const DirectX::BoundingBox& box) const;
+        // 从 indices 中挑出可能可见的编号, 返回数量
+        std::size_t Filter(const DirectX::BoundingBox* boxes, const std::uint32_t* indices, std::size_t count,
+                           std::uint32_t* visible) const;
+
+        int Width() const;
+        int Height() const;
+        // 第 0 层为完整分辨率, 每行 Width() 个深度
+        const float* Depth(int level = 0) const;
+        int LevelCount() const;
+        // 自上次 Begin 以来光栅化的三角形数
+        std::uint64_t TrianglesRasterized() const;
+        // 深度缓冲区内容的哈希, 用于与预先保存的结果比对
+        std::uint64_t DepthHash() const;
+
+    private:
+        template <typename Index>
+        void Rasterize(const void* vertices, std::size_t stride, const Index* indices,
+                       std::size_t indexCount, const DirectX::XMFLOAT4X4& world);
+        // 三个屏幕空间顶点 (x, y, z)
+        void RasterizeTriangle(const float* v0, const float* v1, const float* v2);
+
+        int m_Width = 0;
+        int m_Height = 0;
+        float m_ViewProj[4][4] = {};
+        // 每层的尺寸和深度, 每个像素保存遮挡物最远的深度
+        std::vector<int> m_LevelWidth;
+        std::vector<int> m_LevelHeight;
+        std::vector<std::vector<float>> m_Levels;
+        std::uint64_t m_Triangles = 0;
+    };
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace RainDX
+{
+    struct ShaderDefine
+    {
+        std::string Name;
+        std::string Value;
+    };
+
+    // 一次编译的全部输入
+    struct ShaderRequest
+    {
+        std::wstring Path;
+        std::string EntryPoint;
+        std::string Target;
+        std::vector<ShaderDefine> Defines;
+        std::uint32_t Flags = 0;
+    };
+
+    // 内容寻址的键
+    // Text 记录编译器, 入口, 目标, 标志, 宏以及每个源文件的路径和内容哈希, 加载时逐字核对以排除哈希碰撞
+    struct ShaderKey
+    {
+        std::uint64_t Hash = 0;
+        std::string Text;
+        // 主文件和递归展开的 include, 按首次出现的顺序
+        std::vector<std::wstring> Files;
+    };
+
+    struct ShaderCacheStats
+    {
+        std::size_t Hits = 0;
+        std::size_t Misses = 0;
+        // 写入失败时少于 Misses
+        std::size_t Stores = 0;
+    };
+
+    // 磁盘上的着色器字节码缓存
+    // 键由编译器版本, 源文件及其 include 的内容, 宏, 入口, 目标和编译标志计算, 任何一项变化都会落到新的条目
+    // 编译器和文件读取都由外部传入, 缓存本身不依赖 D3D, 可以多线程同时使用
+    class ShaderCache
+    {
+    public:
+        // 读取源文件, 文件不存在时返回 false
+        using SourceReader = std::function<bool(const std::wstring& path, std::string& contents)>;
+        // 编译失败时抛出异常
+        using Compiler = std::function<std::vector<char>(const ShaderRequest& request)>;
+
+        // compiler 标识编译器及其版本, 参与每个键的计算, 换用编译器后旧条目不再命中
+        explicit ShaderCache(const std::wstring& directory, std::string compiler = std::string(),
+                             SourceReader reader = ReadSource);
+
+        // include 按包含它的文件所在的目录解析, 与 D3D_COMPILE_STANDARD_FILE_INCLUDE 一致
+        // 找不到的 include 以名字参与哈希, 之后创建该文件同样会使键改变
+        ShaderKey ComputeKey(const ShaderRequest& request) const;
+
+        // 条目不存在, 已损坏或与键不符时返回 false
+        bool Load(const ShaderKey& key, std::vector<char>& bytecode) const;
+        // 先写临时文件再改名, 读取方不会看到写了一半的条目, 写入失败时返回 false
+        bool Store(const ShaderKey& key, const void* bytecode, std::size_t size);
+
+        // 命中时直接返回缓存的字节码, 否则调用 compile 并写回缓存
+        std::vector<char> GetOrCompile(const ShaderRequest& request, const Compiler& compile);
+        // key 必须是 ComputeKey(request) 的结果, 调用者需要记录键时避免重复计算
+        std::vector<char> GetOrCompile(const ShaderKey& key, const ShaderRequest& request, const Compiler& compile);
+
+        std::wstring EntryPath(const ShaderKey& key) const;
+        ShaderCacheStats Stats() const;
+
+        static bool ReadSource(const std::wstring& path, std::string& contents);
+        // 64 位 FNV-1a
+        static std::uint64_t Hash(const void* data, std::size_t size, std::uint64_t seed = 14695981039346656037ull);
+
+    private:
+        std::wstring m_Directory;
+        std::string m_Compiler;
+        SourceReader m_Reader;
+        std::atomic<std::size_t> m_Hits{0};
+        std::atomic<std::size_t> m_Misses{0};
+        std::atomic<std::size_t> m_Stores{0};
+        // 临时文件的序号, 同一进程中的并发写入互不冲突
+        std::atomic<std::uint32_t> m_TempCounter{0};
+    };
+}
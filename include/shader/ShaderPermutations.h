@@ -0,0 +1,130 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "shader/ShaderCache.h"
+
+namespace RainDX
+{
+    class JobSystem;
+
+    // 清单中的一个入口, 关键字的每种组合各编译一次
+    struct PermutationShader
+    {
+        // 相对于清单所在的目录
+        std::string File;
+        std::string EntryPoint;
+        std::string Target;
+        // 第 i 个关键字对应排列掩码的第 i 位, 置位时定义为 1
+        std::vector<std::string> Keywords;
+
+        // 在排列包中查找时使用的名字, 如 color.hlsl:VS
+        std::string Name() const { return File + ":" + EntryPoint; }
+    };
+
+    // 排列清单
+    // 每行一个入口: 文件 入口 目标 关键字..., # 之后为注释
+    class PermutationManifest
+    {
+    public:
+        // 每个入口最多 2^MaxKeywords 个排列
+        static constexpr std::size_t MaxKeywords = 8;
+
+        // 格式错误时返回 false, error 不为空时写入出错的行号和原因
+        static bool Parse(const std::string& text, std::vector<PermutationShader>& shaders, std::string* error = nullptr);
+        static bool Load(const std::wstring& path, std::vector<PermutationShader>& shaders, std::string* error = nullptr);
+    };
+
+    struct ShaderBytecodeView
+    {
+        const void* Data = nullptr;
+        std::size_t Size = 0;
+    };
+
+    // 排列包: 所有入口的全部排列的字节码
+    // 每个入口的排列在表中连续存放, 按掩码直接索引, 运行时查找是 O(1)
+    class ShaderArchive
+    {
+    public:
+        static constexpr std::uint32_t InvalidShader = 0xffffffffu;
+
+        // 追加一个入口并为 2^keywords 个排列预留位置, 返回入口的编号
+        std::uint32_t AddShader(const std::string& name, const std::vector<std::string>& keywords);
+        // key 为编译该排列时的 ShaderKey::Hash, 为 0 时加载时的校验总是失败
+        void SetPermutation(std::uint32_t shader, std::uint32_t mask, const void* data, std::size_t size,
+                            std::uint64_t key = 0);
+
+        // 找不到时返回 InvalidShader, 应在初始化时查好编号
+        std::uint32_t Find(const std::string& name) const;
+        // 关键字对应的位, 入口没有该关键字时返回 0
+        std::uint32_t KeywordMask(std::uint32_t shader, const std::string& keyword) const;
+        // 掩码中超出入口关键字数的位被忽略
+        ShaderBytecodeView Get(std::uint32_t shader, std::uint32_t mask) const;
+
+        std::size_t ShaderCount() const;
+        std::size_t PermutationCount() const;
+        std::size_t BytecodeSize() const;
+
+        // 文件不存在, 已损坏或版本不符时返回 false, 原有内容保持不变
+        bool Load(const std::wstring& path);
+        // 同时按清单用 cache 重新计算每个排列的键, 入口, 关键字或任何一个键与包中记录的不符时返回 false
+        // 着色器源文件, include, 编译标志或编译器改变后排列包即失效, 调用者应重新编译
+        bool Load(const std::wstring& path, const std::vector<PermutationShader>& shaders,
+                  const std::wstring& directory, std::uint32_t flags, const ShaderCache& cache);
+        // 先写临时文件再改名, 写入失败时返回 false
+        bool Save(const std::wstring& path) const;
+        void Clear();
+
+    private:
+        struct Shader
+        {
+            std::string Name;
+            std::vector<std::string> Keywords;
+            std::uint32_t FirstPermutation = 0;
+            std::uint32_t MaskBits = 0;
+        };
+
+        struct Permutation
+        {
+            std::uint64_t Offset = 0;
+            std::uint64_t Size = 0;
+            std::uint64_t Key = 0;
+        };
+
+        std::vector<Shader> m_Shaders;
+        std::unordered_map<std::string, std::uint32_t> m_Index;
+        std::vector<Permutation> m_Permutations;
+        // 所有排列的字节码首尾相接
+        std::vector<char> m_Data;
+    };
+
+    struct PermutationBuildStats
+    {
+        std::size_t Shaders = 0;
+        std::size_t Permutations = 0;
+        // 来自 cache 的排列数, 没有 cache 时为 0
+        std::size_t CacheHits = 0;
+        double Milliseconds = 0.0;
+    };
+
+    // 排列编译器
+    // 展开清单中每个入口的全部关键字组合, 在任务系统的所有线程上并行编译
+    // 结果按清单和掩码的顺序写入排列包, 与线程的调度无关
+    class PermutationCompiler
+    {
+    public:
+        // directory 为清单中文件路径的根目录, cache 可以为空, 此时排列包中不记录键
+        // 任何一个排列编译失败时, 等其余任务结束后在调用线程上重新抛出第一个异常, archive 不被修改
+        static PermutationBuildStats Build(
+            const std::vector<PermutationShader>& shaders, const std::wstring& directory, std::uint32_t flags,
+            const ShaderCache::Compiler& compile, ShaderCache* cache, JobSystem& jobs, ShaderArchive& archive);
+
+        // 掩码对应的宏, 按关键字的顺序
+        static std::vector<ShaderDefine> Defines(const PermutationShader& shader, std::uint32_t mask);
+        // 排列的编译请求, 编译和校验排列包使用同一份
+        static ShaderRequest Request(const PermutationShader& shader, std::uint32_t mask,
+                                     const std::wstring& directory, std::uint32_t flags);
+    };
+}
@@ -4,11 +4,32 @@
 // Transforms and colors geometry.
 //***************************************************************************************
 
-cbuffer cbPerObject : register(b0)
+// 每个实例的数据, 与 CPU 端 InstanceData 布局一致
+struct InstanceData
 {
-	float4x4 gWorldViewProj; 
+	float4x4 World;
+	float4 Color;
+};
+
+#ifdef ROOT_CONSTANTS
+// 单独绘制时每个物体的数据直接放在根常量中, 与 InstanceData 布局相同
+cbuffer cbPerObject : register(b1)
+{
+	float4x4 gWorld;
+	float4 gColor;
+};
+#else
+StructuredBuffer<InstanceData> gInstances : register(t0);
+#endif
+
+cbuffer cbPerPass : register(b0)
+{
+	float4x4 gViewProj; 
 	float4 gPulseColor;
+	// 位置按网格包围盒量化, 还原为 PosL * gPosScale + gPosBias
+	float3 gPosScale;
 	float gTime;
+	float3 gPosBias;
 };
 
 struct VertexIn
@@ -24,15 +45,30 @@ struct VertexOut
 };
 
 // 顶点着色器
-VertexOut VS(VertexIn vin)
+// 关键字见 permutations.txt, QUANTIZED_POSITION 时位置为量化后的值, ROOT_CONSTANTS 时不使用实例缓冲区
+// 实例缓冲区绑定时已偏移到本次绘制的第一个实例, SV_InstanceID 从 0 开始
+VertexOut VS(VertexIn vin, uint instanceID : SV_InstanceID)
 {
 	VertexOut vout;
+#ifdef ROOT_CONSTANTS
+	InstanceData inst;
+	inst.World = gWorld;
+	inst.Color = gColor;
+#else
+	InstanceData inst = gInstances[instanceID];
+#endif
 	
 	// 齐次坐标变换
-	vout.PosH = mul(float4(vin.PosL, 1.0f), gWorldViewProj);
+#ifdef QUANTIZED_POSITION
+	float3 posL = vin.PosL * gPosScale + gPosBias;
+#else
+	float3 posL = vin.PosL;
+#endif
+	float4 posW = mul(float4(posL, 1.0f), inst.World);
+	vout.PosH = mul(posW, gViewProj);
 	
-	// 颜色不变
-    vout.Color = vin.Color;
+	// 顶点颜色乘以实例颜色
+    vout.Color = vin.Color * inst.Color;
     
     return vout;
 }
@@ -10,8 +10,12 @@ MsgProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
     return RainDX::Application::GetApplication()->MsgHandler(hwnd, msg, wParam, lParam);
 }
 
-RainDX::Application::Application(HINSTANCE instance) : m_Inst(instance)
+RainDX::Application::Application(HINSTANCE instance, std::unique_ptr<RenderDevice> device) :
+    m_Inst(instance), m_Render(std::move(device))
 {
+    m_Headless = m_Render != nullptr;
+    m_Jobs = std::make_unique<JobSystem>();
+    RAINDX_PROFILE_THREAD("Main");
     assert(m_App == nullptr);
     m_App = this;
 }
@@ -22,8 +26,16 @@ RainDX::Application::~Application()
 
 bool RainDX::Application::Init()
 {
-    if (!InitWnd()) return false;
-    if (!InitDirectX()) return false;
+    RAINDX_PROFILE_FUNCTION();
+    if (m_Headless)
+    {
+        if (!InitHeadless()) return false;
+    }
+    else
+    {
+        if (!InitWnd()) return false;
+        if (!InitDirectX()) return false;
+    }
 
     OnResize();
 
@@ -44,8 +56,11 @@ bool RainDX::Application::Run()
         }
         else
         {
+            RAINDX_PROFILE_FRAME();
+            RAINDX_PROFILE_SCOPE("Frame");
             m_Timer.Tick();
-            FrameRate();
+            UpdateTitle();
+            Simulate();
             Update();
             Draw();
         }
@@ -54,30 +69,74 @@ bool RainDX::Application::Run()
     return true;
 }
 
-void RainDX::Application::FrameRate() const
+bool RainDX::Application::RunFrames(int frameCount)
 {
-    // 每秒帧数
-    static int frameCnt = 0;
-    static float timeElapsed = 0.0f;
+    m_Timer.Reset();
 
-    ++frameCnt;
+    for (int i = 0; i < frameCount; ++i)
+    {
+        RAINDX_PROFILE_FRAME();
+        RAINDX_PROFILE_SCOPE("Frame");
+        m_Timer.Tick();
+        Simulate();
+        Update();
+        Draw();
+    }
 
-    // Compute averages over one second period.
-    if ((m_Timer.TotalTime() - timeElapsed) >= 1.0f)
+    return true;
+}
+
+void RainDX::Application::Simulate()
+{
+    RAINDX_PROFILE_FUNCTION();
+    int steps = m_Timestep.Advance(m_Timer.DeltaTime());
+    float dt = static_cast<float>(m_Timestep.Step());
+    for (int i = 0; i < steps; ++i)
+        FixedUpdate(dt);
+}
+
+void RainDX::Application::UpdateTitle()
+{
+    ++m_TitleFrames;
+
+    float elapsed = m_Timer.TotalTime() - m_TitleTime;
+    if (elapsed < 1.0f)
+        return;
+
+    float fps = m_TitleFrames / elapsed;
+    float tpf = 1000.0f / fps;
+    FrameSummary frames = m_Timer.Stats().Summarize();
+
+    std::wstring windowText = m_Title +
+        L"    fps: " + std::to_wstring(fps) +
+        L"    tpf: " + std::to_wstring(tpf) + L" ms" +
+        L"    p50: " + std::to_wstring(frames.P50Ms) +
+        L"    p99: " + std::to_wstring(frames.P99Ms) +
+        L"    1% low: " + std::to_wstring(frames.OnePercentLowFps) + L" fps" +
+        L"    hitches: " + std::to_wstring(frames.Hitches);
+    if (Profiler::IsCapturing())
+        windowText += L"    [profiling]";
+    SetWindowText(m_Wnd, windowText.c_str());
+
+    m_TitleFrames = 0;
+    m_TitleTime = m_Timer.TotalTime();
+}
+
+void RainDX::Application::ToggleProfileCapture()
+{
+    if (!Profiler::IsCapturing())
     {
-        float fps = static_cast<float>(frameCnt); // fps = frameCnt / 1
-        float tpf = 1000.0f / fps;
-
-        std::wstring fpsStr = std::to_wstring(fps);
-        std::wstring tpfStr = std::to_wstring(tpf);
-        std::wstring windowText = m_Title +
-            L"    fps: " + fpsStr +
-            L"    tpf: " + tpfStr + L" ms";
-        SetWindowText(m_Wnd, windowText.c_str());
-
-        frameCnt = 0;
-        timeElapsed += 1.0f;
+        Profiler::BeginCapture();
+        return;
     }
+
+    Profiler::EndCapture();
+    Profiler::WriteChromeTrace(m_ProfilePath);
+}
+
+void RainDX::Application::DumpFrameTimes()
+{
+    m_Timer.Stats().WriteCsv(m_FrameTimePath);
 }
 
 
@@ -142,6 +201,26 @@ float RainDX::Application::AspectRatio() const
     return static_cast<float>(m_Width) / m_Height;
 }
 
+bool RainDX::Application::IsHeadless() const
+{
+    return m_Headless;
+}
+
+const RainDX::FrameStats& RainDX::Application::FrameTimes() const
+{
+    return m_Timer.Stats();
+}
+
+const RainDX::FixedTimestep& RainDX::Application::Timestep() const
+{
+    return m_Timestep;
+}
+
+float RainDX::Application::StepAlpha() const
+{
+    return static_cast<float>(m_Timestep.Alpha());
+}
+
 ID3D12Resource* RainDX::Application::CurBuf() const
 {
     return m_SwapBuf[m_CurBufIndex].Get();
@@ -149,15 +228,12 @@ ID3D12Resource* RainDX::Application::CurBuf() const
 
 D3D12_CPU_DESCRIPTOR_HANDLE RainDX::Application::CurBufView() const
 {
-    return CD3DX12_CPU_DESCRIPTOR_HANDLE(
-        m_RtvHeap->GetCPUDescriptorHandleForHeapStart(),
-        m_CurBufIndex,
-        m_RtvSize);
+    return m_SwapBufView[m_CurBufIndex];
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE RainDX::Application::DepthView() const
 {
-    return m_DsvHeap->GetCPUDescriptorHandleForHeapStart();
+    return m_DepthBufView;
 }
 
 RainDX::Application* RainDX::Application::GetApplication()
@@ -294,6 +370,12 @@ LRESULT RainDX::Application::MsgHandler(HWND wnd, UINT msg, WPARAM wParam, LPARA
         }
         else if (static_cast<int>(wParam) == VK_F2)
             m_4xMsaaState = !m_4xMsaaState;
+        else if (static_cast<int>(wParam) == VK_F3)
+            ToggleProfileCapture();
+        else if (static_cast<int>(wParam) == VK_F4)
+            DumpFrameTimes();
+        else
+            OnKeyUp(wParam);
 
         return 0;
     }
@@ -1,12 +1,24 @@
 #include "app/Application.h"
 #include <cassert>
 #include "d3d/DxException.h"
+#include "render/D3D12RenderDevice.h"
 
 using Microsoft::WRL::ComPtr;
 
+// 批量上传的暂存环大小
+static constexpr UINT64 UploadArenaSize = 4 * 1024 * 1024;
+// 上传堆每块的大小, 放下上传器的暂存环和每帧的上传环
+static constexpr UINT64 UploadHeapSize = 16 * 1024 * 1024;
+// 着色器可见描述符环的大小, 能放下若干帧的全部描述符表
+static constexpr UINT ShaderVisibleDescriptors = 16384;
+// 暂存堆每页的描述符数, 渲染目标和深度模板视图很少, 用小页
+static constexpr UINT StagingPageSize = 256;
+static constexpr UINT TargetPageSize = 16;
+
 // 初始化 DirectX 相关设置
 bool RainDX::Application::InitDirectX()
 {
+    RAINDX_PROFILE_FUNCTION();
 #if defined(DEBUG) || defined(_DEBUG)
     // Enable the D3D12 debug layer.
     {
@@ -24,41 +36,42 @@ bool RainDX::Application::InitDirectX()
     return true;
 }
 
-// 初始化 Rtv 和 Dsv
-void RainDX::Application::CreateRtvAndDsv()
+// 无窗口初始化, 只使用构造时传入的后端
+bool RainDX::Application::InitHeadless()
 {
-    m_RtvSize = m_Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-    m_DsvSize = m_Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
-    // 以及常量缓冲区视图 / 着色器资源视图 / 无序访问视图（CBV/SRV/UAV）
-    m_CbvSrvUavSize = m_Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    RAINDX_PROFILE_FUNCTION();
+    assert(m_Render);
 
-    // RtvHeap
-    {
-        D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc;
-        rtvHeapDesc.NumDescriptors = m_SwapBufCount;
-        rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-        rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-        // 该描述符堆关联到GPU, 在单GPU系统中, 通常将其设置为 0
-        rtvHeapDesc.NodeMask = 0;
-        ThrowIfFailed(m_Device->
-            CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(m_RtvHeap.GetAddressOf())))
-    }
+    CreateCmd();
+    CreateRtvAndDsv();
 
-    // DsvHeap
-    {
-        D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc;
-        dsvHeapDesc.NumDescriptors = 1;
-        dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
-        dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-        dsvHeapDesc.NodeMask = 0;
-        ThrowIfFailed(m_Device->
-            CreateDescriptorHeap(&dsvHeapDesc, IID_PPV_ARGS(m_DsvHeap.GetAddressOf())))
-    }
+    return true;
+}
+
+// 初始化描述符堆, 以及 Rtv 和 Dsv
+void RainDX::Application::CreateRtvAndDsv()
+{
+    RAINDX_PROFILE_FUNCTION();
+    // CPU 暂存堆按需增长
+    m_RtvHeap = std::make_unique<DescriptorStagingHeap>(m_Render.get(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV, TargetPageSize);
+    m_DsvHeap = std::make_unique<DescriptorStagingHeap>(m_Render.get(), D3D12_DESCRIPTOR_HEAP_TYPE_DSV, TargetPageSize);
+    // 以及常量缓冲区视图 / 着色器资源视图 / 无序访问视图（CBV/SRV/UAV）
+    m_CbvSrvUavHeap = std::make_unique<DescriptorStagingHeap>(
+        m_Render.get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, StagingPageSize);
+    // 同一时刻只能绑定一个着色器可见的 CBV/SRV/UAV 堆, 所有绘制共用这个环
+    m_Descriptors = std::make_unique<DescriptorRing>(
+        m_Render.get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, ShaderVisibleDescriptors);
+
+    // 视图的位置固定, OnResize 在原处重建
+    for (int i = 0; i < m_SwapBufCount; ++i)
+        m_SwapBufView[i] = m_RtvHeap->Allocate();
+    m_DepthBufView = m_DsvHeap->Allocate();
 }
 
 // 初始化 GPU 设备信息
 void RainDX::Application::CreateDevice()
 {
+    RAINDX_PROFILE_FUNCTION();
     // 获取 DXGI 工厂
     ThrowIfFailed(CreateDXGIFactory1(IID_PPV_ARGS(&m_Factory)))
 
@@ -88,39 +101,36 @@ void RainDX::Application::CreateDevice()
 // 初始化命令相关设置
 void RainDX::Application::CreateCmd()
 {
-    // 初始化命令队列
+    RAINDX_PROFILE_FUNCTION();
+    // 初始化命令队列, 无窗口时后端已在构造时传入
+    if (!m_Headless)
     {
         D3D12_COMMAND_QUEUE_DESC queueDesc = {};
         queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
         queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
         ThrowIfFailed(m_Device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_CmdQueue)))
+        m_Render = std::make_unique<D3D12RenderDevice>(m_Device.Get(), m_CmdQueue.Get(), m_Fence.Get());
     }
 
 
     // 初始化命令分配器
-    {
-        ThrowIfFailed(m_Device->
-            CreateCommandAllocator(
-                D3D12_COMMAND_LIST_TYPE_DIRECT,
-                IID_PPV_ARGS(m_CmdAlloc.GetAddressOf())))
-    }
+    m_CmdAlloc = m_Render->CreateCmdAlloc();
 
 
-    // 初始化命令列表
-    {
-        ThrowIfFailed(m_Device->
-            CreateCommandList(
-                0, D3D12_COMMAND_LIST_TYPE_DIRECT,
-                m_CmdAlloc.Get(), nullptr,
-                IID_PPV_ARGS(m_CmdList.GetAddressOf())))
-    }
+    // 初始化命令列表, 创建后处于关闭状态
+    m_CmdList = m_Render->CreateCmdList(m_CmdAlloc.Get());
 
-    m_CmdList->Close();
+    m_BufferHeap = std::make_unique<HeapAllocator>(m_Render.get(), D3D12_HEAP_TYPE_DEFAULT,
+                                                   D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS);
+    m_UploadHeap = std::make_unique<HeapAllocator>(m_Render.get(), D3D12_HEAP_TYPE_UPLOAD,
+                                                   D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS, UploadHeapSize);
+    m_Uploader = std::make_unique<UploadBatcher>(m_Render.get(), UploadArenaSize, m_UploadHeap.get());
 }
 
 // 初始化交换链
 void RainDX::Application::CreateSwapChain()
 {
+    RAINDX_PROFILE_FUNCTION();
     m_Swap.Reset();
 
     DXGI_SWAP_CHAIN_DESC swapDesc;
@@ -176,43 +186,52 @@ void RainDX::Application::CheckMsaa()
 // 清空命令队列
 void RainDX::Application::ClearCmdQueue()
 {
-    // 同步，等待之前的命令执行完毕
-    m_CurFence++;
-
-    // Add an instruction to the command queue to set a new fence point.  Because we 
-    // are on the GPU timeline, the new fence point won't be set until the GPU finishes
-    // processing all the commands prior to this Signal().
-    ThrowIfFailed(m_CmdQueue->Signal(m_Fence.Get(), m_CurFence))
-
-    // Wait until the GPU has completed commands up to this fence point.
-    if (m_Fence->GetCompletedValue() < m_CurFence)
-    {
-        // 事件对象是一种同步原语，可用于线程间或进程间的同步。
-        HANDLE eventHandle = CreateEventEx(nullptr, nullptr, false, EVENT_ALL_ACCESS);
-
-        // 当 GPU 完成到 mCurrentFence 这个围栏点的命令时，触发指定的事件对象。
-        ThrowIfFailed(m_Fence->SetEventOnCompletion(m_CurFence, eventHandle))
+    RAINDX_PROFILE_FUNCTION();
+    // 插入新的围栏点并等待 GPU 执行到该点, 即等待之前的命令全部执行完毕
+    m_Render->Fence()->Flush();
+}
 
-        // 用于等待指定的事件对象被触发
-        WaitForSingleObject(eventHandle, INFINITE);
-        CloseHandle(eventHandle);
-    }
+// 呈现并切换后台缓冲区
+void RainDX::Application::Present()
+{
+    RAINDX_PROFILE_FUNCTION();
+    // 无窗口时没有交换链
+    if (m_Swap != nullptr)
+        ThrowIfFailed(m_Swap->Present(0, 0))
+    m_CurBufIndex = (m_CurBufIndex + 1) % m_SwapBufCount;
 }
 
 
 // 事件函数：改变窗口大小
 void RainDX::Application::OnResize()
 {
+    RAINDX_PROFILE_FUNCTION();
+    assert(m_Render);
+    assert(m_CmdAlloc);
+
+    // 更新屏幕大小和裁剪矩阵
+    {
+        m_ScreenView.TopLeftX = 0;
+        m_ScreenView.TopLeftY = 0;
+        m_ScreenView.Width = static_cast<float>(m_Width);
+        m_ScreenView.Height = static_cast<float>(m_Height);
+        m_ScreenView.MinDepth = 0.0f;
+        m_ScreenView.MaxDepth = 1.0f;
+        m_ScissorRect = {0, 0, m_Width, m_Height};
+    }
+
+    // 无窗口时没有交换链和深度模板缓冲区
+    if (m_Headless)
+        return;
     assert(m_Device);
     assert(m_Swap);
-    assert(m_CmdAlloc);
 
     // 清空命令
     {
         // 清空命令队列
         ClearCmdQueue();
         // 清空命令列表
-        ThrowIfFailed(m_CmdList->Reset(m_CmdAlloc.Get(), nullptr))
+        m_CmdList->Reset(m_CmdAlloc.Get(), nullptr);
     }
 
     // 重置后台缓冲区和描述符的大小
@@ -230,13 +249,10 @@ void RainDX::Application::OnResize()
         m_CurBufIndex = 0;
 
         // 更新 Rtv
-        CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHeapHandle(m_RtvHeap->GetCPUDescriptorHandleForHeapStart());
         for (UINT i = 0; i < m_SwapBufCount; i++)
         {
             ThrowIfFailed(m_Swap->GetBuffer(i, IID_PPV_ARGS(&m_SwapBuf[i])))
-            m_Device->CreateRenderTargetView(m_SwapBuf[i].Get(), nullptr, rtvHeapHandle);
-            // ++rtvHandle, 指向下一个 Rtv
-            rtvHeapHandle.Offset(1, m_RtvSize);
+            m_Device->CreateRenderTargetView(m_SwapBuf[i].Get(), nullptr, m_SwapBufView[i]);
         }
     }
 
@@ -296,23 +312,16 @@ void RainDX::Application::OnResize()
     // 执行重置命令
     {
         // 执行 resize 命令
-        ThrowIfFailed(m_CmdList->Close())
-        ID3D12CommandList* cmdsLists[] = {m_CmdList.Get()};
-        m_CmdQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
+        m_CmdList->Close();
+        RenderCmdList* cmdsLists[] = {m_CmdList.get()};
+        m_Render->Execute(_countof(cmdsLists), cmdsLists);
         // 等待完成
         ClearCmdQueue();
     }
+}
 
-    // 更新屏幕大小和裁剪矩阵
-    {
-        m_ScreenView.TopLeftX = 0;
-        m_ScreenView.TopLeftY = 0;
-        m_ScreenView.Width = static_cast<float>(m_Width);
-        m_ScreenView.Height = static_cast<float>(m_Height);
-        m_ScreenView.MinDepth = 0.0f;
-        m_ScreenView.MaxDepth = 1.0f;
-        m_ScissorRect = {0, 0, m_Width, m_Height};
-    }
+void RainDX::Application::FixedUpdate(float dt)
+{
 }
 
 void RainDX::Application::OnMouseDown(WPARAM btnState, int x, int y)
@@ -326,3 +335,7 @@ void RainDX::Application::OnMouseUp(WPARAM btnState, int x, int y)
 void RainDX::Application::OnMouseMove(WPARAM btnState, int x, int y)
 {
 }
+
+void RainDX::Application::OnKeyUp(WPARAM key)
+{
+}
@@ -1,5 +1,9 @@
 ﻿#include "app/BoxApplication.h"
+#include <algorithm>
 #include <array>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
 #include <d3dcompiler.h>
 #include <DirectXColors.h>
 
@@ -8,33 +12,76 @@
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
 
-RainDX::BoxApplication::BoxApplication(HINSTANCE hInstance) : Application(hInstance)
+// 上传环大小, 足够容纳 gNumFrameResources 帧的常量数据
+static constexpr UINT64 UploadRingSize = 1024 * 1024;
+// 每个工作线程命令列表录制的绘制数
+static constexpr std::size_t DrawsPerList = 1024;
+// 实例化时每次绘制的实例数, 每段命令列表只有一次绘制
+static constexpr std::size_t InstancesPerDraw = 16384;
+// 每个工作任务复制的实例数
+static constexpr std::size_t InstancesPerCopy = 4096;
+// 每帧光栅化的遮挡物数量
+static constexpr std::size_t MaxOccluders = 256;
+// 每个工作任务做遮挡测试的实例数
+static constexpr std::size_t InstancesPerOcclusionTest = 2048;
+// 每个工作任务选择 LOD 的实例数
+static constexpr std::size_t InstancesPerLodSelect = 4096;
+// 根参数: 每帧常量的描述符表, 以及实例缓冲区的根描述符或单个物体的根常量
+static constexpr UINT RootPassTable = 0;
+static constexpr UINT RootPerDraw = 1;
+static constexpr UINT ObjectConstantCount = sizeof(RainDX::InstanceData) / 4;
+
+RainDX::BoxApplication::BoxApplication(HINSTANCE hInstance, std::unique_ptr<RenderDevice> device) :
+    Application(hInstance, std::move(device))
 {
 }
 
 RainDX::BoxApplication::~BoxApplication()
 {
+    // 帧资源可能仍被 GPU 使用
+    if (m_Render != nullptr)
+        ClearCmdQueue();
+
+    // 本次新建的 PSO 写回管线库, 下次启动时不再编译
+    if (m_Pipelines != nullptr)
+        m_Pipelines->Save();
+
+    if (m_BufferHeap != nullptr)
+    {
+        m_BufferHeap->Free(m_VertexAlloc);
+        m_BufferHeap->Free(m_IndexAlloc);
+    }
 }
 
 bool RainDX::BoxApplication::Init()
 {
+    RAINDX_PROFILE_FUNCTION();
     if (!Application::Init())
         return false;
 
     // 重置命令列表
-    ThrowIfFailed(m_CmdList->Reset(m_CmdAlloc.Get(), nullptr));
+    m_CmdList->Reset(m_CmdAlloc.Get(), nullptr);
     
-    CreateCbv();
+    // PSO 在后台创建, 与下面的几何处理重叠
     CreateRootSign();
     BuildShadersAndInputLayout();
-    BuildBoxGeometry();
     BuildPso();
+    BuildBoxGeometry();
+    BuildInstances();
+    CreateCbv();
+
+    // 上传批次先于初始化命令提交
+    m_Uploader->Submit();
+
+    // 没有实体 PSO 就无法绘制, 第一帧之前等它完成, 线框 PSO 继续在后台创建, 完成前用实体 PSO 代替
+    if (m_Pipelines != nullptr)
+        m_Pipelines->Wait(m_SolidPso);
 
     // 执行完毕
     {
-        ThrowIfFailed(m_CmdList->Close());
-        ID3D12CommandList* cmdsLists[] = {m_CmdList.Get()};
-        m_CmdQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
+        m_CmdList->Close();
+        RenderCmdList* cmdsLists[] = {m_CmdList.get()};
+        m_Render->Execute(_countof(cmdsLists), cmdsLists);
         ClearCmdQueue();
     }
 
@@ -43,6 +90,7 @@ bool RainDX::BoxApplication::Init()
 
 void RainDX::BoxApplication::OnResize()
 {
+    RAINDX_PROFILE_FUNCTION();
     Application::OnResize();
 
     // The window resized, so update the aspect ratio and recompute the projection matrix.
@@ -50,9 +98,17 @@ void RainDX::BoxApplication::OnResize()
     XMStoreFloat4x4(&m_Proj, P);
 }
 
+// 固定步长推进模拟状态
+void RainDX::BoxApplication::FixedUpdate(float dt)
+{
+    m_PrevSimTime = m_SimTime;
+    m_SimTime += dt;
+}
+
 // 每帧更新计算观察矩阵
 void RainDX::BoxApplication::Update()
 {
+    RAINDX_PROFILE_FUNCTION();
     // 从球坐标系转换到直角坐标系
     float x = m_Radius * sinf(m_Phi) * cosf(m_Theta);
     float z = m_Radius * sinf(m_Phi) * sinf(m_Theta);
@@ -65,86 +121,335 @@ void RainDX::BoxApplication::Update()
     XMMATRIX view = XMMatrixLookAtLH(pos, target, up);
     XMStoreFloat4x4(&m_View, view);
 
-    XMMATRIX world = XMLoadFloat4x4(&m_World);
     XMMATRIX proj = XMLoadFloat4x4(&m_Proj);
-    XMMATRIX worldViewProj = world * view * proj;
-
-    // 更新常量缓冲区的世界矩阵
-    ObjConst objConstants;
-    XMStoreFloat4x4(&objConstants.WorldViewProj, XMMatrixTranspose(worldViewProj));
-    objConstants.Time = m_Timer.TotalTime();
-    m_ConstBuf->CopyData(0, objConstants);
+    XMMATRIX viewProj = view * proj;
+
+    // 世界矩阵在实例数据中, 常量只包含观察投影矩阵
+    PassConst passConstants;
+    XMStoreFloat4x4(&passConstants.ViewProj, XMMatrixTranspose(viewProj));
+    // 模拟只走到上一个整步, 按剩余比例插值, 画面在任意帧率下都连续
+    passConstants.Time = MathHelper::Lerp(m_PrevSimTime, m_SimTime, StepAlpha());
+    passConstants.PosScale = m_PosDequant.Scale;
+    passConstants.PosBias = m_PosDequant.Bias;
+
+    // 进入下一帧资源, 仅当 GPU 落后一整圈时等待
+    m_FrameRing->Begin();
+    // 回收 GPU 已经读取完的常量数据和描述符
+    std::uint64_t completed = m_Render->Fence()->CompletedValue();
+    m_UploadRing->Retire(completed);
+    m_Descriptors->Retire(completed);
+
+    // 常量写入上传环, 当前帧的描述符在暂存堆中创建, 再复制到着色器可见的环中
+    UploadSlice slice = m_UploadRing->Push(passConstants);
+    D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc;
+    cbvDesc.BufferLocation = slice.Gpu;
+    cbvDesc.SizeInBytes = slice.Size;
+    D3D12_CPU_DESCRIPTOR_HANDLE passCbv = m_PassCbv[m_FrameRing->Index()];
+    m_Render->CreateConstantBufferView(cbvDesc, passCbv);
+    m_PassTable = m_Descriptors->Stage(&passCbv, 1);
+
+    // 视锥裁剪, 只有可见的实例写入实例缓冲区
+    XMFLOAT4X4 viewProjRows;
+    XMStoreFloat4x4(&viewProjRows, viewProj);
+    m_Culler.Cull(*m_Jobs, CullFrustum::FromViewProj(viewProjRows), m_Visible);
+    if (m_Occlusion)
+        CullOccluded(viewProjRows, XMFLOAT3(x, y, z));
+    SortByLod(XMFLOAT3(x, y, z));
+
+    // 单独绘制时每个盒子的数据在绘制时作为根常量写入, 不需要实例缓冲区
+    if (!m_Instancing)
+        return;
+
+    // 可见实例一次性写入上传环中连续的一段, 按块并行收集
+    UINT64 instanceBytes = (std::max)(m_Visible.size(), static_cast<std::size_t>(1)) * sizeof(InstanceData);
+    UploadSlice instances = m_UploadRing->Allocate(instanceBytes, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+    auto* dst = reinterpret_cast<InstanceData*>(instances.Cpu);
+    m_Jobs->ParallelFor(0, m_Visible.size(), InstancesPerCopy,
+        [this, dst](std::size_t first, std::size_t last)
+        {
+            for (std::size_t i = first; i < last; ++i)
+                dst[i] = m_Instances[m_Visible[i]];
+        });
+    m_InstanceGpu = instances.Gpu;
 }
 
 // 绘制指令
 void RainDX::BoxApplication::Draw()
 {
+    RAINDX_PROFILE_FUNCTION();
+    FrameResource& frame = m_FrameRing->Current();
+    // Update 中已确认 GPU 执行完该帧资源上一次的命令
+    frame.Lists.Reset();
+
+    // 提交顺序: 清空, 按对象顺序的各段绘制, 转为呈现状态
+    std::vector<RenderCmdList*> cmdsLists;
+    ID3D12PipelineState* pso = CurrentPso();
+
     // 清空
     {
-        ThrowIfFailed(m_CmdAlloc->Reset());
-        ThrowIfFailed(m_CmdList->Reset(m_CmdAlloc.Get(), m_Pso.Get()));
+        RenderCmdList* list = frame.Lists.Acquire(pso);
 
-        m_CmdList->RSSetViewports(1, &m_ScreenView);
-        m_CmdList->RSSetScissorRects(1, &m_ScissorRect);
-        
         auto br0 = CD3DX12_RESOURCE_BARRIER::Transition(
             CurBuf(),
             D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
-        m_CmdList->ResourceBarrier(1, &br0);
-    
-        m_CmdList->ClearRenderTargetView(CurBufView(), Colors::Wheat, 0, nullptr);
-        m_CmdList->ClearDepthStencilView(DepthView(),
-            D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0,nullptr);
+        list->ResourceBarrier(1, &br0);
+
+        list->ClearRenderTargetView(CurBufView(), Colors::Wheat);
+        list->ClearDepthStencilView(DepthView(),
+            D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0);
+        list->Close();
+        cmdsLists.push_back(list);
     }
-    
+
+    // 绘制分段交给工作线程录制
+    // 实例缓冲区按每次绘制的第一个实例偏移绑定, 着色器用 SV_InstanceID 索引
+    // 可见实例已按 LOD 分组, 一段跨越多个 LOD 时每个 LOD 各绘制一次
+    if (m_Instancing)
+    {
+        frame.Lists.Record(*m_Jobs, m_Visible.size(), InstancesPerDraw, pso,
+            [this](RenderCmdList& list, std::size_t first, std::size_t last)
+            {
+                SetDrawState(list);
+                for (std::size_t lod = 0; lod < m_BoxLodSubmeshes.size(); ++lod)
+                {
+                    std::size_t begin = (std::max)(first, m_LodFirst[lod]);
+                    std::size_t end = (std::min)(last, m_LodFirst[lod + 1]);
+                    if (begin >= end)
+                        continue;
+
+                    const SubmeshGeometry& submesh = m_BoxLodSubmeshes[lod];
+                    list.SetGraphicsRootShaderResourceView(RootPerDraw, m_InstanceGpu + begin * sizeof(InstanceData));
+                    list.DrawIndexedInstanced(submesh.IndexCount, static_cast<UINT>(end - begin),
+                        submesh.StartIndexLocation, submesh.BaseVertexLocation, 0);
+                }
+            },
+            cmdsLists);
+    }
+    else
+    {
+        frame.Lists.Record(*m_Jobs, m_Visible.size(), DrawsPerList, pso,
+            [this](RenderCmdList& list, std::size_t first, std::size_t last)
+            {
+                SetDrawState(list);
+                // 每个盒子的世界矩阵和颜色作为根常量写入命令列表, 不经过描述符和上传缓冲区
+                for (std::size_t lod = 0; lod < m_BoxLodSubmeshes.size(); ++lod)
+                {
+                    const SubmeshGeometry& submesh = m_BoxLodSubmeshes[lod];
+                    std::size_t end = (std::min)(last, m_LodFirst[lod + 1]);
+                    for (std::size_t i = (std::max)(first, m_LodFirst[lod]); i < end; ++i)
+                    {
+                        list.SetGraphicsRoot32BitConstants(RootPerDraw, ObjectConstantCount, &m_Instances[m_Visible[i]], 0);
+                        list.DrawIndexedInstanced(submesh.IndexCount, 1,
+                            submesh.StartIndexLocation, submesh.BaseVertexLocation, 0);
+                    }
+                }
+            },
+            cmdsLists);
+    }
+
+    // 转为呈现状态
+    {
+        RenderCmdList* list = frame.Lists.Acquire();
+        auto br1 = CD3DX12_RESOURCE_BARRIER::Transition(
+            CurBuf(),
+            D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
+        list->ResourceBarrier(1, &br1);
+        list->Close();
+        cmdsLists.push_back(list);
+    }
+
+    // 本帧暂存的描述符一次复制到环中, 必须在提交之前
+    m_Descriptors->Flush();
+    // 一次提交所有列表
+    m_Render->Execute(static_cast<UINT>(cmdsLists.size()), cmdsLists.data());
+
+    Present();
+
+    // 记录围栏值后直接进入下一帧, 不再等待 GPU 空闲
+    m_FrameRing->End();
+    m_UploadRing->FinishFrame(frame.Fence);
+    m_Descriptors->FinishFrame(frame.Fence);
+}
+
+void RainDX::BoxApplication::SetDrawCount(int drawCount)
+{
+    m_DrawCount = (std::max)(drawCount, 1);
+}
+
+void RainDX::BoxApplication::SetInstancing(bool instancing)
+{
+    m_Instancing = instancing;
+}
+
+void RainDX::BoxApplication::SetOcclusion(bool occlusion)
+{
+    m_Occlusion = occlusion;
+}
+
+void RainDX::BoxApplication::SetLod(bool lod)
+{
+    m_Lod = lod;
+}
+
+void RainDX::BoxApplication::SetCompactVertices(bool compact)
+{
+    m_VertexFormat = compact ? VertexFormat::CompactPositionColor() : VertexFormat::PositionColor();
+}
+
+UINT RainDX::BoxApplication::VertexStride() const
+{
+    return m_VertexFormat.Stride();
+}
+
+const RainDX::MeshOptimizeReport& RainDX::BoxApplication::MeshReport() const
+{
+    return m_MeshReport;
+}
+
+std::size_t RainDX::BoxApplication::LodCount() const
+{
+    return m_BoxLods.size();
+}
+
+void RainDX::BoxApplication::CullOccluded(const XMFLOAT4X4& viewProj, const XMFLOAT3& eye)
+{
+    RAINDX_PROFILE_FUNCTION();
+    // 盒子太少时遮挡物就是全部物体, 没有必要测试
+    if (m_Visible.size() <= MaxOccluders)
+        return;
+
+    // 按包围盒中心到相机的距离挑出最近的一批
+    auto distance = [this, &eye](std::uint32_t index)
+    {
+        const XMFLOAT3& c = m_Bounds[index].Center;
+        return (c.x - eye.x) * (c.x - eye.x) + (c.y - eye.y) * (c.y - eye.y) + (c.z - eye.z) * (c.z - eye.z);
+    };
+    std::vector<std::uint32_t> occluders(m_Visible);
+    std::nth_element(occluders.begin(), occluders.begin() + MaxOccluders, occluders.end(),
+        [&distance](std::uint32_t a, std::uint32_t b) { return distance(a) < distance(b); });
+    occluders.resize(MaxOccluders);
+
+    const SubmeshGeometry& submesh = m_BoxGeo->DrawArgs["box"];
+    const XMFLOAT3* vertices = m_BoxPositions.data() + submesh.BaseVertexLocation;
+    // 打包器按顶点数决定索引格式, 按子网格的格式解释索引缓冲区
+    const void* indexData = m_BoxGeo->IndexBufferCPU->GetBufferPointer();
+    const bool wide = m_BoxGeo->SubmeshIndexFormat(submesh) == DXGI_FORMAT_R32_UINT;
+    UINT indexCount = submesh.IndexCount;
+
+    m_Occluder.Begin(viewProj);
+    for (std::uint32_t index : occluders)
+    {
+        // 实例中保存的是转置后的世界矩阵
+        XMFLOAT4X4 world;
+        XMStoreFloat4x4(&world, XMMatrixTranspose(XMLoadFloat4x4(&m_Instances[index].World)));
+        if (wide)
+        {
+            m_Occluder.AddOccluder(vertices, sizeof(XMFLOAT3),
+                static_cast<const std::uint32_t*>(indexData) + submesh.StartIndexLocation, indexCount, world);
+        }
+        else
+        {
+            m_Occluder.AddOccluder(vertices, sizeof(XMFLOAT3),
+                static_cast<const std::uint16_t*>(indexData) + submesh.StartIndexLocation, indexCount, world);
+        }
+    }
+    m_Occluder.End();
+
+    // 并行测试, 再按原顺序压缩
+    m_Unoccluded.resize(m_Visible.size());
+    m_Jobs->ParallelFor(0, m_Visible.size(), InstancesPerOcclusionTest,
+        [this](std::size_t first, std::size_t last)
+        {
+            for (std::size_t i = first; i < last; ++i)
+                m_Unoccluded[i] = m_Occluder.IsVisible(m_Bounds[m_Visible[i]]) ? 1 : 0;
+        });
+
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < m_Visible.size(); ++i)
+    {
+        m_Visible[count] = m_Visible[i];
+        count += m_Unoccluded[i];
+    }
+    m_Visible.resize(count);
+}
+
+void RainDX::BoxApplication::SortByLod(const XMFLOAT3& eye)
+{
+    RAINDX_PROFILE_FUNCTION();
+    const std::size_t lodCount = m_BoxLodSubmeshes.size();
+    m_LodFirst.assign(lodCount + 1, m_Visible.size());
+    m_LodFirst[0] = 0;
+    if (!m_Lod || lodCount == 1)
+        return;
+    assert(lodCount <= MeshSimplifier::MaxLods);
+
+    // 单位距离处一个世界单位在屏幕上的像素数
+    const float pixelsPerUnit = 0.5f * m_Height * m_Proj(1, 1);
+    m_VisibleLod.resize(m_Visible.size());
+    m_Jobs->ParallelFor(0, m_Visible.size(), InstancesPerLodSelect,
+        [this, &eye, pixelsPerUnit](std::size_t first, std::size_t last)
+        {
+            for (std::size_t i = first; i < last; ++i)
+            {
+                // 到包围球表面的距离, 不小于近平面
+                const BoundingBox& bounds = m_Bounds[m_Visible[i]];
+                XMVECTOR center = XMLoadFloat3(&bounds.Center);
+                float distance = XMVectorGetX(XMVector3Length(center - XMLoadFloat3(&eye)))
+                    - XMVectorGetX(XMVector3Length(XMLoadFloat3(&bounds.Extents)));
+                m_VisibleLod[i] = static_cast<std::uint8_t>(MeshSimplifier::SelectLod(
+                    m_BoxLods.data(), m_BoxLods.size(), m_InstanceScale, (std::max)(distance, 1.0f), pixelsPerUnit));
+            }
+        });
+
+    // 计数排序, 同一 LOD 内保持原来的顺序
+    std::fill(m_LodFirst.begin(), m_LodFirst.end(), 0);
+    for (std::uint8_t lod : m_VisibleLod)
+        ++m_LodFirst[lod + 1];
+    for (std::size_t lod = 0; lod < lodCount; ++lod)
+        m_LodFirst[lod + 1] += m_LodFirst[lod];
+
+    m_LodSorted.resize(m_Visible.size());
+    std::array<std::size_t, MeshSimplifier::MaxLods> cursor;
+    std::copy(m_LodFirst.begin(), m_LodFirst.end() - 1, cursor.begin());
+    for (std::size_t i = 0; i < m_Visible.size(); ++i)
+        m_LodSorted[cursor[m_VisibleLod[i]]++] = m_Visible[i];
+    m_Visible.swap(m_LodSorted);
+}
+
+void RainDX::BoxApplication::SetDrawState(RenderCmdList& list) const
+{
+    list.RSSetViewports(1, &m_ScreenView);
+    list.RSSetScissorRects(1, &m_ScissorRect);
+
     auto cur = CurBufView();
     auto dept = DepthView();
-    m_CmdList->OMSetRenderTargets(1, &cur, true, &dept);
+    list.OMSetRenderTargets(1, &cur, true, &dept);
 
     // 设置描述符堆
-    ID3D12DescriptorHeap* descriptorHeaps[] = {m_CbvHeap.Get()};
-    m_CmdList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
+    ID3D12DescriptorHeap* descriptorHeaps[] = {m_Descriptors->Heap()};
+    list.SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
     // 设置根签名
-    m_CmdList->SetGraphicsRootSignature(m_RootSign.Get());
+    list.SetGraphicsRootSignature(m_RootSign.Get());
 
     auto vertex = m_BoxGeo->VertexBufferView();
-    auto index = m_BoxGeo->IndexBufferView();
+    // 索引格式随子网格而定, 所有 LOD 的格式相同, 在 BuildBoxGeometry 中检查
+    auto index = m_BoxGeo->IndexBufferView(m_BoxGeo->SubmeshIndexFormat(m_BoxLodSubmeshes.front()));
     // 设置顶点缓冲区
-    m_CmdList->IASetVertexBuffers(0, 1, &vertex);
+    list.IASetVertexBuffers(0, 1, &vertex);
     // 设置索引缓冲区
-    m_CmdList->IASetIndexBuffer(&index);
-    m_CmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    list.IASetIndexBuffer(&index);
+    list.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-    // 将第一个寄存器绑定到常量缓冲区
-    m_CmdList->SetGraphicsRootDescriptorTable(0, m_CbvHeap->GetGPUDescriptorHandleForHeapStart());
-    // 根据索引绘制物体
-    m_CmdList->DrawIndexedInstanced(
-        m_BoxGeo->DrawArgs["box"].IndexCount,
-        1, 0, 0, 0);
-
-    // 转为呈现状态
-    auto br1 = CD3DX12_RESOURCE_BARRIER::Transition(
-        CurBuf(),
-        D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-    m_CmdList->ResourceBarrier(1, &br1);
-
-    // 执行
-    {
-        ThrowIfFailed(m_CmdList->Close());
-        ID3D12CommandList* cmdsLists[] = {m_CmdList.Get()};
-        m_CmdQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
-    }
-
-    ThrowIfFailed(m_Swap->Present(0, 0));
-    m_CurBufIndex = (m_CurBufIndex + 1) % m_SwapBufCount;
-    
-    ClearCmdQueue();
+    // 将第一个寄存器绑定到当前帧的常量缓冲区
+    list.SetGraphicsRootDescriptorTable(RootPassTable, m_PassTable.Gpu);
 }
 
 void RainDX::BoxApplication::OnMouseDown(WPARAM btnState, int x, int y)
 {
     m_LastMousePos.x = x;
     m_LastMousePos.y = y;
+    m_MouseDownPos = m_LastMousePos;
+    m_MouseDownState = btnState;
 
     SetCapture(m_Wnd);
 }
@@ -152,6 +457,50 @@ void RainDX::BoxApplication::OnMouseDown(WPARAM btnState, int x, int y)
 void RainDX::BoxApplication::OnMouseUp(WPARAM btnState, int x, int y)
 {
     ReleaseCapture();
+
+    // 左键按下后几乎没有拖动, 视为点击
+    if ((m_MouseDownState & MK_LBUTTON) != 0 &&
+        std::abs(x - m_MouseDownPos.x) + std::abs(y - m_MouseDownPos.y) <= 2)
+        Pick(x, y);
+    m_MouseDownState = 0;
+}
+
+void RainDX::BoxApplication::Pick(int x, int y)
+{
+    RAINDX_PROFILE_FUNCTION();
+    // 观察空间中的射线方向
+    float vx = (+2.0f * x / m_Width - 1.0f) / m_Proj(0, 0);
+    float vy = (-2.0f * y / m_Height + 1.0f) / m_Proj(1, 1);
+
+    // 变换到世界空间
+    XMMATRIX view = XMLoadFloat4x4(&m_View);
+    XMVECTOR det = XMMatrixDeterminant(view);
+    XMMATRIX invView = XMMatrixInverse(&det, view);
+    XMFLOAT3 origin;
+    XMFLOAT3 direction;
+    XMStoreFloat3(&origin, XMVector3TransformCoord(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), invView));
+    XMStoreFloat3(&direction, XMVector3TransformNormal(XMVectorSet(vx, vy, 1.0f, 0.0f), invView));
+
+    // 恢复上一次选中的盒子
+    if (m_Picked >= 0)
+    {
+        m_Instances[m_Picked].Color = m_PickedColor;
+        m_Picked = -1;
+    }
+
+    BvhHit hit;
+    if (!m_Bvh.Raycast(origin, direction, MathHelper::Infinity, hit))
+        return;
+
+    m_Picked = static_cast<int>(hit.Index);
+    m_PickedColor = m_Instances[m_Picked].Color;
+    m_Instances[m_Picked].Color = XMFLOAT4(Colors::Gold);
+}
+
+void RainDX::BoxApplication::OnKeyUp(WPARAM key)
+{
+    if (static_cast<int>(key) == VK_F5)
+        m_Wireframe = !m_Wireframe;
 }
 
 void RainDX::BoxApplication::OnMouseMove(WPARAM btnState, int x, int y)
@@ -190,93 +539,106 @@ void RainDX::BoxApplication::OnMouseMove(WPARAM btnState, int x, int y)
 // 创建常量缓冲区
 void RainDX::BoxApplication::CreateCbv()
 {
-    // 创建常量缓冲区描述符堆
-    {
-        D3D12_DESCRIPTOR_HEAP_DESC cbvHeapDesc;
-        cbvHeapDesc.NumDescriptors = 1;
-        cbvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-        cbvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-        cbvHeapDesc.NodeMask = 0;
-        ThrowIfFailed(m_Device->CreateDescriptorHeap(&cbvHeapDesc, IID_PPV_ARGS(&m_CbvHeap)));
-    }
-
-    // 利用上传堆创建常量缓冲区
-    m_ConstBuf = std::make_unique<UploadBuffer<ObjConst>>(m_Device.Get(), 1, true);
-
-    // 创建常量描述符
-    {
-        // 常量缓冲区起始地址
-        D3D12_GPU_VIRTUAL_ADDRESS cbAddress = m_ConstBuf->Resource()->GetGPUVirtualAddress();
-        // 第一个物体的偏移量
-        int boxCBufIndex = 0;
-        UINT objCBByteSize = d3dUtil::ResizeConstBufSize(sizeof(ObjConst));
-        cbAddress += boxCBufIndex * objCBByteSize;
-
-        D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc;
-        cbvDesc.BufferLocation = cbAddress;
-        cbvDesc.SizeInBytes = d3dUtil::ResizeConstBufSize(sizeof(ObjConst));
-        // 创建常量描述符
-        m_Device->CreateConstantBufferView(
-            &cbvDesc,
-            m_CbvHeap->GetCPUDescriptorHandleForHeapStart());
-    }
-
+    RAINDX_PROFILE_FUNCTION();
+    // 每个帧资源在暂存堆中占一个常量缓冲区描述符
+    m_PassCbv.resize(gNumFrameResources);
+    for (D3D12_CPU_DESCRIPTOR_HANDLE& handle : m_PassCbv)
+        handle = m_CbvSrvUavHeap->Allocate();
+
+    // 每个帧资源独占命令分配器
+    m_FrameRing = std::make_unique<FrameRing<FrameResource>>(m_Render->Fence());
+    for (int i = 0; i < gNumFrameResources; ++i)
+        m_FrameRing->Add(std::make_unique<FrameResource>(m_Render.get()));
+
+    // 所有帧共用一个上传环, 常量描述符在每帧 Update 中写入
+    // 每帧还要放下全部实例数据, 多留一帧余量避免等待 GPU
+    UINT64 frameBytes = m_Instances.size() * sizeof(InstanceData) + 2 * D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+    UINT64 ringSize = (std::max)(UploadRingSize, frameBytes * (gNumFrameResources + 1));
+    m_UploadRing = std::make_unique<UploadRing>(m_Render.get(), ringSize, m_UploadHeap.get());
 }
 
 // 创建根签名
 void RainDX::BoxApplication::CreateRootSign()
 {
-    // 根参数数组
-    CD3DX12_ROOT_PARAMETER slotRootParameter[1];
-    // 描述符表
-    CD3DX12_DESCRIPTOR_RANGE cbvTable;
-    // 一个常量描述符，且对应于第一个基准寄存器
-    cbvTable.Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0);
-    // 作为第一个根参数
-    slotRootParameter[0].InitAsDescriptorTable(1, &cbvTable);
-
-    // 根签名描述
-    CD3DX12_ROOT_SIGNATURE_DESC rootSigDesc(1, slotRootParameter, 0, nullptr,
-                                            D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
-
-    // 序列化根签名
-    ComPtr<ID3DBlob> serializedRootSig = nullptr;
-    ComPtr<ID3DBlob> errorBlob = nullptr;
-    HRESULT hr = D3D12SerializeRootSignature(&rootSigDesc, D3D_ROOT_SIGNATURE_VERSION_1,
-                                             serializedRootSig.GetAddressOf(), errorBlob.GetAddressOf());
-
-    if (errorBlob != nullptr)
+    RAINDX_PROFILE_FUNCTION();
+    // 无 GPU 的后端不创建原生对象
+    if (IsHeadless())
+        return;
+
+    // 第一个根参数: 每帧常量的描述符表, 对应 b0
+    RootSignatureLayout layout;
+    layout.AddTable({CD3DX12_DESCRIPTOR_RANGE(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0)});
+    if (m_Instancing)
+    {
+        // 实例结构化缓冲区 t0, 根描述符可以在每次绘制前直接改变偏移
+        layout.AddSrv(0);
+    }
+    else
     {
-        OutputDebugStringA(static_cast<char*>(errorBlob->GetBufferPointer()));
+        // 单独绘制时每个盒子的数据作为根常量, 对应 b1
+        layout.AddConstants(ObjectConstantCount, 1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
     }
-    ThrowIfFailed(hr);
-
-    // 创建根签名
-    ThrowIfFailed(m_Device->CreateRootSignature(
-        0,
-        serializedRootSig->GetBufferPointer(),
-        serializedRootSig->GetBufferSize(),
-        IID_PPV_ARGS(&m_RootSign)));
+
+    // 相同布局的根签名只创建一次
+    m_RootSignatures = std::make_unique<RootSignatureRegistry>(m_Device.Get());
+    RootSignatureHandle root = m_RootSignatures->Get(layout);
+    m_RootSign = root.Signature;
+    m_RootSignHash = root.Hash;
 }
 
 // 编译着色器和输入布局
 void RainDX::BoxApplication::BuildShadersAndInputLayout()
 {
+    RAINDX_PROFILE_FUNCTION();
     HRESULT hr = S_OK;
 
-    m_VertexShader = d3dUtil::CompileShader(L"shaders\\color.hlsl", nullptr, "VS", "vs_5_0");
-    m_PixelShader = d3dUtil::CompileShader(L"shaders\\color.hlsl", nullptr, "PS", "ps_5_0");
-
-    m_InputLayout =
+    if (!IsHeadless())
     {
-        {"POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
-        {"COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0}
-    };
+        std::vector<PermutationShader> shaders;
+        std::string error;
+        if (!PermutationManifest::Load(L"shaders\\permutations.txt", shaders, &error))
+        {
+            OutputDebugStringA((error + "\n").c_str());
+            ThrowIfFailed(E_INVALIDARG);
+        }
+
+        // 优先读取 -buildshaders 生成的排列包, 每个排列的缓存键都要与当前的源文件, 标志和编译器一致
+        // 没有排列包或已过期时按清单在所有线程上编译, 源文件没有变化的排列直接取自缓存
+        const UINT compileFlags = d3dUtil::DefaultCompileFlags();
+        if (!m_Shaders.Load(L"shaders\\permutations.bin", shaders, L"shaders", compileFlags, m_ShaderCache))
+        {
+            PermutationCompiler::Build(shaders, L"shaders", compileFlags,
+                                       d3dUtil::CompileBytecode, &m_ShaderCache, *m_Jobs, m_Shaders);
+        }
+
+        const std::uint32_t vs = m_Shaders.Find("color.hlsl:VS");
+        const std::uint32_t ps = m_Shaders.Find("color.hlsl:PS");
+        if (vs == ShaderArchive::InvalidShader || ps == ShaderArchive::InvalidShader)
+            ThrowIfFailed(E_INVALIDARG);
+
+        // 量化的位置需要在着色器中还原, 浮点位置跳过这一步
+        std::uint32_t vsMask = 0;
+        const VertexElement* position = m_VertexFormat.Find(VertexAttribute::Position);
+        if (position != nullptr && position->Encoding != VertexEncoding::Float3)
+            vsMask |= m_Shaders.KeywordMask(vs, "QUANTIZED_POSITION");
+        // 单独绘制时物体数据来自根常量
+        if (!m_Instancing)
+            vsMask |= m_Shaders.KeywordMask(vs, "ROOT_CONSTANTS");
+
+        ShaderBytecodeView vsCode = m_Shaders.Get(vs, vsMask);
+        ShaderBytecodeView psCode = m_Shaders.Get(ps, 0);
+        m_VertexShader = {vsCode.Data, vsCode.Size};
+        m_PixelShader = {psCode.Data, psCode.Size};
+    }
+
+    // 输入布局由顶点格式生成
+    m_InputLayout = m_VertexFormat.InputLayout();
 }
 
 // 创建顶点和索引缓冲区
 void RainDX::BoxApplication::BuildBoxGeometry()
 {
+    RAINDX_PROFILE_FUNCTION();
     // 运行时在内存中分配顶点数据
     std::array<Vertex, 8> vertices =
     {
@@ -318,62 +680,93 @@ void RainDX::BoxApplication::BuildBoxGeometry()
         4, 3, 7
     };
 
-    constexpr UINT vbByteSize = static_cast<UINT>(vertices.size()) * sizeof(Vertex);
-    constexpr UINT ibByteSize = static_cast<UINT>(indices.size()) * sizeof(std::uint16_t);
-
-    m_BoxGeo = std::make_unique<MeshGeometry>();
-    m_BoxGeo->Name = "boxGeo";
-    m_BoxGeo->VertexByteStride = sizeof(Vertex);
-    m_BoxGeo->VertexBufferByteSize = vbByteSize;
-    m_BoxGeo->IndexFormat = DXGI_FORMAT_R16_UINT;
-    m_BoxGeo->IndexBufferByteSize = ibByteSize;
-    
-    // 复制数据
+    // 经打包器写入共享的顶点和索引缓冲区, 子网格的偏移和索引格式由打包器决定
+    BoundingBox bounds;
+    BoundingBox::CreateFromPoints(bounds, vertices.size(), &vertices[0].Pos, sizeof(Vertex));
+
+    GeometryPacker packer(sizeof(Vertex));
+    packer.Add("box", vertices.data(), vertices.size(), indices.data(), indices.size(), &bounds);
+    m_BoxGeo = std::move(packer.Pack("boxGeo").front());
+    const SubmeshGeometry& submesh = m_BoxGeo->DrawArgs["box"];
+
+    // 上传之前在 CPU 端的数据上重排三角形和顶点
+    m_MeshReport = MeshOptimizer::Optimize(*m_BoxGeo);
+    // LOD 的索引追加在同一个索引缓冲区中, 共用已重排的顶点
+    m_BoxLods = MeshSimplifier::BuildLods(*m_BoxGeo).at("box");
+    m_BoxLodSubmeshes.clear();
+    for (const MeshLod& lod : m_BoxLods)
     {
-        // 分配空间
-        ThrowIfFailed(D3DCreateBlob(vbByteSize, &m_BoxGeo->VertexBufferCPU));
-        // 复制数据
-        CopyMemory(m_BoxGeo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
-        ThrowIfFailed(D3DCreateBlob(ibByteSize, &m_BoxGeo->IndexBufferCPU));
-        CopyMemory(m_BoxGeo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+        // 各级与原子网格使用同一种索引格式, SetDrawState 只绑定一次索引缓冲区
+        m_BoxLodSubmeshes.push_back(m_BoxGeo->DrawArgs.at(lod.Submesh));
+        assert(m_BoxGeo->SubmeshIndexFormat(m_BoxLodSubmeshes.back()) == m_BoxGeo->SubmeshIndexFormat(submesh));
+    }
+    // 只使用网格簇构建对三角形的簇内重排, 运行时还没有按簇剔除, 统计以最终顺序为准
+    MeshletBuilder::Build(*m_BoxGeo);
+    const void* indexData = m_BoxGeo->IndexBufferCPU->GetBufferPointer();
+    if (m_BoxGeo->SubmeshIndexFormat(submesh) == DXGI_FORMAT_R32_UINT)
+    {
+        m_MeshReport.After = MeshOptimizer::AnalyzeVertexCache(
+            static_cast<const std::uint32_t*>(indexData) + submesh.StartIndexLocation,
+            submesh.IndexCount, vertices.size());
+    }
+    else
+    {
+        m_MeshReport.After = MeshOptimizer::AnalyzeVertexCache(
+            static_cast<const std::uint16_t*>(indexData) + submesh.StartIndexLocation,
+            submesh.IndexCount, vertices.size());
+    }
 
-        m_BoxGeo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(m_Device.Get(),
-                                                                m_CmdList.Get(), vertices.data(), vbByteSize,
-                                                                m_BoxGeo->VertexBufferUploader);
+    // 重排后的浮点顶点编码为 GPU 使用的格式, 遮挡剔除仍使用浮点位置
+    const std::size_t vertexCount = m_BoxGeo->VertexBufferByteSize / sizeof(Vertex);
+    const UINT encodedByteSize = static_cast<UINT>(vertexCount) * m_VertexFormat.Stride();
+    {
+        const auto* optimized = static_cast<const Vertex*>(m_BoxGeo->VertexBufferCPU->GetBufferPointer());
+        m_BoxPositions.resize(vertexCount);
+        for (std::size_t i = 0; i < vertexCount; ++i)
+            m_BoxPositions[i] = optimized[i].Pos;
+
+        VertexStreams streams;
+        streams.Position = {&optimized[0].Pos, sizeof(Vertex)};
+        streams.Color = {&optimized[0].Color, sizeof(Vertex)};
+
+        ComPtr<ID3DBlob> encoded;
+        ThrowIfFailed(D3DCreateBlob(encodedByteSize, &encoded));
+        m_VertexFormat.Encode(streams, vertexCount, submesh.Bounds, encoded->GetBufferPointer());
+        m_PosDequant = m_VertexFormat.Dequant(submesh.Bounds);
+
+        m_BoxGeo->VertexBufferCPU = encoded;
+        m_BoxGeo->VertexByteStride = m_VertexFormat.Stride();
+        m_BoxGeo->VertexBufferByteSize = encodedByteSize;
+    }
 
-        m_BoxGeo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(m_Device.Get(),
-                                                               m_CmdList.Get(), indices.data(), ibByteSize,
-                                                               m_BoxGeo->IndexBufferUploader);
+    {
+        // 放置到共享的缓冲区堆中, 顶点和索引共用一个暂存批次, 在 Init 中统一提交
+        m_VertexAlloc = m_BufferHeap->CreateBuffer(encodedByteSize, D3D12_RESOURCE_STATE_COMMON);
+        m_IndexAlloc = m_BufferHeap->CreateBuffer(m_BoxGeo->IndexBufferByteSize, D3D12_RESOURCE_STATE_COMMON);
+        m_Uploader->UploadBuffer(m_VertexAlloc.Resource.Get(), 0,
+                                 m_BoxGeo->VertexBufferCPU->GetBufferPointer(), encodedByteSize);
+        m_Uploader->UploadBuffer(m_IndexAlloc.Resource.Get(), 0,
+                                 m_BoxGeo->IndexBufferCPU->GetBufferPointer(), m_BoxGeo->IndexBufferByteSize);
+
+        m_BoxGeo->VertexBufferGPU = m_VertexAlloc.Resource;
+        m_BoxGeo->IndexBufferGPU = m_IndexAlloc.Resource;
     }
-    
-    // 子物体
-    SubmeshGeometry submesh;
-    // 大小为索引数组
-    submesh.IndexCount = static_cast<UINT>(indices.size());
-    submesh.StartIndexLocation = 0;
-    submesh.BaseVertexLocation = 0;
-    // 记录对应关系
-    m_BoxGeo->DrawArgs["box"] = submesh;
 }
 
 // 创建流水线描述
 void RainDX::BoxApplication::BuildPso()
 {
+    RAINDX_PROFILE_FUNCTION();
+    // 无 GPU 的后端不创建原生对象
+    if (IsHeadless())
+        return;
+
     D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc;
     ZeroMemory(&psoDesc, sizeof(D3D12_GRAPHICS_PIPELINE_STATE_DESC));
     psoDesc.InputLayout = {m_InputLayout.data(), static_cast<UINT>(m_InputLayout.size())};
     psoDesc.pRootSignature = m_RootSign.Get();
-    psoDesc.VS =
-    {
-        reinterpret_cast<BYTE*>(m_VertexShader->GetBufferPointer()),
-        m_VertexShader->GetBufferSize()
-    };
-    psoDesc.PS =
-    {
-        reinterpret_cast<BYTE*>(m_PixelShader->GetBufferPointer()),
-        m_PixelShader->GetBufferSize()
-    };
+    psoDesc.VS = m_VertexShader;
+    psoDesc.PS = m_PixelShader;
     psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
     psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
     psoDesc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
@@ -384,8 +777,65 @@ void RainDX::BoxApplication::BuildPso()
     psoDesc.SampleDesc.Count = m_4xMsaaState ? 4 : 1;
     psoDesc.SampleDesc.Quality = m_4xMsaaState ? (m_4xMsaaQuality - 1) : 0;
     psoDesc.DSVFormat = m_DepthBufType;
-    // 绑定到流水线
-    ThrowIfFailed(m_Device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&m_Pso)));
+
+    // 两种 PSO 都交给工作线程, 管线库中已有时不经过驱动编译
+    m_Pipelines = std::make_unique<PipelineCache>(m_Device.Get(), *m_Jobs, L"shaders\\cache\\pipelines.bin");
+    m_SolidPso = m_Pipelines->Request(psoDesc, m_RootSignHash);
+    psoDesc.RasterizerState.FillMode = D3D12_FILL_MODE_WIREFRAME;
+    m_WireframePso = m_Pipelines->Request(psoDesc, m_RootSignHash);
+}
+
+ID3D12PipelineState* RainDX::BoxApplication::CurrentPso() const
+{
+    if (m_Pipelines == nullptr)
+        return nullptr;
+    ID3D12PipelineState* solid = m_Pipelines->Get(m_SolidPso);
+    return m_Wireframe ? m_Pipelines->Get(m_WireframePso, solid) : solid;
 }
 
 
+// 生成实例数据
+void RainDX::BoxApplication::BuildInstances()
+{
+    RAINDX_PROFILE_FUNCTION();
+    // 每条边的盒子数
+    int side = 1;
+    while (side * side * side < m_DrawCount)
+        ++side;
+
+    // 缩小后排满原来单个盒子的 [-1, 1] 范围, 只有一个盒子时保持原样
+    float scale = 1.0f / side;
+    m_InstanceScale = scale;
+    XMMATRIX world = XMLoadFloat4x4(&m_World);
+    const BoundingBox& bounds = m_BoxGeo->DrawArgs["box"].Bounds;
+
+    m_Instances.resize(m_DrawCount);
+    m_Culler.Clear();
+    m_Culler.Reserve(m_DrawCount);
+    m_Bounds.resize(m_DrawCount);
+    for (int i = 0; i < m_DrawCount; ++i)
+    {
+        int x = i % side;
+        int y = i / side % side;
+        int z = i / (side * side);
+        float u = side > 1 ? static_cast<float>(x) / (side - 1) : 1.0f;
+        float v = side > 1 ? static_cast<float>(y) / (side - 1) : 1.0f;
+        float w = side > 1 ? static_cast<float>(z) / (side - 1) : 1.0f;
+
+        XMMATRIX local = XMMatrixScaling(scale, scale, scale) * XMMatrixTranslation(
+            (2.0f * x + 1.0f) * scale - 1.0f,
+            (2.0f * y + 1.0f) * scale - 1.0f,
+            (2.0f * z + 1.0f) * scale - 1.0f);
+
+        InstanceData& inst = m_Instances[i];
+        XMStoreFloat4x4(&inst.World, XMMatrixTranspose(local * world));
+
+        bounds.Transform(m_Bounds[i], local * world);
+        m_Culler.Add(m_Bounds[i]);
+        // 按网格位置着色
+        inst.Color = XMFLOAT4(u, v, w, 1.0f);
+    }
+
+    m_Bvh.Build(m_Bounds.data(), m_Bounds.size(), m_Jobs.get());
+    m_Picked = -1;
+}
@@ -19,12 +19,14 @@ void RainDX::SimpleApplication::OnResize()
 
 void RainDX::SimpleApplication::Update()
 {
+    RAINDX_PROFILE_FUNCTION();
 }
 
 void RainDX::SimpleApplication::Draw()
 {
+    RAINDX_PROFILE_FUNCTION();
     ThrowIfFailed(m_CmdAlloc->Reset())
-    ThrowIfFailed(m_CmdList->Reset(m_CmdAlloc.Get(), nullptr));
+    m_CmdList->Reset(m_CmdAlloc.Get(), nullptr);
 
     {
         // 缓冲区变为渲染状态
@@ -37,9 +39,9 @@ void RainDX::SimpleApplication::Draw()
         m_CmdList->RSSetScissorRects(1, &m_ScissorRect);
 
         m_CmdList->ClearRenderTargetView(
-            CurBufView(), DirectX::Colors::Wheat, 0, nullptr);
+            CurBufView(), DirectX::Colors::Wheat);
         m_CmdList->ClearDepthStencilView(
-            DepthView(), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
+            DepthView(), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0);
 
         // 指定要渲染的缓冲区
         auto curBufView = CurBufView();
@@ -58,13 +60,12 @@ void RainDX::SimpleApplication::Draw()
     }
 
     // E_INVALIDARG	一个或多个参数无效	0x80070057
-    ThrowIfFailed(m_CmdList->Close());
-    ID3D12CommandList* cmdsLists[] = {m_CmdList.Get()};
-    m_CmdQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
+    m_CmdList->Close();
+    RenderCmdList* cmdsLists[] = {m_CmdList.get()};
+    m_Render->Execute(_countof(cmdsLists), cmdsLists);
 
     // 交换后台缓冲区索引
-    ThrowIfFailed(m_Swap->Present(0, 0))
-    m_CurBufIndex = (m_CurBufIndex + 1) % m_SwapBufCount;
+    Present();
 
     ClearCmdQueue();
 }
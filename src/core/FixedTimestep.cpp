@@ -0,0 +1,83 @@
+#include "core/FixedTimestep.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+RainDX::FixedTimestep::FixedTimestep(double step, int maxSteps) :
+    m_Step(step), m_MaxSteps(maxSteps)
+{
+    assert(step > 0.0 && maxSteps > 0);
+}
+
+int RainDX::FixedTimestep::Advance(double deltaSeconds)
+{
+    m_Accumulator += (std::max)(deltaSeconds, 0.0);
+
+    int steps = static_cast<int>(m_Accumulator / m_Step);
+    m_Accumulator -= steps * m_Step;
+    // 除法的舍入误差可能让余数刚好等于一步或略小于 0, 保证 Alpha 在 [0, 1) 内
+    if (m_Accumulator >= m_Step)
+    {
+        m_Accumulator -= m_Step;
+        ++steps;
+    }
+    m_Accumulator = (std::max)(m_Accumulator, 0.0);
+
+    // 追赶步数有上限, 否则一次慢帧会让后续每帧都更慢
+    if (steps > m_MaxSteps)
+    {
+        m_Dropped += (steps - m_MaxSteps) * m_Step;
+        steps = m_MaxSteps;
+    }
+
+    m_StepCount += steps;
+    return steps;
+}
+
+void RainDX::FixedTimestep::Reset()
+{
+    m_Accumulator = 0.0;
+    m_StepCount = 0;
+    m_Dropped = 0.0;
+}
+
+double RainDX::FixedTimestep::Step() const
+{
+    return m_Step;
+}
+
+void RainDX::FixedTimestep::SetStep(double step)
+{
+    assert(step > 0.0);
+    m_Step = step;
+    // 剩余时间必须不足新的一步, 多出的整步计入丢弃的时间
+    double kept = std::fmod(m_Accumulator, m_Step);
+    m_Dropped += m_Accumulator - kept;
+    m_Accumulator = kept;
+}
+
+int RainDX::FixedTimestep::MaxSteps() const
+{
+    return m_MaxSteps;
+}
+
+void RainDX::FixedTimestep::SetMaxSteps(int maxSteps)
+{
+    assert(maxSteps > 0);
+    m_MaxSteps = maxSteps;
+}
+
+double RainDX::FixedTimestep::Alpha() const
+{
+    return m_Accumulator / m_Step;
+}
+
+std::uint64_t RainDX::FixedTimestep::StepCount() const
+{
+    return m_StepCount;
+}
+
+double RainDX::FixedTimestep::DroppedTime() const
+{
+    return m_Dropped;
+}
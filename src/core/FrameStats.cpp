@@ -0,0 +1,222 @@
+#include "core/FrameStats.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace
+{
+    // 判断卡顿前至少需要的样本数, 避免启动阶段误报
+    constexpr std::size_t HitchWarmupFrames = 16;
+}
+
+RainDX::FrameStats::FrameStats(std::size_t window, double hitchFactor, double hitchMinMs) :
+    m_Window((std::max)(window, static_cast<std::size_t>(1))), m_HitchFactor(hitchFactor), m_HitchMinMs(hitchMinMs)
+{
+    m_Samples.resize(m_Window);
+    m_Histogram.resize(BinCount);
+}
+
+void RainDX::FrameStats::AddFrame(double ms)
+{
+    ms = (std::max)(ms, 0.0);
+
+    // 与加入本帧之前的中位数比较
+    if (WindowSize() >= HitchWarmupFrames)
+    {
+        double median = RunningMedian();
+        if (ms > median * m_HitchFactor && ms - median >= m_HitchMinMs)
+        {
+            ++m_HitchCount;
+            m_Hitches.push_back({m_FrameCount, ms, median});
+            if (m_Hitches.size() > MaxHitches)
+                m_Hitches.pop_front();
+        }
+    }
+
+    double& slot = m_Samples[m_FrameCount % m_Window];
+    // 窗口已满, 移出最早的一帧
+    if (m_FrameCount >= m_Window)
+    {
+        std::size_t oldBin = Bin(slot);
+        if (oldBin < BinCount)
+            --m_Histogram[oldBin];
+        else
+            --m_Overflow;
+        if ((std::min)(oldBin, BinCount) < m_MedianBin)
+            --m_BelowMedian;
+        m_Sum -= slot;
+    }
+
+    slot = ms;
+    std::size_t bin = Bin(ms);
+    if (bin < BinCount)
+        ++m_Histogram[bin];
+    else
+        ++m_Overflow;
+    if ((std::min)(bin, BinCount) < m_MedianBin)
+        ++m_BelowMedian;
+    m_Sum += ms;
+    ++m_FrameCount;
+}
+
+void RainDX::FrameStats::Clear()
+{
+    std::fill(m_Histogram.begin(), m_Histogram.end(), 0u);
+    m_Overflow = 0;
+    m_Sum = 0.0;
+    m_MedianBin = 0;
+    m_BelowMedian = 0;
+    m_FrameCount = 0;
+    m_HitchCount = 0;
+    m_Hitches.clear();
+}
+
+double RainDX::FrameStats::Percentile(double p) const
+{
+    std::size_t count = WindowSize();
+    if (count == 0)
+        return 0.0;
+
+    p = (std::min)((std::max)(p, 0.0), 1.0);
+    std::size_t rank = static_cast<std::size_t>(std::ceil(p * count));
+    rank = (std::min)((std::max)(rank, static_cast<std::size_t>(1)), count);
+
+    std::size_t seen = 0;
+    for (std::size_t bin = 0; bin < BinCount; ++bin)
+    {
+        seen += m_Histogram[bin];
+        if (seen >= rank)
+            return (bin + 0.5) * BinMs;
+    }
+
+    // 落在直方图之外, 对超出的帧排序后取精确值
+    std::vector<double> slow;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (Bin(m_Samples[i]) >= BinCount)
+            slow.push_back(m_Samples[i]);
+    }
+    std::sort(slow.begin(), slow.end());
+    return slow[(std::min)(rank - seen - 1, slow.size() - 1)];
+}
+
+RainDX::FrameSummary RainDX::FrameStats::Summarize() const
+{
+    FrameSummary summary;
+    std::size_t count = WindowSize();
+    summary.Hitches = m_HitchCount;
+    if (count == 0)
+        return summary;
+
+    summary.Frames = count;
+    summary.AverageMs = m_Sum / count;
+    summary.MinMs = *std::min_element(m_Samples.begin(), m_Samples.begin() + count);
+    summary.MaxMs = *std::max_element(m_Samples.begin(), m_Samples.begin() + count);
+    summary.P50Ms = Percentile(0.50);
+    summary.P95Ms = Percentile(0.95);
+    summary.P99Ms = Percentile(0.99);
+
+    // 最慢的 1% 帧, 先取超出直方图的帧, 再从最高的桶向下累加
+    std::size_t worst = (std::max)(count / 100, static_cast<std::size_t>(1));
+    std::vector<double> slow;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (Bin(m_Samples[i]) >= BinCount)
+            slow.push_back(m_Samples[i]);
+    }
+    std::sort(slow.begin(), slow.end(), [](double a, double b) { return a > b; });
+
+    double total = 0.0;
+    std::size_t taken = 0;
+    for (double ms : slow)
+    {
+        if (taken == worst)
+            break;
+        total += ms;
+        ++taken;
+    }
+    for (std::size_t bin = BinCount; bin > 0 && taken < worst; --bin)
+    {
+        std::size_t use = (std::min)(static_cast<std::size_t>(m_Histogram[bin - 1]), worst - taken);
+        total += use * (bin - 0.5) * BinMs;
+        taken += use;
+    }
+
+    summary.OnePercentLowMs = total / taken;
+    summary.OnePercentLowFps = summary.OnePercentLowMs > 0.0 ? 1000.0 / summary.OnePercentLowMs : 0.0;
+    return summary;
+}
+
+const std::deque<RainDX::FrameHitch>& RainDX::FrameStats::Hitches() const
+{
+    return m_Hitches;
+}
+
+std::uint64_t RainDX::FrameStats::FrameCount() const
+{
+    return m_FrameCount;
+}
+
+std::size_t RainDX::FrameStats::WindowSize() const
+{
+    return static_cast<std::size_t>((std::min)(m_FrameCount, static_cast<std::uint64_t>(m_Window)));
+}
+
+bool RainDX::FrameStats::WriteCsv(const std::string& path) const
+{
+    std::ofstream out(path);
+    if (!out)
+        return false;
+
+    out << "frame,ms,hitch\n";
+
+    std::uint64_t first = m_FrameCount - WindowSize();
+    auto hitch = m_Hitches.begin();
+    for (std::uint64_t frame = first; frame < m_FrameCount; ++frame)
+    {
+        // 卡顿记录按帧序号递增
+        while (hitch != m_Hitches.end() && hitch->Frame < frame)
+            ++hitch;
+        bool isHitch = hitch != m_Hitches.end() && hitch->Frame == frame;
+
+        out << frame << ',' << m_Samples[frame % m_Window] << ',' << (isHitch ? 1 : 0) << '\n';
+    }
+
+    return static_cast<bool>(out);
+}
+
+std::size_t RainDX::FrameStats::Bin(double ms) const
+{
+    return static_cast<std::size_t>(ms / BinMs);
+}
+
+double RainDX::FrameStats::RunningMedian()
+{
+    std::size_t count = WindowSize();
+    if (count == 0)
+        return 0.0;
+
+    // 与 Percentile(0.5) 的排名一致
+    std::size_t rank = (std::max)((count + 1) / 2, static_cast<std::size_t>(1));
+    auto binCount = [this](std::size_t bin) -> std::size_t
+    {
+        return bin < BinCount ? m_Histogram[bin] : m_Overflow;
+    };
+
+    // 每帧最多增减一个样本, 通常只移动很少的桶
+    while (m_MedianBin > 0 && m_BelowMedian >= rank)
+    {
+        --m_MedianBin;
+        m_BelowMedian -= binCount(m_MedianBin);
+    }
+    while (m_MedianBin < BinCount && m_BelowMedian + binCount(m_MedianBin) < rank)
+    {
+        m_BelowMedian += binCount(m_MedianBin);
+        ++m_MedianBin;
+    }
+
+    // 中位数超出直方图范围时需要精确值
+    if (m_MedianBin >= BinCount)
+        return Percentile(0.5);
+    return (m_MedianBin + 0.5) * BinMs;
+}
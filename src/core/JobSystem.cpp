@@ -0,0 +1,269 @@
+#include "core/JobSystem.h"
+#include <cassert>
+#include "core/Profiler.h"
+
+namespace
+{
+    // 每个线程的任务槽数量, 必须是 2 的幂
+    constexpr std::size_t JobPoolSize = 4096;
+
+    // 当前线程所属的任务系统和编号
+    thread_local const RainDX::JobSystem* tls_System = nullptr;
+    thread_local int tls_Index = -1;
+}
+
+bool RainDX::JobDeque::Push(Job* job)
+{
+    std::int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+    std::int64_t top = m_Top.load(std::memory_order_acquire);
+    if (bottom - top >= Capacity)
+        return false;
+
+    m_Jobs[bottom & (Capacity - 1)].store(job, std::memory_order_relaxed);
+    m_Bottom.store(bottom + 1, std::memory_order_release);
+    return true;
+}
+
+RainDX::Job* RainDX::JobDeque::Pop()
+{
+    std::int64_t bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+    m_Bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t top = m_Top.load(std::memory_order_relaxed);
+
+    if (top > bottom)
+    {
+        // 队列为空
+        m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = m_Jobs[bottom & (Capacity - 1)].load(std::memory_order_relaxed);
+    if (top == bottom)
+    {
+        // 最后一个任务, 与窃取者竞争
+        if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            job = nullptr;
+        m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+RainDX::Job* RainDX::JobDeque::Steal()
+{
+    std::int64_t top = m_Top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t bottom = m_Bottom.load(std::memory_order_acquire);
+    if (top >= bottom)
+        return nullptr;
+
+    Job* job = m_Jobs[top & (Capacity - 1)].load(std::memory_order_relaxed);
+    if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr;
+    return job;
+}
+
+
+RainDX::JobSystem::JobSystem(int workerCount)
+{
+    if (workerCount < 0)
+    {
+        int hardware = static_cast<int>(std::thread::hardware_concurrency());
+        workerCount = hardware > 1 ? hardware - 1 : 0;
+    }
+
+    // 0 号留给创建者所在的主线程
+    for (int i = 0; i <= workerCount; ++i)
+    {
+        auto worker = std::make_unique<Worker>();
+        worker->Pool = std::make_unique<Job[]>(JobPoolSize);
+        worker->Random = 0x9e3779b9u * static_cast<std::uint32_t>(i + 1);
+        m_Workers.push_back(std::move(worker));
+    }
+
+    tls_System = this;
+    tls_Index = 0;
+
+    for (int i = 1; i <= workerCount; ++i)
+        m_Threads.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+
+RainDX::JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_SleepMutex);
+        m_Running.store(false);
+    }
+    m_WakeUp.notify_all();
+
+    for (std::thread& thread : m_Threads)
+        thread.join();
+
+    if (tls_System == this)
+    {
+        tls_System = nullptr;
+        tls_Index = -1;
+    }
+}
+
+void RainDX::JobSystem::Run(std::function<void()> func, JobCounter* counter)
+{
+    int index = ThreadIndex();
+    assert(index >= 0 && "Jobs must be submitted from the main thread or a job.");
+    Worker& worker = *m_Workers[index];
+
+    Job* job = AllocateJob(worker);
+    if (job == nullptr)
+    {
+        // 任务槽全部在使用中, 直接执行
+        func();
+        return;
+    }
+
+    job->Func = std::move(func);
+    job->Counter = counter;
+    if (counter != nullptr)
+        counter->Add();
+
+    if (!worker.Queue.Push(job))
+    {
+        Execute(job);
+        return;
+    }
+
+    m_Queued.fetch_add(1);
+    if (m_Sleeping.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_SleepMutex);
+        m_WakeUp.notify_one();
+    }
+}
+
+void RainDX::JobSystem::Wait(const JobCounter& counter)
+{
+    int index = ThreadIndex();
+    assert(index >= 0 && "Wait must be called from the main thread or a job.");
+
+    while (!counter.IsDone())
+    {
+        if (!TryRunOne(index))
+            std::this_thread::yield();
+    }
+
+    if (std::exception_ptr error = counter.Error())
+        std::rethrow_exception(error);
+
+    std::exception_ptr orphan;
+    {
+        std::lock_guard<std::mutex> lock(m_ErrorMutex);
+        orphan = std::move(m_Error);
+        m_Error = nullptr;
+    }
+    if (orphan)
+        std::rethrow_exception(orphan);
+}
+
+unsigned RainDX::JobSystem::ThreadCount() const
+{
+    return static_cast<unsigned>(m_Workers.size());
+}
+
+int RainDX::JobSystem::ThreadIndex() const
+{
+    return tls_System == this ? tls_Index : -1;
+}
+
+RainDX::Job* RainDX::JobSystem::AllocateJob(Worker& worker)
+{
+    Job* job = &worker.Pool[worker.NextJob & (JobPoolSize - 1)];
+    if (job->Busy.load(std::memory_order_acquire))
+        return nullptr;
+
+    ++worker.NextJob;
+    job->Busy.store(true, std::memory_order_relaxed);
+    return job;
+}
+
+void RainDX::JobSystem::Execute(Job* job)
+{
+    // 异常不能离开工作线程, 记录下来交给 Wait 抛出
+    JobCounter* counter = job->Counter;
+    try
+    {
+        job->Func();
+    }
+    catch (...)
+    {
+        if (counter != nullptr)
+        {
+            counter->Fail(std::current_exception());
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(m_ErrorMutex);
+            if (!m_Error)
+                m_Error = std::current_exception();
+        }
+    }
+
+    // 先释放捕获的对象和槽位, 最后通知计数器
+    job->Func = nullptr;
+    job->Counter = nullptr;
+    job->Busy.store(false, std::memory_order_release);
+
+    if (counter != nullptr)
+        counter->Done();
+}
+
+bool RainDX::JobSystem::TryRunOne(int index)
+{
+    Job* job = m_Workers[index]->Queue.Pop();
+    if (job == nullptr)
+        job = StealFrom(index);
+    if (job == nullptr)
+        return false;
+
+    m_Queued.fetch_sub(1);
+    Execute(job);
+    return true;
+}
+
+RainDX::Job* RainDX::JobSystem::StealFrom(int thief)
+{
+    // 从随机位置开始轮询其他线程的队列
+    Worker& worker = *m_Workers[thief];
+    worker.Random ^= worker.Random << 13;
+    worker.Random ^= worker.Random >> 17;
+    worker.Random ^= worker.Random << 5;
+
+    std::size_t count = m_Workers.size();
+    std::size_t start = worker.Random % count;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        std::size_t victim = (start + i) % count;
+        if (static_cast<int>(victim) == thief)
+            continue;
+        if (Job* job = m_Workers[victim]->Queue.Steal())
+            return job;
+    }
+    return nullptr;
+}
+
+void RainDX::JobSystem::WorkerLoop(int index)
+{
+    tls_System = this;
+    tls_Index = index;
+    RAINDX_PROFILE_THREAD("Job Worker");
+
+    while (m_Running.load(std::memory_order_relaxed))
+    {
+        if (TryRunOne(index))
+            continue;
+
+        // 没有可执行的任务, 休眠到有新任务提交
+        std::unique_lock<std::mutex> lock(m_SleepMutex);
+        m_Sleeping.fetch_add(1);
+        m_WakeUp.wait(lock, [this] { return m_Queued.load() > 0 || !m_Running.load(); });
+        m_Sleeping.fetch_sub(1);
+    }
+}
@@ -0,0 +1,79 @@
+#include "core/LinearArena.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+RainDX::LinearArena::LinearArena(std::size_t chunkBytes) :
+    m_ChunkBytes((std::max)(chunkBytes, std::size_t(64)))
+{
+}
+
+void* RainDX::LinearArena::Allocate(std::size_t bytes, std::size_t alignment)
+{
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+    if (!m_Chunks.empty())
+    {
+        Chunk& chunk = m_Chunks.back();
+        // 按实际地址对齐, 块本身的对齐可能小于 alignment
+        std::uintptr_t base = reinterpret_cast<std::uintptr_t>(chunk.Memory.get());
+        std::uintptr_t aligned = (base + m_Offset + alignment - 1) & ~(std::uintptr_t(alignment) - 1);
+        std::size_t offset = static_cast<std::size_t>(aligned - base);
+        if (offset + bytes <= chunk.Size)
+        {
+            m_Used += offset + bytes - m_Offset;
+            m_Offset = offset + bytes;
+            return chunk.Memory.get() + offset;
+        }
+    }
+
+    // 新块至少能放下这次分配
+    AddChunk((std::max)(m_ChunkBytes, bytes + alignment));
+    Chunk& chunk = m_Chunks.back();
+    std::uintptr_t base = reinterpret_cast<std::uintptr_t>(chunk.Memory.get());
+    std::uintptr_t aligned = (base + alignment - 1) & ~(std::uintptr_t(alignment) - 1);
+    std::size_t offset = static_cast<std::size_t>(aligned - base);
+    m_Used += offset + bytes;
+    m_Offset = offset + bytes;
+    return chunk.Memory.get() + offset;
+}
+
+void RainDX::LinearArena::Reset()
+{
+    // 上一轮用了多个块时合并成一块, 下一轮同样的用量不再申请
+    if (m_Chunks.size() > 1)
+    {
+        std::size_t total = Capacity();
+        m_Chunks.clear();
+        AddChunk(total);
+    }
+    m_Offset = 0;
+    m_Used = 0;
+}
+
+std::size_t RainDX::LinearArena::Used() const
+{
+    return m_Used;
+}
+
+std::size_t RainDX::LinearArena::Capacity() const
+{
+    std::size_t capacity = 0;
+    for (const Chunk& chunk : m_Chunks)
+        capacity += chunk.Size;
+    return capacity;
+}
+
+std::size_t RainDX::LinearArena::ChunkCount() const
+{
+    return m_Chunks.size();
+}
+
+void RainDX::LinearArena::AddChunk(std::size_t bytes)
+{
+    Chunk chunk;
+    chunk.Memory.reset(new char[bytes]);
+    chunk.Size = bytes;
+    m_Chunks.push_back(std::move(chunk));
+    m_Offset = 0;
+}
@@ -0,0 +1,203 @@
+#include "core/Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    // 单个线程的事件环, 只有所属线程写入
+    struct ThreadBuffer
+    {
+        std::unique_ptr<RainDX::ProfileEvent[]> Events;
+        // 单调递增的写入计数, 导出时据此确定有效区间
+        std::atomic<std::uint64_t> Count{0};
+        // 记录时所属的捕获编号, 与当前编号不同的缓冲区在下次写入时清空
+        std::atomic<std::uint32_t> Epoch{0};
+        std::uint32_t ThreadId = 0;
+        std::string Name;
+        std::uint32_t Depth = 0;
+    };
+
+    constexpr std::uint64_t EventMask = RainDX::Profiler::EventsPerThread - 1;
+
+    // 线程退出后缓冲区仍然保留, 以便导出
+    std::mutex g_RegistryMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> g_Buffers;
+    std::atomic<std::uint32_t> g_Epoch{0};
+
+    thread_local ThreadBuffer* tls_Buffer = nullptr;
+
+    ThreadBuffer& LocalBuffer()
+    {
+        if (tls_Buffer == nullptr)
+        {
+            auto buffer = std::make_unique<ThreadBuffer>();
+            buffer->Events = std::make_unique<RainDX::ProfileEvent[]>(RainDX::Profiler::EventsPerThread);
+
+            std::lock_guard<std::mutex> lock(g_RegistryMutex);
+            buffer->ThreadId = static_cast<std::uint32_t>(g_Buffers.size());
+            tls_Buffer = buffer.get();
+            g_Buffers.push_back(std::move(buffer));
+        }
+        return *tls_Buffer;
+    }
+
+    void Push(ThreadBuffer& buffer, const RainDX::ProfileEvent& event)
+    {
+        std::uint32_t epoch = g_Epoch.load(std::memory_order_acquire);
+        if (buffer.Epoch.load(std::memory_order_relaxed) != epoch)
+        {
+            buffer.Count.store(0, std::memory_order_relaxed);
+            buffer.Epoch.store(epoch, std::memory_order_relaxed);
+        }
+
+        std::uint64_t count = buffer.Count.load(std::memory_order_relaxed);
+        buffer.Events[count & EventMask] = event;
+        buffer.Count.store(count + 1, std::memory_order_release);
+    }
+
+    void WriteEscaped(std::ofstream& out, const char* text)
+    {
+        for (const char* c = text; *c != '\0'; ++c)
+        {
+            if (*c == '"' || *c == '\\')
+                out << '\\';
+            out << *c;
+        }
+    }
+}
+
+std::atomic<bool> RainDX::Profiler::s_Capturing{false};
+
+void RainDX::Profiler::BeginCapture()
+{
+    g_Epoch.fetch_add(1, std::memory_order_release);
+    s_Capturing.store(true, std::memory_order_relaxed);
+}
+
+void RainDX::Profiler::EndCapture()
+{
+    s_Capturing.store(false, std::memory_order_relaxed);
+}
+
+bool RainDX::Profiler::WriteChromeTrace(const std::string& path)
+{
+    std::ofstream out(path);
+    if (!out)
+        return false;
+
+    std::lock_guard<std::mutex> lock(g_RegistryMutex);
+    std::uint32_t epoch = g_Epoch.load(std::memory_order_acquire);
+
+    // 以最早的事件为时间零点
+    std::int64_t origin = INT64_MAX;
+    for (const auto& buffer : g_Buffers)
+    {
+        if (buffer->Epoch.load(std::memory_order_relaxed) != epoch)
+            continue;
+        std::uint64_t count = buffer->Count.load(std::memory_order_acquire);
+        std::uint64_t first = count > EventsPerThread ? count - EventsPerThread : 0;
+        for (std::uint64_t i = first; i < count; ++i)
+            origin = (std::min)(origin, buffer->Events[i & EventMask].Begin);
+    }
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool firstEvent = true;
+    auto separator = [&out, &firstEvent]
+    {
+        if (!firstEvent)
+            out << ",\n";
+        firstEvent = false;
+    };
+
+    char number[64];
+    for (const auto& buffer : g_Buffers)
+    {
+        if (!buffer->Name.empty())
+        {
+            separator();
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->ThreadId
+                << ",\"args\":{\"name\":\"";
+            WriteEscaped(out, buffer->Name.c_str());
+            out << "\"}}";
+        }
+
+        if (buffer->Epoch.load(std::memory_order_relaxed) != epoch)
+            continue;
+
+        std::uint64_t count = buffer->Count.load(std::memory_order_acquire);
+        std::uint64_t first = count > EventsPerThread ? count - EventsPerThread : 0;
+        for (std::uint64_t i = first; i < count; ++i)
+        {
+            const ProfileEvent& event = buffer->Events[i & EventMask];
+            separator();
+
+            // 时间戳以微秒为单位
+            std::snprintf(number, sizeof(number), "%.3f", (event.Begin - origin) / 1000.0);
+            out << "{\"name\":\"";
+            WriteEscaped(out, event.Name);
+            out << "\",\"pid\":0,\"tid\":" << buffer->ThreadId << ",\"ts\":" << number;
+
+            if (event.Depth == ProfileEvent::FrameDepth)
+            {
+                out << ",\"ph\":\"i\",\"s\":\"g\"}";
+            }
+            else
+            {
+                std::snprintf(number, sizeof(number), "%.3f", (event.End - event.Begin) / 1000.0);
+                out << ",\"ph\":\"X\",\"dur\":" << number << "}";
+            }
+        }
+    }
+    out << "]}\n";
+
+    return static_cast<bool>(out);
+}
+
+void RainDX::Profiler::SetThreadName(const char* name)
+{
+    ThreadBuffer& buffer = LocalBuffer();
+    std::lock_guard<std::mutex> lock(g_RegistryMutex);
+    buffer.Name = name;
+}
+
+void RainDX::Profiler::FrameMark()
+{
+    if (!IsCapturing())
+        return;
+
+    ProfileEvent event;
+    event.Name = "Frame";
+    event.Begin = Now();
+    event.End = event.Begin;
+    event.Depth = ProfileEvent::FrameDepth;
+    Push(LocalBuffer(), event);
+}
+
+std::int64_t RainDX::Profiler::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::uint32_t RainDX::Profiler::EnterZone()
+{
+    return LocalBuffer().Depth++;
+}
+
+void RainDX::Profiler::LeaveZone(const char* name, std::int64_t begin, std::uint32_t depth)
+{
+    ThreadBuffer& buffer = LocalBuffer();
+    buffer.Depth = depth;
+
+    ProfileEvent event;
+    event.Name = name;
+    event.Begin = begin;
+    event.End = Now();
+    event.Depth = depth;
+    Push(buffer, event);
+}
@@ -0,0 +1,346 @@
+#include "core/TlsfAllocator.h"
+#include <algorithm>
+#include <cassert>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+    // 最低位 1 的位置, x 不能为 0
+    std::uint32_t LowestBit(std::uint64_t x)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, x);
+        return static_cast<std::uint32_t>(index);
+#else
+        return static_cast<std::uint32_t>(__builtin_ctzll(x));
+#endif
+    }
+
+    // 最高位 1 的位置, x 不能为 0
+    std::uint32_t HighestBit(std::uint64_t x)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanReverse64(&index, x);
+        return static_cast<std::uint32_t>(index);
+#else
+        return 63u - static_cast<std::uint32_t>(__builtin_clzll(x));
+#endif
+    }
+
+    std::uint64_t AlignUp(std::uint64_t value, std::uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+}
+
+RainDX::TlsfAllocator::TlsfAllocator(std::uint64_t capacity, std::uint64_t granularity) :
+    m_Granularity(granularity)
+{
+    assert(granularity != 0 && (granularity & (granularity - 1)) == 0 && "Granularity must be a power of two.");
+    m_GranularityShift = LowestBit(granularity);
+    // 不足一个单位的尾部不参与分配
+    m_Capacity = capacity & ~(granularity - 1);
+    Reset();
+}
+
+RainDX::TlsfAllocation RainDX::TlsfAllocator::Allocate(std::uint64_t size, std::uint64_t alignment)
+{
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two.");
+
+    TlsfAllocation result;
+    size = AlignUp((std::max)(size, static_cast<std::uint64_t>(1)), m_Granularity);
+    alignment = (std::max)(alignment, m_Granularity);
+    if (size > m_Capacity)
+        return result;
+
+    // 空闲块的偏移至少按单位对齐, 最坏情况下需要额外的对齐填充
+    // 填充后超过容量时仍可能放在偏移 0 处, 交给下面逐个检查
+    std::uint64_t padded = (std::min)(size + alignment - m_Granularity, m_Capacity);
+
+    std::uint32_t fl, sl;
+    std::uint32_t index = Null;
+    if (FindFree(padded >> m_GranularityShift, fl, sl))
+    {
+        index = m_FreeHeads[fl][sl];
+    }
+    else
+    {
+        // 向上取整后找不到时, 在同一级中逐个检查, 避免整块容量无法分配
+        Mapping(padded >> m_GranularityShift, fl, sl);
+        for (std::uint32_t i = m_FreeHeads[fl][sl]; i != Null; i = m_Blocks[i].NextFree)
+        {
+            const Block& block = m_Blocks[i];
+            if (AlignUp(block.Offset, alignment) + size <= block.Offset + block.Size)
+            {
+                index = i;
+                break;
+            }
+        }
+        if (index == Null)
+            return result;
+    }
+
+    RemoveFree(index);
+
+    // 头部的对齐填充作为独立的空闲块
+    std::uint64_t pad = AlignUp(m_Blocks[index].Offset, alignment) - m_Blocks[index].Offset;
+    if (pad != 0)
+    {
+        std::uint32_t rest = Split(index, pad);
+        InsertFree(index);
+        index = rest;
+    }
+
+    if (m_Blocks[index].Size > size)
+        InsertFree(Split(index, size));
+
+    Block& block = m_Blocks[index];
+    block.Free = false;
+    m_UsedBytes += block.Size;
+    ++m_Allocations;
+
+    result.Offset = block.Offset;
+    result.Size = block.Size;
+    result.Block = index;
+    return result;
+}
+
+void RainDX::TlsfAllocator::Free(const TlsfAllocation& allocation)
+{
+    if (!allocation.IsValid())
+        return;
+
+    std::uint32_t index = allocation.Block;
+    assert(index < m_Blocks.size() && !m_Blocks[index].Free && "Double free or foreign allocation.");
+    assert(m_Blocks[index].Offset == allocation.Offset);
+
+    m_UsedBytes -= m_Blocks[index].Size;
+    --m_Allocations;
+    m_Blocks[index].Free = true;
+
+    // 与前后相邻的空闲块合并
+    std::uint32_t next = m_Blocks[index].NextPhys;
+    if (next != Null && m_Blocks[next].Free)
+    {
+        RemoveFree(next);
+        MergeNext(index);
+    }
+    std::uint32_t prev = m_Blocks[index].PrevPhys;
+    if (prev != Null && m_Blocks[prev].Free)
+    {
+        RemoveFree(prev);
+        MergeNext(prev);
+        index = prev;
+    }
+
+    InsertFree(index);
+}
+
+void RainDX::TlsfAllocator::Reset()
+{
+    m_Blocks.clear();
+    m_UnusedBlocks.clear();
+    m_UsedBytes = 0;
+    m_Allocations = 0;
+    m_FlBitmap = 0;
+    std::fill(std::begin(m_SlBitmap), std::end(m_SlBitmap), 0u);
+    for (auto& heads : m_FreeHeads)
+        std::fill(std::begin(heads), std::end(heads), Null);
+
+    if (m_Capacity == 0)
+        return;
+
+    std::uint32_t index = NewBlock();
+    m_Blocks[index].Offset = 0;
+    m_Blocks[index].Size = m_Capacity;
+    m_Blocks[index].Free = true;
+    InsertFree(index);
+}
+
+std::uint64_t RainDX::TlsfAllocator::Capacity() const
+{
+    return m_Capacity;
+}
+
+std::uint64_t RainDX::TlsfAllocator::Granularity() const
+{
+    return m_Granularity;
+}
+
+std::uint64_t RainDX::TlsfAllocator::UsedBytes() const
+{
+    return m_UsedBytes;
+}
+
+std::uint32_t RainDX::TlsfAllocator::AllocationCount() const
+{
+    return m_Allocations;
+}
+
+bool RainDX::TlsfAllocator::Empty() const
+{
+    return m_Allocations == 0;
+}
+
+RainDX::TlsfStats RainDX::TlsfAllocator::Stats() const
+{
+    TlsfStats stats;
+    stats.Capacity = m_Capacity;
+    stats.UsedBytes = m_UsedBytes;
+    stats.FreeBytes = m_Capacity - m_UsedBytes;
+    stats.Allocations = m_Allocations;
+
+    for (const Block& block : m_Blocks)
+    {
+        // 大小为 0 的是等待复用的元数据
+        if (!block.Free || block.Size == 0)
+            continue;
+        ++stats.FreeBlocks;
+        stats.LargestFreeBlock = (std::max)(stats.LargestFreeBlock, block.Size);
+    }
+    return stats;
+}
+
+void RainDX::TlsfAllocator::Mapping(std::uint64_t units, std::uint32_t& fl, std::uint32_t& sl) const
+{
+    // 小于 SlCount 个单位的块全部放在第 0 级, 每个大小一个链表
+    if (units < SlCount)
+    {
+        fl = 0;
+        sl = static_cast<std::uint32_t>(units);
+        return;
+    }
+
+    std::uint32_t msb = HighestBit(units);
+    fl = msb - SlBits + 1;
+    sl = static_cast<std::uint32_t>(units >> (msb - SlBits)) - SlCount;
+}
+
+bool RainDX::TlsfAllocator::FindFree(std::uint64_t units, std::uint32_t& fl, std::uint32_t& sl) const
+{
+    // 向上取整到下一个区间, 该区间中任意块都足够大
+    if (units >= SlCount)
+        units += (static_cast<std::uint64_t>(1) << (HighestBit(units) - SlBits)) - 1;
+    Mapping(units, fl, sl);
+    if (fl >= FlCount)
+        return false;
+
+    std::uint32_t slMap = m_SlBitmap[fl] & (~0u << sl);
+    if (slMap == 0)
+    {
+        // 当前级没有, 找更大的一级
+        if (fl + 1 >= FlCount)
+            return false;
+        std::uint64_t flMap = m_FlBitmap & (~static_cast<std::uint64_t>(0) << (fl + 1));
+        if (flMap == 0)
+            return false;
+        fl = LowestBit(flMap);
+        slMap = m_SlBitmap[fl];
+    }
+
+    sl = LowestBit(slMap);
+    return true;
+}
+
+void RainDX::TlsfAllocator::InsertFree(std::uint32_t index)
+{
+    Block& block = m_Blocks[index];
+    block.Free = true;
+
+    std::uint32_t fl, sl;
+    Mapping(block.Size >> m_GranularityShift, fl, sl);
+
+    std::uint32_t head = m_FreeHeads[fl][sl];
+    block.PrevFree = Null;
+    block.NextFree = head;
+    if (head != Null)
+        m_Blocks[head].PrevFree = index;
+    m_FreeHeads[fl][sl] = index;
+
+    m_FlBitmap |= static_cast<std::uint64_t>(1) << fl;
+    m_SlBitmap[fl] |= 1u << sl;
+}
+
+void RainDX::TlsfAllocator::RemoveFree(std::uint32_t index)
+{
+    Block& block = m_Blocks[index];
+
+    std::uint32_t fl, sl;
+    Mapping(block.Size >> m_GranularityShift, fl, sl);
+
+    if (block.PrevFree != Null)
+        m_Blocks[block.PrevFree].NextFree = block.NextFree;
+    else
+        m_FreeHeads[fl][sl] = block.NextFree;
+    if (block.NextFree != Null)
+        m_Blocks[block.NextFree].PrevFree = block.PrevFree;
+
+    block.PrevFree = Null;
+    block.NextFree = Null;
+
+    // 链表空了, 清除对应的位
+    if (m_FreeHeads[fl][sl] == Null)
+    {
+        m_SlBitmap[fl] &= ~(1u << sl);
+        if (m_SlBitmap[fl] == 0)
+            m_FlBitmap &= ~(static_cast<std::uint64_t>(1) << fl);
+    }
+}
+
+std::uint32_t RainDX::TlsfAllocator::Split(std::uint32_t index, std::uint64_t size)
+{
+    // NewBlock 可能使 m_Blocks 扩容, 之后再取引用
+    std::uint32_t rest = NewBlock();
+    Block& block = m_Blocks[index];
+    Block& restBlock = m_Blocks[rest];
+
+    assert(size < block.Size);
+    restBlock.Offset = block.Offset + size;
+    restBlock.Size = block.Size - size;
+    restBlock.PrevPhys = index;
+    restBlock.NextPhys = block.NextPhys;
+    restBlock.Free = false;
+    if (block.NextPhys != Null)
+        m_Blocks[block.NextPhys].PrevPhys = rest;
+
+    block.Size = size;
+    block.NextPhys = rest;
+    return rest;
+}
+
+void RainDX::TlsfAllocator::MergeNext(std::uint32_t index)
+{
+    Block& block = m_Blocks[index];
+    std::uint32_t next = block.NextPhys;
+    Block& nextBlock = m_Blocks[next];
+
+    block.Size += nextBlock.Size;
+    block.NextPhys = nextBlock.NextPhys;
+    if (nextBlock.NextPhys != Null)
+        m_Blocks[nextBlock.NextPhys].PrevPhys = index;
+
+    DeleteBlock(next);
+}
+
+std::uint32_t RainDX::TlsfAllocator::NewBlock()
+{
+    if (!m_UnusedBlocks.empty())
+    {
+        std::uint32_t index = m_UnusedBlocks.back();
+        m_UnusedBlocks.pop_back();
+        return index;
+    }
+
+    m_Blocks.emplace_back();
+    return static_cast<std::uint32_t>(m_Blocks.size() - 1);
+}
+
+void RainDX::TlsfAllocator::DeleteBlock(std::uint32_t index)
+{
+    m_Blocks[index] = Block();
+    m_UnusedBlocks.push_back(index);
+}
@@ -0,0 +1,202 @@
+#include "d3d/DescriptorAllocator.h"
+#include <cassert>
+#include "d3d/d3dUtil.h"
+#include "d3d/DxException.h"
+
+RainDX::DescriptorStagingHeap::DescriptorStagingHeap(RenderDevice* device, D3D12_DESCRIPTOR_HEAP_TYPE type,
+                                                     UINT pageSize) :
+    m_Device(device), m_Type(type), m_PageSize(pageSize)
+{
+    assert(pageSize > 0);
+    m_DescriptorSize = device->DescriptorSize(type);
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE RainDX::DescriptorStagingHeap::Allocate()
+{
+    if (m_FreeList.empty())
+        AddPage();
+
+    UINT index = m_FreeList.back();
+    m_FreeList.pop_back();
+    m_Allocated[index] = true;
+    UINT page = index / m_PageSize;
+    UINT slot = index % m_PageSize;
+    return {m_PageStarts[page] + static_cast<SIZE_T>(slot) * m_DescriptorSize};
+}
+
+void RainDX::DescriptorStagingHeap::Free(D3D12_CPU_DESCRIPTOR_HANDLE handle)
+{
+    // 页数很少, 直接按地址范围查找
+    const SIZE_T pageBytes = static_cast<SIZE_T>(m_PageSize) * m_DescriptorSize;
+    for (UINT page = 0; page < PageCount(); ++page)
+    {
+        SIZE_T start = m_PageStarts[page];
+        if (handle.ptr < start || handle.ptr >= start + pageBytes)
+            continue;
+
+        assert((handle.ptr - start) % m_DescriptorSize == 0);
+        UINT index = page * m_PageSize + static_cast<UINT>((handle.ptr - start) / m_DescriptorSize);
+        assert(m_Allocated[index] && "Descriptor freed twice.");
+        m_Allocated[index] = false;
+        m_FreeList.push_back(index);
+        return;
+    }
+    assert(false && "Descriptor does not belong to this heap.");
+}
+
+D3D12_DESCRIPTOR_HEAP_TYPE RainDX::DescriptorStagingHeap::Type() const
+{
+    return m_Type;
+}
+
+UINT RainDX::DescriptorStagingHeap::PageCount() const
+{
+    return static_cast<UINT>(m_Pages.size());
+}
+
+UINT RainDX::DescriptorStagingHeap::Capacity() const
+{
+    return PageCount() * m_PageSize;
+}
+
+UINT RainDX::DescriptorStagingHeap::Allocated() const
+{
+    return Capacity() - static_cast<UINT>(m_FreeList.size());
+}
+
+void RainDX::DescriptorStagingHeap::AddPage()
+{
+    D3D12_DESCRIPTOR_HEAP_DESC desc;
+    desc.NumDescriptors = m_PageSize;
+    desc.Type = m_Type;
+    desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+    desc.NodeMask = 0;
+    m_Pages.push_back(m_Device->CreateDescriptorHeap(desc));
+    m_PageStarts.push_back(m_Pages.back()->GetCPUDescriptorHandleForHeapStart().ptr);
+
+    // 倒序压入, 新页从第一个描述符开始分配
+    UINT first = (PageCount() - 1) * m_PageSize;
+    for (UINT i = m_PageSize; i > 0; --i)
+        m_FreeList.push_back(first + i - 1);
+    m_Allocated.resize(Capacity(), false);
+}
+
+RainDX::DescriptorRing::DescriptorRing(RenderDevice* device, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT count) :
+    m_Device(device), m_Fence(device->Fence()), m_Type(type), m_Capacity(count)
+{
+    assert(type == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV || type == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+    assert(count > 0);
+    m_DescriptorSize = device->DescriptorSize(type);
+
+    D3D12_DESCRIPTOR_HEAP_DESC desc;
+    desc.NumDescriptors = count;
+    desc.Type = type;
+    desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    desc.NodeMask = 0;
+    m_Heap = device->CreateDescriptorHeap(desc);
+    m_CpuBase = m_Heap->GetCPUDescriptorHandleForHeapStart();
+    m_GpuBase = m_Heap->GetGPUDescriptorHandleForHeapStart();
+}
+
+RainDX::DescriptorTable RainDX::DescriptorRing::Allocate(UINT count)
+{
+    assert(count > 0);
+
+    UINT64 head = 0;
+    for (;;)
+    {
+        // 环中没有任何描述符时从头开始, 回绕跳过的空间不再占用容量
+        if (m_Frames.empty() && m_Head == m_Tail)
+            m_Head = m_Tail = 0;
+
+        head = WrappedHead(count);
+        if (head + count - m_Tail <= m_Capacity)
+            break;
+
+        // 表大于整个环, 或当前帧自己就占满了整个环, 等待 GPU 也放不下
+        if (m_Frames.empty())
+            throw DxException(E_OUTOFMEMORY, L"DescriptorRing::Allocate", AnsiToWString(__FILE__), __LINE__);
+
+        // 追上了 GPU 尚未读取的描述符, 等待最早的帧完成
+        m_Fence->Wait(m_Frames.front().Fence);
+        Retire(m_Fence->CompletedValue());
+    }
+
+    m_Head = head + count;
+
+    UINT64 index = head % m_Capacity;
+    DescriptorTable table;
+    table.Cpu.ptr = m_CpuBase.ptr + static_cast<SIZE_T>(index * m_DescriptorSize);
+    table.Gpu.ptr = m_GpuBase.ptr + index * m_DescriptorSize;
+    table.Count = count;
+    return table;
+}
+
+RainDX::DescriptorTable RainDX::DescriptorRing::Stage(const D3D12_CPU_DESCRIPTOR_HANDLE* src, UINT count)
+{
+    DescriptorTable table = Allocate(count);
+    m_DstStarts.push_back(table.Cpu);
+    m_DstSizes.push_back(count);
+    m_SrcStarts.insert(m_SrcStarts.end(), src, src + count);
+    return table;
+}
+
+void RainDX::DescriptorRing::Flush()
+{
+    if (m_DstStarts.empty())
+        return;
+
+    // 源范围的大小都为 1, 传空指针
+    m_Device->CopyDescriptors(
+        static_cast<UINT>(m_DstStarts.size()), m_DstStarts.data(), m_DstSizes.data(),
+        static_cast<UINT>(m_SrcStarts.size()), m_SrcStarts.data(), nullptr,
+        m_Type);
+
+    m_DstStarts.clear();
+    m_DstSizes.clear();
+    m_SrcStarts.clear();
+}
+
+void RainDX::DescriptorRing::FinishFrame(std::uint64_t fence)
+{
+    assert(m_DstStarts.empty() && "Staged descriptors were not flushed before submission.");
+    m_Frames.push_back({fence, m_Head});
+}
+
+void RainDX::DescriptorRing::Retire(std::uint64_t completedFence)
+{
+    while (!m_Frames.empty() && m_Frames.front().Fence <= completedFence)
+    {
+        m_Tail = m_Frames.front().Head;
+        m_Frames.pop_front();
+    }
+}
+
+ID3D12DescriptorHeap* RainDX::DescriptorRing::Heap() const
+{
+    return m_Heap.Get();
+}
+
+UINT RainDX::DescriptorRing::Capacity() const
+{
+    return m_Capacity;
+}
+
+UINT RainDX::DescriptorRing::Used() const
+{
+    return static_cast<UINT>(m_Head - m_Tail);
+}
+
+UINT RainDX::DescriptorRing::Pending() const
+{
+    return static_cast<UINT>(m_SrcStarts.size());
+}
+
+UINT64 RainDX::DescriptorRing::WrappedHead(UINT count) const
+{
+    // 描述符表必须连续, 剩余空间放不下时跳到堆开头
+    UINT64 index = m_Head % m_Capacity;
+    if (index + count > m_Capacity)
+        return m_Head + (m_Capacity - index);
+    return m_Head;
+}
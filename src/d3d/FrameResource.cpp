@@ -0,0 +1,38 @@
+#include "d3d/FrameResource.h"
+#include "d3d/DxException.h"
+
+RainDX::D3D12FrameFence::D3D12FrameFence(ID3D12CommandQueue* queue, ID3D12Fence* fence) :
+    m_Queue(queue), m_Fence(fence)
+{
+    m_Value = m_Fence->GetCompletedValue();
+    m_Event = CreateEventEx(nullptr, nullptr, false, EVENT_ALL_ACCESS);
+}
+
+RainDX::D3D12FrameFence::~D3D12FrameFence()
+{
+    if (m_Event != nullptr)
+        CloseHandle(m_Event);
+}
+
+std::uint64_t RainDX::D3D12FrameFence::Signal()
+{
+    ++m_Value;
+    // GPU 执行完之前的命令后才会写入该值
+    ThrowIfFailed(m_Queue->Signal(m_Fence, m_Value))
+    return m_Value;
+}
+
+std::uint64_t RainDX::D3D12FrameFence::CompletedValue() const
+{
+    return m_Fence->GetCompletedValue();
+}
+
+void RainDX::D3D12FrameFence::Wait(std::uint64_t value)
+{
+    if (m_Fence->GetCompletedValue() >= value)
+        return;
+
+    // 当 GPU 完成到 value 这个围栏点的命令时，触发事件
+    ThrowIfFailed(m_Fence->SetEventOnCompletion(value, m_Event))
+    WaitForSingleObject(m_Event, INFINITE);
+}
@@ -0,0 +1,165 @@
+#include "d3d/HeapAllocator.h"
+#include <cassert>
+
+using Microsoft::WRL::ComPtr;
+
+RainDX::HeapAllocator::HeapAllocator(RenderDevice* device, D3D12_HEAP_TYPE heapType, D3D12_HEAP_FLAGS heapFlags,
+                                     UINT64 heapSize) :
+    m_Device(device), m_HeapType(heapType), m_HeapFlags(heapFlags)
+{
+    // 允许渲染目标和深度纹理的堆可能放置多重采样资源, 需要 4MB 对齐
+    bool rtDs = (heapFlags & D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES) == 0;
+    m_HeapAlignment = rtDs ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    m_HeapSize = (heapSize + m_HeapAlignment - 1) & ~(m_HeapAlignment - 1);
+}
+
+RainDX::HeapAllocation RainDX::HeapAllocator::CreateBuffer(UINT64 byteSize, D3D12_RESOURCE_STATES initState)
+{
+    return CreateResource(CD3DX12_RESOURCE_DESC::Buffer(byteSize), initState);
+}
+
+RainDX::HeapAllocation RainDX::HeapAllocator::CreateResource(const D3D12_RESOURCE_DESC& desc,
+                                                             D3D12_RESOURCE_STATES initState,
+                                                             const D3D12_CLEAR_VALUE* clearValue)
+{
+    D3D12_RESOURCE_DESC placedDesc = desc;
+    D3D12_RESOURCE_ALLOCATION_INFO info;
+
+    // 小纹理可以按 4KB 放置, 设备拒绝时退回默认对齐
+    bool smallAlignment = desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER && desc.SampleDesc.Count <= 1 &&
+        (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) == 0;
+    if (smallAlignment)
+    {
+        placedDesc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+        info = m_Device->GetResourceAllocationInfo(placedDesc);
+        if (info.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+            smallAlignment = false;
+    }
+    if (!smallAlignment)
+    {
+        placedDesc.Alignment = 0;
+        info = m_Device->GetResourceAllocationInfo(placedDesc);
+    }
+    assert(info.Alignment <= m_HeapAlignment && "Resource alignment not supported by this heap type.");
+
+    HeapAllocation allocation;
+    UINT heapIndex = 0;
+    TlsfAllocation range;
+
+    if (info.SizeInBytes > m_HeapSize)
+    {
+        // 单独占用一个堆
+        heapIndex = AddHeap(info.SizeInBytes);
+        range = m_Heaps[heapIndex]->Range.Allocate(info.SizeInBytes, info.Alignment);
+    }
+    else
+    {
+        for (UINT i = 0; i < m_Heaps.size() && !range.IsValid(); ++i)
+        {
+            if (m_Heaps[i] == nullptr)
+                continue;
+            range = m_Heaps[i]->Range.Allocate(info.SizeInBytes, info.Alignment);
+            heapIndex = i;
+        }
+        if (!range.IsValid())
+        {
+            heapIndex = AddHeap(m_HeapSize);
+            range = m_Heaps[heapIndex]->Range.Allocate(info.SizeInBytes, info.Alignment);
+        }
+    }
+    assert(range.IsValid());
+
+    allocation.Resource = m_Device->CreatePlacedResource(
+        m_Heaps[heapIndex]->Native.Get(),
+        range.Offset,
+        placedDesc,
+        initState,
+        clearValue);
+    allocation.Heap = heapIndex;
+    allocation.Range = range;
+    return allocation;
+}
+
+void RainDX::HeapAllocator::Free(HeapAllocation& allocation)
+{
+    if (!allocation.IsValid())
+        return;
+
+    allocation.Resource.Reset();
+    Heap* heap = m_Heaps[allocation.Heap].get();
+    heap->Range.Free(allocation.Range);
+
+    // 独立的堆用完即释放
+    if (heap->Range.Empty() && heap->Range.Capacity() > m_HeapSize)
+        m_Heaps[allocation.Heap].reset();
+
+    allocation = HeapAllocation();
+}
+
+void RainDX::HeapAllocator::Free(HeapAllocation& allocation, std::uint64_t fence)
+{
+    if (!allocation.IsValid())
+        return;
+
+    m_PendingFrees.push_back({fence, std::move(allocation)});
+    allocation = HeapAllocation();
+}
+
+void RainDX::HeapAllocator::Retire()
+{
+    std::uint64_t completed = m_Device->Fence()->CompletedValue();
+    while (!m_PendingFrees.empty() && m_PendingFrees.front().Fence <= completed)
+    {
+        Free(m_PendingFrees.front().Allocation);
+        m_PendingFrees.pop_front();
+    }
+}
+
+UINT RainDX::HeapAllocator::HeapCount() const
+{
+    UINT count = 0;
+    for (const auto& heap : m_Heaps)
+    {
+        if (heap != nullptr)
+            ++count;
+    }
+    return count;
+}
+
+std::vector<RainDX::HeapStats> RainDX::HeapAllocator::Stats() const
+{
+    std::vector<HeapStats> stats;
+    for (UINT i = 0; i < m_Heaps.size(); ++i)
+    {
+        if (m_Heaps[i] == nullptr)
+            continue;
+        stats.push_back({i, m_Heaps[i]->Range.Stats()});
+    }
+    return stats;
+}
+
+UINT RainDX::HeapAllocator::AddHeap(UINT64 size)
+{
+    size = (size + m_HeapAlignment - 1) & ~(m_HeapAlignment - 1);
+
+    D3D12_HEAP_DESC desc = {};
+    desc.SizeInBytes = size;
+    desc.Properties = CD3DX12_HEAP_PROPERTIES(m_HeapType);
+    desc.Alignment = m_HeapAlignment;
+    desc.Flags = m_HeapFlags;
+
+    auto heap = std::make_unique<Heap>(size, D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT);
+    heap->Native = m_Device->CreateHeap(desc);
+
+    // 优先复用已释放的位置
+    for (UINT i = 0; i < m_Heaps.size(); ++i)
+    {
+        if (m_Heaps[i] == nullptr)
+        {
+            m_Heaps[i] = std::move(heap);
+            return i;
+        }
+    }
+    m_Heaps.push_back(std::move(heap));
+    return static_cast<UINT>(m_Heaps.size() - 1);
+}
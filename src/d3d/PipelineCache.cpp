@@ -0,0 +1,377 @@
+#include "d3d/PipelineCache.h"
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include "d3d/DxException.h"
+#include "shader/ShaderCache.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    // 逐字段累加哈希, 结构体中的填充字节不参与
+    class KeyHasher
+    {
+    public:
+        template <typename T>
+        void Add(const T& value)
+        {
+            m_Hash = RainDX::ShaderCache::Hash(&value, sizeof(value), m_Hash);
+        }
+
+        void AddBytes(const void* data, std::size_t size)
+        {
+            Add(static_cast<std::uint64_t>(size));
+            m_Hash = RainDX::ShaderCache::Hash(data, size, m_Hash);
+        }
+
+        void AddString(const char* text)
+        {
+            AddBytes(text, text != nullptr ? strlen(text) : 0);
+        }
+
+        void AddShader(const D3D12_SHADER_BYTECODE& shader)
+        {
+            AddBytes(shader.pShaderBytecode, shader.pShaderBytecode != nullptr ? shader.BytecodeLength : 0);
+        }
+
+        void AddStencilOp(const D3D12_DEPTH_STENCILOP_DESC& op)
+        {
+            Add(op.StencilFailOp);
+            Add(op.StencilDepthFailOp);
+            Add(op.StencilPassOp);
+            Add(op.StencilFunc);
+        }
+
+        std::uint64_t Value() const { return m_Hash; }
+
+    private:
+        std::uint64_t m_Hash = 14695981039346656037ull;
+    };
+
+    // 管线库中的名字
+    std::wstring LibraryName(std::uint64_t key)
+    {
+        static const wchar_t digits[] = L"0123456789abcdef";
+        std::wstring name(16, L'0');
+        for (int i = 15; i >= 0; --i)
+        {
+            name[i] = digits[key & 0xf];
+            key >>= 4;
+        }
+        return name;
+    }
+
+    void CopyShader(const D3D12_SHADER_BYTECODE& src, std::vector<char>& storage, D3D12_SHADER_BYTECODE& dst)
+    {
+        if (src.pShaderBytecode == nullptr || src.BytecodeLength == 0)
+        {
+            dst = {};
+            return;
+        }
+        const char* bytes = static_cast<const char*>(src.pShaderBytecode);
+        storage.assign(bytes, bytes + src.BytecodeLength);
+        dst = {storage.data(), storage.size()};
+    }
+
+    bool ReadFile(const std::wstring& path, std::vector<char>& data)
+    {
+        std::ifstream in(std::filesystem::path(path), std::ios::binary);
+        if (!in)
+            return false;
+        in.seekg(0, std::ios::end);
+        data.resize(static_cast<std::size_t>(in.tellg()));
+        in.seekg(0, std::ios::beg);
+        return data.empty() || static_cast<bool>(in.read(data.data(), data.size()));
+    }
+}
+
+RainDX::PipelineCache::PipelineCache(ID3D12Device* device, JobSystem& jobs, const std::wstring& libraryPath) :
+    m_Device(device),
+    m_Jobs(jobs),
+    m_LibraryPath(libraryPath)
+{
+    // 管线库需要 ID3D12Device1
+    ComPtr<ID3D12Device1> device1;
+    if (FAILED(m_Device.As(&device1)))
+        return;
+
+    // 驱动或显卡变化后旧的库无法使用, 此时从空库开始
+    HRESULT hr = E_FAIL;
+    if (ReadFile(m_LibraryPath, m_LibraryBlob) && !m_LibraryBlob.empty())
+        hr = device1->CreatePipelineLibrary(m_LibraryBlob.data(), m_LibraryBlob.size(), IID_PPV_ARGS(&m_Library));
+    if (FAILED(hr))
+    {
+        m_LibraryBlob.clear();
+        m_Library.Reset();
+        if (FAILED(device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&m_Library))))
+            m_Library.Reset();
+    }
+}
+
+RainDX::PipelineCache::~PipelineCache()
+{
+    WaitAll();
+}
+
+std::uint64_t RainDX::PipelineCache::Request(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, std::uint64_t rootSignatureHash)
+{
+    // 流输出不在键中, 不支持
+    assert(desc.StreamOutput.NumEntries == 0);
+
+    const std::uint64_t key = ComputeKey(desc, rootSignatureHash);
+    Entry* entry = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_EntryMutex);
+        std::unique_ptr<Entry>& slot = m_Entries[key];
+        if (slot != nullptr)
+            return key;
+        slot = std::make_unique<Entry>();
+        entry = slot.get();
+    }
+
+    entry->Desc = desc;
+    CopyShader(desc.VS, entry->Shaders[0], entry->Desc.VS);
+    CopyShader(desc.PS, entry->Shaders[1], entry->Desc.PS);
+    CopyShader(desc.DS, entry->Shaders[2], entry->Desc.DS);
+    CopyShader(desc.HS, entry->Shaders[3], entry->Desc.HS);
+    CopyShader(desc.GS, entry->Shaders[4], entry->Desc.GS);
+
+    const UINT elementCount = desc.InputLayout.NumElements;
+    entry->SemanticNames.resize(elementCount);
+    entry->InputLayout.assign(desc.InputLayout.pInputElementDescs, desc.InputLayout.pInputElementDescs + elementCount);
+    for (UINT i = 0; i < elementCount; ++i)
+    {
+        entry->SemanticNames[i] = entry->InputLayout[i].SemanticName;
+        entry->InputLayout[i].SemanticName = entry->SemanticNames[i].c_str();
+    }
+    entry->Desc.InputLayout = {entry->InputLayout.data(), elementCount};
+
+    entry->RootSignature = desc.pRootSignature;
+    entry->Desc.pRootSignature = entry->RootSignature.Get();
+    // 驱动的缓存由管线库负责
+    entry->Desc.CachedPSO = {};
+
+    m_Jobs.Run([this, key, entry] { Create(key, *entry); }, &entry->Counter);
+    return key;
+}
+
+ID3D12PipelineState* RainDX::PipelineCache::Get(std::uint64_t key, ID3D12PipelineState* fallback) const
+{
+    Entry* entry = Find(key);
+    if (entry == nullptr || !entry->Ready.load(std::memory_order_acquire) || entry->Pso == nullptr)
+        return fallback;
+    return entry->Pso.Get();
+}
+
+bool RainDX::PipelineCache::IsReady(std::uint64_t key) const
+{
+    Entry* entry = Find(key);
+    return entry != nullptr && entry->Ready.load(std::memory_order_acquire);
+}
+
+ID3D12PipelineState* RainDX::PipelineCache::Wait(std::uint64_t key)
+{
+    Entry* entry = Find(key);
+    assert(entry != nullptr);
+    m_Jobs.Wait(entry->Counter);
+    ThrowIfFailed(entry->Result);
+    return entry->Pso.Get();
+}
+
+void RainDX::PipelineCache::WaitAll()
+{
+    std::vector<Entry*> entries;
+    {
+        std::lock_guard<std::mutex> lock(m_EntryMutex);
+        for (const auto& pair : m_Entries)
+            entries.push_back(pair.second.get());
+    }
+    for (Entry* entry : entries)
+        m_Jobs.Wait(entry->Counter);
+}
+
+bool RainDX::PipelineCache::Save()
+{
+    WaitAll();
+
+    std::lock_guard<std::mutex> lock(m_LibraryMutex);
+    if (m_Library == nullptr || !m_LibraryDirty)
+        return true;
+
+    std::vector<char> data(m_Library->GetSerializedSize());
+    if (FAILED(m_Library->Serialize(data.data(), data.size())))
+        return false;
+
+    std::error_code error;
+    const std::filesystem::path target(m_LibraryPath);
+    if (target.has_parent_path())
+        std::filesystem::create_directories(target.parent_path(), error);
+    std::filesystem::path temp = target;
+    temp += L"." + std::to_wstring(std::chrono::steady_clock::now().time_since_epoch().count()) + L".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size());
+        if (!out)
+        {
+            out.close();
+            std::filesystem::remove(temp, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temp, target, error);
+    if (error)
+    {
+        std::filesystem::remove(temp, error);
+        return false;
+    }
+    m_LibraryDirty = false;
+    return true;
+}
+
+RainDX::PipelineCacheStats RainDX::PipelineCache::Stats() const
+{
+    PipelineCacheStats stats;
+    stats.LibraryHits = m_LibraryHits.load();
+    stats.Compiled = m_Compiled.load();
+    stats.Failed = m_Failed.load();
+
+    std::lock_guard<std::mutex> lock(m_EntryMutex);
+    for (const auto& pair : m_Entries)
+    {
+        if (!pair.second->Ready.load(std::memory_order_acquire))
+            ++stats.Pending;
+    }
+    return stats;
+}
+
+std::uint64_t RainDX::PipelineCache::ComputeKey(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, std::uint64_t rootSignatureHash)
+{
+    KeyHasher hasher;
+    hasher.Add(rootSignatureHash);
+    hasher.AddShader(desc.VS);
+    hasher.AddShader(desc.PS);
+    hasher.AddShader(desc.DS);
+    hasher.AddShader(desc.HS);
+    hasher.AddShader(desc.GS);
+
+    const D3D12_BLEND_DESC& blend = desc.BlendState;
+    hasher.Add(blend.AlphaToCoverageEnable);
+    hasher.Add(blend.IndependentBlendEnable);
+    for (const D3D12_RENDER_TARGET_BLEND_DESC& target : blend.RenderTarget)
+    {
+        hasher.Add(target.BlendEnable);
+        hasher.Add(target.LogicOpEnable);
+        hasher.Add(target.SrcBlend);
+        hasher.Add(target.DestBlend);
+        hasher.Add(target.BlendOp);
+        hasher.Add(target.SrcBlendAlpha);
+        hasher.Add(target.DestBlendAlpha);
+        hasher.Add(target.BlendOpAlpha);
+        hasher.Add(target.LogicOp);
+        hasher.Add(target.RenderTargetWriteMask);
+    }
+    hasher.Add(desc.SampleMask);
+
+    const D3D12_RASTERIZER_DESC& raster = desc.RasterizerState;
+    hasher.Add(raster.FillMode);
+    hasher.Add(raster.CullMode);
+    hasher.Add(raster.FrontCounterClockwise);
+    hasher.Add(raster.DepthBias);
+    hasher.Add(raster.DepthBiasClamp);
+    hasher.Add(raster.SlopeScaledDepthBias);
+    hasher.Add(raster.DepthClipEnable);
+    hasher.Add(raster.MultisampleEnable);
+    hasher.Add(raster.AntialiasedLineEnable);
+    hasher.Add(raster.ForcedSampleCount);
+    hasher.Add(raster.ConservativeRaster);
+
+    const D3D12_DEPTH_STENCIL_DESC& depth = desc.DepthStencilState;
+    hasher.Add(depth.DepthEnable);
+    hasher.Add(depth.DepthWriteMask);
+    hasher.Add(depth.DepthFunc);
+    hasher.Add(depth.StencilEnable);
+    hasher.Add(depth.StencilReadMask);
+    hasher.Add(depth.StencilWriteMask);
+    hasher.AddStencilOp(depth.FrontFace);
+    hasher.AddStencilOp(depth.BackFace);
+
+    // 语义名按内容参与, 不同的字符串指针得到相同的键
+    hasher.Add(desc.InputLayout.NumElements);
+    for (UINT i = 0; i < desc.InputLayout.NumElements; ++i)
+    {
+        const D3D12_INPUT_ELEMENT_DESC& element = desc.InputLayout.pInputElementDescs[i];
+        hasher.AddString(element.SemanticName);
+        hasher.Add(element.SemanticIndex);
+        hasher.Add(element.Format);
+        hasher.Add(element.InputSlot);
+        hasher.Add(element.AlignedByteOffset);
+        hasher.Add(element.InputSlotClass);
+        hasher.Add(element.InstanceDataStepRate);
+    }
+
+    hasher.Add(desc.IBStripCutValue);
+    hasher.Add(desc.PrimitiveTopologyType);
+    hasher.Add(desc.NumRenderTargets);
+    for (UINT i = 0; i < desc.NumRenderTargets; ++i)
+        hasher.Add(desc.RTVFormats[i]);
+    hasher.Add(desc.DSVFormat);
+    hasher.Add(desc.SampleDesc.Count);
+    hasher.Add(desc.SampleDesc.Quality);
+    hasher.Add(desc.NodeMask);
+    hasher.Add(desc.Flags);
+    return hasher.Value();
+}
+
+void RainDX::PipelineCache::Create(std::uint64_t key, Entry& entry)
+{
+    const std::wstring name = LibraryName(key);
+    ComPtr<ID3D12PipelineState> pso;
+    HRESULT hr = E_FAIL;
+    if (m_Library != nullptr)
+    {
+        // 描述与库中保存的不一致时返回 E_INVALIDARG, 当作未命中
+        std::lock_guard<std::mutex> lock(m_LibraryMutex);
+        hr = m_Library->LoadGraphicsPipeline(name.c_str(), &entry.Desc, IID_PPV_ARGS(&pso));
+    }
+
+    if (SUCCEEDED(hr))
+    {
+        ++m_LibraryHits;
+    }
+    else
+    {
+        pso.Reset();
+        hr = m_Device->CreateGraphicsPipelineState(&entry.Desc, IID_PPV_ARGS(&pso));
+        if (SUCCEEDED(hr))
+        {
+            ++m_Compiled;
+            if (m_Library != nullptr)
+            {
+                // 同名条目已存在时 StorePipeline 失败, 旧条目保留
+                std::lock_guard<std::mutex> lock(m_LibraryMutex);
+                if (SUCCEEDED(m_Library->StorePipeline(name.c_str(), pso.Get())))
+                    m_LibraryDirty = true;
+            }
+        }
+        else
+        {
+            ++m_Failed;
+            pso.Reset();
+        }
+    }
+
+    entry.Pso = pso;
+    entry.Result = hr;
+    entry.Ready.store(true, std::memory_order_release);
+}
+
+RainDX::PipelineCache::Entry* RainDX::PipelineCache::Find(std::uint64_t key) const
+{
+    std::lock_guard<std::mutex> lock(m_EntryMutex);
+    auto it = m_Entries.find(key);
+    return it != m_Entries.end() ? it->second.get() : nullptr;
+}
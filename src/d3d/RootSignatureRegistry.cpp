@@ -0,0 +1,225 @@
+#include "d3d/RootSignatureRegistry.h"
+#include <cassert>
+#include "d3d/DxException.h"
+#include "shader/ShaderCache.h"
+
+using Microsoft::WRL::ComPtr;
+
+RainDX::RootSignatureLayout& RainDX::RootSignatureLayout::AddConstants(
+    UINT num32BitValues, UINT shaderRegister, UINT space, D3D12_SHADER_VISIBILITY visibility)
+{
+    Parameter parameter;
+    parameter.Type = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+    parameter.Visibility = visibility;
+    parameter.Num32BitValues = num32BitValues;
+    parameter.ShaderRegister = shaderRegister;
+    parameter.Space = space;
+    m_Parameters.push_back(parameter);
+    assert(Size() <= MaxSize);
+    return *this;
+}
+
+RainDX::RootSignatureLayout& RainDX::RootSignatureLayout::AddCbv(
+    UINT shaderRegister, UINT space, D3D12_SHADER_VISIBILITY visibility)
+{
+    return AddDescriptor(D3D12_ROOT_PARAMETER_TYPE_CBV, shaderRegister, space, visibility);
+}
+
+RainDX::RootSignatureLayout& RainDX::RootSignatureLayout::AddSrv(
+    UINT shaderRegister, UINT space, D3D12_SHADER_VISIBILITY visibility)
+{
+    return AddDescriptor(D3D12_ROOT_PARAMETER_TYPE_SRV, shaderRegister, space, visibility);
+}
+
+RainDX::RootSignatureLayout& RainDX::RootSignatureLayout::AddUav(
+    UINT shaderRegister, UINT space, D3D12_SHADER_VISIBILITY visibility)
+{
+    return AddDescriptor(D3D12_ROOT_PARAMETER_TYPE_UAV, shaderRegister, space, visibility);
+}
+
+RainDX::RootSignatureLayout& RainDX::RootSignatureLayout::AddTable(
+    const std::vector<D3D12_DESCRIPTOR_RANGE>& ranges, D3D12_SHADER_VISIBILITY visibility)
+{
+    assert(!ranges.empty());
+    Parameter parameter;
+    parameter.Type = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+    parameter.Visibility = visibility;
+    parameter.Ranges = ranges;
+    m_Parameters.push_back(std::move(parameter));
+    assert(Size() <= MaxSize);
+    return *this;
+}
+
+RainDX::RootSignatureLayout& RainDX::RootSignatureLayout::SetFlags(D3D12_ROOT_SIGNATURE_FLAGS flags)
+{
+    m_Flags = flags;
+    return *this;
+}
+
+UINT RainDX::RootSignatureLayout::ParameterCount() const
+{
+    return static_cast<UINT>(m_Parameters.size());
+}
+
+UINT RainDX::RootSignatureLayout::Size() const
+{
+    UINT size = 0;
+    for (const Parameter& parameter : m_Parameters)
+    {
+        switch (parameter.Type)
+        {
+        case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+            size += parameter.Num32BitValues;
+            break;
+        case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+            size += 1;
+            break;
+        default:
+            size += 2;
+            break;
+        }
+    }
+    return size;
+}
+
+std::vector<std::uint32_t> RainDX::RootSignatureLayout::Encoding() const
+{
+    std::vector<std::uint32_t> code;
+    code.push_back(static_cast<std::uint32_t>(m_Flags));
+    code.push_back(static_cast<std::uint32_t>(m_Parameters.size()));
+    for (const Parameter& parameter : m_Parameters)
+    {
+        code.push_back(static_cast<std::uint32_t>(parameter.Type));
+        code.push_back(static_cast<std::uint32_t>(parameter.Visibility));
+        if (parameter.Type != D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE)
+        {
+            code.push_back(parameter.Num32BitValues);
+            code.push_back(parameter.ShaderRegister);
+            code.push_back(parameter.Space);
+            continue;
+        }
+
+        code.push_back(static_cast<std::uint32_t>(parameter.Ranges.size()));
+        for (const D3D12_DESCRIPTOR_RANGE& range : parameter.Ranges)
+        {
+            code.push_back(static_cast<std::uint32_t>(range.RangeType));
+            code.push_back(range.NumDescriptors);
+            code.push_back(range.BaseShaderRegister);
+            code.push_back(range.RegisterSpace);
+            code.push_back(range.OffsetInDescriptorsFromTableStart);
+        }
+    }
+    return code;
+}
+
+std::uint64_t RainDX::RootSignatureLayout::Hash() const
+{
+    std::vector<std::uint32_t> code = Encoding();
+    return ShaderCache::Hash(code.data(), code.size() * sizeof(std::uint32_t));
+}
+
+ComPtr<ID3DBlob> RainDX::RootSignatureLayout::Serialize() const
+{
+    // 描述符表的范围直接指向 m_Parameters 中的数组
+    std::vector<D3D12_ROOT_PARAMETER> parameters(m_Parameters.size());
+    for (std::size_t i = 0; i < m_Parameters.size(); ++i)
+    {
+        const Parameter& src = m_Parameters[i];
+        D3D12_ROOT_PARAMETER& dst = parameters[i];
+        dst.ParameterType = src.Type;
+        dst.ShaderVisibility = src.Visibility;
+        switch (src.Type)
+        {
+        case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+            dst.Constants.Num32BitValues = src.Num32BitValues;
+            dst.Constants.ShaderRegister = src.ShaderRegister;
+            dst.Constants.RegisterSpace = src.Space;
+            break;
+        case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+            dst.DescriptorTable.NumDescriptorRanges = static_cast<UINT>(src.Ranges.size());
+            dst.DescriptorTable.pDescriptorRanges = src.Ranges.data();
+            break;
+        default:
+            dst.Descriptor.ShaderRegister = src.ShaderRegister;
+            dst.Descriptor.RegisterSpace = src.Space;
+            break;
+        }
+    }
+
+    CD3DX12_ROOT_SIGNATURE_DESC desc(static_cast<UINT>(parameters.size()), parameters.data(), 0, nullptr, m_Flags);
+    ComPtr<ID3DBlob> serialized = nullptr;
+    ComPtr<ID3DBlob> errorBlob = nullptr;
+    HRESULT hr = D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1,
+                                             serialized.GetAddressOf(), errorBlob.GetAddressOf());
+    if (errorBlob != nullptr)
+        OutputDebugStringA(static_cast<char*>(errorBlob->GetBufferPointer()));
+    ThrowIfFailed(hr);
+    return serialized;
+}
+
+RainDX::RootSignatureLayout& RainDX::RootSignatureLayout::AddDescriptor(
+    D3D12_ROOT_PARAMETER_TYPE type, UINT shaderRegister, UINT space, D3D12_SHADER_VISIBILITY visibility)
+{
+    Parameter parameter;
+    parameter.Type = type;
+    parameter.Visibility = visibility;
+    parameter.ShaderRegister = shaderRegister;
+    parameter.Space = space;
+    m_Parameters.push_back(parameter);
+    assert(Size() <= MaxSize);
+    return *this;
+}
+
+RainDX::RootSignatureRegistry::RootSignatureRegistry(ID3D12Device* device) :
+    m_Device(device)
+{
+}
+
+RainDX::RootSignatureHandle RainDX::RootSignatureRegistry::Get(const RootSignatureLayout& layout)
+{
+    std::vector<std::uint32_t> encoding = layout.Encoding();
+    RootSignatureHandle handle;
+    handle.Hash = ShaderCache::Hash(encoding.data(), encoding.size() * sizeof(std::uint32_t));
+
+    // 创建根签名很快, 直接在锁内完成, 同一布局不会被并发创建两次
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::vector<Entry>& bucket = m_Entries[handle.Hash];
+    for (const Entry& entry : bucket)
+    {
+        if (entry.Encoding == encoding)
+        {
+            ++m_Stats.Reused;
+            handle.Signature = entry.Signature.Get();
+            return handle;
+        }
+    }
+
+    ComPtr<ID3DBlob> serialized = layout.Serialize();
+    Entry entry;
+    entry.Encoding = std::move(encoding);
+    ThrowIfFailed(m_Device->CreateRootSignature(
+        0,
+        serialized->GetBufferPointer(),
+        serialized->GetBufferSize(),
+        IID_PPV_ARGS(&entry.Signature)));
+
+    ++m_Stats.Created;
+    handle.Signature = entry.Signature.Get();
+    bucket.push_back(std::move(entry));
+    return handle;
+}
+
+std::size_t RainDX::RootSignatureRegistry::Count() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::size_t count = 0;
+    for (const auto& pair : m_Entries)
+        count += pair.second.size();
+    return count;
+}
+
+RainDX::RootSignatureStats RainDX::RootSignatureRegistry::Stats() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Stats;
+}
@@ -51,6 +51,8 @@ void Timer::Reset()
 
     m_BaseTime = curTime;
     m_PrevTime = curTime;
+    m_CurTime = curTime;
+    m_PausedTime = 0;
     m_StopTime = 0;
     m_IsStop = false;
 }
@@ -103,10 +105,22 @@ void Timer::Tick()
     __int64 curTime;
     QueryPerformanceCounter(reinterpret_cast<LARGE_INTEGER*>(&curTime));
     m_CurTime = curTime;
-    m_PrevTime = m_CurTime;
 
     // Time difference between this frame and the previous.
     m_DeltaTime = static_cast<double>(m_CurTime - m_PrevTime) * m_SecondsPerCount;
+    m_PrevTime = m_CurTime;
 
     if (m_DeltaTime < 0.0) m_DeltaTime = 0.0;
+
+    m_Stats.AddFrame(m_DeltaTime * 1000.0);
+}
+
+const RainDX::FrameStats& Timer::Stats() const
+{
+    return m_Stats;
+}
+
+RainDX::FrameStats& Timer::Stats()
+{
+    return m_Stats;
 }
@@ -0,0 +1,247 @@
+#include "d3d/UploadBatcher.h"
+#include <cassert>
+#include <cstring>
+#include "d3d/DxException.h"
+
+using Microsoft::WRL::ComPtr;
+
+RainDX::UploadBatcher::UploadBatcher(RenderDevice* device, UINT64 arenaSize, HeapAllocator* uploadHeap) :
+    m_Device(device), m_Fence(device->Fence()), m_UploadHeap(uploadHeap), m_Arena(device, arenaSize, uploadHeap)
+{
+    ComPtr<ID3D12CommandAllocator> alloc = m_Device->CreateCmdAlloc();
+    m_CmdList = m_Device->CreateCmdList(alloc.Get());
+    m_FreeAllocs.push_back(alloc);
+}
+
+RainDX::UploadBatcher::~UploadBatcher()
+{
+    // 暂存内存和保活的资源可能仍在被 GPU 读取
+    if (!m_InFlight.empty())
+        m_Fence->Wait(m_InFlight.back().Fence);
+
+    if (m_UploadHeap != nullptr)
+    {
+        // 未提交的暂存缓冲区 GPU 从未读取, 直接释放
+        for (HeapAllocation& placed : m_Current.Placed)
+            m_UploadHeap->Free(placed);
+        m_UploadHeap->Retire();
+    }
+}
+
+ComPtr<ID3D12Resource> RainDX::UploadBatcher::CreateBuffer(
+    const void* data,
+    UINT64 byteSize,
+    D3D12_RESOURCE_STATES finalState)
+{
+    // 缓冲区从 COMMON 开始, 第一次复制时隐式提升为 COPY_DEST
+    ComPtr<ID3D12Resource> buffer = m_Device->CreateBuffer(
+        D3D12_HEAP_TYPE_DEFAULT,
+        byteSize,
+        D3D12_RESOURCE_STATE_COMMON);
+
+    UploadBuffer(buffer.Get(), 0, data, byteSize, finalState);
+    return buffer;
+}
+
+void RainDX::UploadBatcher::UploadBuffer(
+    ID3D12Resource* dst,
+    UINT64 dstOffset,
+    const void* data,
+    UINT64 byteSize,
+    D3D12_RESOURCE_STATES finalState)
+{
+    ID3D12Resource* src = nullptr;
+    UINT64 srcOffset = 0;
+    BYTE* mapped = Stage(byteSize, 4, &src, &srcOffset);
+    memcpy(mapped, data, byteSize);
+
+    BeginBatch();
+    m_CmdList->CopyBufferRegion(dst, dstOffset, src, srcOffset, byteSize);
+    ++m_Pending;
+
+    // 屏障在 Submit 时放在所有复制之后, 同一批次中多次写入同一个缓冲区只需要一次状态转换
+    if (!m_Transitioned.insert({dst, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES}).second)
+        return;
+    m_Barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+        dst, D3D12_RESOURCE_STATE_COPY_DEST, finalState));
+    m_Current.KeepAlive.push_back(dst);
+}
+
+void RainDX::UploadBatcher::UploadTexture(
+    ID3D12Resource* dst,
+    UINT firstSubresource,
+    UINT numSubresources,
+    const D3D12_SUBRESOURCE_DATA* data,
+    D3D12_RESOURCE_STATES finalState)
+{
+    std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(numSubresources);
+    std::vector<UINT> numRows(numSubresources);
+    std::vector<UINT64> rowSizes(numSubresources);
+    UINT64 totalBytes = 0;
+
+    D3D12_RESOURCE_DESC desc = dst->GetDesc();
+    m_Device->GetCopyableFootprints(desc, firstSubresource, numSubresources, 0,
+                                    layouts.data(), numRows.data(), rowSizes.data(), &totalBytes);
+
+    ID3D12Resource* src = nullptr;
+    UINT64 srcOffset = 0;
+    BYTE* mapped = Stage(totalBytes, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, &src, &srcOffset);
+
+    // 按行复制, 上传缓冲区中每行按 256 字节对齐
+    for (UINT i = 0; i < numSubresources; ++i)
+    {
+        const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& layout = layouts[i];
+        const UINT depth = layout.Footprint.Depth;
+        const UINT64 dstSlicePitch = static_cast<UINT64>(layout.Footprint.RowPitch) * numRows[i];
+        BYTE* dstBase = mapped + layout.Offset;
+        const BYTE* srcBase = static_cast<const BYTE*>(data[i].pData);
+
+        for (UINT z = 0; z < depth; ++z)
+        {
+            for (UINT y = 0; y < numRows[i]; ++y)
+            {
+                memcpy(dstBase + dstSlicePitch * z + static_cast<UINT64>(layout.Footprint.RowPitch) * y,
+                       srcBase + data[i].SlicePitch * z + data[i].RowPitch * y,
+                       static_cast<std::size_t>(rowSizes[i]));
+            }
+        }
+    }
+
+    BeginBatch();
+    for (UINT i = 0; i < numSubresources; ++i)
+    {
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = layouts[i];
+        footprint.Offset += srcOffset;
+
+        CD3DX12_TEXTURE_COPY_LOCATION dstLoc(dst, firstSubresource + i);
+        CD3DX12_TEXTURE_COPY_LOCATION srcLoc(src, footprint);
+        m_CmdList->CopyTextureRegion(&dstLoc, &srcLoc);
+
+        if (m_Transitioned.insert({dst, firstSubresource + i}).second)
+        {
+            m_Barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+                dst, D3D12_RESOURCE_STATE_COPY_DEST, finalState, firstSubresource + i));
+        }
+    }
+    m_Current.KeepAlive.push_back(dst);
+    ++m_Pending;
+}
+
+std::uint64_t RainDX::UploadBatcher::Submit()
+{
+    if (m_Pending == 0)
+        return m_LastFence;
+
+    // 整个批次的状态转换只需一次调用
+    m_CmdList->ResourceBarrier(static_cast<UINT>(m_Barriers.size()), m_Barriers.data());
+    m_CmdList->Close();
+
+    RenderCmdList* cmdsLists[] = {m_CmdList.get()};
+    m_Device->Execute(_countof(cmdsLists), cmdsLists);
+
+    m_LastFence = m_Fence->Signal();
+    m_Arena.FinishFrame(m_LastFence);
+
+    m_Current.Fence = m_LastFence;
+    for (HeapAllocation& placed : m_Current.Placed)
+        m_UploadHeap->Free(placed, m_LastFence);
+    m_Current.Placed.clear();
+    m_InFlight.push_back(std::move(m_Current));
+    m_Current = Batch();
+    m_Barriers.clear();
+    m_Transitioned.clear();
+    m_Pending = 0;
+    m_Recording = false;
+
+    return m_LastFence;
+}
+
+void RainDX::UploadBatcher::Flush()
+{
+    m_Fence->Wait(Submit());
+    Retire();
+}
+
+void RainDX::UploadBatcher::Retire()
+{
+    std::uint64_t completed = m_Fence->CompletedValue();
+    m_Arena.Retire(completed);
+    if (m_UploadHeap != nullptr)
+        m_UploadHeap->Retire();
+
+    while (!m_InFlight.empty() && m_InFlight.front().Fence <= completed)
+    {
+        m_FreeAllocs.push_back(std::move(m_InFlight.front().CmdAlloc));
+        m_InFlight.pop_front();
+    }
+}
+
+std::size_t RainDX::UploadBatcher::PendingCount() const
+{
+    return m_Pending;
+}
+
+std::size_t RainDX::UploadBatcher::InFlightCount() const
+{
+    return m_InFlight.size();
+}
+
+BYTE* RainDX::UploadBatcher::Stage(UINT64 byteSize, UINT64 alignment, ID3D12Resource** src, UINT64* srcOffset)
+{
+    // 比整个暂存环还大, 单独创建上传缓冲区, 随批次一起回收
+    if (byteSize > m_Arena.Capacity())
+    {
+        ComPtr<ID3D12Resource> upload;
+        if (m_UploadHeap != nullptr)
+        {
+            m_Current.Placed.push_back(m_UploadHeap->CreateBuffer(byteSize, D3D12_RESOURCE_STATE_GENERIC_READ));
+            upload = m_Current.Placed.back().Resource;
+        }
+        else
+        {
+            upload = m_Device->CreateBuffer(
+                D3D12_HEAP_TYPE_UPLOAD,
+                byteSize,
+                D3D12_RESOURCE_STATE_GENERIC_READ);
+        }
+
+        BYTE* mapped = nullptr;
+        ThrowIfFailed(upload->Map(0, nullptr, reinterpret_cast<void**>(&mapped)))
+        // 上传堆的映射不影响 GPU 读取, 写完之后保持映射直到释放
+        m_Current.KeepAlive.push_back(upload);
+
+        *src = upload.Get();
+        *srcOffset = 0;
+        return mapped;
+    }
+
+    Retire();
+    // 暂存环已满, 先提交当前批次, 让环能够等待它完成后回收
+    if (!m_Arena.CanAllocate(byteSize, alignment))
+        Submit();
+
+    UploadSlice slice = m_Arena.Allocate(byteSize, alignment);
+    *src = m_Arena.Resource();
+    *srcOffset = slice.Offset;
+    return slice.Cpu;
+}
+
+void RainDX::UploadBatcher::BeginBatch()
+{
+    if (m_Recording)
+        return;
+
+    if (m_FreeAllocs.empty())
+    {
+        m_Current.CmdAlloc = m_Device->CreateCmdAlloc();
+    }
+    else
+    {
+        m_Current.CmdAlloc = std::move(m_FreeAllocs.back());
+        m_FreeAllocs.pop_back();
+    }
+
+    ThrowIfFailed(m_Current.CmdAlloc->Reset())
+    m_CmdList->Reset(m_Current.CmdAlloc.Get(), nullptr);
+    m_Recording = true;
+}
@@ -0,0 +1,127 @@
+#include "d3d/UploadRing.h"
+#include "d3d/d3dUtil.h"
+#include "d3d/DxException.h"
+
+RainDX::UploadRing::UploadRing(RenderDevice* device, UINT64 byteSize, HeapAllocator* heap) :
+    m_Fence(device->Fence()), m_Heap(heap)
+{
+    // 容量按 64KB 对齐, 保证回绕后的偏移仍然满足任意对齐要求
+    constexpr UINT64 alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    m_Capacity = (byteSize + alignment - 1) & ~(alignment - 1);
+
+    if (m_Heap != nullptr)
+    {
+        m_Placed = m_Heap->CreateBuffer(m_Capacity, D3D12_RESOURCE_STATE_GENERIC_READ);
+        m_UploadBuf = m_Placed.Resource;
+    }
+    else
+    {
+        m_UploadBuf = device->CreateBuffer(
+            D3D12_HEAP_TYPE_UPLOAD,
+            m_Capacity,
+            D3D12_RESOURCE_STATE_GENERIC_READ);
+    }
+
+    // 上传堆在整个生命周期内保持映射
+    ThrowIfFailed(m_UploadBuf->Map(0, nullptr, reinterpret_cast<void**>(&m_MappedPtr)))
+    m_GpuBase = m_UploadBuf->GetGPUVirtualAddress();
+}
+
+RainDX::UploadRing::~UploadRing()
+{
+    if (m_UploadBuf != nullptr)
+        m_UploadBuf->Unmap(0, nullptr);
+    m_MappedPtr = nullptr;
+    m_UploadBuf.Reset();
+    if (m_Placed.IsValid())
+        m_Heap->Free(m_Placed);
+}
+
+RainDX::UploadSlice RainDX::UploadRing::Allocate(UINT byteSize)
+{
+    // 常量缓冲区必须以 256 字节对齐
+    return Allocate(d3dUtil::ResizeConstBufSize(byteSize), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+}
+
+RainDX::UploadSlice RainDX::UploadRing::Allocate(UINT64 byteSize, UINT64 alignment)
+{
+    UINT64 size = byteSize;
+    UINT64 head = 0;
+    for (;;)
+    {
+        // 环中没有任何数据时从头开始, 回绕跳过的空间不再占用容量
+        if (m_Frames.empty() && m_Head == m_Tail)
+            m_Head = m_Tail = 0;
+
+        head = AlignedHead(size, alignment);
+        if (head + size - m_Tail <= m_Capacity)
+            break;
+
+        // 单次分配大于整个环, 或当前帧自己就占满了整个环, 等待 GPU 也放不下
+        if (m_Frames.empty())
+            throw DxException(E_OUTOFMEMORY, L"UploadRing::Allocate", AnsiToWString(__FILE__), __LINE__);
+
+        // 追上了 GPU 尚未读取的数据, 等待最早的帧完成
+        m_Fence->Wait(m_Frames.front().Fence);
+        Retire(m_Fence->CompletedValue());
+    }
+
+    UINT64 offset = head % m_Capacity;
+    m_Head = head + size;
+
+    UploadSlice slice;
+    slice.Offset = offset;
+    slice.Size = size;
+    slice.Cpu = m_MappedPtr + offset;
+    slice.Gpu = m_GpuBase + offset;
+    return slice;
+}
+
+void RainDX::UploadRing::FinishFrame(std::uint64_t fence)
+{
+    m_Frames.push_back({fence, m_Head});
+}
+
+void RainDX::UploadRing::Retire(std::uint64_t completedFence)
+{
+    while (!m_Frames.empty() && m_Frames.front().Fence <= completedFence)
+    {
+        m_Tail = m_Frames.front().Head;
+        m_Frames.pop_front();
+    }
+}
+
+ID3D12Resource* RainDX::UploadRing::Resource() const
+{
+    return m_UploadBuf.Get();
+}
+
+UINT64 RainDX::UploadRing::Capacity() const
+{
+    return m_Capacity;
+}
+
+UINT64 RainDX::UploadRing::Used() const
+{
+    return m_Head - m_Tail;
+}
+
+bool RainDX::UploadRing::CanAllocate(UINT64 byteSize, UINT64 alignment) const
+{
+    if (byteSize > m_Capacity)
+        return false;
+    // 环为空时 Allocate 会从头开始
+    if (m_Frames.empty() && m_Head == m_Tail)
+        return true;
+    return AlignedHead(byteSize, alignment) + byteSize - m_Tail <= m_Capacity;
+}
+
+UINT64 RainDX::UploadRing::AlignedHead(UINT64 byteSize, UINT64 alignment) const
+{
+    UINT64 offset = m_Head % m_Capacity;
+    UINT64 aligned = (offset + alignment - 1) & ~(alignment - 1);
+    // 剩余空间放不下时跳到缓冲区开头
+    if (aligned + byteSize > m_Capacity)
+        aligned = m_Capacity;
+    return m_Head + (aligned - offset);
+}
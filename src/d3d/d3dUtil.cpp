@@ -3,78 +3,21 @@
 #include <comdef.h>
 #include <fstream>
 #include <d3dcompiler.h>
+#include <winver.h>
 #include "d3d/DxException.h"
+#include "shader/ShaderCache.h"
 
 using Microsoft::WRL::ComPtr;
 
+// 帧资源环的深度, CPU 最多领先 GPU 的帧数
+const int gNumFrameResources = 3;
+
 bool d3dUtil::IsKeyDown(int vkeyCode)
 {
     return (GetAsyncKeyState(vkeyCode) & 0x8000) != 0;
 }
 
 
-// 将CPU数据上传到GPU，返回一个默认堆
-ComPtr<ID3D12Resource> d3dUtil::CreateDefaultBuffer(
-    ID3D12Device* device,
-    ID3D12GraphicsCommandList* cmdList,
-    const void* initData,
-    UINT64 byteSize,
-    ComPtr<ID3D12Resource>& uploadBuffer)
-{
-    ComPtr<ID3D12Resource> defaultBuffer;
-
-    // 创建一个默认缓冲区
-    {
-        auto prop0 = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-        auto desc0 = CD3DX12_RESOURCE_DESC::Buffer(byteSize);
-        ThrowIfFailed(device->CreateCommittedResource(
-            &prop0,
-            D3D12_HEAP_FLAG_NONE,
-            &desc0,
-            D3D12_RESOURCE_STATE_COMMON,
-            nullptr,
-            IID_PPV_ARGS(defaultBuffer.GetAddressOf())));
-    }
-    
-    // 创建一个上传堆复制数据
-    {
-        auto prop1 = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-        auto desc1 = CD3DX12_RESOURCE_DESC::Buffer(byteSize);
-        ThrowIfFailed(device->CreateCommittedResource(
-            &prop1,
-            D3D12_HEAP_FLAG_NONE,
-            &desc1,
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(uploadBuffer.GetAddressOf())));
-    }
-    
-    // 描述数据大小
-    D3D12_SUBRESOURCE_DATA subResourceData = {};
-    subResourceData.pData = initData;
-    subResourceData.RowPitch = byteSize;
-    subResourceData.SlicePitch = subResourceData.RowPitch;
-    
-    // 默认堆改为接受数据的状态
-    auto br0 = CD3DX12_RESOURCE_BARRIER::Transition(
-        defaultBuffer.Get(),
-        D3D12_RESOURCE_STATE_COMMON,
-        D3D12_RESOURCE_STATE_COPY_DEST);
-    cmdList->ResourceBarrier(1, &br0);
-    // 先拷贝到默认堆，再通过 ID3D12CommandList::CopySubresourceRegion 复制到上传堆
-    UpdateSubresources<1>(cmdList, defaultBuffer.Get(),
-        uploadBuffer.Get(), 0, 0, 1, &subResourceData);
-    // 默认堆转变为可读态
-    auto br1 = CD3DX12_RESOURCE_BARRIER::Transition(
-        defaultBuffer.Get(),
-        D3D12_RESOURCE_STATE_COPY_DEST,
-        D3D12_RESOURCE_STATE_GENERIC_READ);
-    cmdList->ResourceBarrier(1, &br1);
-
-    // 返回默认堆指针
-    return defaultBuffer;
-}
-
 // 编译着色器
 ComPtr<ID3DBlob> d3dUtil::CompileShader(
     const std::wstring& filename,
@@ -82,11 +25,7 @@ ComPtr<ID3DBlob> d3dUtil::CompileShader(
     const std::string& entrypoint,
     const std::string& target)
 {
-    UINT compileFlags = 0;
-#if defined(DEBUG) || defined(_DEBUG)
-    // 调试模式，跳过优化
-    compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#endif
+    UINT compileFlags = DefaultCompileFlags();
 
     HRESULT hr = S_OK;
 
@@ -106,6 +45,64 @@ ComPtr<ID3DBlob> d3dUtil::CompileShader(
     return byteCode;
 }
 
+// 按请求编译着色器
+std::vector<char> d3dUtil::CompileBytecode(const RainDX::ShaderRequest& request)
+{
+    std::vector<D3D_SHADER_MACRO> macros;
+    for (const RainDX::ShaderDefine& define : request.Defines)
+        macros.push_back({define.Name.c_str(), define.Value.c_str()});
+    macros.push_back({nullptr, nullptr});
+
+    ComPtr<ID3DBlob> byteCode = nullptr;
+    ComPtr<ID3DBlob> errors;
+    HRESULT hr = D3DCompileFromFile(request.Path.c_str(), macros.data(), D3D_COMPILE_STANDARD_FILE_INCLUDE,
+                                    request.EntryPoint.c_str(), request.Target.c_str(), request.Flags, 0,
+                                    &byteCode, &errors);
+
+    if (errors != nullptr)
+        OutputDebugStringA(static_cast<char*>(errors->GetBufferPointer()));
+
+    ThrowIfFailed(hr);
+
+    const char* data = static_cast<const char*>(byteCode->GetBufferPointer());
+    return std::vector<char>(data, data + byteCode->GetBufferSize());
+}
+
+UINT d3dUtil::DefaultCompileFlags()
+{
+    UINT compileFlags = 0;
+#if defined(DEBUG) || defined(_DEBUG)
+    // 调试模式，跳过优化
+    compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#endif
+    return compileFlags;
+}
+
+// 编译器版本
+std::string d3dUtil::CompilerVersion()
+{
+    std::string version = "d3dcompiler " + std::to_string(D3D_COMPILER_VERSION);
+
+    // 同名的 d3dcompiler_47.dll 会随系统和 SDK 更新, 还要加上实际加载的文件版本
+    HMODULE module = GetModuleHandleW(D3DCOMPILER_DLL_W);
+    wchar_t path[MAX_PATH] = {};
+    if (module == nullptr || GetModuleFileNameW(module, path, MAX_PATH) == 0)
+        return version;
+
+    DWORD handle = 0;
+    DWORD size = GetFileVersionInfoSizeW(path, &handle);
+    std::vector<BYTE> info(size);
+    VS_FIXEDFILEINFO* fixed = nullptr;
+    UINT fixedSize = 0;
+    if (size == 0 || !GetFileVersionInfoW(path, 0, size, info.data())
+        || !VerQueryValueW(info.data(), L"\\", reinterpret_cast<void**>(&fixed), &fixedSize) || fixed == nullptr)
+        return version;
+
+    version += " " + std::to_string(HIWORD(fixed->dwFileVersionMS)) + "." + std::to_string(LOWORD(fixed->dwFileVersionMS))
+        + "." + std::to_string(HIWORD(fixed->dwFileVersionLS)) + "." + std::to_string(LOWORD(fixed->dwFileVersionLS));
+    return version;
+}
+
 // 从文件加载预编译的着色器
 ComPtr<ID3DBlob> d3dUtil::LoadBinary(const std::wstring& filename)
 {
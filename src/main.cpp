@@ -1,15 +1,2218 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 
 #include "app/BoxApplication.h"
 #include "app/SimpleApplication.h"
+#include "core/FixedTimestep.h"
+#include "core/FrameStats.h"
+#include "core/JobSystem.h"
+#include "core/LinearArena.h"
+#include "core/Profiler.h"
+#include "d3d/DescriptorAllocator.h"
 #include "d3d/DxException.h"
+#include "d3d/HeapAllocator.h"
+#include "mesh/GeometryGenerator.h"
+#include "mesh/GeometryPacker.h"
+#include "mesh/MeshletBuilder.h"
+#include "mesh/MeshOptimizer.h"
+#include "mesh/MeshSimplifier.h"
+#include "render/CmdListPool.h"
+#include "render/NullRenderDevice.h"
+#include "scene/Bvh.h"
+#include "scene/FrustumCuller.h"
+#include "scene/OcclusionCuller.h"
+#include "shader/ShaderCache.h"
+#include "shader/ShaderPermutations.h"
 
 
+// 场景设置, 由命令行开关关闭
+struct SceneOptions
+{
+    bool Instancing = true;
+    bool Occlusion = true;
+    bool CompactVertices = true;
+    bool Lod = true;
+};
+
+// 命令行中存在 flag 时将其移除并返回 true
+static bool TakeFlag(std::string& args, const std::string& flag)
+{
+    size_t pos = args.find(flag);
+    if (pos == std::string::npos)
+        return false;
+    args.erase(pos, flag.size());
+    return true;
+}
+
+// 使用空后端运行若干帧, 输出 CPU 帧耗时分布和命令统计
+static int RunHeadless(HINSTANCE hInstance, const std::string& args, const SceneOptions& options)
+{
+    int frameCount = 1000;
+    int drawCount = 1;
+    std::string tracePath;
+    std::string csvPath;
+    std::istringstream(args) >> frameCount >> drawCount >> tracePath >> csvPath;
+    // "-" 表示不输出
+    if (tracePath == "-")
+        tracePath.clear();
+
+    auto device = std::make_unique<RainDX::NullRenderDevice>();
+    RainDX::NullRenderDevice* null = device.get();
+    auto app = std::make_unique<RainDX::BoxApplication>(hInstance, std::move(device));
+    app->SetDrawCount(drawCount);
+    app->SetInstancing(options.Instancing);
+    app->SetOcclusion(options.Occlusion);
+    app->SetCompactVertices(options.CompactVertices);
+    app->SetLod(options.Lod);
+
+    try
+    {
+        app->Init();
+        // 只统计帧循环
+        null->ResetStats();
+
+        if (!tracePath.empty())
+            RainDX::Profiler::BeginCapture();
+
+        auto begin = std::chrono::steady_clock::now();
+        app->RunFrames(frameCount);
+        auto end = std::chrono::steady_clock::now();
+
+        if (!tracePath.empty())
+        {
+            RainDX::Profiler::EndCapture();
+            RainDX::Profiler::WriteChromeTrace(tracePath);
+        }
+
+        double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+        const RainDX::FrameStats& frameStats = app->FrameTimes();
+        RainDX::FrameSummary frames = frameStats.Summarize();
+        if (!csvPath.empty())
+            frameStats.WriteCsv(csvPath);
+
+        const RainDX::RenderStats& stats = null->Stats();
+        std::wcout << L"frames: " << frameCount
+            << L"    cpu: " << ms / frameCount << L" ms/frame"
+            << L"    draws: " << stats.Draws
+            << L"    instances: " << stats.Instances
+            << L"    indices: " << stats.Indices
+            << L"    lists: " << stats.CmdLists
+            << L"    barriers: " << stats.Barriers
+            << L"    uploaded: " << stats.BytesUploaded << L" bytes"
+            << L"    descriptor copies: " << stats.DescriptorCopies
+            << L"    commands: " << stats.Commands << std::endl;
+        std::wcout << L"p50: " << frames.P50Ms << L" ms"
+            << L"    p95: " << frames.P95Ms << L" ms"
+            << L"    p99: " << frames.P99Ms << L" ms"
+            << L"    max: " << frames.MaxMs << L" ms"
+            << L"    1% low: " << frames.OnePercentLowFps << L" fps"
+            << L"    hitches: " << frames.Hitches << std::endl;
+        std::wcout << L"fixed steps: " << app->Timestep().StepCount()
+            << L"    dropped: " << app->Timestep().DroppedTime() * 1000.0 << L" ms" << std::endl;
+        const RainDX::MeshOptimizeReport& mesh = app->MeshReport();
+        std::wcout << L"mesh acmr: " << mesh.Before.Acmr << L" -> " << mesh.After.Acmr
+            << L"    atvr: " << mesh.Before.Atvr << L" -> " << mesh.After.Atvr
+            << L"    vertex stride: " << app->VertexStride() << L" bytes"
+            << L"    lods: " << app->LodCount() << std::endl;
+    }
+    catch (RainDX::DxException& e)
+    {
+        // 初始化或帧循环失败, 返回非零供脚本判断
+        std::wcout << e.ToString() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+// 帧资源环在假围栏上的行为: 只有领先 GPU 一整圈时才等待, 取出的槽位的围栏一定已经完成
+static int RunFrameRingBenchmark()
+{
+    struct Slot
+    {
+        std::uint64_t Fence = 0;
+    };
+
+    constexpr int slots = 3;
+    constexpr int frames = 100;
+    bool ok = true;
+    for (std::uint64_t latency : {0ull, 1ull, 2ull, 3ull, 5ull})
+    {
+        RainDX::NullFrameFence fence(latency);
+        RainDX::FrameRing<Slot> ring(&fence);
+        for (int i = 0; i < slots; ++i)
+            ring.Add(std::make_unique<Slot>());
+
+        bool firstLapFree = true;
+        bool reuseSafe = true;
+        bool fencesOk = true;
+        for (int f = 0; f < frames; ++f)
+        {
+            std::uint64_t stallsBefore = ring.StallCount();
+            Slot& slot = ring.Begin();
+            // 第一圈的槽位从未提交过, 之后槽位记录的是上一圈同一位置的帧
+            if (f < slots)
+                firstLapFree = firstLapFree && ring.StallCount() == stallsBefore && slot.Fence == 0;
+            else
+                fencesOk = fencesOk && slot.Fence == static_cast<std::uint64_t>(f - slots + 1);
+            reuseSafe = reuseSafe && fence.CompletedValue() >= slot.Fence;
+
+            ring.End();
+            fencesOk = fencesOk && ring.Index() == f % slots
+                && ring.Current().Fence == static_cast<std::uint64_t>(f + 1);
+        }
+
+        // 围栏落后不到一整圈时从不等待, 否则第一圈之后每帧都要等待
+        std::uint64_t expectedStalls = latency < slots ? 0 : frames - slots;
+        bool pass = firstLapFree && reuseSafe && fencesOk
+            && ring.StallCount() == expectedStalls && fence.WaitCount() == expectedStalls;
+        ok = ok && pass;
+
+        std::wcout << L"latency " << latency << L": " << (pass ? L"ok" : L"FAILED")
+            << L"    stalls: " << ring.StallCount() << L" (expected " << expectedStalls << L")"
+            << L"    completed: " << fence.CompletedValue() << L"/" << frames << std::endl;
+    }
+
+    return ok ? 0 : 1;
+}
+
+// 任务系统从 1 到 N 个线程的扩展性
+static int RunJobBenchmark(const std::string& args)
+{
+    int maxThreads = static_cast<int>(std::thread::hardware_concurrency());
+    std::istringstream(args) >> maxThreads;
+    if (maxThreads < 1)
+        maxThreads = 1;
+
+    constexpr std::size_t count = 1 << 22;
+    constexpr int rounds = 10;
+    std::vector<float> data(count);
+
+    double baseline = 0.0;
+    bool ok = true;
+    for (int threads = 1; threads <= maxThreads; ++threads)
+    {
+        RainDX::JobSystem jobs(threads - 1);
+
+        auto begin = std::chrono::steady_clock::now();
+        // 粗粒度: 按 4096 个元素切分的计算
+        for (int r = 0; r < rounds; ++r)
+        {
+            jobs.ParallelFor(0, count, 4096, [&data, r](std::size_t first, std::size_t last)
+            {
+                for (std::size_t i = first; i < last; ++i)
+                    data[i] = std::sqrt(static_cast<float>(i)) * std::sin(static_cast<float>(i + r));
+            });
+        }
+        auto middle = std::chrono::steady_clock::now();
+
+        // 细粒度: 大量空任务, 衡量调度开销
+        std::atomic<int> executed{0};
+        RainDX::JobCounter counter;
+        for (int i = 0; i < 64; ++i)
+        {
+            jobs.Run([&jobs, &executed, &counter]
+            {
+                for (int j = 0; j < 1024; ++j)
+                    jobs.Run([&executed] { executed.fetch_add(1, std::memory_order_relaxed); }, &counter);
+            }, &counter);
+        }
+        jobs.Wait(counter);
+        auto end = std::chrono::steady_clock::now();
+        bool countOk = executed.load() == 64 * 1024;
+
+        // 子任务抛出的异常必须由 Wait 重新抛出, 且不影响其他子任务执行
+        std::atomic<int> survivors{0};
+        RainDX::JobCounter failing;
+        for (int i = 0; i < 64; ++i)
+        {
+            jobs.Run([i, &survivors]
+            {
+                if (i == 17)
+                    throw std::runtime_error("job failure");
+                survivors.fetch_add(1, std::memory_order_relaxed);
+            }, &failing);
+        }
+        bool rethrown = false;
+        try
+        {
+            jobs.Wait(failing);
+        }
+        catch (const std::runtime_error&)
+        {
+            rethrown = true;
+        }
+        bool errorOk = rethrown && survivors.load() == 63;
+        ok = ok && countOk && errorOk;
+
+        double forMs = std::chrono::duration<double, std::milli>(middle - begin).count() / rounds;
+        double jobNs = std::chrono::duration<double, std::nano>(end - middle).count() / executed.load();
+        if (threads == 1)
+            baseline = forMs;
+
+        std::wcout << L"threads: " << threads
+            << L"    parallel_for: " << forMs << L" ms"
+            << L"    speedup: " << baseline / forMs
+            << L"    empty job: " << jobNs << L" ns"
+            << L"    executed: " << (countOk ? L"ok" : L"FAILED")
+            << L"    exception: " << (errorOk ? L"ok" : L"FAILED") << std::endl;
+    }
+
+    return ok ? 0 : 1;
+}
+
+// 区间分配器的随机压力测试: 每批随机分配和释放之后检查区间不重叠, 已用加空闲等于容量, 全部释放后空闲块合并为一块
+// 同样的检查再对空后端上的堆子分配器做一遍, 包括独立堆和延迟释放
+static int RunTlsfBenchmark()
+{
+    bool ok = true;
+
+    {
+        constexpr std::uint64_t capacity = 256ull << 20;
+        constexpr int batches = 40;
+        constexpr int opsPerBatch = 100000;
+        RainDX::TlsfAllocator allocator(capacity, 256);
+        std::mt19937_64 rng(1);
+        std::vector<RainDX::TlsfAllocation> live;
+        // 偏移到大小, 用于检查重叠
+        std::map<std::uint64_t, std::uint64_t> ranges;
+        std::uint64_t failures = 0;
+        bool placed = true;
+        bool consistent = true;
+
+        auto begin = std::chrono::steady_clock::now();
+        for (int b = 0; b < batches; ++b)
+        {
+            for (int i = 0; i < opsPerBatch; ++i)
+            {
+                // 分配略多于释放, 让分配器逐渐填满
+                if (live.empty() || rng() % 8 < 5)
+                {
+                    std::uint64_t size = 1 + rng() % (rng() % 8 == 0 ? (4ull << 20) : 65536ull);
+                    std::uint64_t alignment = 1ull << (rng() % 17);
+                    RainDX::TlsfAllocation allocation = allocator.Allocate(size, alignment);
+                    if (!allocation.IsValid())
+                    {
+                        ++failures;
+                        continue;
+                    }
+                    placed = placed && allocation.Offset % alignment == 0 && allocation.Size >= size
+                        && allocation.Offset + allocation.Size <= capacity;
+                    placed = placed && ranges.emplace(allocation.Offset, allocation.Size).second;
+                    live.push_back(allocation);
+                }
+                else
+                {
+                    std::size_t j = rng() % live.size();
+                    allocator.Free(live[j]);
+                    ranges.erase(live[j].Offset);
+                    live[j] = live.back();
+                    live.pop_back();
+                }
+            }
+
+            // 按偏移排序后相邻区间不重叠
+            std::uint64_t end = 0;
+            std::uint64_t used = 0;
+            for (const auto& range : ranges)
+            {
+                placed = placed && range.first >= end;
+                end = range.first + range.second;
+                used += range.second;
+            }
+            RainDX::TlsfStats stats = allocator.Stats();
+            consistent = consistent && stats.UsedBytes + stats.FreeBytes == capacity
+                && stats.UsedBytes == used && allocator.UsedBytes() == used
+                && stats.Allocations == live.size() && allocator.AllocationCount() == live.size();
+        }
+        double opNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count()
+            / (static_cast<double>(batches) * opsPerBatch);
+        RainDX::TlsfStats loaded = allocator.Stats();
+
+        for (const RainDX::TlsfAllocation& allocation : live)
+            allocator.Free(allocation);
+        RainDX::TlsfStats drained = allocator.Stats();
+        bool merged = allocator.Empty() && drained.FreeBlocks == 1 && drained.LargestFreeBlock == capacity;
+        RainDX::TlsfAllocation whole = allocator.Allocate(capacity);
+        merged = merged && whole.IsValid() && whole.Offset == 0;
+
+        bool pass = placed && consistent && merged && failures > 0;
+        ok = ok && pass;
+        std::wcout << L"tlsf: " << (pass ? L"ok" : L"FAILED")
+            << L"    ops: " << batches * opsPerBatch
+            << L"    op: " << opNs << L" ns"
+            << L"    live: " << loaded.Allocations
+            << L"    fragmentation: " << loaded.Fragmentation()
+            << L"    failed allocations: " << failures << std::endl;
+    }
+
+    {
+        constexpr UINT64 heapSize = 16ull << 20;
+        constexpr int batches = 20;
+        constexpr int opsPerBatch = 10000;
+        RainDX::NullRenderDevice device(2);
+        RainDX::FrameFence* fence = device.Fence();
+        RainDX::HeapAllocator allocator(&device, D3D12_HEAP_TYPE_DEFAULT, D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS, heapSize);
+        std::mt19937_64 rng(2);
+        std::vector<RainDX::HeapAllocation> live;
+        // 延迟释放的区间在围栏完成之前仍然占用
+        std::deque<std::pair<std::uint64_t, D3D12_GPU_VIRTUAL_ADDRESS>> pending;
+        // GPU 地址到大小, 各个堆的地址互不重叠, 可以一起检查
+        std::map<D3D12_GPU_VIRTUAL_ADDRESS, UINT64> ranges;
+        UINT maxHeaps = 0;
+        bool placed = true;
+        bool consistent = true;
+
+        for (int b = 0; b < batches; ++b)
+        {
+            for (int i = 0; i < opsPerBatch; ++i)
+            {
+                if (live.empty() || rng() % 2 == 0)
+                {
+                    // 偶尔分配超过单个堆的缓冲区, 使用独立的堆
+                    UINT64 size = rng() % 64 == 0 ? heapSize + 1 + rng() % heapSize : 1 + rng() % (1ull << 20);
+                    RainDX::HeapAllocation allocation = allocator.CreateBuffer(size, D3D12_RESOURCE_STATE_COMMON);
+                    D3D12_GPU_VIRTUAL_ADDRESS address = allocation.Resource->GetGPUVirtualAddress();
+                    placed = placed && allocation.Range.Size >= size
+                        && allocation.Range.Offset % D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT == 0;
+                    placed = placed && ranges.emplace(address, allocation.Range.Size).second;
+                    live.push_back(std::move(allocation));
+                }
+                else
+                {
+                    std::size_t j = rng() % live.size();
+                    D3D12_GPU_VIRTUAL_ADDRESS address = live[j].Resource->GetGPUVirtualAddress();
+                    if (rng() % 2 == 0)
+                    {
+                        allocator.Free(live[j]);
+                        ranges.erase(address);
+                    }
+                    else
+                    {
+                        std::uint64_t value = fence->Signal();
+                        allocator.Free(live[j], value);
+                        pending.push_back({value, address});
+                    }
+                    live[j] = std::move(live.back());
+                    live.pop_back();
+                }
+
+                if (i % 64 == 0)
+                {
+                    allocator.Retire();
+                    while (!pending.empty() && pending.front().first <= fence->CompletedValue())
+                    {
+                        ranges.erase(pending.front().second);
+                        pending.pop_front();
+                    }
+                }
+            }
+            maxHeaps = (std::max)(maxHeaps, allocator.HeapCount());
+
+            std::uint64_t end = 0;
+            std::uint64_t used = 0;
+            for (const auto& range : ranges)
+            {
+                placed = placed && range.first >= end;
+                end = range.first + range.second;
+                used += range.second;
+            }
+            std::uint64_t heapUsed = 0;
+            for (const RainDX::HeapStats& heap : allocator.Stats())
+            {
+                consistent = consistent && heap.Range.UsedBytes + heap.Range.FreeBytes == heap.Range.Capacity;
+                heapUsed += heap.Range.UsedBytes;
+            }
+            consistent = consistent && heapUsed == used;
+        }
+
+        // 全部释放, 等待 GPU 之后处理延迟释放, 独立的堆应当已经释放, 其余堆各自合并为一个空闲块
+        for (RainDX::HeapAllocation& allocation : live)
+            allocator.Free(allocation);
+        fence->Flush();
+        allocator.Retire();
+        bool merged = true;
+        for (const RainDX::HeapStats& heap : allocator.Stats())
+        {
+            merged = merged && heap.Range.Capacity == heapSize && heap.Range.Allocations == 0
+                && heap.Range.FreeBlocks == 1 && heap.Range.LargestFreeBlock == heapSize;
+        }
+
+        bool pass = placed && consistent && merged;
+        ok = ok && pass;
+        std::wcout << L"heap: " << (pass ? L"ok" : L"FAILED")
+            << L"    ops: " << batches * opsPerBatch
+            << L"    max heaps: " << maxHeaps
+            << L"    heaps after drain: " << allocator.HeapCount()
+            << L"    placed resources: " << device.Stats().PlacedResources << std::endl;
+    }
+
+    return ok ? 0 : 1;
+}
+
+// 命令列表池: 用空后端保存提交的命令流, 检查列表按录制顺序提交, 分配器只在上次使用它的帧完成后重置, 预热后池不再增长
+static int RunCmdListPoolBenchmark()
+{
+    struct Frame
+    {
+        explicit Frame(RainDX::RenderDevice* device) : Pool(device)
+        {
+        }
+
+        RainDX::CmdListPool Pool;
+        std::uint64_t Fence = 0;
+    };
+
+    constexpr int slots = 3;
+    constexpr int frames = 200;
+    constexpr std::size_t maxObjects = 1000;
+    constexpr std::size_t chunkSize = 64;
+    constexpr UINT maxLists = static_cast<UINT>((maxObjects + chunkSize - 1) / chunkSize);
+    RainDX::JobSystem jobs;
+    bool ok = true;
+
+    for (std::uint64_t latency : {0ull, 2ull, 5ull})
+    {
+        RainDX::NullRenderDevice device(latency);
+        RainDX::FrameRing<Frame> ring(device.Fence());
+        for (int i = 0; i < slots; ++i)
+            ring.Add(std::make_unique<Frame>(&device));
+        device.SetCapture(true);
+
+        // 每个分配器最后一次提交时的围栏值
+        std::map<UINT64, std::uint64_t> allocFences;
+        std::vector<UINT64> frameAllocs;
+        std::vector<RainDX::RenderCmdList*> lists;
+        std::mt19937 rng(3);
+        bool ordered = true;
+        bool reuseSafe = true;
+        bool stable = true;
+
+        for (int f = 0; f < frames; ++f)
+        {
+            Frame& frame = ring.Begin();
+            const std::uint64_t completed = device.Fence()->CompletedValue();
+            frame.Pool.Reset();
+
+            // 第一圈录制最多的对象, 之后的帧不应再创建列表
+            std::size_t count = f < slots ? maxObjects : 200 + rng() % (maxObjects - 199);
+            lists.clear();
+            frame.Pool.Record(jobs, count, chunkSize, nullptr,
+                [](RainDX::RenderCmdList& list, std::size_t first, std::size_t last)
+                {
+                    for (std::size_t i = first; i < last; ++i)
+                        list.DrawIndexedInstanced(static_cast<UINT>(i), 1, 0, 0, 0);
+                },
+                lists);
+            device.Execute(static_cast<UINT>(lists.size()), lists.data());
+            ring.End();
+
+            // 绘制的序号按录制顺序连续, 每个列表的分配器都已完成
+            UINT next = 0;
+            frameAllocs.clear();
+            for (const RainDX::NullCmd& cmd : device.Captured())
+            {
+                if (cmd.Type == RainDX::NullCmdType::DrawIndexedInstanced)
+                {
+                    ordered = ordered && cmd.Arg0 == next++;
+                }
+                else if (cmd.Type == RainDX::NullCmdType::Reset)
+                {
+                    auto it = allocFences.find(cmd.Arg0);
+                    reuseSafe = reuseSafe && (it == allocFences.end() || it->second <= completed);
+                    frameAllocs.push_back(cmd.Arg0);
+                }
+            }
+            ordered = ordered && next == count;
+            for (UINT64 alloc : frameAllocs)
+                allocFences[alloc] = frame.Fence;
+            device.ClearCaptured();
+
+            if (f >= slots)
+                stable = stable && frame.Pool.Count() == maxLists;
+        }
+
+        // 每个分配器只属于一个列表, 不同帧之间不共享
+        bool pass = ordered && reuseSafe && stable && allocFences.size() == static_cast<std::size_t>(slots) * maxLists;
+        ok = ok && pass;
+        std::wcout << L"latency " << latency << L": " << (pass ? L"ok" : L"FAILED")
+            << L"    allocators: " << allocFences.size() << L" (expected " << slots * maxLists << L")"
+            << L"    stalls: " << ring.StallCount() << std::endl;
+    }
+
+    return ok ? 0 : 1;
+}
+
+// 帧耗时统计: 已知样本的分位数, 1% low 和卡顿数, 窗口移出旧帧, 以及超出直方图范围的帧
+// 样本都取在直方图桶的中心, 期望值是精确的
+static int RunFrameStatsBenchmark()
+{
+    auto near = [](double a, double b) { return std::abs(a - b) < 1e-6; };
+    bool ok = true;
+
+    // 1..100 ms 倒序加入, 每帧都比之前的快, 不会有卡顿
+    {
+        RainDX::FrameStats stats(100);
+        for (int i = 100; i >= 1; --i)
+            stats.AddFrame(i + 0.025);
+        RainDX::FrameSummary summary = stats.Summarize();
+        bool pass = summary.Frames == 100 && near(summary.P50Ms, 50.025) && near(summary.P95Ms, 95.025)
+            && near(summary.P99Ms, 99.025) && near(summary.OnePercentLowMs, 100.025)
+            && near(summary.AverageMs, 50.525) && near(summary.MinMs, 1.025) && near(summary.MaxMs, 100.025)
+            && summary.Hitches == 0;
+        ok = ok && pass;
+        std::wcout << L"percentiles: " << (pass ? L"ok" : L"FAILED")
+            << L"    p50/p95/p99: " << summary.P50Ms << L"/" << summary.P95Ms << L"/" << summary.P99Ms
+            << L"    1% low: " << summary.OnePercentLowMs << L" ms" << std::endl;
+    }
+
+    // 稳定的 10 ms 中夹杂尖峰, 100 帧后窗口只剩最后 64 帧
+    // 第 5 帧在预热期内, 第 50 帧不到中位数的两倍, 只有 40, 60 和 70 帧是卡顿
+    {
+        RainDX::FrameStats stats(64);
+        for (int f = 0; f < 100; ++f)
+        {
+            double ms = 10.025;
+            if (f == 5)
+                ms = 50.025;
+            else if (f == 40 || f == 70)
+                ms = 30.025;
+            else if (f == 50)
+                ms = 14.025;
+            else if (f == 60)
+                ms = 22.025;
+            stats.AddFrame(ms);
+        }
+        RainDX::FrameSummary summary = stats.Summarize();
+        std::vector<std::uint64_t> hitchFrames;
+        for (const RainDX::FrameHitch& hitch : stats.Hitches())
+            hitchFrames.push_back(hitch.Frame);
+        double average = (60 * 10.025 + 14.025 + 22.025 + 2 * 30.025) / 64;
+        bool pass = summary.Frames == 64 && stats.FrameCount() == 100 && near(summary.MaxMs, 30.025)
+            && near(summary.P50Ms, 10.025) && near(summary.P95Ms, 14.025) && near(summary.P99Ms, 30.025)
+            && near(summary.OnePercentLowMs, 30.025) && near(summary.AverageMs, average)
+            && summary.Hitches == 3 && hitchFrames == std::vector<std::uint64_t>{40, 60, 70};
+        ok = ok && pass;
+        std::wcout << L"window and hitches: " << (pass ? L"ok" : L"FAILED")
+            << L"    frames: " << summary.Frames << L"    max: " << summary.MaxMs << L" ms"
+            << L"    hitches: " << summary.Hitches << std::endl;
+    }
+
+    // 超过直方图上限的帧按精确值排序, 移出窗口后不再影响结果
+    {
+        RainDX::FrameStats stats(100);
+        for (int f = 0; f < 97; ++f)
+            stats.AddFrame(5.025);
+        stats.AddFrame(1000.0);
+        stats.AddFrame(250.0);
+        stats.AddFrame(300.0);
+        RainDX::FrameSummary summary = stats.Summarize();
+        bool overflow = near(stats.Percentile(0.97), 5.025) && near(stats.Percentile(0.98), 250.0)
+            && near(stats.Percentile(0.99), 300.0) && near(stats.Percentile(1.0), 1000.0)
+            && near(summary.P50Ms, 5.025) && near(summary.OnePercentLowMs, 1000.0) && summary.Hitches == 3;
+
+        for (int f = 0; f < 100; ++f)
+            stats.AddFrame(5.025);
+        summary = stats.Summarize();
+        bool evicted = near(stats.Percentile(1.0), 5.025) && near(summary.MaxMs, 5.025)
+            && near(summary.OnePercentLowMs, 5.025) && summary.Hitches == 3;
+
+        stats.Clear();
+        bool cleared = stats.Percentile(0.5) == 0.0 && stats.Summarize().Frames == 0 && stats.Hitches().empty();
+
+        bool pass = overflow && evicted && cleared;
+        ok = ok && pass;
+        std::wcout << L"overflow: " << (pass ? L"ok" : L"FAILED")
+            << L"    p98/p99/max before eviction: 250/300/1000"
+            << L"    after: " << summary.MaxMs << L" ms" << std::endl;
+    }
+
+    return ok ? 0 : 1;
+}
+
+// 固定步长: 累加和切分, 步数上限和丢弃的时间, 修改步长之后 Alpha 仍在 [0, 1) 内
+// 步长和间隔都是 2 的负幂, 期望值是精确的
+static int RunFixedTimestepBenchmark()
+{
+    bool ok = true;
+
+    {
+        RainDX::FixedTimestep timestep(0.25, 4);
+        bool pass = timestep.Advance(0.125) == 0 && timestep.Alpha() == 0.5;
+        pass = pass && timestep.Advance(0.1875) == 1 && timestep.Alpha() == 0.25;
+        pass = pass && timestep.Advance(0.5) == 2 && timestep.Alpha() == 0.25;
+        // 累加到 12.25 步, 只执行 4 步, 丢弃 8 步
+        pass = pass && timestep.Advance(3.0) == 4 && timestep.Alpha() == 0.25;
+        pass = pass && timestep.StepCount() == 7 && timestep.DroppedTime() == 2.0;
+        // 负的间隔不会让时间倒退
+        pass = pass && timestep.Advance(-1.0) == 0 && timestep.Alpha() == 0.25;
+        ok = ok && pass;
+        std::wcout << L"accumulate and clamp: " << (pass ? L"ok" : L"FAILED")
+            << L"    steps: " << timestep.StepCount() << L"    dropped: " << timestep.DroppedTime() << L" s" << std::endl;
+    }
+
+    {
+        // 剩余时间刚好等于新的步长时, 原来的实现会让 Alpha 等于 1
+        RainDX::FixedTimestep timestep(0.25, 4);
+        timestep.Advance(0.125);
+        timestep.SetStep(0.125);
+        bool pass = timestep.Alpha() == 0.0 && timestep.DroppedTime() == 0.125;
+        timestep.Advance(0.1875);
+        timestep.SetStep(0.0625 + 0.03125);
+        pass = pass && timestep.Alpha() >= 0.0 && timestep.Alpha() < 1.0;
+        timestep.SetStep(1.0);
+        pass = pass && timestep.Alpha() < 1.0;
+        ok = ok && pass;
+        std::wcout << L"set step: " << (pass ? L"ok" : L"FAILED")
+            << L"    alpha: " << timestep.Alpha() << L"    dropped: " << timestep.DroppedTime() << L" s" << std::endl;
+    }
+
+    {
+        // 随机帧间隔和步长: 执行的时间, 丢弃的时间和剩余时间之和等于累加的时间, Alpha 始终在 [0, 1) 内
+        RainDX::FixedTimestep timestep(1.0 / 60.0, 5);
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<double> delta(0.0, 0.1);
+        double total = 0.0;
+        double simulated = 0.0;
+        bool alphaOk = true;
+        for (int f = 0; f < 100000; ++f)
+        {
+            if (f % 1000 == 999)
+                timestep.SetStep(1.0 / (30 + rng() % 91));
+            double dt = delta(rng);
+            total += dt;
+            simulated += timestep.Advance(dt) * timestep.Step();
+            alphaOk = alphaOk && timestep.Alpha() >= 0.0 && timestep.Alpha() < 1.0;
+        }
+        double accounted = simulated + timestep.DroppedTime() + timestep.Alpha() * timestep.Step();
+        bool pass = alphaOk && std::abs(accounted - total) < 1e-6 * total && timestep.DroppedTime() > 0.0;
+        ok = ok && pass;
+        std::wcout << L"random: " << (pass ? L"ok" : L"FAILED")
+            << L"    total: " << total << L" s    accounted: " << accounted << L" s"
+            << L"    dropped: " << timestep.DroppedTime() << L" s" << std::endl;
+    }
+
+    return ok ? 0 : 1;
+}
+
+// 视锥裁剪: 逐个 BoundingBox::Intersects 与 SoA 批量测试对比
+static int RunCullBenchmark()
+{
+    using namespace DirectX;
+
+    // 相机在场景外看向原点, 大约一半的盒子可见
+    XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, -400.0f, 1.0f), XMVectorZero(),
+                                     XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f * XM_PI, 1.75f, 1.0f, 1000.0f);
+    XMFLOAT4X4 viewProj;
+    XMStoreFloat4x4(&viewProj, view * proj);
+    RainDX::CullFrustum planes = RainDX::CullFrustum::FromViewProj(viewProj);
+
+    BoundingFrustum frustum;
+    BoundingFrustum::CreateFromMatrix(frustum, proj);
+    frustum.Transform(frustum, XMMatrixInverse(nullptr, view));
+
+    RainDX::JobSystem jobs;
+    constexpr int rounds = 10;
+    const RainDX::CullSimd simds[] = {RainDX::CullSimd::Scalar, RainDX::CullSimd::Sse, RainDX::CullSimd::Avx};
+    bool ok = true;
+
+    // 位置已知的盒子: 原点处的半高约 165.7, 半宽约 290, 近平面在相机前 1, 远平面在相机前 1000
+    {
+        struct KnownBox
+        {
+            BoundingBox Box;
+            bool Visible;
+        };
+        const KnownBox known[] = {
+            {BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)), true},
+            // 相机后方
+            {BoundingBox(XMFLOAT3(0.0f, 0.0f, -500.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)), false},
+            // 远平面之外和跨过远平面
+            {BoundingBox(XMFLOAT3(0.0f, 0.0f, 700.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)), false},
+            {BoundingBox(XMFLOAT3(0.0f, 0.0f, 599.5f), XMFLOAT3(1.0f, 1.0f, 1.0f)), true},
+            // 右侧平面之外和跨过右侧平面
+            {BoundingBox(XMFLOAT3(400.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)), false},
+            {BoundingBox(XMFLOAT3(291.0f, 0.0f, 0.0f), XMFLOAT3(2.0f, 2.0f, 2.0f)), true},
+            // 上侧平面之外
+            {BoundingBox(XMFLOAT3(0.0f, 170.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)), false},
+            // 相机和近平面之间
+            {BoundingBox(XMFLOAT3(0.0f, 0.0f, -399.5f), XMFLOAT3(0.1f, 0.1f, 0.1f)), false},
+            {BoundingBox(XMFLOAT3(-100.0f, 50.0f, 200.0f), XMFLOAT3(3.0f, 3.0f, 3.0f)), true},
+        };
+
+        RainDX::FrustumCuller culler;
+        std::vector<std::uint32_t> expected;
+        bool exact = true;
+        for (const KnownBox& k : known)
+        {
+            std::uint32_t index = culler.Add(k.Box);
+            if (k.Visible)
+                expected.push_back(index);
+            exact = exact && k.Box.Intersects(frustum) == k.Visible;
+        }
+
+        std::vector<std::uint32_t> visible(culler.Size() + RainDX::FrustumCuller::GroupSize);
+        for (RainDX::CullSimd simd : simds)
+        {
+            culler.SetSimd(simd);
+            std::size_t count = culler.Cull(planes, visible.data());
+            exact = exact && std::equal(expected.begin(), expected.end(), visible.begin(), visible.begin() + count);
+        }
+        std::vector<std::uint32_t> parallelVisible;
+        culler.Cull(jobs, planes, parallelVisible);
+        exact = exact && parallelVisible == expected;
+
+        ok = ok && exact;
+        std::wcout << L"known boxes: " << (exact ? L"ok" : L"FAILED") << std::endl;
+    }
+
+    for (std::size_t count : {10000u, 100000u, 1000000u})
+    {
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> position(-300.0f, 300.0f);
+        std::uniform_real_distribution<float> extent(0.1f, 3.0f);
+
+        std::vector<BoundingBox> boxes(count);
+        RainDX::FrustumCuller culler;
+        culler.Reserve(count);
+        for (BoundingBox& box : boxes)
+        {
+            box.Center = XMFLOAT3(position(random), position(random), position(random));
+            box.Extents = XMFLOAT3(extent(random), extent(random), extent(random));
+            culler.Add(box);
+        }
+
+        std::vector<std::uint32_t> visible(count + RainDX::FrustumCuller::GroupSize);
+        std::size_t visibleCount = 0;
+        auto time = [&](auto&& cull)
+        {
+            auto begin = std::chrono::steady_clock::now();
+            for (int r = 0; r < rounds; ++r)
+                cull();
+            auto end = std::chrono::steady_clock::now();
+            return std::chrono::duration<double, std::milli>(end - begin).count() / rounds;
+        };
+
+        double naiveMs = time([&]
+        {
+            visibleCount = 0;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                if (boxes[i].Intersects(frustum))
+                    visible[visibleCount++] = static_cast<std::uint32_t>(i);
+            }
+        });
+        std::size_t naiveCount = visibleCount;
+        std::vector<std::uint32_t> exactVisible(visible.begin(), visible.begin() + naiveCount);
+
+        culler.SetSimd(RainDX::CullSimd::Scalar);
+        visibleCount = culler.Cull(planes, visible.data());
+        std::vector<std::uint32_t> scalarVisible(visible.begin(), visible.begin() + visibleCount);
+
+        culler.SetSimd(RainDX::CullSimd::Sse);
+        double sseMs = time([&] { visibleCount = culler.Cull(planes, visible.data()); });
+        bool pass = std::equal(scalarVisible.begin(), scalarVisible.end(), visible.begin(), visible.begin() + visibleCount);
+        culler.SetSimd(RainDX::FrustumCuller::BestSimd());
+        double simdMs = time([&] { visibleCount = culler.Cull(planes, visible.data()); });
+        pass = pass && std::equal(scalarVisible.begin(), scalarVisible.end(), visible.begin(), visible.begin() + visibleCount);
+        std::vector<std::uint32_t> parallelVisible;
+        double parallelMs = time([&] { culler.Cull(jobs, planes, parallelVisible); });
+        pass = pass && parallelVisible == scalarVisible;
+
+        // 各指令集和并行的结果完全相同, 平面测试比精确相交保守, 精确可见的盒子必须都在结果中
+        pass = pass && std::includes(scalarVisible.begin(), scalarVisible.end(), exactVisible.begin(), exactVisible.end());
+        ok = ok && pass;
+
+        std::wcout << L"boxes " << count << L": " << (pass ? L"ok" : L"FAILED")
+            << L"    Intersects: " << naiveMs << L" ms (" << naiveCount << L")"
+            << L"    sse: " << sseMs << L" ms"
+            << L"    " << (culler.Simd() == RainDX::CullSimd::Avx ? L"avx: " : L"sse: ") << simdMs << L" ms"
+            << L"    parallel: " << parallelMs << L" ms (" << parallelVisible.size() << L")"
+            << L"    speedup: " << naiveMs / parallelMs << std::endl;
+    }
+
+    return ok ? 0 : 1;
+}
+
+// BVH 构建, 更新和查询耗时随场景规模的变化, 与线性扫描对比
+static int RunBvhBenchmark()
+{
+    using namespace DirectX;
+
+    XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, -400.0f, 1.0f), XMVectorZero(),
+                                     XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f * XM_PI, 1.75f, 1.0f, 1000.0f);
+    XMFLOAT4X4 viewProj;
+    XMStoreFloat4x4(&viewProj, view * proj);
+    RainDX::CullFrustum planes = RainDX::CullFrustum::FromViewProj(viewProj);
+
+    RainDX::JobSystem jobs;
+    constexpr int rayCount = 1000;
+    // 线性射线测试太慢, 只取一部分射线
+    constexpr int linearRayCount = 100;
+    bool ok = true;
+
+    auto elapsed = [](std::chrono::steady_clock::time_point begin)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    };
+
+    for (std::size_t count : {10000u, 100000u, 1000000u})
+    {
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> position(-300.0f, 300.0f);
+        std::uniform_real_distribution<float> extent(0.1f, 3.0f);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+        std::vector<BoundingBox> boxes(count);
+        for (BoundingBox& box : boxes)
+        {
+            box.Center = XMFLOAT3(position(random), position(random), position(random));
+            box.Extents = XMFLOAT3(extent(random), extent(random), extent(random));
+        }
+
+        RainDX::Bvh bvh;
+        auto begin = std::chrono::steady_clock::now();
+        bvh.Build(boxes.data(), count);
+        double buildMs = elapsed(begin);
+        std::vector<RainDX::BvhNode> serialNodes = bvh.Nodes();
+        std::vector<std::uint32_t> serialIndices = bvh.Indices();
+
+        begin = std::chrono::steady_clock::now();
+        bvh.Build(boxes.data(), count, &jobs);
+        double parallelBuildMs = elapsed(begin);
+
+        // 并行构建与单线程构建的树完全相同, 叶节点引用每个图元恰好一次
+        bool pass = bvh.Nodes().size() == serialNodes.size() && bvh.Indices() == serialIndices
+            && std::memcmp(bvh.Nodes().data(), serialNodes.data(), serialNodes.size() * sizeof(RainDX::BvhNode)) == 0;
+        std::sort(serialIndices.begin(), serialIndices.end());
+        for (std::size_t i = 0; i < count && pass; ++i)
+            pass = serialIndices[i] == i;
+
+        // 所有盒子移动一小段后只更新包围盒
+        for (BoundingBox& box : boxes)
+            box.Center.y += 0.5f;
+        begin = std::chrono::steady_clock::now();
+        bvh.Refit(boxes.data());
+        double refitMs = elapsed(begin);
+
+        std::vector<std::uint32_t> visible;
+        begin = std::chrono::steady_clock::now();
+        bvh.QueryFrustum(planes, visible);
+        double frustumMs = elapsed(begin);
+
+        RainDX::FrustumCuller culler;
+        culler.Reserve(count);
+        for (const BoundingBox& box : boxes)
+            culler.Add(box);
+        std::vector<std::uint32_t> linearVisible(count + RainDX::FrustumCuller::GroupSize);
+        begin = std::chrono::steady_clock::now();
+        std::size_t linearCount = culler.Cull(planes, linearVisible.data());
+        double linearFrustumMs = elapsed(begin);
+
+        // 叶节点与线性裁剪使用相同的平面测试, 更新包围盒之后结果仍然相同
+        std::sort(visible.begin(), visible.end());
+        pass = pass && std::equal(visible.begin(), visible.end(), linearVisible.begin(), linearVisible.begin() + linearCount);
+
+        std::vector<XMFLOAT3> origins(rayCount);
+        std::vector<XMFLOAT3> directions(rayCount);
+        for (int i = 0; i < rayCount; ++i)
+        {
+            origins[i] = XMFLOAT3(position(random), position(random), position(random));
+            directions[i] = XMFLOAT3(unit(random), unit(random), unit(random));
+        }
+
+        int hits = 0;
+        begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < rayCount; ++i)
+        {
+            RainDX::BvhHit hit;
+            hits += bvh.Raycast(origins[i], directions[i], MathHelper::Infinity, hit) ? 1 : 0;
+        }
+        double rayUs = elapsed(begin) * 1000.0 / rayCount;
+
+        // 线性测试的方向是归一化的, 起点在盒子内部时距离按 0 比较
+        int rayMismatches = 0;
+        begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < linearRayCount; ++i)
+        {
+            XMVECTOR origin = XMLoadFloat3(&origins[i]);
+            XMVECTOR direction = XMVector3Normalize(XMLoadFloat3(&directions[i]));
+            float nearest = MathHelper::Infinity;
+            for (const BoundingBox& box : boxes)
+            {
+                float distance = 0.0f;
+                if (box.Intersects(origin, direction, distance))
+                    nearest = (std::min)(nearest, (std::max)(distance, 0.0f));
+            }
+
+            RainDX::BvhHit hit;
+            bool bvhHit = bvh.Raycast(origins[i], directions[i], MathHelper::Infinity, hit);
+            const XMFLOAT3& d = directions[i];
+            float bvhDistance = hit.Distance * std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+            bool same = bvhHit == (nearest != MathHelper::Infinity)
+                && (!bvhHit || std::abs(bvhDistance - nearest) <= 1e-3f * (1.0f + nearest));
+            rayMismatches += same ? 0 : 1;
+        }
+        double linearRayUs = elapsed(begin) * 1000.0 / linearRayCount;
+        pass = pass && rayMismatches == 0;
+        ok = ok && pass;
+
+        std::wcout << L"boxes " << count << L": " << (pass ? L"ok" : L"FAILED")
+            << L"    build: " << buildMs << L" ms"
+            << L"    parallel build: " << parallelBuildMs << L" ms"
+            << L"    refit: " << refitMs << L" ms"
+            << L"    depth: " << bvh.Depth() << std::endl
+            << L"    frustum: " << frustumMs << L" ms (" << visible.size() << L")"
+            << L"    linear frustum: " << linearFrustumMs << L" ms (" << linearCount << L")"
+            << L"    ray: " << rayUs << L" us (" << hits << L" hits)"
+            << L"    linear ray: " << linearRayUs << L" us (" << rayMismatches << L" mismatches)" << std::endl;
+    }
+
+    return ok ? 0 : 1;
+}
+
+// 软件遮挡剔除: 光栅化吞吐量, 测试吞吐量和深度缓冲区哈希
+// 墙的深度哈希和遮挡结果与保存的期望值比对, 不一致时返回非零
+static int RunOcclusionBenchmark()
+{
+    using namespace DirectX;
+
+    // 垂直视角约 45 度, 宽高比 2, 用近平面尺寸构造, 不经过三角函数, 深度缓冲区的哈希在各平台上一致
+    XMMATRIX proj = XMMatrixPerspectiveLH(1.656854f, 0.828427f, 1.0f, 1000.0f);
+    XMFLOAT4X4 viewProj;
+    XMStoreFloat4x4(&viewProj, proj);
+    XMFLOAT4X4 identity = MathHelper::Identity4x4();
+
+    RainDX::OcclusionCuller culler;
+    bool ok = true;
+
+    // 相机前方的一面墙: 墙后的盒子被遮挡, 墙前和墙外的盒子可见
+    {
+        constexpr std::uint64_t expectedHash = 0x8a8a6353b522ce25ull;
+        const XMFLOAT3 wall[] = {{-5.0f, -5.0f, 10.0f}, {-5.0f, 5.0f, 10.0f}, {5.0f, 5.0f, 10.0f}, {5.0f, -5.0f, 10.0f}};
+        const std::uint16_t indices[] = {0, 1, 2, 0, 2, 3};
+        culler.Begin(viewProj);
+        culler.AddOccluder(wall, sizeof(XMFLOAT3), indices, _countof(indices), identity);
+        culler.End();
+
+        BoundingBox behind(XMFLOAT3(0.0f, 0.0f, 20.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+        BoundingBox front(XMFLOAT3(0.0f, 0.0f, 5.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+        BoundingBox edge(XMFLOAT3(6.0f, 0.0f, 20.0f), XMFLOAT3(2.0f, 1.0f, 1.0f));
+        std::uint64_t hash = culler.DepthHash();
+        bool behindVisible = culler.IsVisible(behind);
+        bool frontVisible = culler.IsVisible(front);
+        bool edgeVisible = culler.IsVisible(edge);
+        bool pass = hash == expectedHash && !behindVisible && frontVisible && edgeVisible;
+        ok = ok && pass;
+        std::wcout << L"wall: " << (pass ? L"ok" : L"FAILED")
+            << std::hex << L"    hash: " << hash << L" (expected " << expectedHash << L")" << std::dec
+            << L"    behind: " << behindVisible
+            << L"    front: " << frontVisible
+            << L"    edge: " << edgeVisible << std::endl;
+    }
+
+    // 随机三角形光栅化
+    std::mt19937 random(2);
+    std::uniform_real_distribution<float> position(-20.0f, 20.0f);
+    std::uniform_real_distribution<float> depth(15.0f, 100.0f);
+    std::uniform_real_distribution<float> size(0.5f, 3.0f);
+
+    constexpr std::uint32_t triangleCount = 100000;
+    std::vector<XMFLOAT3> vertices;
+    std::vector<std::uint32_t> indices;
+    for (std::uint32_t i = 0; i < triangleCount; ++i)
+    {
+        float x = position(random);
+        float y = 0.5f * position(random);
+        float z = depth(random);
+        float r = size(random);
+        vertices.emplace_back(x - r, y - r, z);
+        vertices.emplace_back(x - r, y + r, z);
+        vertices.emplace_back(x + r, y + r, z);
+        for (int k = 0; k < 3; ++k)
+            indices.push_back(static_cast<std::uint32_t>(indices.size()));
+    }
+
+    constexpr int rounds = 10;
+    auto begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r)
+    {
+        culler.Begin(viewProj);
+        culler.AddOccluder(vertices.data(), sizeof(XMFLOAT3), indices.data(), indices.size(), identity);
+        culler.End();
+    }
+    double rasterMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() / rounds;
+
+    std::vector<BoundingBox> boxes(100000);
+    std::vector<std::uint32_t> candidates(boxes.size());
+    for (std::size_t i = 0; i < boxes.size(); ++i)
+    {
+        boxes[i] = BoundingBox(XMFLOAT3(position(random), 0.5f * position(random), depth(random)),
+                               XMFLOAT3(0.5f, 0.5f, 0.5f));
+        candidates[i] = static_cast<std::uint32_t>(i);
+    }
+    std::vector<std::uint32_t> visible(boxes.size());
+    begin = std::chrono::steady_clock::now();
+    std::size_t visibleCount = culler.Filter(boxes.data(), candidates.data(), boxes.size(), visible.data());
+    double testMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    // 随机分布与标准库的实现有关, 只检查批量测试与逐个测试一致
+    std::vector<std::uint32_t> expectedVisible;
+    for (std::size_t i = 0; i < boxes.size(); ++i)
+    {
+        if (culler.IsVisible(boxes[i]))
+            expectedVisible.push_back(static_cast<std::uint32_t>(i));
+    }
+    bool pass = visibleCount > 0 && visibleCount < boxes.size()
+        && std::equal(expectedVisible.begin(), expectedVisible.end(), visible.begin(), visible.begin() + visibleCount)
+        && expectedVisible.size() == visibleCount;
+    ok = ok && pass;
+
+    std::wcout << L"random: " << (pass ? L"ok" : L"FAILED")
+        << L"    triangles: " << culler.TrianglesRasterized()
+        << L"    raster: " << rasterMs << L" ms (" << culler.TrianglesRasterized() / rasterMs << L" tris/ms)"
+        << L"    hash: " << std::hex << culler.DepthHash() << std::dec << std::endl
+        << L"boxes: " << boxes.size()
+        << L"    test: " << testMs << L" ms"
+        << L"    visible: " << visibleCount << std::endl;
+
+    return ok ? 0 : 1;
+}
+
+// 网格优化: 打乱三角形顺序的网格在优化前后的 ACMR 和 ATVR
+static int RunMeshBenchmark(const std::string& args)
+{
+    int size = 256;
+    std::istringstream(args) >> size;
+    if (size < 1)
+        size = 1;
+
+    // 起伏的网格, 顶点与盒子的顶点格式相同
+    const std::uint32_t row = static_cast<std::uint32_t>(size) + 1;
+    std::vector<RainDX::Vertex> vertices;
+    vertices.reserve(static_cast<std::size_t>(row) * row);
+    for (std::uint32_t y = 0; y < row; ++y)
+    {
+        for (std::uint32_t x = 0; x < row; ++x)
+        {
+            float height = 0.5f * sinf(0.1f * x) * cosf(0.1f * y);
+            vertices.push_back({DirectX::XMFLOAT3(static_cast<float>(x), height, static_cast<float>(y)),
+                                DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f)});
+        }
+    }
+
+    std::vector<std::uint32_t> quads(static_cast<std::size_t>(size) * size);
+    for (std::size_t i = 0; i < quads.size(); ++i)
+        quads[i] = static_cast<std::uint32_t>(i);
+    std::mt19937 random(3);
+    std::shuffle(quads.begin(), quads.end(), random);
+
+    std::vector<std::uint32_t> indices;
+    indices.reserve(quads.size() * 6);
+    for (std::uint32_t quad : quads)
+    {
+        std::uint32_t a = quad / size * row + quad % size;
+        std::uint32_t b = a + 1;
+        std::uint32_t c = a + row;
+        std::uint32_t d = c + 1;
+        indices.insert(indices.end(), {a, c, d, a, d, b});
+    }
+
+    // 按位置还原网格点编号, 每个三角形旋转到最小编号在前, 保持绕序, 用于比较优化前后的三角形集合
+    auto triangleSet = [row](const std::vector<RainDX::Vertex>& vs, const std::vector<std::uint32_t>& is)
+    {
+        std::vector<std::array<std::uint32_t, 3>> triangles;
+        triangles.reserve(is.size() / 3);
+        for (std::size_t i = 0; i + 2 < is.size(); i += 3)
+        {
+            std::array<std::uint32_t, 3> t;
+            for (int k = 0; k < 3; ++k)
+            {
+                const DirectX::XMFLOAT3& p = vs[is[i + k]].Pos;
+                t[k] = static_cast<std::uint32_t>(p.z) * row + static_cast<std::uint32_t>(p.x);
+            }
+            std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+            triangles.push_back(t);
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    };
+    const auto sourceTriangles = triangleSet(vertices, indices);
+    // 规则网格优化后每个顶点平均变换约 1.1 到 1.3 次, 与网格大小无关
+    constexpr float maxAtvr = 1.5f;
+    bool ok = true;
+
+    for (std::uint32_t cacheSize : {16u, 32u})
+    {
+        std::vector<RainDX::Vertex> optimizedVertices = vertices;
+        std::vector<std::uint32_t> optimizedIndices = indices;
+        auto begin = std::chrono::steady_clock::now();
+        RainDX::MeshOptimizeReport report = RainDX::MeshOptimizer::Optimize(
+            optimizedVertices.data(), sizeof(RainDX::Vertex), optimizedVertices.size(),
+            optimizedIndices.data(), optimizedIndices.size(), cacheSize);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+        // 同一输入得到同一结果
+        std::vector<RainDX::Vertex> repeatVertices = vertices;
+        std::vector<std::uint32_t> repeatIndices = indices;
+        RainDX::MeshOptimizer::Optimize(repeatVertices.data(), sizeof(RainDX::Vertex), repeatVertices.size(),
+                                        repeatIndices.data(), repeatIndices.size(), cacheSize);
+
+        // 三角形集合和绕序不变, 所有顶点都被引用, 缓存未命中不增加且接近理想值
+        bool pass = triangleSet(optimizedVertices, optimizedIndices) == sourceTriangles
+            && repeatIndices == optimizedIndices
+            && report.After.Triangles == quads.size() * 2 && report.After.Vertices == vertices.size()
+            && report.After.Acmr <= report.Before.Acmr && report.After.Atvr <= maxAtvr;
+        ok = ok && pass;
+
+        std::wcout << L"cache " << cacheSize << L": " << (pass ? L"ok" : L"FAILED")
+            << L"    triangles: " << report.After.Triangles
+            << L"    acmr: " << report.Before.Acmr << L" -> " << report.After.Acmr
+            << L"    atvr: " << report.Before.Atvr << L" -> " << report.After.Atvr
+            << L"    time: " << ms << L" ms" << std::endl;
+    }
+
+    return ok ? 0 : 1;
+}
+
+// 网格簇: 球面网格的构建耗时, 簇的填充率, 从一侧观察时的裁剪结果和确定性哈希
+static int RunMeshletBenchmark(const std::string& args)
+{
+    using namespace DirectX;
+
+    int rings = 500;
+    std::istringstream(args) >> rings;
+    if (rings < 2)
+        rings = 2;
+    const std::uint32_t segments = static_cast<std::uint32_t>(rings) * 2;
+
+    std::vector<XMFLOAT3> vertices;
+    for (int i = 0; i <= rings; ++i)
+    {
+        float theta = XM_PI * i / rings;
+        for (std::uint32_t j = 0; j <= segments; ++j)
+        {
+            float phi = XM_2PI * j / segments;
+            vertices.emplace_back(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+        }
+    }
+    std::vector<std::uint32_t> indices;
+    for (std::uint32_t i = 0; i < static_cast<std::uint32_t>(rings); ++i)
+    {
+        for (std::uint32_t j = 0; j < segments; ++j)
+        {
+            std::uint32_t a = i * (segments + 1) + j;
+            std::uint32_t b = a + 1;
+            std::uint32_t c = a + segments + 1;
+            std::uint32_t d = c + 1;
+            indices.insert(indices.end(), {a, b, d, a, d, c});
+        }
+    }
+    const std::vector<std::uint32_t> sourceIndices = indices;
+
+    std::vector<RainDX::Meshlet> meshlets;
+    auto begin = std::chrono::steady_clock::now();
+    RainDX::MeshletBuilder::Build(indices.data(), indices.size(), &vertices[0].x, sizeof(XMFLOAT3),
+                                  vertices.size(), 0, meshlets);
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    // 每个三角形旋转到最小编号在前, 保持绕序, 排序后比较三角形集合
+    auto triangleSet = [](const std::vector<std::uint32_t>& is)
+    {
+        std::vector<std::array<std::uint32_t, 3>> triangles(is.size() / 3);
+        for (std::size_t t = 0; t < triangles.size(); ++t)
+        {
+            triangles[t] = {is[t * 3], is[t * 3 + 1], is[t * 3 + 2]};
+            std::rotate(triangles[t].begin(), std::min_element(triangles[t].begin(), triangles[t].end()),
+                        triangles[t].end());
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    };
+
+    // 簇按顺序连续覆盖整个索引缓冲区, 不超过顶点和三角形上限, 包围球包含簇的所有顶点
+    bool buildOk = triangleSet(indices) == triangleSet(sourceIndices);
+    std::size_t meshletVertices = 0;
+    std::uint32_t nextIndex = 0;
+    std::vector<std::uint32_t> unique;
+    for (const RainDX::Meshlet& meshlet : meshlets)
+    {
+        meshletVertices += meshlet.VertexCount;
+        unique.assign(indices.begin() + meshlet.StartIndexLocation,
+                      indices.begin() + meshlet.StartIndexLocation + meshlet.IndexCount);
+        std::sort(unique.begin(), unique.end());
+        unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+
+        bool inside = true;
+        for (std::uint32_t v : unique)
+        {
+            float dx = vertices[v].x - meshlet.Center.x;
+            float dy = vertices[v].y - meshlet.Center.y;
+            float dz = vertices[v].z - meshlet.Center.z;
+            inside = inside && std::sqrt(dx * dx + dy * dy + dz * dz) <= meshlet.Radius * 1.0001f + 1e-6f;
+        }
+
+        buildOk = buildOk && inside && meshlet.StartIndexLocation == nextIndex
+            && meshlet.IndexCount > 0 && meshlet.IndexCount % 3 == 0
+            && meshlet.IndexCount / 3 <= RainDX::MeshletBuilder::MaxTriangles
+            && meshlet.VertexCount == unique.size() && meshlet.VertexCount <= RainDX::MeshletBuilder::MaxVertices;
+        nextIndex += meshlet.IndexCount;
+    }
+    buildOk = buildOk && nextIndex == indices.size();
+
+    // 从球外一侧看向球心, 只有朝向相机且在视锥内的簇留下
+    XMFLOAT3 eye(0.0f, 0.5f, -2.5f);
+    XMMATRIX view = XMMatrixLookAtLH(XMLoadFloat3(&eye), XMVectorZero(), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+    XMMATRIX proj = XMMatrixPerspectiveFovLH(0.15f * XM_PI, 1.5f, 0.1f, 100.0f);
+    XMFLOAT4X4 viewProj;
+    XMStoreFloat4x4(&viewProj, view * proj);
+    RainDX::CullFrustum frustum = RainDX::CullFrustum::FromViewProj(viewProj);
+
+    std::vector<RainDX::MeshletRange> ranges;
+    constexpr int rounds = 100;
+    RainDX::MeshletCullStats stats;
+    begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r)
+    {
+        ranges.clear();
+        stats = RainDX::MeshletBuilder::Cull(meshlets.data(), meshlets.size(), frustum, eye, ranges);
+    }
+    double cullUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / rounds;
+
+    std::size_t survivingTriangles = 0;
+    for (const RainDX::MeshletRange& range : ranges)
+        survivingTriangles += range.IndexCount / 3;
+
+    // 裁剪必须保守: 被裁掉的簇要么所有顶点在同一个平面之外, 要么所有三角形都背向相机
+    // 位置经过三角函数, 不同平台的边界情况可能不同, 这里只检查保守性和计数
+    bool cullOk = stats.Visible + stats.FrustumCulled + stats.BackfaceCulled == meshlets.size()
+        && survivingTriangles > 0;
+    std::size_t range = 0;
+    std::size_t keptIndices = 0;
+    for (const RainDX::Meshlet& meshlet : meshlets)
+    {
+        while (range < ranges.size()
+            && ranges[range].StartIndexLocation + ranges[range].IndexCount <= meshlet.StartIndexLocation)
+            ++range;
+        bool kept = range < ranges.size() && ranges[range].StartIndexLocation <= meshlet.StartIndexLocation;
+        if (kept)
+        {
+            keptIndices += meshlet.IndexCount;
+            continue;
+        }
+
+        const std::uint32_t* first = indices.data() + meshlet.StartIndexLocation;
+        bool outside = false;
+        for (const XMFLOAT4& plane : frustum.Planes)
+        {
+            bool allOutside = true;
+            for (std::uint32_t i = 0; i < meshlet.IndexCount; ++i)
+            {
+                const XMFLOAT3& p = vertices[first[i]];
+                allOutside = allOutside && plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w < 1e-5f;
+            }
+            outside = outside || allOutside;
+        }
+
+        bool backfacing = true;
+        for (std::uint32_t t = 0; t < meshlet.IndexCount; t += 3)
+        {
+            const XMFLOAT3& p0 = vertices[first[t]];
+            const XMFLOAT3& p1 = vertices[first[t + 1]];
+            const XMFLOAT3& p2 = vertices[first[t + 2]];
+            XMFLOAT3 e1(p1.x - p0.x, p1.y - p0.y, p1.z - p0.z);
+            XMFLOAT3 e2(p2.x - p0.x, p2.y - p0.y, p2.z - p0.z);
+            XMFLOAT3 n(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+            float facing = (p0.x - eye.x) * n.x + (p0.y - eye.y) * n.y + (p0.z - eye.z) * n.z;
+            backfacing = backfacing && facing >= -1e-7f;
+        }
+        cullOk = cullOk && (outside || backfacing);
+    }
+    cullOk = cullOk && keptIndices == survivingTriangles * 3;
+
+    // FNV-1a, 覆盖重排后的索引和簇的范围
+    std::uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](std::uint32_t value)
+    {
+        hash = (hash ^ value) * 1099511628211ull;
+    };
+    for (std::uint32_t index : indices)
+        mix(index);
+    for (const RainDX::Meshlet& meshlet : meshlets)
+    {
+        mix(meshlet.StartIndexLocation);
+        mix(meshlet.VertexCount);
+    }
+
+    // 构建只取决于拓扑, 默认环数下簇数和哈希在各平台上相同
+    constexpr int defaultRings = 500;
+    constexpr std::size_t expectedMeshlets = 12875;
+    constexpr std::uint64_t expectedHash = 0xcd2c142828545c36ull;
+    if (rings == defaultRings)
+    {
+        buildOk = buildOk && meshlets.size() == expectedMeshlets && hash == expectedHash;
+        // 相机只看到球的一小块, 两种裁剪都应该起作用
+        cullOk = cullOk && stats.FrustumCulled > 0 && stats.BackfaceCulled > 0;
+    }
+
+    std::wcout << L"layout: " << (buildOk ? L"ok" : L"FAILED")
+        << L"    conservative cull: " << (cullOk ? L"ok" : L"FAILED") << std::endl
+        << L"triangles: " << indices.size() / 3
+        << L"    meshlets: " << meshlets.size()
+        << L"    build: " << buildMs << L" ms"
+        << L"    vertices/meshlet: " << static_cast<double>(meshletVertices) / meshlets.size()
+        << L"    triangles/meshlet: " << static_cast<double>(indices.size() / 3) / meshlets.size() << std::endl
+        << L"    visible: " << stats.Visible
+        << L"    frustum culled: " << stats.FrustumCulled
+        << L"    backface culled: " << stats.BackfaceCulled
+        << L"    ranges: " << ranges.size()
+        << L"    triangles kept: " << survivingTriangles
+        << L"    cull: " << cullUs << L" us"
+        << L"    hash: " << std::hex << hash << std::dec << std::endl;
+
+    return buildOk && cullOk ? 0 : 1;
+}
+
+// 几何打包: 大量小网格和少量大网格打包后的页数, 16/32 位子网格数和索引内存
+static int RunPackBenchmark(const std::string& args)
+{
+    int meshCount = 4096;
+    std::istringstream(args) >> meshCount;
+    if (meshCount < 1)
+        meshCount = 1;
+
+    // 每 512 个网格中有一个超过 16 位索引范围
+    std::mt19937 random(4);
+    std::uniform_int_distribution<std::uint32_t> smallSize(24, 4096);
+    RainDX::GeometryPacker packer(sizeof(RainDX::Vertex));
+    std::vector<RainDX::Vertex> vertices;
+    std::vector<std::uint32_t> indices;
+    for (int m = 0; m < meshCount; ++m)
+    {
+        std::uint32_t vertexCount = m % 512 == 511 ? 70000 : smallSize(random);
+        vertices.assign(vertexCount, {DirectX::XMFLOAT3(0.0f, 0.0f, 0.0f), DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f)});
+        for (std::uint32_t v = 0; v < vertexCount; ++v)
+            vertices[v].Pos = DirectX::XMFLOAT3(static_cast<float>(v), static_cast<float>(m), 0.0f);
+
+        indices.clear();
+        for (std::uint32_t v = 0; v + 2 < vertexCount; ++v)
+            indices.insert(indices.end(), {v, v + 1, v + 2});
+        packer.Add("mesh" + std::to_string(m), vertices.data(), vertices.size(), indices.data(), indices.size());
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::unique_ptr<MeshGeometry>> pages = packer.Pack("packed");
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    // 按子网格自己的格式读回索引, 经 BaseVertexLocation 取到的顶点必须是原网格的顶点
+    // 每页内各子网格的顶点和索引字节范围互不重叠
+    const RainDX::GeometryPackStats& stats = packer.Stats();
+    bool ok = stats.Pages == pages.size() && stats.Submeshes16 + stats.Submeshes32 == static_cast<std::size_t>(meshCount)
+        && stats.Submeshes32 == static_cast<std::size_t>(meshCount / 512) && stats.IndexBytes <= stats.IndexBytes32;
+    std::vector<bool> seen(meshCount, false);
+    std::uint64_t vertexBytes = 0;
+    std::uint64_t indexBytes = 0;
+    std::uint64_t indexBytes32 = 0;
+    for (const std::unique_ptr<MeshGeometry>& page : pages)
+    {
+        vertexBytes += page->VertexBufferByteSize;
+        indexBytes += page->IndexBufferByteSize;
+        const auto* pageVertices = static_cast<const RainDX::Vertex*>(page->VertexBufferCPU->GetBufferPointer());
+        const char* pageIndices = static_cast<const char*>(page->IndexBufferCPU->GetBufferPointer());
+        const std::size_t pageVertexCount = page->VertexBufferByteSize / sizeof(RainDX::Vertex);
+
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> vertexRanges;
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> indexRanges;
+        for (const auto& arg : page->DrawArgs)
+        {
+            const int m = std::stoi(arg.first.substr(4));
+            const SubmeshGeometry& submesh = arg.second;
+            const bool wide = page->SubmeshIndexFormat(submesh) == DXGI_FORMAT_R32_UINT;
+            const std::uint32_t vertexCount = submesh.IndexCount / 3 + 2;
+            const std::uint64_t elementSize = wide ? 4 : 2;
+            const std::uint64_t indexStart = submesh.StartIndexLocation * elementSize;
+            const std::uint64_t indexEnd = indexStart + submesh.IndexCount * elementSize;
+            const std::size_t base = static_cast<std::size_t>(submesh.BaseVertexLocation);
+            indexBytes32 += static_cast<std::uint64_t>(submesh.IndexCount) * 4;
+
+            bool pass = m >= 0 && m < meshCount && !seen[m] && wide == (m % 512 == 511)
+                && indexEnd <= page->IndexBufferByteSize && base + vertexCount <= pageVertexCount;
+            for (std::uint32_t k = 0; pass && k < submesh.IndexCount; ++k)
+            {
+                std::uint32_t index = wide ? reinterpret_cast<const std::uint32_t*>(pageIndices)[submesh.StartIndexLocation + k]
+                                           : reinterpret_cast<const std::uint16_t*>(pageIndices)[submesh.StartIndexLocation + k];
+                const DirectX::XMFLOAT3& pos = pageVertices[base + index].Pos;
+                pass = index == k / 3 + k % 3 && pos.x == static_cast<float>(index) && pos.y == static_cast<float>(m);
+            }
+            ok = ok && pass;
+            if (m >= 0 && m < meshCount)
+                seen[m] = true;
+            vertexRanges.emplace_back(base, base + vertexCount);
+            indexRanges.emplace_back(indexStart, indexEnd);
+        }
+
+        std::sort(vertexRanges.begin(), vertexRanges.end());
+        std::sort(indexRanges.begin(), indexRanges.end());
+        for (std::size_t i = 1; i < vertexRanges.size(); ++i)
+            ok = ok && vertexRanges[i - 1].second <= vertexRanges[i].first;
+        for (std::size_t i = 1; i < indexRanges.size(); ++i)
+            ok = ok && indexRanges[i - 1].second <= indexRanges[i].first;
+    }
+    ok = ok && std::find(seen.begin(), seen.end(), false) == seen.end()
+        && vertexBytes == stats.VertexBytes && indexBytes == stats.IndexBytes && indexBytes32 == stats.IndexBytes32;
+
+    std::wcout << L"layout: " << (ok ? L"ok" : L"FAILED") << std::endl
+        << L"meshes: " << meshCount
+        << L"    pages: " << stats.Pages
+        << L"    16-bit: " << stats.Submeshes16
+        << L"    32-bit: " << stats.Submeshes32
+        << L"    pack: " << ms << L" ms" << std::endl
+        << L"    vertex bytes: " << stats.VertexBytes
+        << L"    index bytes: " << stats.IndexBytes
+        << L"    all 32-bit: " << stats.IndexBytes32 << std::endl;
+
+    return ok ? 0 : 1;
+}
+
+// 几何生成: 所有形状写入同一个线性分配器, 大网格串行和按行带并行生成的耗时
+static int RunGeometryBenchmark(const std::string& args)
+{
+    int size = 4096;
+    std::istringstream(args) >> size;
+    if (size < 2)
+        size = 2;
+    const std::uint32_t rows = static_cast<std::uint32_t>(size);
+
+    using RainDX::GeometryGenerator;
+    using RainDX::GeometrySize;
+
+    // 生成的数量必须等于 *Size 的预测, 所有索引都指向本形状的顶点
+    auto valid = [](const GeometrySize& predicted, const GeometrySize& generated, const auto& spans)
+    {
+        if (generated.VertexCount != predicted.VertexCount || generated.IndexCount != predicted.IndexCount)
+            return false;
+        for (std::uint32_t i = 0; i < generated.IndexCount; ++i)
+        {
+            if (spans.Indices[i] >= generated.VertexCount)
+                return false;
+        }
+        return true;
+    };
+
+    // 第二轮复用第一轮合并后的内存块, 检查在计时之后进行
+    RainDX::LinearArena arena(64 * 1024);
+    std::uint64_t shapeVertices = 0;
+    std::uint64_t shapeIndices = 0;
+    double shapeMs = 0.0;
+    bool shapesOk = true;
+    for (int round = 0; round < 2; ++round)
+    {
+        arena.Reset();
+        shapeVertices = 0;
+        shapeIndices = 0;
+        auto begin = std::chrono::steady_clock::now();
+        auto add = [&](const GeometrySize& generated)
+        {
+            shapeVertices += generated.VertexCount;
+            shapeIndices += generated.IndexCount;
+            return generated;
+        };
+
+        GeometrySize box = GeometryGenerator::BoxSize(3);
+        auto boxSpans = GeometryGenerator::Allocate<std::uint16_t>(arena, box);
+        GeometrySize boxOut = add(GeometryGenerator::Box(1.0f, 1.0f, 1.0f, 3, boxSpans));
+        GeometrySize sphere = GeometryGenerator::SphereSize(64, 32);
+        auto sphereSpans = GeometryGenerator::Allocate<std::uint16_t>(arena, sphere);
+        GeometrySize sphereOut = add(GeometryGenerator::Sphere(1.0f, 64, 32, sphereSpans));
+        GeometrySize geosphere = GeometryGenerator::GeosphereSize(5);
+        auto geosphereSpans = GeometryGenerator::Allocate<std::uint32_t>(arena, geosphere);
+        GeometrySize geosphereOut = add(GeometryGenerator::Geosphere(1.0f, 5, geosphereSpans));
+        GeometrySize cylinder = GeometryGenerator::CylinderSize(64, 16);
+        auto cylinderSpans = GeometryGenerator::Allocate<std::uint16_t>(arena, cylinder);
+        GeometrySize cylinderOut = add(GeometryGenerator::Cylinder(1.0f, 0.5f, 2.0f, 64, 16, cylinderSpans));
+        GeometrySize torus = GeometryGenerator::TorusSize(128, 32);
+        auto torusSpans = GeometryGenerator::Allocate<std::uint16_t>(arena, torus);
+        GeometrySize torusOut = add(GeometryGenerator::Torus(2.0f, 0.5f, 128, 32, torusSpans));
+
+        shapeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+        shapesOk = shapesOk && valid(box, boxOut, boxSpans) && valid(sphere, sphereOut, sphereSpans)
+            && valid(geosphere, geosphereOut, geosphereSpans) && valid(cylinder, cylinderOut, cylinderSpans)
+            && valid(torus, torusOut, torusSpans);
+    }
+
+    // 两次生成到同一块内存, 比较哈希确认并行结果与串行相同, 并行之前用无效值覆盖串行的结果
+    GeometrySize grid = GeometryGenerator::GridSize(rows, rows);
+    arena.Reset();
+    RainDX::GeometrySpans<std::uint32_t> spans = GeometryGenerator::Allocate<std::uint32_t>(arena, grid);
+    auto hashGrid = [&spans, &grid]()
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(spans.Vertices);
+        for (std::size_t i = 0; i < grid.VertexCount * sizeof(RainDX::GeometryVertex); ++i)
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        for (std::uint32_t i = 0; i < grid.IndexCount; ++i)
+            hash = (hash ^ spans.Indices[i]) * 1099511628211ull;
+        return hash;
+    };
+
+    // 先写一遍, 避免首次访问的缺页计入串行耗时
+    memset(spans.Vertices, 0, grid.VertexCount * sizeof(RainDX::GeometryVertex));
+    memset(spans.Indices, 0, grid.IndexCount * sizeof(std::uint32_t));
+
+    auto begin = std::chrono::steady_clock::now();
+    GeometrySize serialOut = GeometryGenerator::Grid(100.0f, 100.0f, rows, rows, spans);
+    double serialMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    std::uint64_t serialHash = hashGrid();
+    bool serialOk = valid(grid, serialOut, spans);
+
+    memset(spans.Vertices, 0xff, grid.VertexCount * sizeof(RainDX::GeometryVertex));
+    memset(spans.Indices, 0xff, grid.IndexCount * sizeof(std::uint32_t));
+
+    RainDX::JobSystem jobs;
+    begin = std::chrono::steady_clock::now();
+    GeometrySize parallelOut = GeometryGenerator::Grid(100.0f, 100.0f, rows, rows, spans, &jobs);
+    double parallelMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    std::uint64_t parallelHash = hashGrid();
+    bool gridOk = serialOk && valid(grid, parallelOut, spans) && serialHash == parallelHash;
+
+    std::wcout << L"shapes: " << (shapesOk ? L"ok" : L"FAILED")
+        << L"    " << shapeVertices << L" vertices, " << shapeIndices << L" indices"
+        << L"    time: " << shapeMs << L" ms" << std::endl
+        << L"grid: " << (gridOk ? L"ok" : L"FAILED") << L"    " << rows << L"x" << rows
+        << L"    serial: " << serialMs << L" ms"
+        << L"    parallel: " << parallelMs << L" ms (" << jobs.ThreadCount() << L" threads)"
+        << L"    match: " << (serialHash == parallelHash ? L"yes" : L"no") << std::endl
+        << L"arena: " << arena.Capacity() / (1024 * 1024) << L" MB in " << arena.ChunkCount() << L" chunks" << std::endl;
+
+    return shapesOk && gridOk ? 0 : 1;
+}
+
+// LOD 链: 生成的球和圆环简化后每一级的三角形数和误差, 以及不同距离上选中的级别
+static int RunLodBenchmark(const std::string& args)
+{
+    int subdivisions = 5;
+    std::istringstream(args) >> subdivisions;
+    subdivisions = (std::min)((std::max)(subdivisions, 1), 7);
+
+    using RainDX::GeometryGenerator;
+    using RainDX::GeometrySize;
+
+    RainDX::LinearArena arena;
+    // 最高细分时两个网格超过默认的页大小, 放宽上限使它们留在同一页
+    RainDX::GeometryPacker packer(sizeof(RainDX::GeometryVertex), 4 * RainDX::GeometryPacker::DefaultPageBytes);
+    const std::uint32_t levels = static_cast<std::uint32_t>(subdivisions);
+    GeometrySize sphere = GeometryGenerator::GeosphereSize(levels);
+    RainDX::GeometrySpans<std::uint32_t> sphereSpans = GeometryGenerator::Allocate<std::uint32_t>(arena, sphere);
+    GeometryGenerator::Geosphere(1.0f, levels, sphereSpans);
+    packer.Add("geosphere", sphereSpans.Vertices, sphere.VertexCount, sphereSpans.Indices, sphere.IndexCount);
+
+    const std::uint32_t ring = 16u << levels;
+    GeometrySize torus = GeometryGenerator::TorusSize(ring, ring / 4);
+    RainDX::GeometrySpans<std::uint32_t> torusSpans = GeometryGenerator::Allocate<std::uint32_t>(arena, torus);
+    GeometryGenerator::Torus(1.0f, 0.3f, ring, ring / 4, torusSpans);
+    packer.Add("torus", torusSpans.Vertices, torus.VertexCount, torusSpans.Indices, torus.IndexCount);
+
+    std::unique_ptr<MeshGeometry> geo = std::move(packer.Pack("lod").front());
+    const UINT indexBytes = geo->IndexBufferByteSize;
+    const char* packedIndices = static_cast<const char*>(geo->IndexBufferCPU->GetBufferPointer());
+    const std::vector<char> original(packedIndices, packedIndices + indexBytes);
+    auto begin = std::chrono::steady_clock::now();
+    const RainDX::MeshLodMap lodMap = RainDX::MeshSimplifier::BuildLods(*geo);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+    // 原有的索引不变, 只在末尾追加
+    bool ok = lodMap.size() == 2 && geo->IndexBufferByteSize >= indexBytes
+        && memcmp(geo->IndexBufferCPU->GetBufferPointer(), original.data(), indexBytes) == 0;
+    std::wcout << L"build: " << ms << L" ms"
+        << L"    index bytes: " << indexBytes << L" -> " << geo->IndexBufferByteSize << std::endl;
+
+    // 1080 像素高, 45 度视野
+    const float pixelsPerUnit = 0.5f * 1080.0f / tanf(0.125f * DirectX::XM_PI);
+    for (const char* name : {"geosphere", "torus"})
+    {
+        const std::vector<RainDX::MeshLod>& lods = lodMap.at(name);
+        const SubmeshGeometry& base = geo->DrawArgs.at(name);
+        const DXGI_FORMAT format = geo->SubmeshIndexFormat(base);
+        const std::size_t elementSize = format == DXGI_FORMAT_R32_UINT ? 4 : 2;
+        const char* indices = static_cast<const char*>(geo->IndexBufferCPU->GetBufferPointer());
+        auto indexAt = [&](const SubmeshGeometry& submesh, std::size_t k) -> std::uint32_t
+        {
+            std::size_t location = submesh.StartIndexLocation + k;
+            if (elementSize == 4)
+                return reinterpret_cast<const std::uint32_t*>(indices)[location];
+            return reinterpret_cast<const std::uint16_t*>(indices)[location];
+        };
+        std::vector<bool> used;
+        for (std::size_t k = 0; k < base.IndexCount; ++k)
+        {
+            std::uint32_t v = indexAt(base, k);
+            if (v >= used.size())
+                used.resize(v + 1, false);
+            used[v] = true;
+        }
+
+        // 第 0 级是原网格, 之后每级至少减少到上一级的 MinLodReduction, 误差不超过 maxRelativeError 换算的距离
+        // 各级格式和 BaseVertexLocation 与原网格相同, 只引用原网格用到的顶点, 没有退化三角形
+        const DirectX::XMFLOAT3& e = base.Bounds.Extents;
+        const float maxError = 0.1f * std::sqrt(e.x * e.x + e.y * e.y + e.z * e.z);
+        bool pass = lods.size() >= 2 && lods.front().Submesh == name && lods.front().Error == 0.0f;
+        for (std::size_t level = 1; pass && level < lods.size(); ++level)
+        {
+            const SubmeshGeometry& previous = geo->DrawArgs.at(lods[level - 1].Submesh);
+            const SubmeshGeometry& submesh = geo->DrawArgs.at(lods[level].Submesh);
+            pass = geo->SubmeshIndexFormat(submesh) == format && submesh.BaseVertexLocation == base.BaseVertexLocation
+                && submesh.IndexCount > 0 && submesh.IndexCount % 3 == 0
+                && submesh.IndexCount <= previous.IndexCount * RainDX::MeshSimplifier::MinLodReduction
+                && (submesh.StartIndexLocation + submesh.IndexCount) * elementSize <= geo->IndexBufferByteSize
+                && submesh.StartIndexLocation * elementSize >= indexBytes
+                && lods[level].Error >= lods[level - 1].Error && lods[level].Error <= maxError;
+            for (std::size_t k = 0; pass && k < submesh.IndexCount; k += 3)
+            {
+                std::uint32_t a = indexAt(submesh, k);
+                std::uint32_t b = indexAt(submesh, k + 1);
+                std::uint32_t c = indexAt(submesh, k + 2);
+                pass = a < used.size() && b < used.size() && c < used.size() && used[a] && used[b] && used[c]
+                    && a != b && b != c && a != c;
+            }
+        }
+
+        // 距离越远选择的级别越粗, 足够近时使用原网格, 足够远时使用最粗一级
+        std::size_t previousLod = 0;
+        for (float distance : {0.01f, 2.0f, 10.0f, 50.0f, 250.0f, 1e6f})
+        {
+            std::size_t lod = RainDX::MeshSimplifier::SelectLod(lods.data(), lods.size(), 1.0f, distance, pixelsPerUnit);
+            pass = pass && lod >= previousLod && lod < lods.size();
+            previousLod = lod;
+        }
+        pass = pass && RainDX::MeshSimplifier::SelectLod(lods.data(), lods.size(), 1.0f, 0.01f, pixelsPerUnit) == 0
+            && previousLod == lods.size() - 1;
+        ok = ok && pass;
+
+        std::wcout << name << L": " << (pass ? L"ok" : L"FAILED");
+        for (const RainDX::MeshLod& lod : lods)
+        {
+            std::wcout << L"    " << geo->DrawArgs.at(lod.Submesh).IndexCount / 3 << L" tris"
+                << L" (" << lod.Error << L")";
+        }
+        std::wcout << std::endl << L"    lod at distance:";
+        for (float distance : {2.0f, 10.0f, 50.0f, 250.0f})
+        {
+            std::wcout << L" " << distance << L"=" << RainDX::MeshSimplifier::SelectLod(
+                lods.data(), lods.size(), 1.0f, distance, pixelsPerUnit);
+        }
+        std::wcout << std::endl;
+    }
+
+    return ok ? 0 : 1;
+}
+
+// 着色器缓存: 用假的编译器检查命中, include 修改, 宏变化和重启后的行为, 不需要 D3D 编译器
+static int RunShaderCacheBenchmark()
+{
+    namespace fs = std::filesystem;
+    const fs::path root = fs::temp_directory_path() / "raindx_shadercache";
+    std::error_code error;
+    fs::remove_all(root, error);
+    fs::create_directories(root / "include", error);
+
+    auto write = [&root](const char* name, const std::string& text)
+    {
+        std::ofstream(root / name, std::ios::binary) << text;
+    };
+    write("main.hlsl", "#include \"include/common.hlsli\"\nfloat4 VS() : SV_POSITION { return Value(); }\n");
+    write("include/common.hlsli", "  #  include <inner.hlsli>\nfloat4 Value() { return Inner; }\n");
+    write("include/inner.hlsli", "static const float4 Inner = 1.0f;\n");
+
+    // 字节码是请求的描述, 同时记录编译次数
+    int compiles = 0;
+    RainDX::ShaderCache::Compiler compile = [&compiles](const RainDX::ShaderRequest& request)
+    {
+        ++compiles;
+        std::string text = request.EntryPoint + request.Target + std::to_string(request.Defines.size());
+        return std::vector<char>(text.begin(), text.end());
+    };
+
+    RainDX::ShaderRequest request;
+    request.Path = (root / "main.hlsl").wstring();
+    request.EntryPoint = "VS";
+    request.Target = "vs_5_0";
+
+    auto cache = std::make_unique<RainDX::ShaderCache>((root / "cache").wstring());
+    bool ok = true;
+    auto step = [&](const wchar_t* name, int expectedCompiles)
+    {
+        cache->GetOrCompile(request, compile);
+        bool pass = compiles == expectedCompiles;
+        ok = ok && pass;
+        std::wcout << name << L": " << (pass ? L"ok" : L"FAILED") << L"    compiles: " << compiles << std::endl;
+    };
+
+    step(L"cold", 1);
+    step(L"warm", 1);
+    write("include/inner.hlsli", "static const float4 Inner = 2.0f;\n");
+    step(L"nested include changed", 2);
+    step(L"warm", 2);
+    request.Defines.push_back({"USE_FOG", "1"});
+    step(L"define added", 3);
+    request.Flags = 1;
+    step(L"flags changed", 4);
+    // 重新创建缓存对象相当于重启程序
+    cache = std::make_unique<RainDX::ShaderCache>((root / "cache").wstring());
+    step(L"restart", 4);
+    cache = std::make_unique<RainDX::ShaderCache>((root / "cache").wstring(), "compiler 2");
+    step(L"compiler changed", 5);
+
+    const RainDX::ShaderKey key = cache->ComputeKey(request);
+    constexpr int rounds = 1000;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+        cache->ComputeKey(request);
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / rounds;
+
+    std::wcout << L"files per key: " << key.Files.size()
+        << L"    key: " << us << L" us"
+        << L"    hits: " << cache->Stats().Hits << std::endl;
+
+    fs::remove_all(root, error);
+    return ok ? 0 : 1;
+}
+
+// 排列编译: 假的编译器模拟固定的编译耗时, 比较单线程和全部线程, 并检查排列包的内容和读写
+static int RunPermutationBenchmark()
+{
+    namespace fs = std::filesystem;
+    const fs::path root = fs::temp_directory_path() / "raindx_permutations";
+    std::error_code error;
+    fs::remove_all(root, error);
+    fs::create_directories(root, error);
+    std::ofstream(root / "lit.hlsl", std::ios::binary) << "float4 PS() : SV_Target { return 1.0f; }\n";
+
+    const std::string manifest =
+        "# test\n"
+        "lit.hlsl VS vs_5_0 SKINNED INSTANCED QUANTIZED_POSITION\n"
+        "lit.hlsl PS ps_5_0 FOG SHADOWS NORMAL_MAP ALPHA_TEST  # 16\n"
+        "\n"
+        "lit.hlsl CS cs_5_0\n";
+    std::vector<RainDX::PermutationShader> shaders;
+    std::string parseError;
+    bool ok = RainDX::PermutationManifest::Parse(manifest, shaders, &parseError);
+    std::vector<RainDX::PermutationShader> rejected;
+    bool badLine = !RainDX::PermutationManifest::Parse("lit.hlsl VS vs_5_0 FOG\nlit.hlsl PS\n", rejected, &parseError);
+    bool duplicate = !RainDX::PermutationManifest::Parse("lit.hlsl VS vs_5_0 FOG FOG\n", rejected, nullptr);
+    std::wcout << L"manifest: " << (ok && shaders.size() == 3 ? L"ok" : L"FAILED")
+        << L"    bad line: " << (badLine ? L"ok" : L"FAILED") << L" (" << parseError.c_str() << L")"
+        << L"    duplicate keyword: " << (duplicate ? L"ok" : L"FAILED") << std::endl;
+    ok = ok && shaders.size() == 3 && badLine && duplicate;
+    if (!ok)
+        return 1;
+
+    // 字节码是入口和宏的描述, 每次编译耗时约 2 ms
+    std::atomic<int> compiles{0};
+    std::atomic<int> failMask{-1};
+    RainDX::ShaderCache::Compiler compile = [&](const RainDX::ShaderRequest& request)
+    {
+        ++compiles;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        std::string text = request.EntryPoint + ":" + request.Target;
+        for (const RainDX::ShaderDefine& define : request.Defines)
+            text += " " + define.Name + "=" + define.Value;
+        if (failMask.load() >= 0 && request.Defines.size() == static_cast<std::size_t>(failMask.load()))
+            throw std::runtime_error("compile error");
+        return std::vector<char>(text.begin(), text.end());
+    };
+
+    auto describe = [](const RainDX::PermutationShader& shader, std::uint32_t mask)
+    {
+        std::string text = shader.EntryPoint + ":" + shader.Target;
+        for (const RainDX::ShaderDefine& define : RainDX::PermutationCompiler::Defines(shader, mask))
+            text += " " + define.Name + "=" + define.Value;
+        return text;
+    };
+    auto verify = [&](const RainDX::ShaderArchive& archive)
+    {
+        for (const RainDX::PermutationShader& shader : shaders)
+        {
+            std::uint32_t index = archive.Find(shader.Name());
+            if (index == RainDX::ShaderArchive::InvalidShader)
+                return false;
+            for (std::uint32_t mask = 0; mask < (1u << shader.Keywords.size()); ++mask)
+            {
+                RainDX::ShaderBytecodeView code = archive.Get(index, mask);
+                if (std::string(static_cast<const char*>(code.Data), code.Size) != describe(shader, mask))
+                    return false;
+            }
+        }
+        return true;
+    };
+
+    double serialMs = 0.0;
+    RainDX::ShaderArchive archive;
+    for (int threads : {1, static_cast<int>(std::thread::hardware_concurrency())})
+    {
+        RainDX::JobSystem jobs(threads - 1);
+        compiles = 0;
+        RainDX::PermutationBuildStats stats = RainDX::PermutationCompiler::Build(
+            shaders, root.wstring(), 0, compile, nullptr, jobs, archive);
+        if (threads == 1)
+            serialMs = stats.Milliseconds;
+        bool pass = verify(archive) && compiles == static_cast<int>(stats.Permutations);
+        ok = ok && pass;
+        std::wcout << L"threads: " << jobs.ThreadCount()
+            << L"    permutations: " << stats.Permutations
+            << L"    build: " << stats.Milliseconds << L" ms"
+            << L"    speedup: " << serialMs / stats.Milliseconds
+            << L"    contents: " << (pass ? L"ok" : L"FAILED") << std::endl;
+    }
+
+    // 经过缓存的第二次构建不再调用编译器
+    RainDX::JobSystem jobs;
+    RainDX::ShaderCache cache((root / "cache").wstring());
+    RainDX::PermutationCompiler::Build(shaders, root.wstring(), 0, compile, &cache, jobs, archive);
+    compiles = 0;
+    RainDX::PermutationBuildStats warm = RainDX::PermutationCompiler::Build(
+        shaders, root.wstring(), 0, compile, &cache, jobs, archive);
+    bool cached = compiles == 0 && warm.CacheHits == warm.Permutations && verify(archive);
+    ok = ok && cached;
+    std::wcout << L"warm cache: " << (cached ? L"ok" : L"FAILED") << L"    build: " << warm.Milliseconds << L" ms" << std::endl;
+
+    // 一个排列失败时异常回到调用线程, 排列包保持不变
+    failMask = 2;
+    bool thrown = false;
+    try
+    {
+        RainDX::PermutationCompiler::Build(shaders, root.wstring(), 0, compile, nullptr, jobs, archive);
+    }
+    catch (const std::runtime_error&)
+    {
+        thrown = true;
+    }
+    failMask = -1;
+    bool failed = thrown && verify(archive);
+    ok = ok && failed;
+    std::wcout << L"compile error: " << (failed ? L"ok" : L"FAILED") << std::endl;
+
+    // 读写往返, 损坏的文件不影响已有内容
+    const std::wstring path = (root / "permutations.bin").wstring();
+    RainDX::ShaderArchive loaded;
+    bool saved = archive.Save(path) && loaded.Load(path) && verify(loaded)
+        && loaded.PermutationCount() == archive.PermutationCount() && loaded.BytecodeSize() == archive.BytecodeSize();
+
+    // 按清单校验记录的缓存键: 一致时加载, 清单, 标志或源文件改变后拒绝并保持原有内容
+    RainDX::ShaderArchive checked;
+    bool current = checked.Load(path, shaders, root.wstring(), 0, cache) && verify(checked);
+    std::vector<RainDX::PermutationShader> fewer(shaders.begin(), shaders.end() - 1);
+    bool manifestChanged = !checked.Load(path, fewer, root.wstring(), 0, cache);
+    bool flagsChanged = !checked.Load(path, shaders, root.wstring(), 1, cache);
+    std::ofstream(root / "lit.hlsl", std::ios::binary) << "float4 PS() : SV_Target { return 0.5f; }\n";
+    bool sourceChanged = !checked.Load(path, shaders, root.wstring(), 0, cache) && verify(checked);
+    bool stale = current && manifestChanged && flagsChanged && sourceChanged;
+    fs::resize_file(fs::path(path), fs::file_size(fs::path(path)) - 1, error);
+    bool truncated = !loaded.Load(path) && verify(loaded);
+    ok = ok && saved && stale && truncated;
+    std::wcout << L"save/load: " << (saved ? L"ok" : L"FAILED")
+        << L"    stale: " << (stale ? L"ok" : L"FAILED")
+        << L"    truncated: " << (truncated ? L"ok" : L"FAILED") << std::endl;
+
+    // 运行时按掩码查找
+    const std::uint32_t ps = loaded.Find("lit.hlsl:PS");
+    const std::uint32_t fog = loaded.KeywordMask(ps, "FOG");
+    const std::uint32_t shadows = loaded.KeywordMask(ps, "SHADOWS");
+    constexpr int lookups = 1 << 22;
+    std::size_t bytes = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < lookups; ++i)
+        bytes += loaded.Get(ps, (i & 1 ? fog : 0) | (i & 2 ? shadows : 0)).Size;
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / lookups;
+    std::wcout << L"lookup: " << ns << L" ns    bytes: " << bytes << std::endl;
+
+    fs::remove_all(root, error);
+    return ok ? 0 : 1;
+}
+
+// 构建时工具: 按清单并行编译全部排列, 写出排列包
+static int BuildShaderPermutations(const std::string& args)
+{
+    std::string manifest = "shaders\\permutations.txt";
+    std::string output = "shaders\\permutations.bin";
+    std::istringstream(args) >> manifest >> output;
+
+    std::vector<RainDX::PermutationShader> shaders;
+    std::string error;
+    const std::filesystem::path manifestPath(manifest);
+    if (!RainDX::PermutationManifest::Load(manifestPath.wstring(), shaders, &error))
+    {
+        std::wcout << manifestPath.wstring() << L": " << error.c_str() << std::endl;
+        return 1;
+    }
+
+    RainDX::JobSystem jobs;
+    RainDX::ShaderCache cache((manifestPath.parent_path() / "cache").wstring(), d3dUtil::CompilerVersion());
+    RainDX::ShaderArchive archive;
+    RainDX::PermutationBuildStats stats;
+    try
+    {
+        stats = RainDX::PermutationCompiler::Build(shaders, manifestPath.parent_path().wstring(),
+                                                   d3dUtil::DefaultCompileFlags(), d3dUtil::CompileBytecode,
+                                                   &cache, jobs, archive);
+    }
+    catch (RainDX::DxException& e)
+    {
+        std::wcout << e.ToString() << std::endl;
+        return 1;
+    }
+
+    if (!archive.Save(std::filesystem::path(output).wstring()))
+    {
+        std::wcout << L"cannot write " << std::filesystem::path(output).wstring() << std::endl;
+        return 1;
+    }
+
+    std::wcout << L"shaders: " << stats.Shaders
+        << L"    permutations: " << stats.Permutations
+        << L"    cached: " << stats.CacheHits
+        << L"    threads: " << jobs.ThreadCount()
+        << L"    time: " << stats.Milliseconds << L" ms"
+        << L"    bytes: " << archive.BytecodeSize() << std::endl;
+    return 0;
+}
+
+// 描述符暂存堆的空闲链表重用, 描述符环的回绕和回收, 以及每帧合并后的复制次数
+static int RunDescriptorBenchmark()
+{
+    constexpr std::uint64_t latency = 2;
+    RainDX::NullRenderDevice device(latency);
+    const D3D12_DESCRIPTOR_HEAP_TYPE type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    const UINT descriptorSize = device.DescriptorSize(type);
+
+    // 暂存堆: 释放一半再分配, 应当重用释放的描述符而不增加新页
+    RainDX::DescriptorStagingHeap staging(&device, type, 256);
+    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> handles(4096);
+    for (D3D12_CPU_DESCRIPTOR_HANDLE& handle : handles)
+        handle = staging.Allocate();
+    const UINT pages = staging.PageCount();
+    for (std::size_t i = 0; i < handles.size(); i += 2)
+        staging.Free(handles[i]);
+    for (std::size_t i = 0; i < handles.size(); i += 2)
+        handles[i] = staging.Allocate();
+
+    std::vector<SIZE_T> addresses;
+    for (const D3D12_CPU_DESCRIPTOR_HANDLE& handle : handles)
+        addresses.push_back(handle.ptr);
+    std::sort(addresses.begin(), addresses.end());
+    bool unique = std::adjacent_find(addresses.begin(), addresses.end()) == addresses.end();
+    bool stagingOk = unique && pages == 16 && staging.PageCount() == pages && staging.Allocated() == handles.size();
+
+    constexpr int rounds = 1 << 20;
+    auto begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r)
+    {
+        std::size_t j = (static_cast<std::size_t>(r) * 769) % handles.size();
+        staging.Free(handles[j]);
+        handles[j] = staging.Allocate();
+    }
+    double freeAllocNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / rounds;
+
+    std::wcout << L"staging: " << (stagingOk ? L"ok" : L"FAILED")
+        << L"    pages: " << staging.PageCount()
+        << L"    allocated: " << staging.Allocated()
+        << L"    free + allocate: " << freeAllocNs << L" ns" << std::endl;
+
+    // 描述符环: 每帧暂存若干张表, GPU 落后 latency 帧
+    // 记录每个槽位最后写入它的帧的围栏值, 写入尚未完成的槽位即为覆盖了 GPU 仍在读取的描述符
+    constexpr UINT capacity = 4096;
+    constexpr int frames = 1000;
+    constexpr int tablesPerFrame = 200;
+    constexpr std::uint64_t inFrame = ~0ull;
+    RainDX::DescriptorRing ring(&device, type, capacity);
+    device.ResetStats();
+    const SIZE_T cpuBase = ring.Heap()->GetCPUDescriptorHandleForHeapStart().ptr;
+    const UINT64 gpuBase = ring.Heap()->GetGPUDescriptorHandleForHeapStart().ptr;
+
+    std::vector<std::uint64_t> owner(capacity, 0);
+    std::vector<UINT> written;
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<UINT> tableSize(1, 8);
+    UINT64 tables = 0;
+    UINT64 descriptors = 0;
+    UINT maxUsed = 0;
+    bool contiguous = true;
+    bool overwritten = false;
+
+    begin = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f)
+    {
+        ring.Retire(device.Fence()->CompletedValue());
+        written.clear();
+        for (int t = 0; t < tablesPerFrame; ++t)
+        {
+            UINT count = tableSize(rng);
+            std::size_t first = (static_cast<std::size_t>(t) * 8) % (handles.size() - 8);
+            RainDX::DescriptorTable table = ring.Stage(handles.data() + first, count);
+
+            UINT index = static_cast<UINT>((table.Cpu.ptr - cpuBase) / descriptorSize);
+            contiguous = contiguous && index + count <= capacity && table.Count == count
+                && table.Gpu.ptr == gpuBase + static_cast<UINT64>(index) * descriptorSize;
+            std::uint64_t completed = device.Fence()->CompletedValue();
+            for (UINT k = index; k < index + count && k < capacity; ++k)
+            {
+                overwritten = overwritten || owner[k] == inFrame || owner[k] > completed;
+                owner[k] = inFrame;
+                written.push_back(k);
+            }
+            ++tables;
+            descriptors += count;
+        }
+        maxUsed = (std::max)(maxUsed, ring.Used());
+
+        ring.Flush();
+        std::uint64_t fence = device.Fence()->Signal();
+        ring.FinishFrame(fence);
+        for (UINT k : written)
+            owner[k] = fence;
+    }
+    double stageNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / descriptors;
+
+    const RainDX::RenderStats& stats = device.Stats();
+    bool batched = stats.DescriptorCopies == static_cast<UINT64>(frames) && stats.DescriptorWrites == descriptors;
+    bool ringOk = contiguous && !overwritten && batched && ring.Pending() == 0;
+    auto* fence = static_cast<RainDX::NullFrameFence*>(device.Fence());
+
+    // 大于整个环的表和占满整个环的帧等待 GPU 也放不下, 应当抛出异常
+    RainDX::DescriptorRing smallRing(&device, type, 16);
+    auto throws = [&smallRing](UINT count)
+    {
+        try
+        {
+            smallRing.Allocate(count);
+        }
+        catch (const RainDX::DxException&)
+        {
+            return true;
+        }
+        return false;
+    };
+    ringOk = ringOk && throws(17) && !throws(16) && throws(1);
+
+    std::wcout << L"ring: " << (ringOk ? L"ok" : L"FAILED")
+        << L"    tables: " << tables
+        << L"    descriptors: " << descriptors
+        << L"    copy calls: " << stats.DescriptorCopies << L" (per table: " << tables << L")"
+        << L"    max used: " << maxUsed << L"/" << capacity
+        << L"    stalls: " << fence->WaitCount()
+        << L"    stage: " << stageNs << L" ns/descriptor" << std::endl;
+
+    return stagingOk && ringOk ? 0 : 1;
+}
+
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE prevInstance,
                    PSTR cmdLine, int showCmd)
 {
+    // -headless [帧数] [盒子数] [trace 输出路径或 -] [帧耗时 csv 路径]
+    // -noinstancing 每个盒子单独绘制, 物体数据用根常量
+    // -noocclusion 不做软件遮挡剔除
+    // -fullvertices 顶点使用 32 位浮点, 不量化
+    // -nolod 总是绘制原网格
+    // -framebench
+    // -jobbench [最大线程数]
+    // -tlsfbench
+    // -poolbench
+    // -statsbench
+    // -stepbench
+    // -cullbench
+    // -bvhbench
+    // -occlusionbench
+    // -meshbench [网格边长]
+    // -meshletbench [球面环数]
+    // -packbench [网格数]
+    // -genbench [网格边长]
+    // -lodbench [细分级数]
+    // -shadercachebench
+    // -permbench
+    // -descbench
+    // -buildshaders [清单路径] [排列包路径]
+    std::string args = cmdLine != nullptr ? cmdLine : "";
+    if (args.find("-framebench") != std::string::npos)
+        return RunFrameRingBenchmark();
+    if (args.find("-tlsfbench") != std::string::npos)
+        return RunTlsfBenchmark();
+    if (args.find("-poolbench") != std::string::npos)
+        return RunCmdListPoolBenchmark();
+    if (args.find("-statsbench") != std::string::npos)
+        return RunFrameStatsBenchmark();
+    if (args.find("-stepbench") != std::string::npos)
+        return RunFixedTimestepBenchmark();
+    if (args.find("-cullbench") != std::string::npos)
+        return RunCullBenchmark();
+    if (args.find("-bvhbench") != std::string::npos)
+        return RunBvhBenchmark();
+    if (args.find("-occlusionbench") != std::string::npos)
+        return RunOcclusionBenchmark();
+    if (args.find("-shadercachebench") != std::string::npos)
+        return RunShaderCacheBenchmark();
+    if (args.find("-permbench") != std::string::npos)
+        return RunPermutationBenchmark();
+    if (args.find("-descbench") != std::string::npos)
+        return RunDescriptorBenchmark();
+
+    size_t buildShaders = args.find("-buildshaders");
+    if (buildShaders != std::string::npos)
+        return BuildShaderPermutations(args.substr(buildShaders + std::string("-buildshaders").size()));
+
+    size_t lodBench = args.find("-lodbench");
+    if (lodBench != std::string::npos)
+        return RunLodBenchmark(args.substr(lodBench + std::string("-lodbench").size()));
+
+    size_t genBench = args.find("-genbench");
+    if (genBench != std::string::npos)
+        return RunGeometryBenchmark(args.substr(genBench + std::string("-genbench").size()));
+
+    size_t packBench = args.find("-packbench");
+    if (packBench != std::string::npos)
+        return RunPackBenchmark(args.substr(packBench + std::string("-packbench").size()));
+
+    size_t meshletBench = args.find("-meshletbench");
+    if (meshletBench != std::string::npos)
+        return RunMeshletBenchmark(args.substr(meshletBench + std::string("-meshletbench").size()));
+
+    size_t meshBench = args.find("-meshbench");
+    if (meshBench != std::string::npos)
+        return RunMeshBenchmark(args.substr(meshBench + std::string("-meshbench").size()));
+
+    size_t jobBench = args.find("-jobbench");
+    if (jobBench != std::string::npos)
+        return RunJobBenchmark(args.substr(jobBench + std::string("-jobbench").size()));
+
+    SceneOptions options;
+    options.Instancing = !TakeFlag(args, "-noinstancing");
+    options.Occlusion = !TakeFlag(args, "-noocclusion");
+    options.CompactVertices = !TakeFlag(args, "-fullvertices");
+    options.Lod = !TakeFlag(args, "-nolod");
+
+    size_t headless = args.find("-headless");
+    if (headless != std::string::npos)
+        return RunHeadless(hInstance, args.substr(headless + std::string("-headless").size()), options);
+
     auto app = std::make_unique<RainDX::BoxApplication>(hInstance);
+    app->SetInstancing(options.Instancing);
+    app->SetOcclusion(options.Occlusion);
+    app->SetCompactVertices(options.CompactVertices);
+    app->SetLod(options.Lod);
 
     try
     {
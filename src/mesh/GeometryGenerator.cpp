@@ -0,0 +1,548 @@
+#include "mesh/GeometryGenerator.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "core/JobSystem.h"
+#include "core/LinearArena.h"
+
+namespace
+{
+    // 细分级数上限, 超过后顶点数会超出 32 位索引
+    static constexpr std::uint32_t MaxSubdivisions = 10;
+    static constexpr float Pi = 3.1415926535f;
+
+    using DirectX::XMFLOAT2;
+    using DirectX::XMFLOAT3;
+
+    XMFLOAT3 Normalize(const XMFLOAT3& v)
+    {
+        float length = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+        if (length == 0.0f)
+            return v;
+        return XMFLOAT3(v.x / length, v.y / length, v.z / length);
+    }
+
+    RainDX::GeometryVertex MakeVertex(const XMFLOAT3& position, const XMFLOAT3& normal,
+                                      const XMFLOAT3& tangent, float u, float v)
+    {
+        RainDX::GeometryVertex vertex;
+        vertex.Position = position;
+        vertex.Normal = normal;
+        vertex.TangentU = tangent;
+        vertex.TexC = XMFLOAT2(u, v);
+        return vertex;
+    }
+
+    // 球面上的顶点, 纹理坐标和切线按球坐标计算
+    RainDX::GeometryVertex SphereVertex(const XMFLOAT3& direction, float radius)
+    {
+        XMFLOAT3 n = Normalize(direction);
+        float theta = std::atan2(n.z, n.x);
+        if (theta < 0.0f)
+            theta += 2.0f * Pi;
+        float phi = std::acos((std::min)((std::max)(n.y, -1.0f), 1.0f));
+
+        // 两极处切线退化, 取 x 轴
+        XMFLOAT3 tangent(-std::sin(theta), 0.0f, std::cos(theta));
+        if (std::sin(phi) < 1e-6f)
+            tangent = XMFLOAT3(1.0f, 0.0f, 0.0f);
+
+        return MakeVertex(XMFLOAT3(n.x * radius, n.y * radius, n.z * radius), n, tangent,
+                          theta / (2.0f * Pi), phi / Pi);
+    }
+
+    // a 为左上角, b 右上, c 左下, d 右下, 从正面看为顺时针
+    template <typename Index>
+    Index* WriteQuad(Index* out, std::uint32_t a, std::uint32_t b, std::uint32_t c, std::uint32_t d)
+    {
+        out[0] = static_cast<Index>(c);
+        out[1] = static_cast<Index>(a);
+        out[2] = static_cast<Index>(b);
+        out[3] = static_cast<Index>(c);
+        out[4] = static_cast<Index>(b);
+        out[5] = static_cast<Index>(d);
+        return out + 6;
+    }
+
+    template <typename Index>
+    void CheckCapacity(const RainDX::GeometrySpans<Index>& out, const RainDX::GeometrySize& size)
+    {
+        assert(out.Vertices != nullptr && out.Indices != nullptr);
+        assert(out.VertexCount >= size.VertexCount && out.IndexCount >= size.IndexCount);
+        // 16 位索引只能寻址 65536 个顶点
+        assert(size.VertexCount == 0 || size.VertexCount - 1 <= static_cast<std::uint32_t>(Index(~Index(0))));
+        (void)out;
+        (void)size;
+    }
+
+    std::uint32_t Segments(std::uint32_t subdivisions)
+    {
+        return 1u << (std::min)(subdivisions, MaxSubdivisions);
+    }
+
+    // 二十面体, 顶点在单位球上
+    static constexpr float IcoX = 0.525731f;
+    static constexpr float IcoZ = 0.850651f;
+
+    const XMFLOAT3 IcoVertices[12] = {
+        XMFLOAT3(-IcoX, 0.0f, IcoZ), XMFLOAT3(IcoX, 0.0f, IcoZ),
+        XMFLOAT3(-IcoX, 0.0f, -IcoZ), XMFLOAT3(IcoX, 0.0f, -IcoZ),
+        XMFLOAT3(0.0f, IcoZ, IcoX), XMFLOAT3(0.0f, IcoZ, -IcoX),
+        XMFLOAT3(0.0f, -IcoZ, IcoX), XMFLOAT3(0.0f, -IcoZ, -IcoX),
+        XMFLOAT3(IcoZ, IcoX, 0.0f), XMFLOAT3(-IcoZ, IcoX, 0.0f),
+        XMFLOAT3(IcoZ, -IcoX, 0.0f), XMFLOAT3(-IcoZ, -IcoX, 0.0f),
+    };
+
+    const std::uint32_t IcoFaces[20][3] = {
+        {1, 4, 0}, {4, 9, 0}, {4, 5, 9}, {8, 5, 4}, {1, 8, 4},
+        {1, 10, 8}, {10, 3, 8}, {8, 3, 5}, {3, 2, 5}, {3, 7, 2},
+        {3, 10, 7}, {10, 6, 7}, {6, 11, 7}, {6, 0, 11}, {6, 1, 0},
+        {10, 1, 6}, {11, 0, 9}, {2, 11, 9}, {5, 2, 9}, {11, 2, 7},
+    };
+
+    // 盒子的一个面: 从外侧看, Right 向右, Up 向上
+    struct BoxFace
+    {
+        XMFLOAT3 Normal;
+        XMFLOAT3 Right;
+        XMFLOAT3 Up;
+    };
+
+    const BoxFace BoxFaces[6] = {
+        {XMFLOAT3(0.0f, 0.0f, -1.0f), XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f)},
+        {XMFLOAT3(0.0f, 0.0f, 1.0f), XMFLOAT3(-1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f)},
+        {XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f)},
+        {XMFLOAT3(0.0f, -1.0f, 0.0f), XMFLOAT3(-1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f)},
+        {XMFLOAT3(-1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, -1.0f), XMFLOAT3(0.0f, 1.0f, 0.0f)},
+        {XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 1.0f), XMFLOAT3(0.0f, 1.0f, 0.0f)},
+    };
+
+    // 写入网格的 [firstRow, lastRow) 行顶点和以这些行为上边的四边形
+    template <typename Index>
+    void WriteGridRows(float width, float depth, std::uint32_t rows, std::uint32_t columns,
+                       std::uint32_t firstRow, std::uint32_t lastRow, const RainDX::GeometrySpans<Index>& out)
+    {
+        const float halfWidth = 0.5f * width;
+        const float halfDepth = 0.5f * depth;
+        const float dx = width / (columns - 1);
+        const float dz = depth / (rows - 1);
+        const float du = 1.0f / (columns - 1);
+        const float dv = 1.0f / (rows - 1);
+
+        RainDX::GeometryVertex* vertex = out.Vertices + static_cast<std::size_t>(firstRow) * columns;
+        for (std::uint32_t i = firstRow; i < lastRow; ++i)
+        {
+            float z = halfDepth - i * dz;
+            for (std::uint32_t j = 0; j < columns; ++j)
+            {
+                *vertex++ = MakeVertex(XMFLOAT3(-halfWidth + j * dx, 0.0f, z), XMFLOAT3(0.0f, 1.0f, 0.0f),
+                                       XMFLOAT3(1.0f, 0.0f, 0.0f), j * du, i * dv);
+            }
+        }
+
+        // 四边形的行数比顶点少一
+        const std::uint32_t quadLast = (std::min)(lastRow, rows - 1);
+        Index* index = out.Indices + static_cast<std::size_t>(firstRow) * (columns - 1) * 6;
+        for (std::uint32_t i = firstRow; i < quadLast; ++i)
+        {
+            for (std::uint32_t j = 0; j + 1 < columns; ++j)
+            {
+                std::uint32_t a = i * columns + j;
+                index = WriteQuad(index, a, a + 1, a + columns, a + columns + 1);
+            }
+        }
+    }
+}
+
+template <typename Index>
+RainDX::GeometrySpans<Index> RainDX::GeometryGenerator::Allocate(LinearArena& arena, const GeometrySize& size)
+{
+    GeometrySpans<Index> spans;
+    spans.Vertices = arena.Allocate<GeometryVertex>(size.VertexCount);
+    spans.VertexCount = size.VertexCount;
+    spans.Indices = arena.Allocate<Index>(size.IndexCount);
+    spans.IndexCount = size.IndexCount;
+    return spans;
+}
+
+RainDX::GeometrySize RainDX::GeometryGenerator::BoxSize(std::uint32_t subdivisions)
+{
+    std::uint32_t n = Segments(subdivisions);
+    GeometrySize size;
+    size.VertexCount = 6 * (n + 1) * (n + 1);
+    size.IndexCount = 6 * n * n * 6;
+    return size;
+}
+
+template <typename Index>
+RainDX::GeometrySize RainDX::GeometryGenerator::Box(float width, float height, float depth,
+                                                    std::uint32_t subdivisions, const GeometrySpans<Index>& out)
+{
+    const GeometrySize size = BoxSize(subdivisions);
+    CheckCapacity(out, size);
+
+    const std::uint32_t n = Segments(subdivisions);
+    const XMFLOAT3 half(0.5f * width, 0.5f * height, 0.5f * depth);
+
+    GeometryVertex* vertex = out.Vertices;
+    Index* index = out.Indices;
+    for (std::uint32_t f = 0; f < 6; ++f)
+    {
+        const BoxFace& face = BoxFaces[f];
+        const std::uint32_t base = f * (n + 1) * (n + 1);
+
+        // 行从上到下, 列从左到右
+        for (std::uint32_t i = 0; i <= n; ++i)
+        {
+            float v = static_cast<float>(i) / n;
+            float up = 1.0f - 2.0f * v;
+            for (std::uint32_t j = 0; j <= n; ++j)
+            {
+                float u = static_cast<float>(j) / n;
+                float right = 2.0f * u - 1.0f;
+                XMFLOAT3 p(
+                    (face.Normal.x + face.Right.x * right + face.Up.x * up) * half.x,
+                    (face.Normal.y + face.Right.y * right + face.Up.y * up) * half.y,
+                    (face.Normal.z + face.Right.z * right + face.Up.z * up) * half.z);
+                *vertex++ = MakeVertex(p, face.Normal, face.Right, u, v);
+            }
+        }
+
+        for (std::uint32_t i = 0; i < n; ++i)
+        {
+            for (std::uint32_t j = 0; j < n; ++j)
+            {
+                std::uint32_t a = base + i * (n + 1) + j;
+                index = WriteQuad(index, a, a + 1, a + n + 1, a + n + 2);
+            }
+        }
+    }
+    return size;
+}
+
+RainDX::GeometrySize RainDX::GeometryGenerator::SphereSize(std::uint32_t sliceCount, std::uint32_t stackCount)
+{
+    assert(sliceCount >= 3 && stackCount >= 2);
+    GeometrySize size;
+    size.VertexCount = 2 + (stackCount - 1) * (sliceCount + 1);
+    size.IndexCount = 2 * sliceCount * 3 + (stackCount - 2) * sliceCount * 6;
+    return size;
+}
+
+template <typename Index>
+RainDX::GeometrySize RainDX::GeometryGenerator::Sphere(float radius, std::uint32_t sliceCount,
+                                                       std::uint32_t stackCount, const GeometrySpans<Index>& out)
+{
+    const GeometrySize size = SphereSize(sliceCount, stackCount);
+    CheckCapacity(out, size);
+
+    const float phiStep = Pi / stackCount;
+    const float thetaStep = 2.0f * Pi / sliceCount;
+    const std::uint32_t ringVertexCount = sliceCount + 1;
+
+    // 北极, 中间的纬线圈 (首尾顶点重合以便纹理坐标闭合), 南极
+    GeometryVertex* vertex = out.Vertices;
+    *vertex++ = MakeVertex(XMFLOAT3(0.0f, radius, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f),
+                           XMFLOAT3(1.0f, 0.0f, 0.0f), 0.0f, 0.0f);
+    for (std::uint32_t i = 1; i < stackCount; ++i)
+    {
+        float phi = i * phiStep;
+        for (std::uint32_t j = 0; j <= sliceCount; ++j)
+        {
+            float theta = j * thetaStep;
+            XMFLOAT3 n(std::sin(phi) * std::cos(theta), std::cos(phi), std::sin(phi) * std::sin(theta));
+            *vertex++ = MakeVertex(XMFLOAT3(n.x * radius, n.y * radius, n.z * radius), n,
+                                   XMFLOAT3(-std::sin(theta), 0.0f, std::cos(theta)),
+                                   theta / (2.0f * Pi), phi / Pi);
+        }
+    }
+    *vertex++ = MakeVertex(XMFLOAT3(0.0f, -radius, 0.0f), XMFLOAT3(0.0f, -1.0f, 0.0f),
+                           XMFLOAT3(1.0f, 0.0f, 0.0f), 0.0f, 1.0f);
+
+    Index* index = out.Indices;
+    for (std::uint32_t j = 0; j < sliceCount; ++j)
+    {
+        *index++ = 0;
+        *index++ = static_cast<Index>(1 + j + 1);
+        *index++ = static_cast<Index>(1 + j);
+    }
+
+    for (std::uint32_t i = 0; i + 2 < stackCount; ++i)
+    {
+        for (std::uint32_t j = 0; j < sliceCount; ++j)
+        {
+            std::uint32_t a = 1 + i * ringVertexCount + j;
+            index = WriteQuad(index, a, a + 1, a + ringVertexCount, a + ringVertexCount + 1);
+        }
+    }
+
+    const std::uint32_t south = size.VertexCount - 1;
+    const std::uint32_t lastRing = south - ringVertexCount;
+    for (std::uint32_t j = 0; j < sliceCount; ++j)
+    {
+        *index++ = static_cast<Index>(south);
+        *index++ = static_cast<Index>(lastRing + j);
+        *index++ = static_cast<Index>(lastRing + j + 1);
+    }
+    return size;
+}
+
+RainDX::GeometrySize RainDX::GeometryGenerator::GeosphereSize(std::uint32_t subdivisions)
+{
+    std::uint32_t n = Segments(subdivisions);
+    GeometrySize size;
+    size.VertexCount = 20 * (n + 1) * (n + 2) / 2;
+    size.IndexCount = 20 * n * n * 3;
+    return size;
+}
+
+template <typename Index>
+RainDX::GeometrySize RainDX::GeometryGenerator::Geosphere(float radius, std::uint32_t subdivisions,
+                                                          const GeometrySpans<Index>& out)
+{
+    const GeometrySize size = GeosphereSize(subdivisions);
+    CheckCapacity(out, size);
+
+    const std::uint32_t n = Segments(subdivisions);
+    const std::uint32_t faceVertexCount = (n + 1) * (n + 2) / 2;
+
+    GeometryVertex* vertex = out.Vertices;
+    Index* index = out.Indices;
+    for (std::uint32_t f = 0; f < 20; ++f)
+    {
+        const XMFLOAT3& a = IcoVertices[IcoFaces[f][0]];
+        const XMFLOAT3& b = IcoVertices[IcoFaces[f][1]];
+        const XMFLOAT3& c = IcoVertices[IcoFaces[f][2]];
+        const std::uint32_t base = f * faceVertexCount;
+
+        // 第 i 行有 i + 1 个顶点: a + i/n (b - a) + j/n (c - b), 最后一行是 bc 边
+        for (std::uint32_t i = 0; i <= n; ++i)
+        {
+            float s = static_cast<float>(i) / n;
+            for (std::uint32_t j = 0; j <= i; ++j)
+            {
+                float t = static_cast<float>(j) / n;
+                XMFLOAT3 p(
+                    a.x + (b.x - a.x) * s + (c.x - b.x) * t,
+                    a.y + (b.y - a.y) * s + (c.y - b.y) * t,
+                    a.z + (b.z - a.z) * s + (c.z - b.z) * t);
+                *vertex++ = SphereVertex(p, radius);
+            }
+        }
+
+        // 与 abc 同向的三角形和夹在它们之间的倒三角形
+        for (std::uint32_t i = 0; i < n; ++i)
+        {
+            std::uint32_t row = base + i * (i + 1) / 2;
+            std::uint32_t next = base + (i + 1) * (i + 2) / 2;
+            for (std::uint32_t j = 0; j <= i; ++j)
+            {
+                *index++ = static_cast<Index>(row + j);
+                *index++ = static_cast<Index>(next + j);
+                *index++ = static_cast<Index>(next + j + 1);
+                if (j < i)
+                {
+                    *index++ = static_cast<Index>(row + j);
+                    *index++ = static_cast<Index>(next + j + 1);
+                    *index++ = static_cast<Index>(row + j + 1);
+                }
+            }
+        }
+    }
+    return size;
+}
+
+RainDX::GeometrySize RainDX::GeometryGenerator::CylinderSize(std::uint32_t sliceCount, std::uint32_t stackCount)
+{
+    assert(sliceCount >= 3 && stackCount >= 1);
+    GeometrySize size;
+    size.VertexCount = (stackCount + 1) * (sliceCount + 1) + 2 * (sliceCount + 2);
+    size.IndexCount = stackCount * sliceCount * 6 + 2 * sliceCount * 3;
+    return size;
+}
+
+template <typename Index>
+RainDX::GeometrySize RainDX::GeometryGenerator::Cylinder(float bottomRadius, float topRadius, float height,
+                                                         std::uint32_t sliceCount, std::uint32_t stackCount,
+                                                         const GeometrySpans<Index>& out)
+{
+    const GeometrySize size = CylinderSize(sliceCount, stackCount);
+    CheckCapacity(out, size);
+
+    const float stackHeight = height / stackCount;
+    const float radiusStep = (topRadius - bottomRadius) / stackCount;
+    const float dTheta = 2.0f * Pi / sliceCount;
+    const float dr = bottomRadius - topRadius;
+    const std::uint32_t ringVertexCount = sliceCount + 1;
+
+    // 侧面: 从底到顶的圆环, 法线由切线和沿母线的副切线求出
+    GeometryVertex* vertex = out.Vertices;
+    for (std::uint32_t i = 0; i <= stackCount; ++i)
+    {
+        float y = -0.5f * height + i * stackHeight;
+        float r = bottomRadius + i * radiusStep;
+        for (std::uint32_t j = 0; j <= sliceCount; ++j)
+        {
+            float c = std::cos(j * dTheta);
+            float s = std::sin(j * dTheta);
+            XMFLOAT3 tangent(-s, 0.0f, c);
+            XMFLOAT3 bitangent(dr * c, -height, dr * s);
+            XMFLOAT3 normal = Normalize(XMFLOAT3(
+                tangent.y * bitangent.z - tangent.z * bitangent.y,
+                tangent.z * bitangent.x - tangent.x * bitangent.z,
+                tangent.x * bitangent.y - tangent.y * bitangent.x));
+            *vertex++ = MakeVertex(XMFLOAT3(r * c, y, r * s), normal, tangent,
+                                   static_cast<float>(j) / sliceCount, 1.0f - static_cast<float>(i) / stackCount);
+        }
+    }
+
+    Index* index = out.Indices;
+    for (std::uint32_t i = 0; i < stackCount; ++i)
+    {
+        for (std::uint32_t j = 0; j < sliceCount; ++j)
+        {
+            std::uint32_t a = i * ringVertexCount + j;
+            index = WriteQuad(index, a + ringVertexCount, a + ringVertexCount + 1, a, a + 1);
+        }
+    }
+
+    // 上下底面各有自己的一圈顶点和中心点, 法线与侧面不同
+    for (int cap = 0; cap < 2; ++cap)
+    {
+        const bool top = cap == 0;
+        const float y = top ? 0.5f * height : -0.5f * height;
+        const float r = top ? topRadius : bottomRadius;
+        const std::uint32_t base = static_cast<std::uint32_t>(vertex - out.Vertices);
+        const XMFLOAT3 normal(0.0f, top ? 1.0f : -1.0f, 0.0f);
+
+        for (std::uint32_t j = 0; j <= sliceCount; ++j)
+        {
+            float x = r * std::cos(j * dTheta);
+            float z = r * std::sin(j * dTheta);
+            *vertex++ = MakeVertex(XMFLOAT3(x, y, z), normal, XMFLOAT3(1.0f, 0.0f, 0.0f),
+                                   x / height + 0.5f, z / height + 0.5f);
+        }
+        *vertex++ = MakeVertex(XMFLOAT3(0.0f, y, 0.0f), normal, XMFLOAT3(1.0f, 0.0f, 0.0f), 0.5f, 0.5f);
+
+        const std::uint32_t center = base + ringVertexCount;
+        for (std::uint32_t j = 0; j < sliceCount; ++j)
+        {
+            *index++ = static_cast<Index>(center);
+            *index++ = static_cast<Index>(top ? base + j + 1 : base + j);
+            *index++ = static_cast<Index>(top ? base + j : base + j + 1);
+        }
+    }
+    return size;
+}
+
+RainDX::GeometrySize RainDX::GeometryGenerator::GridSize(std::uint32_t rows, std::uint32_t columns)
+{
+    assert(rows >= 2 && columns >= 2);
+    GeometrySize size;
+    size.VertexCount = rows * columns;
+    size.IndexCount = (rows - 1) * (columns - 1) * 6;
+    return size;
+}
+
+template <typename Index>
+RainDX::GeometrySize RainDX::GeometryGenerator::Grid(float width, float depth, std::uint32_t rows,
+                                                     std::uint32_t columns, const GeometrySpans<Index>& out,
+                                                     JobSystem* jobs)
+{
+    const GeometrySize size = GridSize(rows, columns);
+    CheckCapacity(out, size);
+
+    // 每一行的顶点和索引位置都能直接算出, 行带之间互不依赖
+    const std::size_t bandRows = (std::max)(GridVerticesPerJob / columns, std::size_t(1));
+    if (jobs == nullptr || bandRows >= rows)
+    {
+        WriteGridRows(width, depth, rows, columns, 0, rows, out);
+        return size;
+    }
+
+    jobs->ParallelFor(0, rows, bandRows, [&](std::size_t first, std::size_t last)
+    {
+        WriteGridRows(width, depth, rows, columns,
+                      static_cast<std::uint32_t>(first), static_cast<std::uint32_t>(last), out);
+    });
+    return size;
+}
+
+RainDX::GeometrySize RainDX::GeometryGenerator::TorusSize(std::uint32_t ringSegments, std::uint32_t tubeSegments)
+{
+    assert(ringSegments >= 3 && tubeSegments >= 3);
+    GeometrySize size;
+    size.VertexCount = (ringSegments + 1) * (tubeSegments + 1);
+    size.IndexCount = ringSegments * tubeSegments * 6;
+    return size;
+}
+
+template <typename Index>
+RainDX::GeometrySize RainDX::GeometryGenerator::Torus(float majorRadius, float minorRadius,
+                                                      std::uint32_t ringSegments, std::uint32_t tubeSegments,
+                                                      const GeometrySpans<Index>& out)
+{
+    const GeometrySize size = TorusSize(ringSegments, tubeSegments);
+    CheckCapacity(out, size);
+
+    const std::uint32_t tubeVertexCount = tubeSegments + 1;
+
+    // 第 i 个截面在大圆的角度 u 处, 截面上的角度 v 从外侧赤道开始向上
+    GeometryVertex* vertex = out.Vertices;
+    for (std::uint32_t i = 0; i <= ringSegments; ++i)
+    {
+        float u = 2.0f * Pi * i / ringSegments;
+        float cu = std::cos(u);
+        float su = std::sin(u);
+        for (std::uint32_t j = 0; j <= tubeSegments; ++j)
+        {
+            float v = 2.0f * Pi * j / tubeSegments;
+            float cv = std::cos(v);
+            float sv = std::sin(v);
+            float r = majorRadius + minorRadius * cv;
+            *vertex++ = MakeVertex(XMFLOAT3(r * cu, minorRadius * sv, r * su), XMFLOAT3(cv * cu, sv, cv * su),
+                                   XMFLOAT3(-su, 0.0f, cu),
+                                   static_cast<float>(i) / ringSegments, static_cast<float>(j) / tubeSegments);
+        }
+    }
+
+    Index* index = out.Indices;
+    for (std::uint32_t i = 0; i < ringSegments; ++i)
+    {
+        for (std::uint32_t j = 0; j < tubeSegments; ++j)
+        {
+            std::uint32_t a = i * tubeVertexCount + j;
+            index = WriteQuad(index, a + 1, a + tubeVertexCount + 1, a, a + tubeVertexCount);
+        }
+    }
+    return size;
+}
+
+template RainDX::GeometrySpans<std::uint16_t> RainDX::GeometryGenerator::Allocate<std::uint16_t>(
+    LinearArena&, const GeometrySize&);
+template RainDX::GeometrySpans<std::uint32_t> RainDX::GeometryGenerator::Allocate<std::uint32_t>(
+    LinearArena&, const GeometrySize&);
+template RainDX::GeometrySize RainDX::GeometryGenerator::Box<std::uint16_t>(
+    float, float, float, std::uint32_t, const GeometrySpans<std::uint16_t>&);
+template RainDX::GeometrySize RainDX::GeometryGenerator::Box<std::uint32_t>(
+    float, float, float, std::uint32_t, const GeometrySpans<std::uint32_t>&);
+template RainDX::GeometrySize RainDX::GeometryGenerator::Sphere<std::uint16_t>(
+    float, std::uint32_t, std::uint32_t, const GeometrySpans<std::uint16_t>&);
+template RainDX::GeometrySize RainDX::GeometryGenerator::Sphere<std::uint32_t>(
+    float, std::uint32_t, std::uint32_t, const GeometrySpans<std::uint32_t>&);
+template RainDX::GeometrySize RainDX::GeometryGenerator::Geosphere<std::uint16_t>(
+    float, std::uint32_t, const GeometrySpans<std::uint16_t>&);
+template RainDX::GeometrySize RainDX::GeometryGenerator::Geosphere<std::uint32_t>(
+    float, std::uint32_t, const GeometrySpans<std::uint32_t>&);
+template RainDX::GeometrySize RainDX::GeometryGenerator::Cylinder<std::uint16_t>(
+    float, float, float, std::uint32_t, std::uint32_t, const GeometrySpans<std::uint16_t>&);
+template RainDX::GeometrySize RainDX::GeometryGenerator::Cylinder<std::uint32_t>(
+    float, float, float, std::uint32_t, std::uint32_t, const GeometrySpans<std::uint32_t>&);
+template RainDX::GeometrySize RainDX::GeometryGenerator::Grid<std::uint16_t>(
+    float, float, std::uint32_t, std::uint32_t, const GeometrySpans<std::uint16_t>&, JobSystem*);
+template RainDX::GeometrySize RainDX::GeometryGenerator::Grid<std::uint32_t>(
+    float, float, std::uint32_t, std::uint32_t, const GeometrySpans<std::uint32_t>&, JobSystem*);
+template RainDX::GeometrySize RainDX::GeometryGenerator::Torus<std::uint16_t>(
+    float, float, std::uint32_t, std::uint32_t, const GeometrySpans<std::uint16_t>&);
+template RainDX::GeometrySize RainDX::GeometryGenerator::Torus<std::uint32_t>(
+    float, float, std::uint32_t, std::uint32_t, const GeometrySpans<std::uint32_t>&);
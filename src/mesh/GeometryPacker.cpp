@@ -0,0 +1,181 @@
+#include "mesh/GeometryPacker.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <d3dcompiler.h>
+#include "d3d/DxException.h"
+
+RainDX::GeometryPacker::GeometryPacker(UINT vertexStride, std::uint64_t pageBytes) :
+    m_VertexStride(vertexStride), m_PageBytes(pageBytes)
+{
+    assert(vertexStride >= 12);
+}
+
+template <typename Index>
+void RainDX::GeometryPacker::Add(const std::string& name, const void* vertices, std::size_t vertexCount,
+                                 const Index* indices, std::size_t indexCount, const DirectX::BoundingBox* bounds)
+{
+    Mesh mesh;
+    mesh.Name = name;
+    mesh.FirstVertexByte = m_Vertices.size();
+    mesh.VertexCount = static_cast<std::uint32_t>(vertexCount);
+    mesh.FirstIndex = m_Indices.size();
+    mesh.IndexCount = static_cast<std::uint32_t>(indexCount);
+
+    const char* source = static_cast<const char*>(vertices);
+    m_Vertices.insert(m_Vertices.end(), source, source + vertexCount * m_VertexStride);
+    for (std::size_t i = 0; i < indexCount; ++i)
+    {
+        assert(indices[i] < vertexCount);
+        m_Indices.push_back(indices[i]);
+        mesh.MaxIndex = (std::max)(mesh.MaxIndex, static_cast<std::uint32_t>(indices[i]));
+    }
+
+    if (bounds != nullptr)
+    {
+        mesh.Bounds = *bounds;
+    }
+    else if (vertexCount > 0)
+    {
+        float lo[3];
+        float hi[3];
+        memcpy(lo, source, sizeof(lo));
+        memcpy(hi, source, sizeof(hi));
+        for (std::size_t v = 1; v < vertexCount; ++v)
+        {
+            float p[3];
+            memcpy(p, source + v * m_VertexStride, sizeof(p));
+            for (int k = 0; k < 3; ++k)
+            {
+                lo[k] = (std::min)(lo[k], p[k]);
+                hi[k] = (std::max)(hi[k], p[k]);
+            }
+        }
+        mesh.Bounds.Center = DirectX::XMFLOAT3(0.5f * (lo[0] + hi[0]), 0.5f * (lo[1] + hi[1]), 0.5f * (lo[2] + hi[2]));
+        mesh.Bounds.Extents = DirectX::XMFLOAT3(0.5f * (hi[0] - lo[0]), 0.5f * (hi[1] - lo[1]), 0.5f * (hi[2] - lo[2]));
+    }
+
+    m_Meshes.push_back(mesh);
+}
+
+std::vector<std::unique_ptr<MeshGeometry>> RainDX::GeometryPacker::Pack(const std::string& name)
+{
+    m_Stats = GeometryPackStats();
+    std::vector<std::unique_ptr<MeshGeometry>> pages;
+
+    // 按添加顺序装页, 单个网格超过上限时独占一页
+    std::size_t first = 0;
+    std::uint64_t pageBytes = 0;
+    for (std::size_t i = 0; i < m_Meshes.size(); ++i)
+    {
+        // 每个网格最多带来 2 字节的对齐
+        std::uint64_t meshBytes = static_cast<std::uint64_t>(m_Meshes[i].VertexCount) * m_VertexStride
+            + m_Meshes[i].IndexBytes() + 2;
+        if (i > first && pageBytes + meshBytes > m_PageBytes)
+        {
+            pages.push_back(BuildPage(name + std::to_string(pages.size()), first, i));
+            first = i;
+            pageBytes = 0;
+        }
+        pageBytes += meshBytes;
+    }
+    if (first < m_Meshes.size())
+        pages.push_back(BuildPage(name + std::to_string(pages.size()), first, m_Meshes.size()));
+
+    m_Stats.Pages = pages.size();
+    return pages;
+}
+
+void RainDX::GeometryPacker::Clear()
+{
+    m_Meshes.clear();
+    m_Vertices.clear();
+    m_Indices.clear();
+}
+
+std::size_t RainDX::GeometryPacker::MeshCount() const
+{
+    return m_Meshes.size();
+}
+
+const RainDX::GeometryPackStats& RainDX::GeometryPacker::Stats() const
+{
+    return m_Stats;
+}
+
+std::unique_ptr<MeshGeometry> RainDX::GeometryPacker::BuildPage(const std::string& name, std::size_t first, std::size_t last)
+{
+    // 16 位区域在前, 32 位区域从 4 字节边界开始, 总大小补齐到 4 字节
+    std::uint64_t vertexBytes = 0;
+    std::uint64_t narrowBytes = 0;
+    std::uint64_t wideBytes = 0;
+    for (std::size_t i = first; i < last; ++i)
+    {
+        const Mesh& mesh = m_Meshes[i];
+        vertexBytes += static_cast<std::uint64_t>(mesh.VertexCount) * m_VertexStride;
+        (mesh.Wide() ? wideBytes : narrowBytes) += mesh.IndexBytes();
+    }
+    const std::uint64_t wideOffset = (narrowBytes + 3) & ~std::uint64_t(3);
+    const std::uint64_t indexBytes = (std::max)((wideOffset + wideBytes + 3) & ~std::uint64_t(3), std::uint64_t(4));
+
+    auto geo = std::make_unique<MeshGeometry>();
+    geo->Name = name;
+    geo->VertexByteStride = m_VertexStride;
+    geo->VertexBufferByteSize = static_cast<UINT>(vertexBytes);
+    geo->IndexBufferByteSize = static_cast<UINT>(indexBytes);
+    geo->IndexFormat = narrowBytes != 0 || wideBytes == 0 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+
+    ThrowIfFailed(D3DCreateBlob(static_cast<SIZE_T>((std::max)(vertexBytes, std::uint64_t(1))), &geo->VertexBufferCPU))
+    ThrowIfFailed(D3DCreateBlob(static_cast<SIZE_T>(indexBytes), &geo->IndexBufferCPU))
+    char* vertices = static_cast<char*>(geo->VertexBufferCPU->GetBufferPointer());
+    char* indices = static_cast<char*>(geo->IndexBufferCPU->GetBufferPointer());
+    memset(indices, 0, static_cast<std::size_t>(indexBytes));
+
+    std::uint64_t vertexOffset = 0;
+    UINT narrowIndex = 0;
+    UINT wideIndex = static_cast<UINT>(wideOffset / 4);
+    for (std::size_t i = first; i < last; ++i)
+    {
+        const Mesh& mesh = m_Meshes[i];
+        const std::size_t meshVertexBytes = static_cast<std::size_t>(mesh.VertexCount) * m_VertexStride;
+        memcpy(vertices + vertexOffset * m_VertexStride, m_Vertices.data() + mesh.FirstVertexByte, meshVertexBytes);
+
+        SubmeshGeometry submesh;
+        submesh.IndexCount = mesh.IndexCount;
+        submesh.BaseVertexLocation = static_cast<INT>(vertexOffset);
+        submesh.Bounds = mesh.Bounds;
+
+        const std::uint32_t* source = m_Indices.data() + mesh.FirstIndex;
+        if (mesh.Wide())
+        {
+            submesh.IndexFormat = DXGI_FORMAT_R32_UINT;
+            submesh.StartIndexLocation = wideIndex;
+            memcpy(reinterpret_cast<std::uint32_t*>(indices) + wideIndex, source, mesh.IndexCount * sizeof(std::uint32_t));
+            wideIndex += mesh.IndexCount;
+            ++m_Stats.Submeshes32;
+        }
+        else
+        {
+            submesh.IndexFormat = DXGI_FORMAT_R16_UINT;
+            submesh.StartIndexLocation = narrowIndex;
+            std::uint16_t* target = reinterpret_cast<std::uint16_t*>(indices) + narrowIndex;
+            for (std::uint32_t k = 0; k < mesh.IndexCount; ++k)
+                target[k] = static_cast<std::uint16_t>(source[k]);
+            narrowIndex += mesh.IndexCount;
+            ++m_Stats.Submeshes16;
+        }
+
+        geo->DrawArgs[mesh.Name] = submesh;
+        vertexOffset += mesh.VertexCount;
+        m_Stats.IndexBytes32 += static_cast<std::uint64_t>(mesh.IndexCount) * 4;
+    }
+
+    m_Stats.VertexBytes += vertexBytes;
+    m_Stats.IndexBytes += indexBytes;
+    return geo;
+}
+
+template void RainDX::GeometryPacker::Add<std::uint16_t>(
+    const std::string&, const void*, std::size_t, const std::uint16_t*, std::size_t, const DirectX::BoundingBox*);
+template void RainDX::GeometryPacker::Add<std::uint32_t>(
+    const std::string&, const void*, std::size_t, const std::uint32_t*, std::size_t, const DirectX::BoundingBox*);
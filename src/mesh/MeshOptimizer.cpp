@@ -0,0 +1,513 @@
+#include "mesh/MeshOptimizer.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include "d3d/d3dUtil.h"
+
+namespace
+{
+    using RainDX::VertexCacheStats;
+
+    // FIFO 缓存用时间戳模拟: 顶点写入时记下时间, 之后写入的顶点不足 cacheSize 个则仍在缓存中
+    // 时间只在未命中时前进, 整体加上 cacheSize + 1 即清空缓存
+    struct FifoCache
+    {
+        FifoCache(std::size_t vertexCount, std::uint32_t cacheSize) :
+            Stamps(vertexCount, 0), Time(cacheSize + 1), Size(cacheSize)
+        {
+        }
+
+        bool Contains(std::uint32_t v) const { return Time - Stamps[v] <= Size; }
+        // 返回是否未命中
+        bool Touch(std::uint32_t v)
+        {
+            if (Contains(v))
+                return false;
+            Stamps[v] = Time++;
+            return true;
+        }
+        void Flush() { Time += Size + 1; }
+
+        std::vector<std::uint32_t> Stamps;
+        std::uint32_t Time;
+        std::uint32_t Size;
+    };
+
+    void Finish(VertexCacheStats& stats)
+    {
+        stats.Acmr = stats.Triangles != 0 ? static_cast<float>(stats.Misses) / stats.Triangles : 0.0f;
+        stats.Atvr = stats.Vertices != 0 ? static_cast<float>(stats.Misses) / stats.Vertices : 0.0f;
+    }
+
+    void Accumulate(VertexCacheStats& total, const VertexCacheStats& stats)
+    {
+        total.Triangles += stats.Triangles;
+        total.Vertices += stats.Vertices;
+        total.Misses += stats.Misses;
+        Finish(total);
+    }
+
+    struct Float3
+    {
+        float X, Y, Z;
+    };
+
+    Float3 LoadPosition(const float* positions, std::size_t stride, std::size_t v)
+    {
+        const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + v * stride);
+        return {p[0], p[1], p[2]};
+    }
+
+    // 排序用的簇
+    struct Cluster
+    {
+        std::uint32_t First = 0;
+        std::uint32_t Count = 0;
+        float Key = 0.0f;
+    };
+
+    template <typename Index>
+    RainDX::MeshOptimizeReport OptimizeRange(
+        void* vertices, std::size_t stride, std::size_t vertexCount,
+        Index* indices, std::size_t indexCount, std::uint32_t cacheSize, bool reorderVertices)
+    {
+        using RainDX::MeshOptimizer;
+
+        RainDX::MeshOptimizeReport report;
+        report.Before = MeshOptimizer::AnalyzeVertexCache(indices, indexCount, vertexCount, cacheSize);
+
+        std::vector<std::uint32_t> clusters;
+        MeshOptimizer::OptimizeVertexCache(indices, indexCount, vertexCount, cacheSize, &clusters);
+        MeshOptimizer::OptimizeOverdraw(indices, indexCount, static_cast<const float*>(vertices), stride,
+                                        vertexCount, clusters, cacheSize);
+        if (reorderVertices)
+            MeshOptimizer::OptimizeVertexFetch(vertices, stride, vertexCount, indices, indexCount);
+
+        report.After = MeshOptimizer::AnalyzeVertexCache(indices, indexCount, vertexCount, cacheSize);
+        return report;
+    }
+
+    template <typename Index>
+    std::size_t MaxIndex(const Index* indices, std::size_t count)
+    {
+        std::size_t maxIndex = 0;
+        for (std::size_t i = 0; i < count; ++i)
+            maxIndex = (std::max)(maxIndex, static_cast<std::size_t>(indices[i]));
+        return maxIndex;
+    }
+
+    void OptimizeSubmeshes(MeshGeometry& geo, const std::vector<const SubmeshGeometry*>& submeshes,
+                           std::uint32_t cacheSize, RainDX::MeshOptimizeReport& report)
+    {
+        char* vertices = static_cast<char*>(geo.VertexBufferCPU->GetBufferPointer());
+        char* indices = static_cast<char*>(geo.IndexBufferCPU->GetBufferPointer());
+        const std::size_t stride = geo.VertexByteStride;
+        const std::size_t vertexTotal = geo.VertexBufferByteSize / stride;
+
+        // 每个子网格占用的顶点区间 [Base, Base + 最大索引]
+        struct Range
+        {
+            std::size_t Begin;
+            std::size_t End;
+        };
+        std::vector<Range> ranges;
+        ranges.reserve(submeshes.size());
+        for (const SubmeshGeometry* submesh : submeshes)
+        {
+            const bool wide = geo.SubmeshIndexFormat(*submesh) == DXGI_FORMAT_R32_UINT;
+            const std::size_t elementSize = wide ? 4 : 2;
+            assert((submesh->StartIndexLocation + submesh->IndexCount) * elementSize <= geo.IndexBufferByteSize);
+            const char* first = indices + submesh->StartIndexLocation * elementSize;
+            std::size_t maxIndex = wide
+                ? MaxIndex(reinterpret_cast<const std::uint32_t*>(first), submesh->IndexCount)
+                : MaxIndex(reinterpret_cast<const std::uint16_t*>(first), submesh->IndexCount);
+            std::size_t begin = static_cast<std::size_t>(submesh->BaseVertexLocation);
+            ranges.push_back({begin, (std::min)(begin + maxIndex + 1, vertexTotal)});
+        }
+
+        // 子网格共享顶点时重排会互相破坏, 只重排三角形
+        std::vector<Range> sorted = ranges;
+        std::sort(sorted.begin(), sorted.end(), [](const Range& a, const Range& b) { return a.Begin < b.Begin; });
+        bool disjoint = true;
+        for (std::size_t i = 1; i < sorted.size(); ++i)
+            disjoint = disjoint && sorted[i].Begin >= sorted[i - 1].End;
+
+        for (std::size_t i = 0; i < submeshes.size(); ++i)
+        {
+            const SubmeshGeometry* submesh = submeshes[i];
+            char* submeshVertices = vertices + ranges[i].Begin * stride;
+            const std::size_t vertexCount = ranges[i].End - ranges[i].Begin;
+            RainDX::MeshOptimizeReport part;
+            if (geo.SubmeshIndexFormat(*submesh) == DXGI_FORMAT_R32_UINT)
+            {
+                part = OptimizeRange(submeshVertices, stride, vertexCount,
+                                     reinterpret_cast<std::uint32_t*>(indices) + submesh->StartIndexLocation,
+                                     submesh->IndexCount, cacheSize, disjoint);
+            }
+            else
+            {
+                part = OptimizeRange(submeshVertices, stride, vertexCount,
+                                     reinterpret_cast<std::uint16_t*>(indices) + submesh->StartIndexLocation,
+                                     submesh->IndexCount, cacheSize, disjoint);
+            }
+            Accumulate(report.Before, part.Before);
+            Accumulate(report.After, part.After);
+        }
+    }
+}
+
+template <typename Index>
+RainDX::VertexCacheStats RainDX::MeshOptimizer::AnalyzeVertexCache(
+    const Index* indices, std::size_t indexCount, std::size_t vertexCount, std::uint32_t cacheSize)
+{
+    VertexCacheStats stats;
+    stats.Triangles = indexCount / 3;
+
+    FifoCache cache(vertexCount, cacheSize);
+    std::vector<bool> used(vertexCount, false);
+    for (std::size_t i = 0; i < stats.Triangles * 3; ++i)
+    {
+        std::uint32_t v = indices[i];
+        assert(v < vertexCount);
+        if (cache.Touch(v))
+            ++stats.Misses;
+        if (!used[v])
+        {
+            used[v] = true;
+            ++stats.Vertices;
+        }
+    }
+
+    Finish(stats);
+    return stats;
+}
+
+template <typename Index>
+void RainDX::MeshOptimizer::OptimizeVertexCache(
+    Index* indices, std::size_t indexCount, std::size_t vertexCount,
+    std::uint32_t cacheSize, std::vector<std::uint32_t>* clusters)
+{
+    if (clusters != nullptr)
+        clusters->clear();
+
+    const std::size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
+
+    // 每个顶点引用的三角形, 按三角形顺序排列
+    std::vector<std::uint32_t> offsets(vertexCount + 1, 0);
+    for (std::size_t i = 0; i < triangleCount * 3; ++i)
+        ++offsets[indices[i] + 1];
+    for (std::size_t v = 0; v < vertexCount; ++v)
+        offsets[v + 1] += offsets[v];
+
+    std::vector<std::uint32_t> adjacency(triangleCount * 3);
+    {
+        std::vector<std::uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (std::size_t i = 0; i < triangleCount * 3; ++i)
+            adjacency[fill[indices[i]]++] = static_cast<std::uint32_t>(i / 3);
+    }
+
+    // 每个顶点还未输出的三角形数
+    std::vector<std::uint32_t> live(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+        live[v] = offsets[v + 1] - offsets[v];
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<Index> output(triangleCount * 3);
+    std::size_t outputTriangle = 0;
+
+    FifoCache cache(vertexCount, cacheSize);
+    std::vector<std::uint32_t> deadEnd;
+    std::vector<std::uint32_t> candidates;
+    std::size_t cursor = 0;
+
+    // 从第一个被引用的顶点开始
+    while (cursor < vertexCount && live[cursor] == 0)
+        ++cursor;
+    std::uint32_t fan = static_cast<std::uint32_t>(cursor);
+    if (clusters != nullptr)
+        clusters->push_back(0);
+
+    for (;;)
+    {
+        // 输出 fan 周围所有未输出的三角形
+        candidates.clear();
+        for (std::uint32_t a = offsets[fan]; a < offsets[fan + 1]; ++a)
+        {
+            std::uint32_t t = adjacency[a];
+            if (emitted[t])
+                continue;
+            emitted[t] = true;
+
+            for (int k = 0; k < 3; ++k)
+            {
+                Index v = indices[t * 3 + k];
+                output[outputTriangle * 3 + k] = v;
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                cache.Touch(v);
+            }
+            ++outputTriangle;
+        }
+
+        if (outputTriangle == triangleCount)
+            break;
+
+        // 下一个扇心: 变换完剩余三角形后仍留在缓存中的顶点里最老的一个
+        std::int64_t bestPriority = -1;
+        std::uint32_t next = UINT32_MAX;
+        for (std::uint32_t v : candidates)
+        {
+            if (live[v] == 0)
+                continue;
+            std::int64_t age = cache.Time - cache.Stamps[v];
+            std::int64_t priority = age + 2 * live[v] <= cacheSize ? age : 0;
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                next = v;
+            }
+        }
+
+        if (next == UINT32_MAX)
+        {
+            // 死路: 先回到最近用过的顶点, 再按顺序找下一个还有三角形的顶点
+            while (!deadEnd.empty())
+            {
+                std::uint32_t v = deadEnd.back();
+                deadEnd.pop_back();
+                if (live[v] != 0)
+                {
+                    next = v;
+                    break;
+                }
+            }
+            if (next == UINT32_MAX)
+            {
+                while (cursor < vertexCount && live[cursor] == 0)
+                    ++cursor;
+                assert(cursor < vertexCount);
+                next = static_cast<std::uint32_t>(cursor);
+            }
+
+            if (clusters != nullptr)
+                clusters->push_back(static_cast<std::uint32_t>(outputTriangle));
+        }
+
+        fan = next;
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+template <typename Index>
+void RainDX::MeshOptimizer::OptimizeOverdraw(
+    Index* indices, std::size_t indexCount,
+    const float* positions, std::size_t stride, std::size_t vertexCount,
+    const std::vector<std::uint32_t>& clusters,
+    std::uint32_t cacheSize, float threshold)
+{
+    const std::uint32_t triangleCount = static_cast<std::uint32_t>(indexCount / 3);
+    if (triangleCount == 0)
+        return;
+
+    // 在硬簇内部切出软簇: 前缀的 ACMR 已经接近整簇时断开, 簇越小排序越有效, 缓存命中率几乎不变
+    std::vector<Cluster> soft;
+    FifoCache cache(vertexCount, cacheSize);
+    auto misses = [&](std::uint32_t t) {
+        int count = 0;
+        for (int k = 0; k < 3; ++k)
+            count += cache.Touch(indices[t * 3 + k]) ? 1 : 0;
+        return count;
+    };
+
+    const std::size_t hardCount = clusters.empty() ? 1 : clusters.size();
+    for (std::size_t c = 0; c < hardCount; ++c)
+    {
+        std::uint32_t begin = clusters.empty() ? 0 : clusters[c];
+        std::uint32_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+        if (begin >= end)
+            continue;
+
+        cache.Flush();
+        std::uint32_t clusterMisses = 0;
+        for (std::uint32_t t = begin; t < end; ++t)
+            clusterMisses += misses(t);
+        const float limit = threshold * clusterMisses / (end - begin);
+
+        cache.Flush();
+        std::uint32_t first = begin;
+        std::uint32_t running = 0;
+        for (std::uint32_t t = begin; t < end; ++t)
+        {
+            running += misses(t);
+            if (t + 1 < end && running <= limit * (t + 1 - first))
+            {
+                soft.push_back({first, t + 1 - first, 0.0f});
+                first = t + 1;
+                running = 0;
+                cache.Flush();
+            }
+        }
+        soft.push_back({first, end - first, 0.0f});
+    }
+
+    // 面积加权的簇中心和平均法线, 法线沿绕序方向指向网格外侧
+    std::vector<Float3> centers(soft.size());
+    std::vector<Float3> normals(soft.size());
+    Float3 meshCenter = {0.0f, 0.0f, 0.0f};
+    float meshArea = 0.0f;
+    for (std::size_t c = 0; c < soft.size(); ++c)
+    {
+        Float3 center = {0.0f, 0.0f, 0.0f};
+        Float3 normal = {0.0f, 0.0f, 0.0f};
+        float area = 0.0f;
+        for (std::uint32_t t = soft[c].First; t < soft[c].First + soft[c].Count; ++t)
+        {
+            Float3 p0 = LoadPosition(positions, stride, indices[t * 3 + 0]);
+            Float3 p1 = LoadPosition(positions, stride, indices[t * 3 + 1]);
+            Float3 p2 = LoadPosition(positions, stride, indices[t * 3 + 2]);
+
+            Float3 e1 = {p1.X - p0.X, p1.Y - p0.Y, p1.Z - p0.Z};
+            Float3 e2 = {p2.X - p0.X, p2.Y - p0.Y, p2.Z - p0.Z};
+            Float3 n = {e1.Y * e2.Z - e1.Z * e2.Y, e1.Z * e2.X - e1.X * e2.Z, e1.X * e2.Y - e1.Y * e2.X};
+            float a = std::sqrt(n.X * n.X + n.Y * n.Y + n.Z * n.Z);
+
+            center.X += (p0.X + p1.X + p2.X) * a / 3.0f;
+            center.Y += (p0.Y + p1.Y + p2.Y) * a / 3.0f;
+            center.Z += (p0.Z + p1.Z + p2.Z) * a / 3.0f;
+            normal.X += n.X;
+            normal.Y += n.Y;
+            normal.Z += n.Z;
+            area += a;
+        }
+
+        meshCenter.X += center.X;
+        meshCenter.Y += center.Y;
+        meshCenter.Z += center.Z;
+        meshArea += area;
+
+        if (area > 0.0f)
+            center = {center.X / area, center.Y / area, center.Z / area};
+        centers[c] = center;
+
+        float length = std::sqrt(normal.X * normal.X + normal.Y * normal.Y + normal.Z * normal.Z);
+        normals[c] = length > 0.0f ? Float3{normal.X / length, normal.Y / length, normal.Z / length}
+                                   : Float3{0.0f, 0.0f, 0.0f};
+    }
+    if (meshArea > 0.0f)
+        meshCenter = {meshCenter.X / meshArea, meshCenter.Y / meshArea, meshCenter.Z / meshArea};
+
+    // 越朝外的簇越可能遮挡其他簇, 先画
+    for (std::size_t c = 0; c < soft.size(); ++c)
+    {
+        soft[c].Key = (centers[c].X - meshCenter.X) * normals[c].X
+            + (centers[c].Y - meshCenter.Y) * normals[c].Y
+            + (centers[c].Z - meshCenter.Z) * normals[c].Z;
+    }
+    std::stable_sort(soft.begin(), soft.end(), [](const Cluster& a, const Cluster& b) { return a.Key > b.Key; });
+
+    std::vector<Index> output(static_cast<std::size_t>(triangleCount) * 3);
+    std::size_t written = 0;
+    for (const Cluster& cluster : soft)
+    {
+        const Index* first = indices + static_cast<std::size_t>(cluster.First) * 3;
+        std::copy(first, first + static_cast<std::size_t>(cluster.Count) * 3, output.begin() + written);
+        written += static_cast<std::size_t>(cluster.Count) * 3;
+    }
+    std::copy(output.begin(), output.end(), indices);
+}
+
+template <typename Index>
+std::size_t RainDX::MeshOptimizer::OptimizeVertexFetch(
+    void* vertices, std::size_t stride, std::size_t vertexCount,
+    Index* indices, std::size_t indexCount)
+{
+    constexpr std::uint32_t Unused = UINT32_MAX;
+    std::vector<std::uint32_t> remap(vertexCount, Unused);
+
+    std::uint32_t next = 0;
+    for (std::size_t i = 0; i < indexCount; ++i)
+    {
+        std::uint32_t& slot = remap[indices[i]];
+        if (slot == Unused)
+            slot = next++;
+        indices[i] = static_cast<Index>(slot);
+    }
+
+    const std::size_t used = next;
+    for (std::uint32_t& slot : remap)
+    {
+        if (slot == Unused)
+            slot = next++;
+    }
+
+    std::vector<char> reordered(vertexCount * stride);
+    const char* source = static_cast<const char*>(vertices);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+        memcpy(reordered.data() + remap[v] * stride, source + v * stride, stride);
+    memcpy(vertices, reordered.data(), reordered.size());
+
+    return used;
+}
+
+template <typename Index>
+RainDX::MeshOptimizeReport RainDX::MeshOptimizer::Optimize(
+    void* vertices, std::size_t stride, std::size_t vertexCount,
+    Index* indices, std::size_t indexCount, std::uint32_t cacheSize)
+{
+    return OptimizeRange(vertices, stride, vertexCount, indices, indexCount, cacheSize, true);
+}
+
+RainDX::MeshOptimizeReport RainDX::MeshOptimizer::Optimize(MeshGeometry& geo, std::uint32_t cacheSize)
+{
+    MeshOptimizeReport report;
+    if (geo.VertexBufferCPU == nullptr || geo.IndexBufferCPU == nullptr || geo.VertexByteStride == 0)
+        return report;
+
+    // 按索引位置处理, 结果与哈希表的遍历顺序无关; 共用同一段索引的子网格只处理一次
+    std::vector<const SubmeshGeometry*> submeshes;
+    for (const auto& arg : geo.DrawArgs)
+        submeshes.push_back(&arg.second);
+    // 16 位和 32 位子网格的 StartIndexLocation 单位不同, 格式也作为键的一部分
+    std::sort(submeshes.begin(), submeshes.end(), [&geo](const SubmeshGeometry* a, const SubmeshGeometry* b) {
+        if (geo.SubmeshIndexFormat(*a) != geo.SubmeshIndexFormat(*b))
+            return geo.SubmeshIndexFormat(*a) < geo.SubmeshIndexFormat(*b);
+        if (a->StartIndexLocation != b->StartIndexLocation)
+            return a->StartIndexLocation < b->StartIndexLocation;
+        return a->IndexCount < b->IndexCount;
+    });
+    submeshes.erase(std::unique(submeshes.begin(), submeshes.end(), [&geo](const SubmeshGeometry* a, const SubmeshGeometry* b) {
+        return geo.SubmeshIndexFormat(*a) == geo.SubmeshIndexFormat(*b)
+            && a->StartIndexLocation == b->StartIndexLocation && a->IndexCount == b->IndexCount;
+    }), submeshes.end());
+
+    OptimizeSubmeshes(geo, submeshes, cacheSize, report);
+    return report;
+}
+
+template RainDX::VertexCacheStats RainDX::MeshOptimizer::AnalyzeVertexCache<std::uint16_t>(
+    const std::uint16_t*, std::size_t, std::size_t, std::uint32_t);
+template RainDX::VertexCacheStats RainDX::MeshOptimizer::AnalyzeVertexCache<std::uint32_t>(
+    const std::uint32_t*, std::size_t, std::size_t, std::uint32_t);
+template void RainDX::MeshOptimizer::OptimizeVertexCache<std::uint16_t>(
+    std::uint16_t*, std::size_t, std::size_t, std::uint32_t, std::vector<std::uint32_t>*);
+template void RainDX::MeshOptimizer::OptimizeVertexCache<std::uint32_t>(
+    std::uint32_t*, std::size_t, std::size_t, std::uint32_t, std::vector<std::uint32_t>*);
+template void RainDX::MeshOptimizer::OptimizeOverdraw<std::uint16_t>(
+    std::uint16_t*, std::size_t, const float*, std::size_t, std::size_t,
+    const std::vector<std::uint32_t>&, std::uint32_t, float);
+template void RainDX::MeshOptimizer::OptimizeOverdraw<std::uint32_t>(
+    std::uint32_t*, std::size_t, const float*, std::size_t, std::size_t,
+    const std::vector<std::uint32_t>&, std::uint32_t, float);
+template std::size_t RainDX::MeshOptimizer::OptimizeVertexFetch<std::uint16_t>(
+    void*, std::size_t, std::size_t, std::uint16_t*, std::size_t);
+template std::size_t RainDX::MeshOptimizer::OptimizeVertexFetch<std::uint32_t>(
+    void*, std::size_t, std::size_t, std::uint32_t*, std::size_t);
+template RainDX::MeshOptimizeReport RainDX::MeshOptimizer::Optimize<std::uint16_t>(
+    void*, std::size_t, std::size_t, std::uint16_t*, std::size_t, std::uint32_t);
+template RainDX::MeshOptimizeReport RainDX::MeshOptimizer::Optimize<std::uint32_t>(
+    void*, std::size_t, std::size_t, std::uint32_t*, std::size_t, std::uint32_t);
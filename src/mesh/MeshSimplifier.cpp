@@ -0,0 +1,498 @@
+#include "mesh/MeshSimplifier.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <d3dcompiler.h>
+#include "d3d/d3dUtil.h"
+#include "d3d/DxException.h"
+#include "mesh/MeshOptimizer.h"
+
+namespace
+{
+    // 边界约束平面的权重, 乘以边长的平方, 使边界比内部更难移动
+    static constexpr double BorderWeight = 10.0;
+    // 合并后三角形法线与原法线夹角余弦的下限, 超过这个转角视为翻面
+    static constexpr double MinNormalCosine = 0.25;
+    // 合并后三角形面积与原面积之比的下限, 压成一条线的三角形没有意义
+    static constexpr double MinAreaRatio = 1e-3;
+
+    struct Vec3
+    {
+        double X = 0.0;
+        double Y = 0.0;
+        double Z = 0.0;
+    };
+
+    Vec3 Sub(const Vec3& a, const Vec3& b)
+    {
+        return {a.X - b.X, a.Y - b.Y, a.Z - b.Z};
+    }
+
+    Vec3 Cross(const Vec3& a, const Vec3& b)
+    {
+        return {a.Y * b.Z - a.Z * b.Y, a.Z * b.X - a.X * b.Z, a.X * b.Y - a.Y * b.X};
+    }
+
+    double Dot(const Vec3& a, const Vec3& b)
+    {
+        return a.X * b.X + a.Y * b.Y + a.Z * b.Z;
+    }
+
+    double Length(const Vec3& a)
+    {
+        return std::sqrt(Dot(a, a));
+    }
+
+    // 对称矩阵形式的平面距离平方和, Weight 为所有平面的权重之和
+    struct Quadric
+    {
+        double A00 = 0.0, A11 = 0.0, A22 = 0.0, A01 = 0.0, A02 = 0.0, A12 = 0.0;
+        double B0 = 0.0, B1 = 0.0, B2 = 0.0;
+        double C = 0.0;
+        double Weight = 0.0;
+
+        // 平面 n.p + d = 0, n 为单位向量
+        static Quadric Plane(const Vec3& n, double d, double weight)
+        {
+            Quadric q;
+            q.A00 = n.X * n.X * weight;
+            q.A11 = n.Y * n.Y * weight;
+            q.A22 = n.Z * n.Z * weight;
+            q.A01 = n.X * n.Y * weight;
+            q.A02 = n.X * n.Z * weight;
+            q.A12 = n.Y * n.Z * weight;
+            q.B0 = n.X * d * weight;
+            q.B1 = n.Y * d * weight;
+            q.B2 = n.Z * d * weight;
+            q.C = d * d * weight;
+            q.Weight = weight;
+            return q;
+        }
+
+        Quadric& operator+=(const Quadric& rhs)
+        {
+            A00 += rhs.A00;
+            A11 += rhs.A11;
+            A22 += rhs.A22;
+            A01 += rhs.A01;
+            A02 += rhs.A02;
+            A12 += rhs.A12;
+            B0 += rhs.B0;
+            B1 += rhs.B1;
+            B2 += rhs.B2;
+            C += rhs.C;
+            Weight += rhs.Weight;
+            return *this;
+        }
+
+        // 到各平面距离平方的加权平均
+        double Evaluate(const Vec3& p) const
+        {
+            double r = A00 * p.X * p.X + A11 * p.Y * p.Y + A22 * p.Z * p.Z
+                + 2.0 * (A01 * p.X * p.Y + A02 * p.X * p.Z + A12 * p.Y * p.Z)
+                + 2.0 * (B0 * p.X + B1 * p.Y + B2 * p.Z) + C;
+            return Weight > 0.0 ? std::fabs(r) / Weight : 0.0;
+        }
+    };
+
+    enum class VertexKind : std::uint8_t
+    {
+        Manifold,
+        Border,
+        // 与其他顶点位置相同, 合并会撕开接缝
+        Locked,
+    };
+
+    struct Collapse
+    {
+        std::uint32_t From = 0;
+        std::uint32_t To = 0;
+        double Cost = 0.0;
+    };
+
+    std::uint64_t EdgeKey(std::uint32_t a, std::uint32_t b)
+    {
+        return (static_cast<std::uint64_t>(a) << 32) | b;
+    }
+
+    // 只有一个三角形使用的边, 反向的有向边不存在
+    bool IsBorderEdge(const std::vector<std::uint64_t>& edges, std::uint32_t a, std::uint32_t b)
+    {
+        return !std::binary_search(edges.begin(), edges.end(), EdgeKey(b, a))
+            || !std::binary_search(edges.begin(), edges.end(), EdgeKey(a, b));
+    }
+
+    template <typename Index>
+    void CollectEdges(const Index* indices, std::size_t indexCount, std::vector<std::uint64_t>& edges)
+    {
+        edges.clear();
+        for (std::size_t t = 0; t < indexCount; t += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+                edges.push_back(EdgeKey(indices[t + k], indices[t + (k + 1) % 3]));
+        }
+        std::sort(edges.begin(), edges.end());
+    }
+
+    template <typename Index>
+    void AppendLods(MeshGeometry& geo, const std::string& name, std::size_t maxLods, float maxRelativeError,
+                    std::vector<char>& appended, RainDX::MeshLodMap& result)
+    {
+        const SubmeshGeometry submesh = geo.DrawArgs.at(name);
+        const DXGI_FORMAT format = geo.SubmeshIndexFormat(submesh);
+        const Index* indices = static_cast<const Index*>(geo.IndexBufferCPU->GetBufferPointer())
+            + submesh.StartIndexLocation;
+        const std::size_t indexCount = submesh.IndexCount;
+        const char* vertices = static_cast<const char*>(geo.VertexBufferCPU->GetBufferPointer())
+            + static_cast<std::size_t>(submesh.BaseVertexLocation) * geo.VertexByteStride;
+
+        std::size_t vertexCount = 0;
+        for (std::size_t i = 0; i < indexCount; ++i)
+            vertexCount = (std::max)(vertexCount, static_cast<std::size_t>(indices[i]) + 1);
+
+        const DirectX::XMFLOAT3& e = submesh.Bounds.Extents;
+        const float maxError = maxRelativeError * std::sqrt(e.x * e.x + e.y * e.y + e.z * e.z);
+
+        std::vector<RainDX::MeshLod> lods;
+        lods.push_back({name, 0.0f});
+
+        // 每一级都从原网格简化, 误差相对原网格计算
+        std::vector<Index> lod(indexCount);
+        std::size_t previousCount = indexCount;
+        float target = static_cast<float>(indexCount);
+        for (std::size_t level = 1; level < maxLods; ++level)
+        {
+            target *= RainDX::MeshSimplifier::LodReduction;
+            float error = 0.0f;
+            std::size_t lodCount = RainDX::MeshSimplifier::Simplify(
+                lod.data(), indices, indexCount, reinterpret_cast<const float*>(vertices), geo.VertexByteStride,
+                vertexCount, static_cast<std::size_t>(target) / 3 * 3, maxError, &error);
+            if (lodCount == 0 || lodCount > previousCount * RainDX::MeshSimplifier::MinLodReduction)
+                break;
+            RainDX::MeshOptimizer::OptimizeVertexCache(lod.data(), lodCount, vertexCount);
+
+            // 起点按索引大小对齐, 以便用同一格式的视图寻址
+            std::size_t offset = geo.IndexBufferByteSize + appended.size();
+            std::size_t aligned = (offset + sizeof(Index) - 1) / sizeof(Index) * sizeof(Index);
+            appended.resize(appended.size() + (aligned - offset) + lodCount * sizeof(Index));
+            memcpy(appended.data() + (aligned - geo.IndexBufferByteSize), lod.data(), lodCount * sizeof(Index));
+
+            SubmeshGeometry lodSubmesh = submesh;
+            lodSubmesh.IndexCount = static_cast<UINT>(lodCount);
+            lodSubmesh.StartIndexLocation = static_cast<UINT>(aligned / sizeof(Index));
+            lodSubmesh.IndexFormat = format;
+
+            std::string lodName = name + "_lod" + std::to_string(level);
+            geo.DrawArgs[lodName] = lodSubmesh;
+            lods.push_back({lodName, error});
+            previousCount = lodCount;
+        }
+
+        result[name] = std::move(lods);
+    }
+}
+
+template <typename Index>
+std::size_t RainDX::MeshSimplifier::Simplify(
+    Index* destination, const Index* indices, std::size_t indexCount,
+    const float* positions, std::size_t stride, std::size_t vertexCount,
+    std::size_t targetIndexCount, float maxError, float* error)
+{
+    assert(indexCount % 3 == 0);
+    std::copy(indices, indices + indexCount, destination);
+    if (error != nullptr)
+        *error = 0.0f;
+
+    const char* base = reinterpret_cast<const char*>(positions);
+    std::vector<Vec3> points(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+    {
+        const float* p = reinterpret_cast<const float*>(base + v * stride);
+        points[v] = {p[0], p[1], p[2]};
+    }
+
+    // 位置相同的顶点属于接缝, 全部锁定
+    std::vector<VertexKind> kinds(vertexCount, VertexKind::Manifold);
+    {
+        std::vector<std::uint32_t> order(vertexCount);
+        for (std::size_t v = 0; v < vertexCount; ++v)
+            order[v] = static_cast<std::uint32_t>(v);
+        auto less = [&points](std::uint32_t a, std::uint32_t b)
+        {
+            const Vec3& p = points[a];
+            const Vec3& q = points[b];
+            if (p.X != q.X)
+                return p.X < q.X;
+            if (p.Y != q.Y)
+                return p.Y < q.Y;
+            return p.Z < q.Z;
+        };
+        std::sort(order.begin(), order.end(), less);
+        for (std::size_t i = 1; i < vertexCount; ++i)
+        {
+            if (!less(order[i - 1], order[i]))
+            {
+                kinds[order[i - 1]] = VertexKind::Locked;
+                kinds[order[i]] = VertexKind::Locked;
+            }
+        }
+    }
+
+    // 每个顶点的误差: 相邻三角形平面按面积加权, 边界边加上垂直于三角形的约束平面
+    std::vector<std::uint64_t> edges;
+    CollectEdges(destination, indexCount, edges);
+    std::vector<Quadric> quadrics(vertexCount);
+    for (std::size_t t = 0; t < indexCount; t += 3)
+    {
+        const std::uint32_t tri[3] = {destination[t], destination[t + 1], destination[t + 2]};
+        Vec3 normal = Cross(Sub(points[tri[1]], points[tri[0]]), Sub(points[tri[2]], points[tri[0]]));
+        double area = Length(normal);
+        if (area == 0.0)
+            continue;
+        normal = {normal.X / area, normal.Y / area, normal.Z / area};
+
+        Quadric plane = Quadric::Plane(normal, -Dot(normal, points[tri[0]]), 0.5 * area);
+        for (std::uint32_t v : tri)
+            quadrics[v] += plane;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            std::uint32_t a = tri[k];
+            std::uint32_t b = tri[(k + 1) % 3];
+            if (std::binary_search(edges.begin(), edges.end(), EdgeKey(b, a)))
+                continue;
+            Vec3 edge = Sub(points[b], points[a]);
+            double length = Length(edge);
+            if (length == 0.0)
+                continue;
+            Vec3 side = Cross(edge, normal);
+            double sideLength = Length(side);
+            side = {side.X / sideLength, side.Y / sideLength, side.Z / sideLength};
+            Quadric border = Quadric::Plane(side, -Dot(side, points[a]), BorderWeight * length * length);
+            quadrics[a] += border;
+            quadrics[b] += border;
+        }
+    }
+
+    const double maxCost = static_cast<double>(maxError) * maxError;
+    double resultCost = 0.0;
+    std::size_t count = indexCount;
+
+    std::vector<std::uint8_t> border(vertexCount);
+    std::vector<std::uint8_t> touched(vertexCount);
+    std::vector<std::uint32_t> remap(vertexCount);
+    std::vector<std::uint32_t> adjacencyOffsets(vertexCount + 1);
+    std::vector<std::uint32_t> adjacency;
+    std::vector<Collapse> best(vertexCount);
+    std::vector<Collapse> collapses;
+
+    // 每一轮每个顶点最多参与一次合并, 合并过的顶点周围的三角形在本轮不再变化
+    while (count > targetIndexCount)
+    {
+        CollectEdges(destination, count, edges);
+        std::fill(border.begin(), border.end(), std::uint8_t(0));
+        for (std::uint64_t key : edges)
+        {
+            std::uint32_t a = static_cast<std::uint32_t>(key >> 32);
+            std::uint32_t b = static_cast<std::uint32_t>(key);
+            if (!std::binary_search(edges.begin(), edges.end(), EdgeKey(b, a)))
+            {
+                border[a] = 1;
+                border[b] = 1;
+            }
+        }
+
+        // 顶点到三角形的邻接表
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0u);
+        for (std::size_t i = 0; i < count; ++i)
+            ++adjacencyOffsets[destination[i] + 1];
+        for (std::size_t v = 0; v < vertexCount; ++v)
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        adjacency.resize(count);
+        {
+            std::vector<std::uint32_t> cursor(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (std::size_t i = 0; i < count; ++i)
+                adjacency[cursor[destination[i]]++] = static_cast<std::uint32_t>(i / 3);
+        }
+
+        // 每个顶点代价最小的合并方向
+        for (std::size_t v = 0; v < vertexCount; ++v)
+            best[v] = {static_cast<std::uint32_t>(v), static_cast<std::uint32_t>(v),
+                       std::numeric_limits<double>::infinity()};
+        for (std::size_t t = 0; t < count; t += 3)
+        {
+            for (int k = 0; k < 6; ++k)
+            {
+                std::uint32_t from = destination[t + k % 3];
+                std::uint32_t to = destination[t + (k + 1 + k / 3) % 3];
+                if (from == to || kinds[from] == VertexKind::Locked)
+                    continue;
+                if (border[from] && (!border[to] || !IsBorderEdge(edges, from, to)))
+                    continue;
+
+                Quadric q = quadrics[from];
+                q += quadrics[to];
+                double cost = q.Evaluate(points[to]);
+                if (cost < best[from].Cost || (cost == best[from].Cost && to < best[from].To))
+                    best[from] = {from, to, cost};
+            }
+        }
+
+        collapses.clear();
+        for (std::size_t v = 0; v < vertexCount; ++v)
+        {
+            if (best[v].Cost <= maxCost)
+                collapses.push_back(best[v]);
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+        {
+            return a.Cost < b.Cost || (a.Cost == b.Cost && a.From < b.From);
+        });
+
+        for (std::size_t v = 0; v < vertexCount; ++v)
+            remap[v] = static_cast<std::uint32_t>(v);
+        std::fill(touched.begin(), touched.end(), std::uint8_t(0));
+
+        std::size_t triangles = count / 3;
+        const std::size_t targetTriangles = targetIndexCount / 3;
+        std::size_t applied = 0;
+        for (const Collapse& collapse : collapses)
+        {
+            if (triangles <= targetTriangles)
+                break;
+            if (touched[collapse.From] || touched[collapse.To])
+                continue;
+
+            // 不含目标顶点的三角形移动后不能翻面, 不能转过太大角度, 也不能退化
+            bool flipped = false;
+            std::size_t removed = 0;
+            for (std::uint32_t a = adjacencyOffsets[collapse.From]; a < adjacencyOffsets[collapse.From + 1]; ++a)
+            {
+                const Index* tri = destination + adjacency[a] * 3;
+                if (tri[0] == collapse.To || tri[1] == collapse.To || tri[2] == collapse.To)
+                {
+                    ++removed;
+                    continue;
+                }
+
+                Vec3 p[3];
+                Vec3 q[3];
+                for (int k = 0; k < 3; ++k)
+                {
+                    p[k] = points[tri[k]];
+                    q[k] = tri[k] == collapse.From ? points[collapse.To] : p[k];
+                }
+                Vec3 before = Cross(Sub(p[1], p[0]), Sub(p[2], p[0]));
+                Vec3 after = Cross(Sub(q[1], q[0]), Sub(q[2], q[0]));
+                double beforeLength = Length(before);
+                double afterLength = Length(after);
+                if (afterLength <= MinAreaRatio * beforeLength
+                    || Dot(before, after) < MinNormalCosine * beforeLength * afterLength)
+                {
+                    flipped = true;
+                    break;
+                }
+            }
+            if (flipped)
+                continue;
+
+            remap[collapse.From] = collapse.To;
+            quadrics[collapse.To] += quadrics[collapse.From];
+            resultCost = (std::max)(resultCost, collapse.Cost);
+            triangles -= (std::min)(removed, triangles);
+            ++applied;
+
+            touched[collapse.From] = 1;
+            touched[collapse.To] = 1;
+            for (std::uint32_t a = adjacencyOffsets[collapse.From]; a < adjacencyOffsets[collapse.From + 1]; ++a)
+            {
+                const Index* tri = destination + adjacency[a] * 3;
+                touched[tri[0]] = 1;
+                touched[tri[1]] = 1;
+                touched[tri[2]] = 1;
+            }
+        }
+
+        if (applied == 0)
+            break;
+
+        // 改写索引并去掉退化的三角形
+        std::size_t write = 0;
+        for (std::size_t t = 0; t < count; t += 3)
+        {
+            std::uint32_t a = remap[destination[t]];
+            std::uint32_t b = remap[destination[t + 1]];
+            std::uint32_t c = remap[destination[t + 2]];
+            if (a == b || b == c || c == a)
+                continue;
+            destination[write++] = static_cast<Index>(a);
+            destination[write++] = static_cast<Index>(b);
+            destination[write++] = static_cast<Index>(c);
+        }
+        count = write;
+    }
+
+    if (error != nullptr)
+        *error = static_cast<float>(std::sqrt(resultCost));
+    return count;
+}
+
+RainDX::MeshLodMap RainDX::MeshSimplifier::BuildLods(MeshGeometry& geo, std::size_t maxLods, float maxRelativeError)
+{
+    assert(geo.VertexBufferCPU != nullptr && geo.IndexBufferCPU != nullptr);
+
+    // 按名字排序, 结果与哈希表的遍历顺序无关
+    std::vector<std::string> names;
+    for (const auto& entry : geo.DrawArgs)
+        names.push_back(entry.first);
+    std::sort(names.begin(), names.end());
+
+    MeshLodMap result;
+    std::vector<char> appended;
+    for (const std::string& name : names)
+    {
+        if (geo.SubmeshIndexFormat(geo.DrawArgs.at(name)) == DXGI_FORMAT_R32_UINT)
+            AppendLods<std::uint32_t>(geo, name, maxLods, maxRelativeError, appended, result);
+        else
+            AppendLods<std::uint16_t>(geo, name, maxLods, maxRelativeError, appended, result);
+    }
+    if (appended.empty())
+        return result;
+
+    // 新的索引缓冲区: 原有数据加上追加的 LOD, 末尾对齐到 4 字节
+    const UINT byteSize = static_cast<UINT>((geo.IndexBufferByteSize + appended.size() + 3) & ~std::size_t(3));
+    Microsoft::WRL::ComPtr<ID3DBlob> blob;
+    ThrowIfFailed(D3DCreateBlob(byteSize, &blob))
+    char* dst = static_cast<char*>(blob->GetBufferPointer());
+    memset(dst, 0, byteSize);
+    memcpy(dst, geo.IndexBufferCPU->GetBufferPointer(), geo.IndexBufferByteSize);
+    memcpy(dst + geo.IndexBufferByteSize, appended.data(), appended.size());
+
+    geo.IndexBufferCPU = blob;
+    geo.IndexBufferByteSize = byteSize;
+    return result;
+}
+
+std::size_t RainDX::MeshSimplifier::SelectLod(const MeshLod* lods, std::size_t count, float scale, float distance,
+                                              float pixelsPerUnit, float threshold)
+{
+    // 误差随级数递增, 找到第一个超过阈值的级别为止
+    const float perUnit = scale * pixelsPerUnit / (std::max)(distance, 1e-4f);
+    std::size_t selected = 0;
+    for (std::size_t i = 1; i < count; ++i)
+    {
+        if (lods[i].Error * perUnit > threshold)
+            break;
+        selected = i;
+    }
+    return selected;
+}
+
+template std::size_t RainDX::MeshSimplifier::Simplify<std::uint16_t>(
+    std::uint16_t*, const std::uint16_t*, std::size_t, const float*, std::size_t, std::size_t,
+    std::size_t, float, float*);
+template std::size_t RainDX::MeshSimplifier::Simplify<std::uint32_t>(
+    std::uint32_t*, const std::uint32_t*, std::size_t, const float*, std::size_t, std::size_t,
+    std::size_t, float, float*);
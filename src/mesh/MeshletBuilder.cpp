@@ -0,0 +1,346 @@
+#include "mesh/MeshletBuilder.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "d3d/d3dUtil.h"
+
+using DirectX::XMFLOAT3;
+
+namespace
+{
+    XMFLOAT3 LoadPosition(const float* positions, std::size_t stride, std::size_t v)
+    {
+        const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + v * stride);
+        return XMFLOAT3(p[0], p[1], p[2]);
+    }
+
+    float Dot(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    XMFLOAT3 Sub(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+    }
+
+    // 包围球和法线锥, triangles 为簇内三角形的顶点编号
+    template <typename Index>
+    void ComputeBounds(RainDX::Meshlet& meshlet, const Index* triangles, std::uint32_t triangleCount,
+                       const float* positions, std::size_t stride)
+    {
+        // 包围盒中心作为球心
+        XMFLOAT3 lo = LoadPosition(positions, stride, triangles[0]);
+        XMFLOAT3 hi = lo;
+        for (std::uint32_t i = 0; i < triangleCount * 3; ++i)
+        {
+            XMFLOAT3 p = LoadPosition(positions, stride, triangles[i]);
+            lo = XMFLOAT3((std::min)(lo.x, p.x), (std::min)(lo.y, p.y), (std::min)(lo.z, p.z));
+            hi = XMFLOAT3((std::max)(hi.x, p.x), (std::max)(hi.y, p.y), (std::max)(hi.z, p.z));
+        }
+        XMFLOAT3 center(0.5f * (lo.x + hi.x), 0.5f * (lo.y + hi.y), 0.5f * (lo.z + hi.z));
+
+        float radiusSq = 0.0f;
+        for (std::uint32_t i = 0; i < triangleCount * 3; ++i)
+        {
+            XMFLOAT3 d = Sub(LoadPosition(positions, stride, triangles[i]), center);
+            radiusSq = (std::max)(radiusSq, Dot(d, d));
+        }
+        meshlet.Center = center;
+        meshlet.Radius = std::sqrt(radiusSq);
+
+        // 单位法线的平均方向, 退化三角形不参与
+        std::vector<XMFLOAT3> normals;
+        normals.reserve(triangleCount);
+        XMFLOAT3 axis(0.0f, 0.0f, 0.0f);
+        for (std::uint32_t t = 0; t < triangleCount; ++t)
+        {
+            XMFLOAT3 p0 = LoadPosition(positions, stride, triangles[t * 3 + 0]);
+            XMFLOAT3 e1 = Sub(LoadPosition(positions, stride, triangles[t * 3 + 1]), p0);
+            XMFLOAT3 e2 = Sub(LoadPosition(positions, stride, triangles[t * 3 + 2]), p0);
+            XMFLOAT3 n(e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x);
+            float length = std::sqrt(Dot(n, n));
+            if (length == 0.0f)
+                continue;
+            n = XMFLOAT3(n.x / length, n.y / length, n.z / length);
+            normals.push_back(n);
+            axis = XMFLOAT3(axis.x + n.x, axis.y + n.y, axis.z + n.z);
+        }
+
+        meshlet.ConeAxis = XMFLOAT3(0.0f, 0.0f, 1.0f);
+        meshlet.ConeCutoff = 1.0f;
+        float axisLength = std::sqrt(Dot(axis, axis));
+        if (normals.empty() || axisLength == 0.0f)
+            return;
+        axis = XMFLOAT3(axis.x / axisLength, axis.y / axisLength, axis.z / axisLength);
+
+        float minDot = 1.0f;
+        for (const XMFLOAT3& n : normals)
+            minDot = (std::min)(minDot, Dot(n, axis));
+
+        meshlet.ConeAxis = axis;
+        // 锥的半角超过 90 度时法线朝向各个方向, 不做背面裁剪
+        if (minDot > 0.0f)
+            meshlet.ConeCutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+
+    void BuildSubmeshes(MeshGeometry& geo, RainDX::MeshletMap& result)
+    {
+        const char* vertices = static_cast<const char*>(geo.VertexBufferCPU->GetBufferPointer());
+        char* indices = static_cast<char*>(geo.IndexBufferCPU->GetBufferPointer());
+        const std::size_t stride = geo.VertexByteStride;
+        const std::size_t vertexTotal = geo.VertexBufferByteSize / stride;
+
+        // 按索引位置处理, 共用同一段索引的子网格共用结果
+        // 16 位和 32 位子网格的 StartIndexLocation 单位不同, 格式也作为键的一部分
+        std::vector<std::pair<const std::string*, const SubmeshGeometry*>> submeshes;
+        for (const auto& arg : geo.DrawArgs)
+            submeshes.emplace_back(&arg.first, &arg.second);
+        auto sameRange = [&geo](const SubmeshGeometry* a, const SubmeshGeometry* b) {
+            return geo.SubmeshIndexFormat(*a) == geo.SubmeshIndexFormat(*b)
+                && a->StartIndexLocation == b->StartIndexLocation && a->IndexCount == b->IndexCount;
+        };
+        std::sort(submeshes.begin(), submeshes.end(), [&geo](const auto& a, const auto& b) {
+            if (geo.SubmeshIndexFormat(*a.second) != geo.SubmeshIndexFormat(*b.second))
+                return geo.SubmeshIndexFormat(*a.second) < geo.SubmeshIndexFormat(*b.second);
+            if (a.second->StartIndexLocation != b.second->StartIndexLocation)
+                return a.second->StartIndexLocation < b.second->StartIndexLocation;
+            if (a.second->IndexCount != b.second->IndexCount)
+                return a.second->IndexCount < b.second->IndexCount;
+            return *a.first < *b.first;
+        });
+
+        const SubmeshGeometry* previous = nullptr;
+        const std::string* previousName = nullptr;
+        for (const auto& entry : submeshes)
+        {
+            const SubmeshGeometry* submesh = entry.second;
+            if (previous != nullptr && sameRange(previous, submesh))
+            {
+                result[*entry.first] = result[*previousName];
+                continue;
+            }
+
+            std::vector<RainDX::Meshlet>& meshlets = result[*entry.first];
+            const std::size_t base = static_cast<std::size_t>(submesh->BaseVertexLocation);
+            const float* positions = reinterpret_cast<const float*>(vertices + base * stride);
+            if (geo.SubmeshIndexFormat(*submesh) == DXGI_FORMAT_R32_UINT)
+            {
+                RainDX::MeshletBuilder::Build(
+                    reinterpret_cast<std::uint32_t*>(indices) + submesh->StartIndexLocation, submesh->IndexCount,
+                    positions, stride, vertexTotal - base, submesh->StartIndexLocation, meshlets);
+            }
+            else
+            {
+                RainDX::MeshletBuilder::Build(
+                    reinterpret_cast<std::uint16_t*>(indices) + submesh->StartIndexLocation, submesh->IndexCount,
+                    positions, stride, vertexTotal - base, submesh->StartIndexLocation, meshlets);
+            }
+
+            previous = submesh;
+            previousName = entry.first;
+        }
+    }
+}
+
+template <typename Index>
+void RainDX::MeshletBuilder::Build(
+    Index* indices, std::size_t indexCount,
+    const float* positions, std::size_t stride, std::size_t vertexCount,
+    std::uint32_t startIndex, std::vector<Meshlet>& meshlets)
+{
+    const std::uint32_t triangleCount = static_cast<std::uint32_t>(indexCount / 3);
+    if (triangleCount == 0)
+        return;
+
+    // 每个顶点引用的三角形
+    std::vector<std::uint32_t> offsets(vertexCount + 1, 0);
+    for (std::size_t i = 0; i < static_cast<std::size_t>(triangleCount) * 3; ++i)
+    {
+        assert(indices[i] < vertexCount);
+        ++offsets[indices[i] + 1];
+    }
+    for (std::size_t v = 0; v < vertexCount; ++v)
+        offsets[v + 1] += offsets[v];
+
+    std::vector<std::uint32_t> adjacency(static_cast<std::size_t>(triangleCount) * 3);
+    {
+        std::vector<std::uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (std::size_t i = 0; i < adjacency.size(); ++i)
+            adjacency[fill[indices[i]]++] = static_cast<std::uint32_t>(i / 3);
+    }
+
+    // 每个顶点还未放入簇的三角形数
+    std::vector<std::uint32_t> live(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; ++v)
+        live[v] = offsets[v + 1] - offsets[v];
+
+    std::vector<bool> emitted(triangleCount, false);
+    // 顶点所在的簇编号加一, 用于判断顶点是否已在当前簇中
+    std::vector<std::uint32_t> owner(vertexCount, 0);
+    std::vector<Index> output;
+    output.reserve(static_cast<std::size_t>(triangleCount) * 3);
+
+    // 与当前簇相邻的三角形, 可能重复, 也可能已经被放入簇中
+    std::vector<std::uint32_t> candidates;
+    std::uint32_t cursor = 0;
+    std::uint32_t emittedCount = 0;
+    std::uint32_t stamp = 0;
+
+    auto newVertices = [&](std::uint32_t t) {
+        std::uint32_t count = 0;
+        for (int k = 0; k < 3; ++k)
+            count += owner[indices[t * 3 + k]] != stamp ? 1 : 0;
+        return count;
+    };
+    auto liveSum = [&](std::uint32_t t) {
+        return live[indices[t * 3 + 0]] + live[indices[t * 3 + 1]] + live[indices[t * 3 + 2]];
+    };
+
+    while (emittedCount < triangleCount)
+    {
+        // 种子: 上一个簇边缘上最难单独处理的三角形, 没有时按顺序取下一个
+        std::uint32_t seed = UINT32_MAX;
+        std::uint32_t seedLive = UINT32_MAX;
+        for (std::uint32_t t : candidates)
+        {
+            if (!emitted[t] && liveSum(t) < seedLive)
+            {
+                seed = t;
+                seedLive = liveSum(t);
+            }
+        }
+        if (seed == UINT32_MAX)
+        {
+            while (emitted[cursor])
+                ++cursor;
+            seed = cursor;
+        }
+
+        ++stamp;
+        candidates.clear();
+        Meshlet meshlet;
+        meshlet.StartIndexLocation = startIndex + static_cast<std::uint32_t>(output.size());
+        std::uint32_t meshletTriangles = 0;
+
+        for (std::uint32_t t = seed; t != UINT32_MAX;)
+        {
+            emitted[t] = true;
+            ++emittedCount;
+            ++meshletTriangles;
+            for (int k = 0; k < 3; ++k)
+            {
+                Index v = indices[t * 3 + k];
+                output.push_back(v);
+                --live[v];
+                if (owner[v] != stamp)
+                {
+                    owner[v] = stamp;
+                    ++meshlet.VertexCount;
+                    for (std::uint32_t a = offsets[v]; a < offsets[v + 1]; ++a)
+                    {
+                        if (!emitted[adjacency[a]])
+                            candidates.push_back(adjacency[a]);
+                    }
+                }
+            }
+
+            if (meshletTriangles == MaxTriangles)
+                break;
+
+            // 下一个三角形: 新增顶点最少, 其次顶点上剩余三角形最少, 最后取编号最小
+            t = UINT32_MAX;
+            std::uint32_t bestNew = UINT32_MAX;
+            std::uint32_t bestLive = UINT32_MAX;
+            std::size_t kept = 0;
+            for (std::size_t c = 0; c < candidates.size(); ++c)
+            {
+                std::uint32_t candidate = candidates[c];
+                if (emitted[candidate])
+                    continue;
+                candidates[kept++] = candidate;
+
+                std::uint32_t added = newVertices(candidate);
+                if (meshlet.VertexCount + added > MaxVertices)
+                    continue;
+                std::uint32_t remaining = liveSum(candidate);
+                if (added < bestNew || (added == bestNew && (remaining < bestLive
+                    || (remaining == bestLive && candidate < t))))
+                {
+                    t = candidate;
+                    bestNew = added;
+                    bestLive = remaining;
+                }
+            }
+            candidates.resize(kept);
+        }
+
+        meshlet.IndexCount = meshletTriangles * 3;
+        ComputeBounds(meshlet, output.data() + (meshlet.StartIndexLocation - startIndex), meshletTriangles,
+                      positions, stride);
+        meshlets.push_back(meshlet);
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+}
+
+RainDX::MeshletMap RainDX::MeshletBuilder::Build(MeshGeometry& geo)
+{
+    MeshletMap result;
+    if (geo.VertexBufferCPU == nullptr || geo.IndexBufferCPU == nullptr || geo.VertexByteStride == 0)
+        return result;
+
+    BuildSubmeshes(geo, result);
+    return result;
+}
+
+RainDX::MeshletCullStats RainDX::MeshletBuilder::Cull(
+    const Meshlet* meshlets, std::size_t count,
+    const CullFrustum& frustum, const XMFLOAT3& eye,
+    std::vector<MeshletRange>& ranges)
+{
+    MeshletCullStats stats;
+    const std::size_t firstRange = ranges.size();
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const Meshlet& meshlet = meshlets[i];
+        const XMFLOAT3& c = meshlet.Center;
+
+        bool outside = false;
+        for (const DirectX::XMFLOAT4& plane : frustum.Planes)
+            outside = outside || plane.x * c.x + plane.y * c.y + plane.z * c.z + plane.w < -meshlet.Radius;
+        if (outside)
+        {
+            ++stats.FrustumCulled;
+            continue;
+        }
+
+        // 球内任意一点看向簇的方向都落在法线锥的背面一侧时, 整簇背向相机
+        XMFLOAT3 view = Sub(c, eye);
+        float distance = std::sqrt(Dot(view, view));
+        if (Dot(view, meshlet.ConeAxis) >= meshlet.ConeCutoff * distance + meshlet.Radius)
+        {
+            ++stats.BackfaceCulled;
+            continue;
+        }
+
+        ++stats.Visible;
+        if (ranges.size() > firstRange
+            && ranges.back().StartIndexLocation + ranges.back().IndexCount == meshlet.StartIndexLocation)
+        {
+            ranges.back().IndexCount += meshlet.IndexCount;
+        }
+        else
+        {
+            ranges.push_back({meshlet.StartIndexLocation, meshlet.IndexCount});
+        }
+    }
+
+    return stats;
+}
+
+template void RainDX::MeshletBuilder::Build<std::uint16_t>(
+    std::uint16_t*, std::size_t, const float*, std::size_t, std::size_t, std::uint32_t, std::vector<Meshlet>&);
+template void RainDX::MeshletBuilder::Build<std::uint32_t>(
+    std::uint32_t*, std::size_t, const float*, std::size_t, std::size_t, std::uint32_t, std::vector<Meshlet>&);
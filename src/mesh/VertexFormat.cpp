@@ -0,0 +1,351 @@
+#include "mesh/VertexFormat.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // 写入 count 个 16 位分量
+    void Store16(char* dst, const std::uint16_t* values, int count)
+    {
+        memcpy(dst, values, count * sizeof(std::uint16_t));
+    }
+
+    const char* SemanticName(RainDX::VertexAttribute attribute)
+    {
+        switch (attribute)
+        {
+        case RainDX::VertexAttribute::Position:
+            return "POSITION";
+        case RainDX::VertexAttribute::Normal:
+            return "NORMAL";
+        case RainDX::VertexAttribute::Color:
+            return "COLOR";
+        }
+        return "";
+    }
+
+    bool IsValid(RainDX::VertexAttribute attribute, RainDX::VertexEncoding encoding)
+    {
+        using RainDX::VertexAttribute;
+        using RainDX::VertexEncoding;
+        switch (attribute)
+        {
+        case VertexAttribute::Position:
+            return encoding == VertexEncoding::Float3 || encoding == VertexEncoding::Snorm16x4
+                || encoding == VertexEncoding::Half16x4;
+        case VertexAttribute::Normal:
+            return encoding == VertexEncoding::Float3 || encoding == VertexEncoding::Oct16x2;
+        case VertexAttribute::Color:
+            return encoding == VertexEncoding::Float4 || encoding == VertexEncoding::Unorm8x4;
+        }
+        return false;
+    }
+}
+
+RainDX::VertexFormat& RainDX::VertexFormat::Add(VertexAttribute attribute, VertexEncoding encoding)
+{
+    assert(IsValid(attribute, encoding));
+    assert(Find(attribute) == nullptr);
+
+    VertexElement element;
+    element.Attribute = attribute;
+    element.Encoding = encoding;
+    element.Offset = m_Stride;
+    m_Elements.push_back(element);
+
+    m_Stride += (EncodingSize(encoding) + 3) & ~3u;
+    return *this;
+}
+
+UINT RainDX::VertexFormat::Stride() const
+{
+    return m_Stride;
+}
+
+const std::vector<RainDX::VertexElement>& RainDX::VertexFormat::Elements() const
+{
+    return m_Elements;
+}
+
+const RainDX::VertexElement* RainDX::VertexFormat::Find(VertexAttribute attribute) const
+{
+    for (const VertexElement& element : m_Elements)
+    {
+        if (element.Attribute == attribute)
+            return &element;
+    }
+    return nullptr;
+}
+
+std::vector<D3D12_INPUT_ELEMENT_DESC> RainDX::VertexFormat::InputLayout(UINT slot) const
+{
+    std::vector<D3D12_INPUT_ELEMENT_DESC> layout;
+    layout.reserve(m_Elements.size());
+    for (const VertexElement& element : m_Elements)
+    {
+        layout.push_back({SemanticName(element.Attribute), 0, EncodingFormat(element.Encoding), slot,
+                          element.Offset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0});
+    }
+    return layout;
+}
+
+void RainDX::VertexFormat::Encode(const VertexStreams& src, std::size_t count,
+                                  const DirectX::BoundingBox& bounds, void* dst) const
+{
+    // 包围盒退化的轴上所有位置都等于中心
+    const DirectX::XMFLOAT3& c = bounds.Center;
+    const DirectX::XMFLOAT3& e = bounds.Extents;
+    const float inv[3] = {
+        e.x > 0.0f ? 1.0f / e.x : 0.0f,
+        e.y > 0.0f ? 1.0f / e.y : 0.0f,
+        e.z > 0.0f ? 1.0f / e.z : 0.0f,
+    };
+
+    char* out = static_cast<char*>(dst);
+    for (const VertexElement& element : m_Elements)
+    {
+        const VertexStream& stream = element.Attribute == VertexAttribute::Position ? src.Position
+            : element.Attribute == VertexAttribute::Normal ? src.Normal : src.Color;
+        assert(stream.Data != nullptr);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const float* value = stream.At(i);
+            char* target = out + i * m_Stride + element.Offset;
+
+            switch (element.Encoding)
+            {
+            case VertexEncoding::Float3:
+                memcpy(target, value, 3 * sizeof(float));
+                break;
+            case VertexEncoding::Float4:
+                memcpy(target, value, 4 * sizeof(float));
+                break;
+            case VertexEncoding::Snorm16x4:
+            {
+                std::uint16_t q[4] = {
+                    static_cast<std::uint16_t>(FloatToSnorm16((value[0] - c.x) * inv[0])),
+                    static_cast<std::uint16_t>(FloatToSnorm16((value[1] - c.y) * inv[1])),
+                    static_cast<std::uint16_t>(FloatToSnorm16((value[2] - c.z) * inv[2])),
+                    0,
+                };
+                Store16(target, q, 4);
+                break;
+            }
+            case VertexEncoding::Half16x4:
+            {
+                std::uint16_t q[4] = {
+                    FloatToHalf((value[0] - c.x) * inv[0]),
+                    FloatToHalf((value[1] - c.y) * inv[1]),
+                    FloatToHalf((value[2] - c.z) * inv[2]),
+                    0,
+                };
+                Store16(target, q, 4);
+                break;
+            }
+            case VertexEncoding::Unorm8x4:
+            {
+                std::uint8_t q[4] = {
+                    FloatToUnorm8(value[0]), FloatToUnorm8(value[1]),
+                    FloatToUnorm8(value[2]), FloatToUnorm8(value[3]),
+                };
+                memcpy(target, q, sizeof(q));
+                break;
+            }
+            case VertexEncoding::Oct16x2:
+            {
+                float u = 0.0f;
+                float v = 0.0f;
+                OctEncode(value, u, v);
+                std::uint16_t q[2] = {
+                    static_cast<std::uint16_t>(FloatToSnorm16(u)),
+                    static_cast<std::uint16_t>(FloatToSnorm16(v)),
+                };
+                Store16(target, q, 2);
+                break;
+            }
+            }
+        }
+    }
+}
+
+RainDX::PositionDequant RainDX::VertexFormat::Dequant(const DirectX::BoundingBox& bounds) const
+{
+    PositionDequant dequant;
+    const VertexElement* position = Find(VertexAttribute::Position);
+    if (position != nullptr && position->Encoding != VertexEncoding::Float3)
+    {
+        dequant.Scale = bounds.Extents;
+        dequant.Bias = bounds.Center;
+    }
+    return dequant;
+}
+
+UINT RainDX::VertexFormat::EncodingSize(VertexEncoding encoding)
+{
+    switch (encoding)
+    {
+    case VertexEncoding::Float3:
+        return 12;
+    case VertexEncoding::Float4:
+        return 16;
+    case VertexEncoding::Snorm16x4:
+    case VertexEncoding::Half16x4:
+        return 8;
+    case VertexEncoding::Unorm8x4:
+    case VertexEncoding::Oct16x2:
+        return 4;
+    }
+    return 0;
+}
+
+DXGI_FORMAT RainDX::VertexFormat::EncodingFormat(VertexEncoding encoding)
+{
+    switch (encoding)
+    {
+    case VertexEncoding::Float3:
+        return DXGI_FORMAT_R32G32B32_FLOAT;
+    case VertexEncoding::Float4:
+        return DXGI_FORMAT_R32G32B32A32_FLOAT;
+    case VertexEncoding::Snorm16x4:
+        return DXGI_FORMAT_R16G16B16A16_SNORM;
+    case VertexEncoding::Half16x4:
+        return DXGI_FORMAT_R16G16B16A16_FLOAT;
+    case VertexEncoding::Unorm8x4:
+        return DXGI_FORMAT_R8G8B8A8_UNORM;
+    case VertexEncoding::Oct16x2:
+        return DXGI_FORMAT_R16G16_SNORM;
+    }
+    return DXGI_FORMAT_UNKNOWN;
+}
+
+RainDX::VertexFormat RainDX::VertexFormat::PositionColor()
+{
+    VertexFormat format;
+    format.Add(VertexAttribute::Position, VertexEncoding::Float3)
+          .Add(VertexAttribute::Color, VertexEncoding::Float4);
+    return format;
+}
+
+RainDX::VertexFormat RainDX::VertexFormat::CompactPositionColor()
+{
+    VertexFormat format;
+    format.Add(VertexAttribute::Position, VertexEncoding::Snorm16x4)
+          .Add(VertexAttribute::Color, VertexEncoding::Unorm8x4);
+    return format;
+}
+
+std::uint16_t RainDX::FloatToHalf(float value)
+{
+    std::uint32_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+
+    const std::uint32_t sign = (bits >> 16) & 0x8000u;
+    const std::uint32_t abs = bits & 0x7fffffffu;
+
+    // NaN 保持为 NaN, 超出范围的值变为无穷大
+    if (abs > 0x7f800000u)
+        return static_cast<std::uint16_t>(sign | 0x7e00u);
+    if (abs >= 0x477ff000u)
+        return static_cast<std::uint16_t>(sign | 0x7c00u);
+
+    // 非规格化数: 用浮点加法对齐到半精度的最小单位, 由硬件完成舍入
+    if (abs < 0x38800000u)
+    {
+        float magnitude = 0.0f;
+        memcpy(&magnitude, &abs, sizeof(magnitude));
+        magnitude += 0.5f;
+        std::uint32_t rounded = 0;
+        memcpy(&rounded, &magnitude, sizeof(rounded));
+        return static_cast<std::uint16_t>(sign | (rounded - 0x3f000000u));
+    }
+
+    // 规格化数: 调整指数偏移, 尾数舍入到最近的偶数
+    std::uint32_t mantissaOdd = (abs >> 13) & 1u;
+    std::uint32_t rounded = abs + 0xc8000fffu + mantissaOdd;
+    return static_cast<std::uint16_t>(sign | (rounded >> 13));
+}
+
+float RainDX::HalfToFloat(std::uint16_t value)
+{
+    const std::uint32_t sign = (value & 0x8000u) << 16;
+    const std::uint32_t exponent = (value >> 10) & 0x1fu;
+    const std::uint32_t mantissa = value & 0x3ffu;
+
+    float result = 0.0f;
+    if (exponent == 0)
+    {
+        result = std::ldexp(static_cast<float>(mantissa), -24);
+    }
+    else if (exponent == 31)
+    {
+        std::uint32_t bits = 0x7f800000u | (mantissa << 13);
+        memcpy(&result, &bits, sizeof(result));
+    }
+    else
+    {
+        std::uint32_t bits = ((exponent + 112) << 23) | (mantissa << 13);
+        memcpy(&result, &bits, sizeof(result));
+    }
+
+    std::uint32_t bits = 0;
+    memcpy(&bits, &result, sizeof(bits));
+    bits |= sign;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+std::int16_t RainDX::FloatToSnorm16(float value)
+{
+    value = (std::min)((std::max)(value, -1.0f), 1.0f);
+    return static_cast<std::int16_t>(std::lround(value * 32767.0f));
+}
+
+std::uint8_t RainDX::FloatToUnorm8(float value)
+{
+    value = (std::min)((std::max)(value, 0.0f), 1.0f);
+    return static_cast<std::uint8_t>(std::lround(value * 255.0f));
+}
+
+void RainDX::OctEncode(const float* normal, float& u, float& v)
+{
+    float l1 = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+    if (l1 == 0.0f)
+    {
+        u = 0.0f;
+        v = 0.0f;
+        return;
+    }
+
+    float x = normal[0] / l1;
+    float y = normal[1] / l1;
+    // 下半球沿对角线折叠到上半球之外
+    if (normal[2] < 0.0f)
+    {
+        float fx = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float fy = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = fx;
+        y = fy;
+    }
+    u = x;
+    v = y;
+}
+
+void RainDX::OctDecode(float u, float v, float* normal)
+{
+    float x = u;
+    float y = v;
+    float z = 1.0f - std::fabs(u) - std::fabs(v);
+    if (z < 0.0f)
+    {
+        x = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+        y = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+    }
+
+    float length = std::sqrt(x * x + y * y + z * z);
+    normal[0] = x / length;
+    normal[1] = y / length;
+    normal[2] = z / length;
+}
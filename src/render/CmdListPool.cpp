@@ -0,0 +1,38 @@
+#include "render/CmdListPool.h"
+#include "d3d/DxException.h"
+
+RainDX::CmdListPool::CmdListPool(RenderDevice* device) : m_Device(device)
+{
+}
+
+void RainDX::CmdListPool::Reset()
+{
+    m_Used = 0;
+}
+
+RainDX::RenderCmdList* RainDX::CmdListPool::Acquire(ID3D12PipelineState* pso)
+{
+    if (m_Used == m_Entries.size())
+    {
+        Entry entry;
+        entry.Alloc = m_Device->CreateCmdAlloc();
+        entry.List = m_Device->CreateCmdList(entry.Alloc.Get());
+        m_Entries.push_back(std::move(entry));
+    }
+
+    Entry& entry = m_Entries[m_Used++];
+    // 上一次使用该分配器的帧已经完成
+    ThrowIfFailed(entry.Alloc->Reset())
+    entry.List->Reset(entry.Alloc.Get(), pso);
+    return entry.List.get();
+}
+
+UINT RainDX::CmdListPool::Count() const
+{
+    return static_cast<UINT>(m_Entries.size());
+}
+
+UINT RainDX::CmdListPool::Used() const
+{
+    return m_Used;
+}
@@ -0,0 +1,257 @@
+#include "render/D3D12RenderDevice.h"
+#include <vector>
+#include "d3d/DxException.h"
+
+using Microsoft::WRL::ComPtr;
+
+RainDX::D3D12RenderCmdList::D3D12RenderCmdList(ComPtr<ID3D12GraphicsCommandList> list) :
+    m_List(std::move(list))
+{
+}
+
+void RainDX::D3D12RenderCmdList::Reset(ID3D12CommandAllocator* alloc, ID3D12PipelineState* pso)
+{
+    ThrowIfFailed(m_List->Reset(alloc, pso))
+}
+
+void RainDX::D3D12RenderCmdList::Close()
+{
+    ThrowIfFailed(m_List->Close())
+}
+
+void RainDX::D3D12RenderCmdList::ResourceBarrier(UINT count, const D3D12_RESOURCE_BARRIER* barriers)
+{
+    m_List->ResourceBarrier(count, barriers);
+}
+
+void RainDX::D3D12RenderCmdList::CopyBufferRegion(ID3D12Resource* dst, UINT64 dstOffset,
+                                                  ID3D12Resource* src, UINT64 srcOffset, UINT64 byteSize)
+{
+    m_List->CopyBufferRegion(dst, dstOffset, src, srcOffset, byteSize);
+}
+
+void RainDX::D3D12RenderCmdList::CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION* dst,
+                                                   const D3D12_TEXTURE_COPY_LOCATION* src)
+{
+    m_List->CopyTextureRegion(dst, 0, 0, 0, src, nullptr);
+}
+
+void RainDX::D3D12RenderCmdList::RSSetViewports(UINT count, const D3D12_VIEWPORT* viewports)
+{
+    m_List->RSSetViewports(count, viewports);
+}
+
+void RainDX::D3D12RenderCmdList::RSSetScissorRects(UINT count, const D3D12_RECT* rects)
+{
+    m_List->RSSetScissorRects(count, rects);
+}
+
+void RainDX::D3D12RenderCmdList::ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE rtv, const FLOAT color[4])
+{
+    m_List->ClearRenderTargetView(rtv, color, 0, nullptr);
+}
+
+void RainDX::D3D12RenderCmdList::ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE dsv, D3D12_CLEAR_FLAGS flags,
+                                                       FLOAT depth, UINT8 stencil)
+{
+    m_List->ClearDepthStencilView(dsv, flags, depth, stencil, 0, nullptr);
+}
+
+void RainDX::D3D12RenderCmdList::OMSetRenderTargets(UINT count, const D3D12_CPU_DESCRIPTOR_HANDLE* rtvs,
+                                                    BOOL singleHandle, const D3D12_CPU_DESCRIPTOR_HANDLE* dsv)
+{
+    m_List->OMSetRenderTargets(count, rtvs, singleHandle, dsv);
+}
+
+void RainDX::D3D12RenderCmdList::SetPipelineState(ID3D12PipelineState* pso)
+{
+    m_List->SetPipelineState(pso);
+}
+
+void RainDX::D3D12RenderCmdList::SetDescriptorHeaps(UINT count, ID3D12DescriptorHeap* const* heaps)
+{
+    m_List->SetDescriptorHeaps(count, heaps);
+}
+
+void RainDX::D3D12RenderCmdList::SetGraphicsRootSignature(ID3D12RootSignature* rootSign)
+{
+    m_List->SetGraphicsRootSignature(rootSign);
+}
+
+void RainDX::D3D12RenderCmdList::SetGraphicsRootDescriptorTable(UINT index, D3D12_GPU_DESCRIPTOR_HANDLE table)
+{
+    m_List->SetGraphicsRootDescriptorTable(index, table);
+}
+
+void RainDX::D3D12RenderCmdList::SetGraphicsRootShaderResourceView(UINT index, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    m_List->SetGraphicsRootShaderResourceView(index, address);
+}
+
+void RainDX::D3D12RenderCmdList::SetGraphicsRootConstantBufferView(UINT index, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    m_List->SetGraphicsRootConstantBufferView(index, address);
+}
+
+void RainDX::D3D12RenderCmdList::SetGraphicsRoot32BitConstants(UINT index, UINT count, const void* data, UINT offset)
+{
+    m_List->SetGraphicsRoot32BitConstants(index, count, data, offset);
+}
+
+void RainDX::D3D12RenderCmdList::IASetVertexBuffers(UINT slot, UINT count, const D3D12_VERTEX_BUFFER_VIEW* views)
+{
+    m_List->IASetVertexBuffers(slot, count, views);
+}
+
+void RainDX::D3D12RenderCmdList::IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view)
+{
+    m_List->IASetIndexBuffer(view);
+}
+
+void RainDX::D3D12RenderCmdList::IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology)
+{
+    m_List->IASetPrimitiveTopology(topology);
+}
+
+void RainDX::D3D12RenderCmdList::DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex,
+                                                      INT baseVertex, UINT startInstance)
+{
+    m_List->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+}
+
+ID3D12GraphicsCommandList* RainDX::D3D12RenderCmdList::Native() const
+{
+    return m_List.Get();
+}
+
+
+RainDX::D3D12RenderDevice::D3D12RenderDevice(ID3D12Device* device, ID3D12CommandQueue* queue, ID3D12Fence* fence) :
+    m_Device(device), m_Queue(queue), m_Fence(queue, fence)
+{
+}
+
+ComPtr<ID3D12Resource> RainDX::D3D12RenderDevice::CreateBuffer(
+    D3D12_HEAP_TYPE heapType,
+    UINT64 byteSize,
+    D3D12_RESOURCE_STATES initState)
+{
+    ComPtr<ID3D12Resource> buffer;
+
+    auto prop = CD3DX12_HEAP_PROPERTIES(heapType);
+    auto desc = CD3DX12_RESOURCE_DESC::Buffer(byteSize);
+    ThrowIfFailed(m_Device->CreateCommittedResource(
+        &prop,
+        D3D12_HEAP_FLAG_NONE,
+        &desc,
+        initState,
+        nullptr,
+        IID_PPV_ARGS(buffer.GetAddressOf())))
+
+    return buffer;
+}
+
+ComPtr<ID3D12Heap> RainDX::D3D12RenderDevice::CreateHeap(const D3D12_HEAP_DESC& desc)
+{
+    ComPtr<ID3D12Heap> heap;
+    ThrowIfFailed(m_Device->CreateHeap(&desc, IID_PPV_ARGS(heap.GetAddressOf())))
+    return heap;
+}
+
+ComPtr<ID3D12Resource> RainDX::D3D12RenderDevice::CreatePlacedResource(
+    ID3D12Heap* heap,
+    UINT64 heapOffset,
+    const D3D12_RESOURCE_DESC& desc,
+    D3D12_RESOURCE_STATES initState,
+    const D3D12_CLEAR_VALUE* clearValue)
+{
+    ComPtr<ID3D12Resource> resource;
+    ThrowIfFailed(m_Device->CreatePlacedResource(
+        heap,
+        heapOffset,
+        &desc,
+        initState,
+        clearValue,
+        IID_PPV_ARGS(resource.GetAddressOf())))
+    return resource;
+}
+
+D3D12_RESOURCE_ALLOCATION_INFO RainDX::D3D12RenderDevice::GetResourceAllocationInfo(const D3D12_RESOURCE_DESC& desc)
+{
+    return m_Device->GetResourceAllocationInfo(0, 1, &desc);
+}
+
+ComPtr<ID3D12DescriptorHeap> RainDX::D3D12RenderDevice::CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC& desc)
+{
+    ComPtr<ID3D12DescriptorHeap> heap;
+    ThrowIfFailed(m_Device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(heap.GetAddressOf())))
+    return heap;
+}
+
+UINT RainDX::D3D12RenderDevice::DescriptorSize(D3D12_DESCRIPTOR_HEAP_TYPE type) const
+{
+    return m_Device->GetDescriptorHandleIncrementSize(type);
+}
+
+void RainDX::D3D12RenderDevice::CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC& desc,
+                                                         D3D12_CPU_DESCRIPTOR_HANDLE handle)
+{
+    m_Device->CreateConstantBufferView(&desc, handle);
+}
+
+void RainDX::D3D12RenderDevice::CopyDescriptors(UINT dstRangeCount, const D3D12_CPU_DESCRIPTOR_HANDLE* dstStarts,
+                                                const UINT* dstSizes, UINT srcRangeCount,
+                                                const D3D12_CPU_DESCRIPTOR_HANDLE* srcStarts, const UINT* srcSizes,
+                                                D3D12_DESCRIPTOR_HEAP_TYPE type)
+{
+    m_Device->CopyDescriptors(dstRangeCount, dstStarts, dstSizes, srcRangeCount, srcStarts, srcSizes, type);
+}
+
+void RainDX::D3D12RenderDevice::GetCopyableFootprints(const D3D12_RESOURCE_DESC& desc,
+                                                      UINT firstSubresource, UINT numSubresources, UINT64 baseOffset,
+                                                      D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts, UINT* numRows,
+                                                      UINT64* rowSizes, UINT64* totalBytes)
+{
+    m_Device->GetCopyableFootprints(&desc, firstSubresource, numSubresources, baseOffset,
+                                    layouts, numRows, rowSizes, totalBytes);
+}
+
+ComPtr<ID3D12CommandAllocator> RainDX::D3D12RenderDevice::CreateCmdAlloc()
+{
+    ComPtr<ID3D12CommandAllocator> alloc;
+    ThrowIfFailed(m_Device->CreateCommandAllocator(
+        D3D12_COMMAND_LIST_TYPE_DIRECT,
+        IID_PPV_ARGS(alloc.GetAddressOf())))
+    return alloc;
+}
+
+std::unique_ptr<RainDX::RenderCmdList> RainDX::D3D12RenderDevice::CreateCmdList(ID3D12CommandAllocator* alloc)
+{
+    ComPtr<ID3D12GraphicsCommandList> list;
+    ThrowIfFailed(m_Device->CreateCommandList(
+        0, D3D12_COMMAND_LIST_TYPE_DIRECT,
+        alloc, nullptr,
+        IID_PPV_ARGS(list.GetAddressOf())))
+    // 新建的命令列表处于记录状态, 先关闭
+    ThrowIfFailed(list->Close())
+
+    return std::make_unique<D3D12RenderCmdList>(std::move(list));
+}
+
+void RainDX::D3D12RenderDevice::Execute(UINT count, RenderCmdList* const* lists)
+{
+    std::vector<ID3D12CommandList*> cmdsLists(count);
+    for (UINT i = 0; i < count; ++i)
+        cmdsLists[i] = lists[i]->Native();
+
+    m_Queue->ExecuteCommandLists(count, cmdsLists.data());
+}
+
+RainDX::FrameFence* RainDX::D3D12RenderDevice::Fence()
+{
+    return &m_Fence;
+}
+
+ID3D12Device* RainDX::D3D12RenderDevice::Native() const
+{
+    return m_Device;
+}
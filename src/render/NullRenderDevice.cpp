@@ -0,0 +1,659 @@
+#include "render/NullRenderDevice.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    // 假设备子对象的公共部分: 引用计数和空的私有数据接口
+    template <typename T>
+    class NullDeviceChild : public T
+    {
+    public:
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** obj) override
+        {
+            if (riid == __uuidof(IUnknown) || riid == __uuidof(T))
+            {
+                *obj = static_cast<T*>(this);
+                AddRef();
+                return S_OK;
+            }
+            *obj = nullptr;
+            return E_NOINTERFACE;
+        }
+
+        ULONG STDMETHODCALLTYPE AddRef() override
+        {
+            return ++m_RefCount;
+        }
+
+        ULONG STDMETHODCALLTYPE Release() override
+        {
+            ULONG count = --m_RefCount;
+            if (count == 0)
+                delete this;
+            return count;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID guid, UINT* dataSize, void* data) override
+        {
+            return DXGI_ERROR_NOT_FOUND;
+        }
+
+        HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID guid, UINT dataSize, const void* data) override
+        {
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID guid, const IUnknown* data) override
+        {
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE SetName(LPCWSTR name) override
+        {
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetDevice(REFIID riid, void** device) override
+        {
+            *device = nullptr;
+            return E_NOTIMPL;
+        }
+
+    protected:
+        virtual ~NullDeviceChild() = default;
+
+    private:
+        std::atomic<ULONG> m_RefCount{1};
+    };
+
+    // 缓冲区, 上传堆和回读堆的数据保存在内存中
+    class NullResource : public NullDeviceChild<ID3D12Resource>
+    {
+    public:
+        NullResource(D3D12_HEAP_TYPE heapType, const D3D12_RESOURCE_DESC& desc, D3D12_GPU_VIRTUAL_ADDRESS address) :
+            m_HeapType(heapType), m_Desc(desc), m_Address(address)
+        {
+            if (heapType != D3D12_HEAP_TYPE_DEFAULT && desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+                m_Data.resize(static_cast<size_t>(desc.Width));
+        }
+
+        HRESULT STDMETHODCALLTYPE Map(UINT subresource, const D3D12_RANGE* readRange, void** data) override
+        {
+            // 默认堆不能映射
+            if (m_Data.empty())
+                return E_INVALIDARG;
+            if (data != nullptr)
+                *data = m_Data.data();
+            return S_OK;
+        }
+
+        void STDMETHODCALLTYPE Unmap(UINT subresource, const D3D12_RANGE* writtenRange) override
+        {
+        }
+
+        D3D12_RESOURCE_DESC STDMETHODCALLTYPE GetDesc() override
+        {
+            return m_Desc;
+        }
+
+        D3D12_GPU_VIRTUAL_ADDRESS STDMETHODCALLTYPE GetGPUVirtualAddress() override
+        {
+            return m_Address;
+        }
+
+        HRESULT STDMETHODCALLTYPE WriteToSubresource(UINT dstSubresource, const D3D12_BOX* dstBox,
+                                                     const void* srcData, UINT srcRowPitch,
+                                                     UINT srcDepthPitch) override
+        {
+            return E_NOTIMPL;
+        }
+
+        HRESULT STDMETHODCALLTYPE ReadFromSubresource(void* dstData, UINT dstRowPitch, UINT dstDepthPitch,
+                                                      UINT srcSubresource, const D3D12_BOX* srcBox) override
+        {
+            return E_NOTIMPL;
+        }
+
+        HRESULT STDMETHODCALLTYPE GetHeapProperties(D3D12_HEAP_PROPERTIES* heapProperties,
+                                                    D3D12_HEAP_FLAGS* heapFlags) override
+        {
+            if (heapProperties != nullptr)
+                *heapProperties = CD3DX12_HEAP_PROPERTIES(m_HeapType);
+            if (heapFlags != nullptr)
+                *heapFlags = D3D12_HEAP_FLAG_NONE;
+            return S_OK;
+        }
+
+    private:
+        D3D12_HEAP_TYPE m_HeapType;
+        D3D12_RESOURCE_DESC m_Desc;
+        D3D12_GPU_VIRTUAL_ADDRESS m_Address;
+        std::vector<BYTE> m_Data;
+    };
+
+    // 描述符堆, 只分配地址不保存描述符
+    class NullDescriptorHeap : public NullDeviceChild<ID3D12DescriptorHeap>
+    {
+    public:
+        NullDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC& desc, UINT64 address) :
+            m_Desc(desc), m_Address(address)
+        {
+        }
+
+        D3D12_DESCRIPTOR_HEAP_DESC STDMETHODCALLTYPE GetDesc() override
+        {
+            return m_Desc;
+        }
+
+        D3D12_CPU_DESCRIPTOR_HANDLE STDMETHODCALLTYPE GetCPUDescriptorHandleForHeapStart() override
+        {
+            return {static_cast<SIZE_T>(m_Address)};
+        }
+
+        D3D12_GPU_DESCRIPTOR_HANDLE STDMETHODCALLTYPE GetGPUDescriptorHandleForHeapStart() override
+        {
+            if ((m_Desc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE) == 0)
+                return {0};
+            return {m_Address};
+        }
+
+    private:
+        D3D12_DESCRIPTOR_HEAP_DESC m_Desc;
+        UINT64 m_Address;
+    };
+
+    // 显式堆, 只记录描述和起始地址
+    class NullHeap : public NullDeviceChild<ID3D12Heap>
+    {
+    public:
+        NullHeap(const D3D12_HEAP_DESC& desc, D3D12_GPU_VIRTUAL_ADDRESS address) :
+            m_Desc(desc), m_Address(address)
+        {
+        }
+
+        D3D12_HEAP_DESC STDMETHODCALLTYPE GetDesc() override
+        {
+            return m_Desc;
+        }
+
+        D3D12_GPU_VIRTUAL_ADDRESS Address() const
+        {
+            return m_Address;
+        }
+
+    private:
+        D3D12_HEAP_DESC m_Desc;
+        D3D12_GPU_VIRTUAL_ADDRESS m_Address;
+    };
+
+    class NullCmdAlloc : public NullDeviceChild<ID3D12CommandAllocator>
+    {
+    public:
+        HRESULT STDMETHODCALLTYPE Reset() override
+        {
+            return S_OK;
+        }
+    };
+
+    // 所有类型的描述符都按 32 字节计算
+    constexpr UINT NullDescriptorSize = 32;
+
+    // 未列出的格式按 4 字节计算
+    UINT NullBytesPerPixel(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:
+        case DXGI_FORMAT_R32G32B32A32_UINT:
+            return 16;
+        case DXGI_FORMAT_R32G32B32_FLOAT:
+            return 12;
+        case DXGI_FORMAT_R16G16B16A16_FLOAT:
+        case DXGI_FORMAT_R16G16B16A16_UNORM:
+        case DXGI_FORMAT_R32G32_FLOAT:
+            return 8;
+        case DXGI_FORMAT_R16_FLOAT:
+        case DXGI_FORMAT_R16_UNORM:
+        case DXGI_FORMAT_R8G8_UNORM:
+            return 2;
+        case DXGI_FORMAT_R8_UNORM:
+        case DXGI_FORMAT_A8_UNORM:
+            return 1;
+        default:
+            return 4;
+        }
+    }
+}
+
+RainDX::RenderStats& RainDX::RenderStats::operator+=(const RenderStats& rhs)
+{
+    Commands += rhs.Commands;
+    Draws += rhs.Draws;
+    Instances += rhs.Instances;
+    Indices += rhs.Indices;
+    Barriers += rhs.Barriers;
+    BytesUploaded += rhs.BytesUploaded;
+    CmdLists += rhs.CmdLists;
+    Submits += rhs.Submits;
+    BuffersCreated += rhs.BuffersCreated;
+    HeapsCreated += rhs.HeapsCreated;
+    PlacedResources += rhs.PlacedResources;
+    DescriptorWrites += rhs.DescriptorWrites;
+    DescriptorCopies += rhs.DescriptorCopies;
+    return *this;
+}
+
+
+RainDX::NullFrameFence::NullFrameFence(std::uint64_t latency) : m_Latency(latency)
+{
+}
+
+std::uint64_t RainDX::NullFrameFence::Signal()
+{
+    return ++m_Value;
+}
+
+std::uint64_t RainDX::NullFrameFence::CompletedValue() const
+{
+    std::uint64_t scheduled = m_Value > m_Latency ? m_Value - m_Latency : 0;
+    return (std::max)(scheduled, m_Forced);
+}
+
+void RainDX::NullFrameFence::Wait(std::uint64_t value)
+{
+    if (CompletedValue() >= value)
+        return;
+
+    // 模拟 GPU 执行完毕
+    ++m_WaitCount;
+    m_Forced = (std::min)(value, m_Value);
+}
+
+std::uint64_t RainDX::NullFrameFence::WaitCount() const
+{
+    return m_WaitCount;
+}
+
+
+void RainDX::NullRenderCmdList::Reset(ID3D12CommandAllocator* alloc, ID3D12PipelineState* pso)
+{
+    m_Cmds.clear();
+    m_Stats = RenderStats();
+    m_IsOpen = true;
+    Record(NullCmdType::Reset, reinterpret_cast<UINT64>(alloc), reinterpret_cast<UINT64>(pso));
+}
+
+void RainDX::NullRenderCmdList::Close()
+{
+    Record(NullCmdType::Close);
+    m_IsOpen = false;
+}
+
+void RainDX::NullRenderCmdList::ResourceBarrier(UINT count, const D3D12_RESOURCE_BARRIER* barriers)
+{
+    m_Stats.Barriers += count;
+    Record(NullCmdType::ResourceBarrier, count);
+}
+
+void RainDX::NullRenderCmdList::CopyBufferRegion(ID3D12Resource* dst, UINT64 dstOffset,
+                                                 ID3D12Resource* src, UINT64 srcOffset, UINT64 byteSize)
+{
+    m_Stats.BytesUploaded += byteSize;
+    Record(NullCmdType::CopyBufferRegion, reinterpret_cast<UINT64>(dst), byteSize);
+}
+
+void RainDX::NullRenderCmdList::CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION* dst,
+                                                  const D3D12_TEXTURE_COPY_LOCATION* src)
+{
+    UINT64 byteSize = 0;
+    if (src->Type == D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT)
+    {
+        const D3D12_SUBRESOURCE_FOOTPRINT& footprint = src->PlacedFootprint.Footprint;
+        byteSize = static_cast<UINT64>(footprint.RowPitch) * footprint.Height * footprint.Depth;
+    }
+    m_Stats.BytesUploaded += byteSize;
+    Record(NullCmdType::CopyTextureRegion, reinterpret_cast<UINT64>(dst->pResource), byteSize);
+}
+
+void RainDX::NullRenderCmdList::RSSetViewports(UINT count, const D3D12_VIEWPORT* viewports)
+{
+    Record(NullCmdType::SetViewports, count);
+}
+
+void RainDX::NullRenderCmdList::RSSetScissorRects(UINT count, const D3D12_RECT* rects)
+{
+    Record(NullCmdType::SetScissorRects, count);
+}
+
+void RainDX::NullRenderCmdList::ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE rtv, const FLOAT color[4])
+{
+    Record(NullCmdType::ClearRenderTarget, rtv.ptr);
+}
+
+void RainDX::NullRenderCmdList::ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE dsv, D3D12_CLEAR_FLAGS flags,
+                                                      FLOAT depth, UINT8 stencil)
+{
+    Record(NullCmdType::ClearDepthStencil, dsv.ptr, flags);
+}
+
+void RainDX::NullRenderCmdList::OMSetRenderTargets(UINT count, const D3D12_CPU_DESCRIPTOR_HANDLE* rtvs,
+                                                   BOOL singleHandle, const D3D12_CPU_DESCRIPTOR_HANDLE* dsv)
+{
+    Record(NullCmdType::SetRenderTargets, count, dsv != nullptr ? dsv->ptr : 0);
+}
+
+void RainDX::NullRenderCmdList::SetPipelineState(ID3D12PipelineState* pso)
+{
+    Record(NullCmdType::SetPipelineState, reinterpret_cast<UINT64>(pso));
+}
+
+void RainDX::NullRenderCmdList::SetDescriptorHeaps(UINT count, ID3D12DescriptorHeap* const* heaps)
+{
+    Record(NullCmdType::SetDescriptorHeaps, count);
+}
+
+void RainDX::NullRenderCmdList::SetGraphicsRootSignature(ID3D12RootSignature* rootSign)
+{
+    Record(NullCmdType::SetRootSignature, reinterpret_cast<UINT64>(rootSign));
+}
+
+void RainDX::NullRenderCmdList::SetGraphicsRootDescriptorTable(UINT index, D3D12_GPU_DESCRIPTOR_HANDLE table)
+{
+    Record(NullCmdType::SetRootDescriptorTable, index, table.ptr);
+}
+
+void RainDX::NullRenderCmdList::SetGraphicsRootShaderResourceView(UINT index, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    Record(NullCmdType::SetRootShaderResourceView, index, address);
+}
+
+void RainDX::NullRenderCmdList::SetGraphicsRootConstantBufferView(UINT index, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+    Record(NullCmdType::SetRootConstantBufferView, index, address);
+}
+
+void RainDX::NullRenderCmdList::SetGraphicsRoot32BitConstants(UINT index, UINT count, const void* data, UINT offset)
+{
+    Record(NullCmdType::SetRoot32BitConstants, index, count);
+}
+
+void RainDX::NullRenderCmdList::IASetVertexBuffers(UINT slot, UINT count, const D3D12_VERTEX_BUFFER_VIEW* views)
+{
+    Record(NullCmdType::SetVertexBuffers, slot, count);
+}
+
+void RainDX::NullRenderCmdList::IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view)
+{
+    Record(NullCmdType::SetIndexBuffer, view != nullptr ? view->BufferLocation : 0);
+}
+
+void RainDX::NullRenderCmdList::IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology)
+{
+    Record(NullCmdType::SetPrimitiveTopology, topology);
+}
+
+void RainDX::NullRenderCmdList::DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex,
+                                                     INT baseVertex, UINT startInstance)
+{
+    ++m_Stats.Draws;
+    m_Stats.Instances += instanceCount;
+    m_Stats.Indices += static_cast<UINT64>(indexCount) * instanceCount;
+    Record(NullCmdType::DrawIndexedInstanced, indexCount, instanceCount);
+}
+
+ID3D12GraphicsCommandList* RainDX::NullRenderCmdList::Native() const
+{
+    return nullptr;
+}
+
+const std::vector<RainDX::NullCmd>& RainDX::NullRenderCmdList::Commands() const
+{
+    return m_Cmds;
+}
+
+const RainDX::RenderStats& RainDX::NullRenderCmdList::Stats() const
+{
+    return m_Stats;
+}
+
+void RainDX::NullRenderCmdList::Record(NullCmdType type, UINT64 arg0, UINT64 arg1)
+{
+    // 与 D3D12 一样, 关闭的命令列表不能记录
+    assert(m_IsOpen && "Recording into a closed command list.");
+    ++m_Stats.Commands;
+    m_Cmds.push_back({type, arg0, arg1});
+}
+
+
+RainDX::NullRenderDevice::NullRenderDevice(std::uint64_t fenceLatency) : m_Fence(fenceLatency)
+{
+}
+
+ComPtr<ID3D12Resource> RainDX::NullRenderDevice::CreateBuffer(
+    D3D12_HEAP_TYPE heapType,
+    UINT64 byteSize,
+    D3D12_RESOURCE_STATES initState)
+{
+    ++m_Stats.BuffersCreated;
+
+    ComPtr<ID3D12Resource> buffer;
+    buffer.Attach(new NullResource(heapType, CD3DX12_RESOURCE_DESC::Buffer(byteSize), m_NextGpuAddress));
+
+    // 与 D3D12 一样按 64KB 对齐分配地址
+    constexpr UINT64 alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    m_NextGpuAddress += (byteSize + alignment - 1) & ~(alignment - 1);
+
+    return buffer;
+}
+
+ComPtr<ID3D12Heap> RainDX::NullRenderDevice::CreateHeap(const D3D12_HEAP_DESC& desc)
+{
+    ++m_Stats.HeapsCreated;
+
+    ComPtr<ID3D12Heap> heap;
+    heap.Attach(new NullHeap(desc, m_NextGpuAddress));
+
+    constexpr UINT64 alignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+    m_NextGpuAddress += (desc.SizeInBytes + alignment - 1) & ~(alignment - 1);
+
+    return heap;
+}
+
+ComPtr<ID3D12Resource> RainDX::NullRenderDevice::CreatePlacedResource(
+    ID3D12Heap* heap,
+    UINT64 heapOffset,
+    const D3D12_RESOURCE_DESC& desc,
+    D3D12_RESOURCE_STATES initState,
+    const D3D12_CLEAR_VALUE* clearValue)
+{
+    ++m_Stats.PlacedResources;
+
+    auto* nullHeap = static_cast<NullHeap*>(heap);
+    D3D12_HEAP_DESC heapDesc = nullHeap->GetDesc();
+    assert(heapOffset + GetResourceAllocationInfo(desc).SizeInBytes <= heapDesc.SizeInBytes &&
+        "Placed resource exceeds the heap.");
+
+    ComPtr<ID3D12Resource> resource;
+    resource.Attach(new NullResource(heapDesc.Properties.Type, desc, nullHeap->Address() + heapOffset));
+    return resource;
+}
+
+D3D12_RESOURCE_ALLOCATION_INFO RainDX::NullRenderDevice::GetResourceAllocationInfo(const D3D12_RESOURCE_DESC& desc)
+{
+    // 缓冲区按 64KB, 多重采样纹理按 4MB, 其余纹理可以申请 4KB 对齐
+    UINT64 size = desc.Width;
+    UINT64 alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+    if (desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER)
+    {
+        UINT subresources = (std::max)(desc.MipLevels, static_cast<UINT16>(1));
+        if (desc.Dimension != D3D12_RESOURCE_DIMENSION_TEXTURE3D)
+            subresources *= desc.DepthOrArraySize;
+        GetCopyableFootprints(desc, 0, subresources, 0, nullptr, nullptr, nullptr, &size);
+
+        if (desc.SampleDesc.Count > 1)
+        {
+            size *= desc.SampleDesc.Count;
+            alignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+        }
+        else if (desc.Alignment == D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT &&
+            size <= D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT &&
+            (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) == 0)
+        {
+            alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+        }
+    }
+
+    D3D12_RESOURCE_ALLOCATION_INFO info;
+    info.Alignment = alignment;
+    info.SizeInBytes = (size + alignment - 1) & ~(alignment - 1);
+    return info;
+}
+
+ComPtr<ID3D12DescriptorHeap> RainDX::NullRenderDevice::CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC& desc)
+{
+    ComPtr<ID3D12DescriptorHeap> heap;
+    heap.Attach(new NullDescriptorHeap(desc, m_NextDescriptorAddress));
+    m_NextDescriptorAddress += static_cast<UINT64>(desc.NumDescriptors) * NullDescriptorSize;
+    return heap;
+}
+
+UINT RainDX::NullRenderDevice::DescriptorSize(D3D12_DESCRIPTOR_HEAP_TYPE type) const
+{
+    return NullDescriptorSize;
+}
+
+void RainDX::NullRenderDevice::CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC& desc,
+                                                        D3D12_CPU_DESCRIPTOR_HANDLE handle)
+{
+    ++m_Stats.DescriptorWrites;
+}
+
+void RainDX::NullRenderDevice::CopyDescriptors(UINT dstRangeCount, const D3D12_CPU_DESCRIPTOR_HANDLE* dstStarts,
+                                               const UINT* dstSizes, UINT srcRangeCount,
+                                               const D3D12_CPU_DESCRIPTOR_HANDLE* srcStarts, const UINT* srcSizes,
+                                               D3D12_DESCRIPTOR_HEAP_TYPE type)
+{
+    UINT64 dstCount = 0;
+    for (UINT i = 0; i < dstRangeCount; ++i)
+        dstCount += dstSizes != nullptr ? dstSizes[i] : 1;
+    UINT64 srcCount = 0;
+    for (UINT i = 0; i < srcRangeCount; ++i)
+        srcCount += srcSizes != nullptr ? srcSizes[i] : 1;
+    assert(dstCount == srcCount && "Descriptor copy ranges differ in size.");
+
+    ++m_Stats.DescriptorCopies;
+    m_Stats.DescriptorWrites += dstCount;
+}
+
+void RainDX::NullRenderDevice::GetCopyableFootprints(const D3D12_RESOURCE_DESC& desc,
+                                                     UINT firstSubresource, UINT numSubresources, UINT64 baseOffset,
+                                                     D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts, UINT* numRows,
+                                                     UINT64* rowSizes, UINT64* totalBytes)
+{
+    // 按未压缩格式计算, 行距 256 字节对齐, 子资源 512 字节对齐
+    UINT64 offset = baseOffset;
+    UINT mipLevels = (std::max)(desc.MipLevels, static_cast<UINT16>(1));
+    for (UINT i = 0; i < numSubresources; ++i)
+    {
+        UINT mip = (firstSubresource + i) % mipLevels;
+
+        UINT64 rowSize = desc.Width;
+        UINT height = 1;
+        UINT depth = 1;
+        if (desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER)
+        {
+            rowSize = (std::max)(desc.Width >> mip, static_cast<UINT64>(1)) * NullBytesPerPixel(desc.Format);
+            height = (std::max)(desc.Height >> mip, 1u);
+            if (desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D)
+                depth = (std::max)(static_cast<UINT>(desc.DepthOrArraySize) >> mip, 1u);
+        }
+        UINT64 rowPitch = (rowSize + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) &
+            ~static_cast<UINT64>(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+        offset = (offset + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) &
+            ~static_cast<UINT64>(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+
+        if (layouts != nullptr)
+        {
+            layouts[i].Offset = offset;
+            layouts[i].Footprint.Format = desc.Format;
+            layouts[i].Footprint.Width = static_cast<UINT>((std::max)(desc.Width >> mip, static_cast<UINT64>(1)));
+            layouts[i].Footprint.Height = height;
+            layouts[i].Footprint.Depth = depth;
+            layouts[i].Footprint.RowPitch = static_cast<UINT>(rowPitch);
+        }
+        if (numRows != nullptr)
+            numRows[i] = height;
+        if (rowSizes != nullptr)
+            rowSizes[i] = rowSize;
+
+        offset += rowPitch * height * depth;
+    }
+
+    if (totalBytes != nullptr)
+        *totalBytes = offset - baseOffset;
+}
+
+ComPtr<ID3D12CommandAllocator> RainDX::NullRenderDevice::CreateCmdAlloc()
+{
+    ComPtr<ID3D12CommandAllocator> alloc;
+    alloc.Attach(new NullCmdAlloc());
+    return alloc;
+}
+
+std::unique_ptr<RainDX::RenderCmdList> RainDX::NullRenderDevice::CreateCmdList(ID3D12CommandAllocator* alloc)
+{
+    return std::make_unique<NullRenderCmdList>();
+}
+
+void RainDX::NullRenderDevice::Execute(UINT count, RenderCmdList* const* lists)
+{
+    ++m_Stats.Submits;
+    for (UINT i = 0; i < count; ++i)
+    {
+        auto* list = static_cast<NullRenderCmdList*>(lists[i]);
+        ++m_Stats.CmdLists;
+        m_Stats += list->Stats();
+
+        if (m_Capture)
+            m_Captured.insert(m_Captured.end(), list->Commands().begin(), list->Commands().end());
+    }
+}
+
+RainDX::FrameFence* RainDX::NullRenderDevice::Fence()
+{
+    return &m_Fence;
+}
+
+ID3D12Device* RainDX::NullRenderDevice::Native() const
+{
+    return nullptr;
+}
+
+const RainDX::RenderStats& RainDX::NullRenderDevice::Stats() const
+{
+    return m_Stats;
+}
+
+void RainDX::NullRenderDevice::ResetStats()
+{
+    m_Stats = RenderStats();
+}
+
+void RainDX::NullRenderDevice::SetCapture(bool capture)
+{
+    m_Capture = capture;
+}
+
+const std::vector<RainDX::NullCmd>& RainDX::NullRenderDevice::Captured() const
+{
+    return m_Captured;
+}
+
+void RainDX::NullRenderDevice::ClearCaptured()
+{
+    m_Captured.clear();
+}
@@ -0,0 +1,485 @@
+#include "scene/Bvh.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using DirectX::XMFLOAT3;
+
+namespace
+{
+    constexpr float g_Infinity = std::numeric_limits<float>::infinity();
+
+    inline float Axis(const XMFLOAT3& v, int axis)
+    {
+        return (&v.x)[axis];
+    }
+
+    inline XMFLOAT3 Min3(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return XMFLOAT3((std::min)(a.x, b.x), (std::min)(a.y, b.y), (std::min)(a.z, b.z));
+    }
+
+    inline XMFLOAT3 Max3(const XMFLOAT3& a, const XMFLOAT3& b)
+    {
+        return XMFLOAT3((std::max)(a.x, b.x), (std::max)(a.y, b.y), (std::max)(a.z, b.z));
+    }
+
+    // 包围盒的半表面积, 只用于比较
+    inline float HalfArea(const XMFLOAT3& min, const XMFLOAT3& max)
+    {
+        float x = max.x - min.x;
+        float y = max.y - min.y;
+        float z = max.z - min.z;
+        return x * y + y * z + z * x;
+    }
+
+    struct Bin
+    {
+        XMFLOAT3 Min{g_Infinity, g_Infinity, g_Infinity};
+        XMFLOAT3 Max{-g_Infinity, -g_Infinity, -g_Infinity};
+        std::uint32_t Count = 0;
+    };
+
+    // 射线与包围盒的进入距离, 不相交时返回无穷大
+    inline float SlabTest(const XMFLOAT3& min, const XMFLOAT3& max,
+                          const XMFLOAT3& origin, const XMFLOAT3& invDir, float maxDistance)
+    {
+        float t0x = (min.x - origin.x) * invDir.x;
+        float t1x = (max.x - origin.x) * invDir.x;
+        float t0y = (min.y - origin.y) * invDir.y;
+        float t1y = (max.y - origin.y) * invDir.y;
+        float t0z = (min.z - origin.z) * invDir.z;
+        float t1z = (max.z - origin.z) * invDir.z;
+
+        float tNear = (std::max)((std::max)((std::min)(t0x, t1x), (std::min)(t0y, t1y)), (std::min)(t0z, t1z));
+        float tFar = (std::min)((std::min)((std::max)(t0x, t1x), (std::max)(t0y, t1y)), (std::max)(t0z, t1z));
+
+        tNear = (std::max)(tNear, 0.0f);
+        return tNear <= tFar && tNear <= maxDistance ? tNear : g_Infinity;
+    }
+}
+
+void RainDX::Bvh::Build(const DirectX::BoundingBox* boxes, std::size_t count, JobSystem* jobs)
+{
+    Clear();
+    if (count == 0)
+        return;
+
+    m_Indices.resize(count);
+    m_PrimMin.resize(count);
+    m_PrimMax.resize(count);
+    m_Centers.resize(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const DirectX::BoundingBox& box = boxes[i];
+        m_Indices[i] = static_cast<std::uint32_t>(i);
+        m_PrimMin[i] = XMFLOAT3(box.Center.x - box.Extents.x, box.Center.y - box.Extents.y, box.Center.z - box.Extents.z);
+        m_PrimMax[i] = XMFLOAT3(box.Center.x + box.Extents.x, box.Center.y + box.Extents.y, box.Center.z + box.Extents.z);
+        m_Centers[i] = box.Center;
+    }
+
+    // 二叉树最多 2n - 1 个节点, 子节点成对分配
+    m_BuildNodes.resize(2 * count);
+    m_BuildNodes[0].First = 0;
+    m_BuildNodes[0].Count = static_cast<std::uint32_t>(count);
+    m_BuildCount.store(1, std::memory_order_relaxed);
+
+    if (jobs != nullptr)
+    {
+        JobCounter counter;
+        Subdivide(0, jobs, &counter);
+        jobs->Wait(counter);
+    }
+    else
+    {
+        Subdivide(0, nullptr, nullptr);
+    }
+
+    // 按深度优先顺序重新排列
+    m_Nodes.reserve(m_BuildCount.load(std::memory_order_relaxed));
+    Flatten(0, 1);
+
+    m_BuildNodes.clear();
+    m_BuildNodes.shrink_to_fit();
+    m_Centers.clear();
+    m_Centers.shrink_to_fit();
+}
+
+void RainDX::Bvh::Refit(const DirectX::BoundingBox* boxes)
+{
+    for (std::size_t i = 0; i < m_PrimMin.size(); ++i)
+    {
+        const DirectX::BoundingBox& box = boxes[i];
+        m_PrimMin[i] = XMFLOAT3(box.Center.x - box.Extents.x, box.Center.y - box.Extents.y, box.Center.z - box.Extents.z);
+        m_PrimMax[i] = XMFLOAT3(box.Center.x + box.Extents.x, box.Center.y + box.Extents.y, box.Center.z + box.Extents.z);
+    }
+
+    // 子节点总在父节点之后, 倒序遍历即自底向上
+    for (std::size_t i = m_Nodes.size(); i-- > 0;)
+    {
+        BvhNode& node = m_Nodes[i];
+        if (node.IsLeaf())
+        {
+            XMFLOAT3 min(g_Infinity, g_Infinity, g_Infinity);
+            XMFLOAT3 max(-g_Infinity, -g_Infinity, -g_Infinity);
+            for (std::uint32_t k = 0; k < node.Count; ++k)
+            {
+                std::uint32_t prim = m_Indices[node.Offset + k];
+                min = Min3(min, m_PrimMin[prim]);
+                max = Max3(max, m_PrimMax[prim]);
+            }
+            node.Min = min;
+            node.Max = max;
+        }
+        else
+        {
+            const BvhNode& left = m_Nodes[i + 1];
+            const BvhNode& right = m_Nodes[node.Offset];
+            node.Min = Min3(left.Min, right.Min);
+            node.Max = Max3(left.Max, right.Max);
+        }
+    }
+}
+
+void RainDX::Bvh::Clear()
+{
+    m_Nodes.clear();
+    m_Indices.clear();
+    m_PrimMin.clear();
+    m_PrimMax.clear();
+    m_Depth = 0;
+}
+
+void RainDX::Bvh::QueryFrustum(const CullFrustum& frustum, std::vector<std::uint32_t>& visible) const
+{
+    if (m_Nodes.empty())
+        return;
+
+    // 每个节点带着仍需测试的平面掩码, 完全在某个平面内侧的子树不再测试该平面
+    struct Entry
+    {
+        std::uint32_t Node;
+        std::uint32_t Planes;
+    };
+    // 深度优先遍历时栈中最多同时有 Depth 个节点
+    std::vector<Entry> stack;
+    stack.reserve(m_Depth + 1);
+    stack.push_back({0, 0x3f});
+
+    while (!stack.empty())
+    {
+        Entry entry = stack.back();
+        stack.pop_back();
+        const BvhNode& node = m_Nodes[entry.Node];
+
+        float cx = 0.5f * (node.Min.x + node.Max.x);
+        float cy = 0.5f * (node.Min.y + node.Max.y);
+        float cz = 0.5f * (node.Min.z + node.Max.z);
+        float ex = 0.5f * (node.Max.x - node.Min.x);
+        float ey = 0.5f * (node.Max.y - node.Min.y);
+        float ez = 0.5f * (node.Max.z - node.Min.z);
+
+        bool culled = false;
+        std::uint32_t planes = entry.Planes;
+        for (int p = 0; p < 6 && !culled; ++p)
+        {
+            if ((planes & (1u << p)) == 0)
+                continue;
+            const DirectX::XMFLOAT4& plane = frustum.Planes[p];
+            float d = plane.x * cx + plane.y * cy + plane.z * cz + plane.w;
+            float r = std::fabs(plane.x) * ex + std::fabs(plane.y) * ey + std::fabs(plane.z) * ez;
+            if (d + r < 0.0f)
+                culled = true;
+            else if (d - r >= 0.0f)
+                planes &= ~(1u << p);
+        }
+        if (culled)
+            continue;
+
+        // 整个子树都在视锥内, 其图元是连续的一段
+        if (planes == 0)
+        {
+            std::uint32_t first = 0;
+            std::uint32_t last = 0;
+            SubtreeRange(entry.Node, first, last);
+            visible.insert(visible.end(), m_Indices.begin() + first, m_Indices.begin() + last);
+            continue;
+        }
+
+        if (node.IsLeaf())
+        {
+            for (std::uint32_t k = 0; k < node.Count; ++k)
+            {
+                std::uint32_t prim = m_Indices[node.Offset + k];
+                const XMFLOAT3& min = m_PrimMin[prim];
+                const XMFLOAT3& max = m_PrimMax[prim];
+                bool inside = true;
+                for (int p = 0; p < 6 && inside; ++p)
+                {
+                    if ((planes & (1u << p)) == 0)
+                        continue;
+                    const DirectX::XMFLOAT4& plane = frustum.Planes[p];
+                    // 平面法线方向上最远的角点
+                    float x = plane.x >= 0.0f ? max.x : min.x;
+                    float y = plane.y >= 0.0f ? max.y : min.y;
+                    float z = plane.z >= 0.0f ? max.z : min.z;
+                    inside = plane.x * x + plane.y * y + plane.z * z + plane.w >= 0.0f;
+                }
+                if (inside)
+                    visible.push_back(prim);
+            }
+            continue;
+        }
+
+        stack.push_back({node.Offset, planes});
+        stack.push_back({entry.Node + 1, planes});
+    }
+}
+
+bool RainDX::Bvh::Raycast(const XMFLOAT3& origin, const XMFLOAT3& direction, float maxDistance, BvhHit& hit) const
+{
+    if (m_Nodes.empty())
+        return false;
+
+    // 分量为 0 时得到无穷大, 平板测试仍然正确
+    XMFLOAT3 invDir(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+    float best = maxDistance;
+    bool found = false;
+
+    std::vector<std::uint32_t> stack;
+    stack.reserve(m_Depth + 1);
+    if (SlabTest(m_Nodes[0].Min, m_Nodes[0].Max, origin, invDir, best) != g_Infinity)
+        stack.push_back(0);
+
+    while (!stack.empty())
+    {
+        std::uint32_t index = stack.back();
+        stack.pop_back();
+        const BvhNode& node = m_Nodes[index];
+
+        if (node.IsLeaf())
+        {
+            for (std::uint32_t k = 0; k < node.Count; ++k)
+            {
+                std::uint32_t prim = m_Indices[node.Offset + k];
+                float t = SlabTest(m_PrimMin[prim], m_PrimMax[prim], origin, invDir, best);
+                if (t < best || (!found && t <= best))
+                {
+                    best = t;
+                    hit.Index = prim;
+                    hit.Distance = t;
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        std::uint32_t near = index + 1;
+        std::uint32_t far = node.Offset;
+        float tNear = SlabTest(m_Nodes[near].Min, m_Nodes[near].Max, origin, invDir, best);
+        float tFar = SlabTest(m_Nodes[far].Min, m_Nodes[far].Max, origin, invDir, best);
+        if (tFar < tNear)
+        {
+            std::swap(near, far);
+            std::swap(tNear, tFar);
+        }
+
+        // 先压入较远的子节点, 较近的先出栈, 命中后可以剪掉更远的子树
+        if (tFar != g_Infinity)
+            stack.push_back(far);
+        if (tNear != g_Infinity)
+            stack.push_back(near);
+    }
+
+    return found;
+}
+
+std::size_t RainDX::Bvh::Size() const
+{
+    return m_Indices.size();
+}
+
+const std::vector<RainDX::BvhNode>& RainDX::Bvh::Nodes() const
+{
+    return m_Nodes;
+}
+
+const std::vector<std::uint32_t>& RainDX::Bvh::Indices() const
+{
+    return m_Indices;
+}
+
+std::uint32_t RainDX::Bvh::Depth() const
+{
+    return m_Depth;
+}
+
+void RainDX::Bvh::Subdivide(std::uint32_t index, JobSystem* jobs, JobCounter* counter)
+{
+    BuildNode& node = m_BuildNodes[index];
+
+    // 节点包围盒和图元中心的包围盒
+    XMFLOAT3 min(g_Infinity, g_Infinity, g_Infinity);
+    XMFLOAT3 max(-g_Infinity, -g_Infinity, -g_Infinity);
+    XMFLOAT3 centerMin = min;
+    XMFLOAT3 centerMax = max;
+    for (std::uint32_t i = node.First; i < node.First + node.Count; ++i)
+    {
+        std::uint32_t prim = m_Indices[i];
+        min = Min3(min, m_PrimMin[prim]);
+        max = Max3(max, m_PrimMax[prim]);
+        centerMin = Min3(centerMin, m_Centers[prim]);
+        centerMax = Max3(centerMax, m_Centers[prim]);
+    }
+    node.Min = min;
+    node.Max = max;
+
+    if (node.Count <= 1)
+        return;
+
+    // 三个轴在同一遍中分桶, 每个图元只读取一次
+    Bin bins[3][BinCount];
+    float scales[3];
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        float extent = Axis(centerMax, axis) - Axis(centerMin, axis);
+        scales[axis] = extent > 0.0f ? BinCount / extent : 0.0f;
+    }
+    for (std::uint32_t i = node.First; i < node.First + node.Count; ++i)
+    {
+        std::uint32_t prim = m_Indices[i];
+        const XMFLOAT3& primMin = m_PrimMin[prim];
+        const XMFLOAT3& primMax = m_PrimMax[prim];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float offset = Axis(m_Centers[prim], axis) - Axis(centerMin, axis);
+            int b = (std::min)(static_cast<int>(offset * scales[axis]), BinCount - 1);
+            Bin& bin = bins[axis][b];
+            bin.Min = Min3(bin.Min, primMin);
+            bin.Max = Max3(bin.Max, primMax);
+            ++bin.Count;
+        }
+    }
+
+    // 找代价最小的划分
+    int bestAxis = -1;
+    int bestSplit = 0;
+    float bestCost = g_Infinity;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (scales[axis] == 0.0f)
+            continue;
+
+        // 从右向左累积右侧的面积
+        float rightArea[BinCount];
+        std::uint32_t rightCount[BinCount];
+        Bin accum;
+        for (int b = BinCount - 1; b > 0; --b)
+        {
+            accum.Min = Min3(accum.Min, bins[axis][b].Min);
+            accum.Max = Max3(accum.Max, bins[axis][b].Max);
+            accum.Count += bins[axis][b].Count;
+            rightArea[b] = accum.Count > 0 ? HalfArea(accum.Min, accum.Max) : 0.0f;
+            rightCount[b] = accum.Count;
+        }
+
+        accum = Bin();
+        for (int b = 0; b < BinCount - 1; ++b)
+        {
+            accum.Min = Min3(accum.Min, bins[axis][b].Min);
+            accum.Max = Max3(accum.Max, bins[axis][b].Max);
+            accum.Count += bins[axis][b].Count;
+            if (accum.Count == 0 || rightCount[b + 1] == 0)
+                continue;
+
+            float cost = HalfArea(accum.Min, accum.Max) * accum.Count + rightArea[b + 1] * rightCount[b + 1];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = b + 1;
+            }
+        }
+    }
+
+    // 划分的代价为一次遍历加上两侧按面积比例的相交测试, 不比叶节点便宜时停止
+    // 叶节点过大时仍然强制划分
+    float area = HalfArea(min, max);
+    float splitCost = area > 0.0f ? TraversalCost + bestCost / area : TraversalCost;
+    if (splitCost >= node.Count && node.Count <= MaxLeafSize)
+        return;
+
+    std::uint32_t* begin = m_Indices.data() + node.First;
+    std::uint32_t* end = begin + node.Count;
+    std::uint32_t* middle = begin;
+    if (bestAxis >= 0)
+    {
+        float lo = Axis(centerMin, bestAxis);
+        float scale = scales[bestAxis];
+        middle = std::partition(begin, end, [&](std::uint32_t prim)
+        {
+            int b = (std::min)(static_cast<int>((Axis(m_Centers[prim], bestAxis) - lo) * scale), BinCount - 1);
+            return b < bestSplit;
+        });
+    }
+
+    // 所有中心重合时无法按位置划分, 按数量对半分
+    if (middle == begin || middle == end)
+        middle = begin + node.Count / 2;
+
+    std::uint32_t leftCount = static_cast<std::uint32_t>(middle - begin);
+    std::uint32_t left = m_BuildCount.fetch_add(2, std::memory_order_relaxed);
+    m_BuildNodes[left].First = node.First;
+    m_BuildNodes[left].Count = leftCount;
+    m_BuildNodes[left + 1].First = node.First + leftCount;
+    m_BuildNodes[left + 1].Count = node.Count - leftCount;
+    node.Left = left;
+    node.Count = 0;
+
+    // 大的右子树交给其他线程, 左子树继续在当前线程划分
+    std::uint32_t rightCountPrims = m_BuildNodes[left + 1].Count;
+    if (jobs != nullptr && rightCountPrims >= ParallelThreshold)
+        jobs->Run([this, left, jobs, counter] { Subdivide(left + 1, jobs, counter); }, counter);
+    else
+        Subdivide(left + 1, jobs, counter);
+    Subdivide(left, jobs, counter);
+}
+
+std::uint32_t RainDX::Bvh::Flatten(std::uint32_t index, std::uint32_t depth)
+{
+    const BuildNode& build = m_BuildNodes[index];
+    std::uint32_t out = static_cast<std::uint32_t>(m_Nodes.size());
+    m_Depth = (std::max)(m_Depth, depth);
+
+    BvhNode node;
+    node.Min = build.Min;
+    node.Max = build.Max;
+    m_Nodes.push_back(node);
+
+    if (build.Count > 0)
+    {
+        m_Nodes[out].Offset = build.First;
+        m_Nodes[out].Count = build.Count;
+        return out;
+    }
+
+    Flatten(build.Left, depth + 1);
+    std::uint32_t right = Flatten(build.Left + 1, depth + 1);
+    m_Nodes[out].Offset = right;
+    return out;
+}
+
+void RainDX::Bvh::SubtreeRange(std::uint32_t index, std::uint32_t& first, std::uint32_t& last) const
+{
+    // 最左的叶节点给出起点, 最右的叶节点给出终点
+    std::uint32_t left = index;
+    while (!m_Nodes[left].IsLeaf())
+        ++left;
+    std::uint32_t right = index;
+    while (!m_Nodes[right].IsLeaf())
+        right = m_Nodes[right].Offset;
+
+    first = m_Nodes[left].Offset;
+    last = m_Nodes[right].Offset + m_Nodes[right].Count;
+}
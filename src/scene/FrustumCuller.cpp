@@ -0,0 +1,341 @@
+#include "scene/FrustumCuller.h"
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+#include <limits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+// MSVC 不需要 /arch:AVX 也能使用 AVX 内建函数, 运行时检测后再调用
+#define RAINDX_TARGET_AVX
+#else
+#define RAINDX_TARGET_AVX __attribute__((target("avx")))
+#endif
+
+namespace
+{
+    using RainDX::CullFrustum;
+
+    // 补齐的盒子中心为 NaN, 所有比较都为假, 因此总是被裁掉
+    const float g_PadValue = std::numeric_limits<float>::quiet_NaN();
+
+    struct BoxArrays
+    {
+        const float* Cx;
+        const float* Cy;
+        const float* Cz;
+        const float* Ex;
+        const float* Ey;
+        const float* Ez;
+    };
+
+    // 可见的组内编号按位写入 mask, 不分支地追加到输出
+    inline std::size_t Emit(unsigned mask, std::uint32_t base, std::size_t lanes, std::uint32_t* out)
+    {
+        std::size_t n = 0;
+        for (std::size_t k = 0; k < lanes; ++k)
+        {
+            out[n] = base + static_cast<std::uint32_t>(k);
+            n += (mask >> k) & 1u;
+        }
+        return n;
+    }
+
+    std::size_t CullScalar(const CullFrustum& frustum, const BoxArrays& boxes,
+                           std::size_t first, std::size_t last, std::uint32_t* out)
+    {
+        std::size_t n = 0;
+        for (std::size_t i = first; i < last; ++i)
+        {
+            bool inside = true;
+            for (const DirectX::XMFLOAT4& p : frustum.Planes)
+            {
+                // 中心到平面的距离加上盒子在法线方向上的投影半径
+                float d = p.x * boxes.Cx[i] + p.y * boxes.Cy[i] + p.z * boxes.Cz[i] + p.w;
+                float r = std::fabs(p.x) * boxes.Ex[i] + std::fabs(p.y) * boxes.Ey[i] + std::fabs(p.z) * boxes.Ez[i];
+                inside = inside && d + r >= 0.0f;
+            }
+            out[n] = static_cast<std::uint32_t>(i);
+            n += inside ? 1 : 0;
+        }
+        return n;
+    }
+
+    std::size_t CullSse(const CullFrustum& frustum, const BoxArrays& boxes,
+                        std::size_t first, std::size_t last, std::uint32_t* out)
+    {
+        __m128 nx[6], ny[6], nz[6], ax[6], ay[6], az[6], w[6];
+        for (int p = 0; p < 6; ++p)
+        {
+            const DirectX::XMFLOAT4& plane = frustum.Planes[p];
+            nx[p] = _mm_set1_ps(plane.x);
+            ny[p] = _mm_set1_ps(plane.y);
+            nz[p] = _mm_set1_ps(plane.z);
+            ax[p] = _mm_set1_ps(std::fabs(plane.x));
+            ay[p] = _mm_set1_ps(std::fabs(plane.y));
+            az[p] = _mm_set1_ps(std::fabs(plane.z));
+            w[p] = _mm_set1_ps(plane.w);
+        }
+
+        const __m128 zero = _mm_setzero_ps();
+        std::size_t n = 0;
+        for (std::size_t i = first; i < last; i += 4)
+        {
+            __m128 cx = _mm_loadu_ps(boxes.Cx + i);
+            __m128 cy = _mm_loadu_ps(boxes.Cy + i);
+            __m128 cz = _mm_loadu_ps(boxes.Cz + i);
+            __m128 ex = _mm_loadu_ps(boxes.Ex + i);
+            __m128 ey = _mm_loadu_ps(boxes.Ey + i);
+            __m128 ez = _mm_loadu_ps(boxes.Ez + i);
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p)
+            {
+                __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], cx), _mm_mul_ps(ny[p], cy)),
+                                      _mm_add_ps(_mm_mul_ps(nz[p], cz), w[p]));
+                __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey)),
+                                      _mm_mul_ps(az[p], ez));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), zero));
+            }
+
+            n += Emit(static_cast<unsigned>(_mm_movemask_ps(inside)), static_cast<std::uint32_t>(i), 4, out + n);
+        }
+        return n;
+    }
+
+    RAINDX_TARGET_AVX
+    std::size_t CullAvx(const CullFrustum& frustum, const BoxArrays& boxes,
+                        std::size_t first, std::size_t last, std::uint32_t* out)
+    {
+        __m256 nx[6], ny[6], nz[6], ax[6], ay[6], az[6], w[6];
+        for (int p = 0; p < 6; ++p)
+        {
+            const DirectX::XMFLOAT4& plane = frustum.Planes[p];
+            nx[p] = _mm256_set1_ps(plane.x);
+            ny[p] = _mm256_set1_ps(plane.y);
+            nz[p] = _mm256_set1_ps(plane.z);
+            ax[p] = _mm256_set1_ps(std::fabs(plane.x));
+            ay[p] = _mm256_set1_ps(std::fabs(plane.y));
+            az[p] = _mm256_set1_ps(std::fabs(plane.z));
+            w[p] = _mm256_set1_ps(plane.w);
+        }
+
+        const __m256 zero = _mm256_setzero_ps();
+        std::size_t n = 0;
+        for (std::size_t i = first; i < last; i += 8)
+        {
+            __m256 cx = _mm256_loadu_ps(boxes.Cx + i);
+            __m256 cy = _mm256_loadu_ps(boxes.Cy + i);
+            __m256 cz = _mm256_loadu_ps(boxes.Cz + i);
+            __m256 ex = _mm256_loadu_ps(boxes.Ex + i);
+            __m256 ey = _mm256_loadu_ps(boxes.Ey + i);
+            __m256 ez = _mm256_loadu_ps(boxes.Ez + i);
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p)
+            {
+                __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx[p], cx), _mm256_mul_ps(ny[p], cy)),
+                                         _mm256_add_ps(_mm256_mul_ps(nz[p], cz), w[p]));
+                __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax[p], ex), _mm256_mul_ps(ay[p], ey)),
+                                         _mm256_mul_ps(az[p], ez));
+                // 有序比较, NaN 视为不可见
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, r), zero, _CMP_GE_OQ));
+            }
+
+            n += Emit(static_cast<unsigned>(_mm256_movemask_ps(inside)), static_cast<std::uint32_t>(i), 8, out + n);
+        }
+        return n;
+    }
+}
+
+RainDX::CullFrustum RainDX::CullFrustum::FromViewProj(const DirectX::XMFLOAT4X4& viewProj)
+{
+    // 行向量约定下 clip = v * M, 平面由 M 的列组合得到
+    auto column = [&viewProj](int j)
+    {
+        return DirectX::XMFLOAT4(viewProj.m[0][j], viewProj.m[1][j], viewProj.m[2][j], viewProj.m[3][j]);
+    };
+    auto combine = [](const DirectX::XMFLOAT4& a, const DirectX::XMFLOAT4& b, float s)
+    {
+        return DirectX::XMFLOAT4(a.x + s * b.x, a.y + s * b.y, a.z + s * b.z, a.w + s * b.w);
+    };
+
+    DirectX::XMFLOAT4 c0 = column(0);
+    DirectX::XMFLOAT4 c1 = column(1);
+    DirectX::XMFLOAT4 c2 = column(2);
+    DirectX::XMFLOAT4 c3 = column(3);
+
+    CullFrustum frustum;
+    frustum.Planes[0] = combine(c3, c0, 1.0f);   // 左
+    frustum.Planes[1] = combine(c3, c0, -1.0f);  // 右
+    frustum.Planes[2] = combine(c3, c1, 1.0f);   // 下
+    frustum.Planes[3] = combine(c3, c1, -1.0f);  // 上
+    frustum.Planes[4] = c2;                      // 近
+    frustum.Planes[5] = combine(c3, c2, -1.0f);  // 远
+
+    for (DirectX::XMFLOAT4& p : frustum.Planes)
+    {
+        float length = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+        if (length > 0.0f)
+        {
+            p.x /= length;
+            p.y /= length;
+            p.z /= length;
+            p.w /= length;
+        }
+    }
+
+    return frustum;
+}
+
+RainDX::FrustumCuller::FrustumCuller() : m_Simd(BestSimd())
+{
+}
+
+void RainDX::FrustumCuller::Clear()
+{
+    m_Count = 0;
+    m_CenterX.clear();
+    m_CenterY.clear();
+    m_CenterZ.clear();
+    m_ExtentX.clear();
+    m_ExtentY.clear();
+    m_ExtentZ.clear();
+}
+
+void RainDX::FrustumCuller::Reserve(std::size_t count)
+{
+    std::size_t padded = (count + GroupSize - 1) / GroupSize * GroupSize;
+    m_CenterX.reserve(padded);
+    m_CenterY.reserve(padded);
+    m_CenterZ.reserve(padded);
+    m_ExtentX.reserve(padded);
+    m_ExtentY.reserve(padded);
+    m_ExtentZ.reserve(padded);
+}
+
+std::uint32_t RainDX::FrustumCuller::Add(const DirectX::BoundingBox& box)
+{
+    std::uint32_t index = static_cast<std::uint32_t>(m_Count++);
+
+    // 新开一组时整组先填充补齐值
+    if (index % GroupSize == 0)
+    {
+        std::size_t padded = m_CenterX.size() + GroupSize;
+        m_CenterX.resize(padded, g_PadValue);
+        m_CenterY.resize(padded, g_PadValue);
+        m_CenterZ.resize(padded, g_PadValue);
+        m_ExtentX.resize(padded, 0.0f);
+        m_ExtentY.resize(padded, 0.0f);
+        m_ExtentZ.resize(padded, 0.0f);
+    }
+
+    Set(index, box);
+    return index;
+}
+
+void RainDX::FrustumCuller::Set(std::uint32_t index, const DirectX::BoundingBox& box)
+{
+    m_CenterX[index] = box.Center.x;
+    m_CenterY[index] = box.Center.y;
+    m_CenterZ[index] = box.Center.z;
+    m_ExtentX[index] = box.Extents.x;
+    m_ExtentY[index] = box.Extents.y;
+    m_ExtentZ[index] = box.Extents.z;
+}
+
+std::size_t RainDX::FrustumCuller::Size() const
+{
+    return m_Count;
+}
+
+std::size_t RainDX::FrustumCuller::Cull(const CullFrustum& frustum, std::uint32_t* visible) const
+{
+    return CullGroups(frustum, 0, m_CenterX.size() / GroupSize, visible);
+}
+
+std::size_t RainDX::FrustumCuller::Cull(JobSystem& jobs, const CullFrustum& frustum,
+                                        std::vector<std::uint32_t>& visible) const
+{
+    std::size_t groups = m_CenterX.size() / GroupSize;
+    constexpr std::size_t groupsPerJob = BoxesPerJob / GroupSize;
+    std::size_t jobCount = (groups + groupsPerJob - 1) / groupsPerJob;
+
+    // 每块写到输出中与输入相同的位置, 块之间互不重叠, 最后再向前拼接
+    visible.resize(m_CenterX.size() + GroupSize);
+    std::vector<std::size_t> counts(jobCount);
+    std::uint32_t* out = visible.data();
+    jobs.ParallelFor(0, jobCount, 1, [&](std::size_t firstJob, std::size_t lastJob)
+    {
+        for (std::size_t job = firstJob; job < lastJob; ++job)
+        {
+            std::size_t first = job * groupsPerJob;
+            std::size_t last = (std::min)(first + groupsPerJob, groups);
+            counts[job] = CullGroups(frustum, first, last, out + first * GroupSize);
+        }
+    });
+
+    std::size_t total = 0;
+    for (std::size_t job = 0; job < jobCount; ++job)
+    {
+        std::uint32_t* src = out + job * BoxesPerJob;
+        if (src != out + total)
+            std::copy(src, src + counts[job], out + total);
+        total += counts[job];
+    }
+
+    visible.resize(total);
+    return total;
+}
+
+RainDX::CullSimd RainDX::FrustumCuller::Simd() const
+{
+    return m_Simd;
+}
+
+void RainDX::FrustumCuller::SetSimd(CullSimd simd)
+{
+    // 不能超过 CPU 实际支持的指令集
+    m_Simd = static_cast<int>(simd) <= static_cast<int>(BestSimd()) ? simd : BestSimd();
+}
+
+RainDX::CullSimd RainDX::FrustumCuller::BestSimd()
+{
+    static const CullSimd best = []
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        // 需要 CPU 支持 AVX 且操作系统保存 YMM 寄存器
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (osxsave && avx && (_xgetbv(0) & 6) == 6)
+            return CullSimd::Avx;
+#else
+        if (__builtin_cpu_supports("avx"))
+            return CullSimd::Avx;
+#endif
+        // x64 总是支持 SSE2
+        return CullSimd::Sse;
+    }();
+    return best;
+}
+
+std::size_t RainDX::FrustumCuller::CullGroups(const CullFrustum& frustum, std::size_t firstGroup,
+                                              std::size_t lastGroup, std::uint32_t* visible) const
+{
+    BoxArrays boxes{m_CenterX.data(), m_CenterY.data(), m_CenterZ.data(),
+                    m_ExtentX.data(), m_ExtentY.data(), m_ExtentZ.data()};
+    std::size_t first = firstGroup * GroupSize;
+    std::size_t last = lastGroup * GroupSize;
+
+    switch (m_Simd)
+    {
+    case CullSimd::Avx:
+        return CullAvx(frustum, boxes, first, last, visible);
+    case CullSimd::Sse:
+        return CullSse(frustum, boxes, first, last, visible);
+    default:
+        return CullScalar(frustum, boxes, first, last, visible);
+    }
+}
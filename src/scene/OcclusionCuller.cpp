@@ -0,0 +1,298 @@
+#include "scene/OcclusionCuller.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+
+namespace
+{
+    // 近平面附近的 w, 小于它的顶点无法安全投影
+    constexpr float g_MinW = 1e-4f;
+
+    // 行向量乘矩阵
+    inline void Transform(const float m[4][4], float x, float y, float z, float out[4])
+    {
+        for (int j = 0; j < 4; ++j)
+            out[j] = x * m[0][j] + y * m[1][j] + z * m[2][j] + m[3][j];
+    }
+
+    inline void Multiply(const float a[4][4], const float b[4][4], float out[4][4])
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = 0; j < 4; ++j)
+                out[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j] + a[i][2] * b[2][j] + a[i][3] * b[3][j];
+        }
+    }
+}
+
+RainDX::OcclusionCuller::OcclusionCuller(int width, int height) :
+    m_Width((width + 3) & ~3), m_Height(height)
+{
+    int w = m_Width;
+    int h = m_Height;
+    for (;;)
+    {
+        m_LevelWidth.push_back(w);
+        m_LevelHeight.push_back(h);
+        m_Levels.emplace_back(static_cast<std::size_t>(w) * h, 1.0f);
+        if (w == 1 && h == 1)
+            break;
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+    }
+}
+
+void RainDX::OcclusionCuller::Begin(const DirectX::XMFLOAT4X4& viewProj)
+{
+    memcpy(m_ViewProj, viewProj.m, sizeof(m_ViewProj));
+    std::fill(m_Levels[0].begin(), m_Levels[0].end(), 1.0f);
+    m_Triangles = 0;
+}
+
+void RainDX::OcclusionCuller::AddOccluder(const void* vertices, std::size_t stride, const std::uint16_t* indices,
+                                          std::size_t indexCount, const DirectX::XMFLOAT4X4& world)
+{
+    Rasterize(vertices, stride, indices, indexCount, world);
+}
+
+void RainDX::OcclusionCuller::AddOccluder(const void* vertices, std::size_t stride, const std::uint32_t* indices,
+                                          std::size_t indexCount, const DirectX::XMFLOAT4X4& world)
+{
+    Rasterize(vertices, stride, indices, indexCount, world);
+}
+
+void RainDX::OcclusionCuller::End()
+{
+    // 上一层 2x2 像素取最大深度, 奇数边界重复最后一行或一列
+    for (std::size_t level = 1; level < m_Levels.size(); ++level)
+    {
+        const std::vector<float>& src = m_Levels[level - 1];
+        std::vector<float>& dst = m_Levels[level];
+        int srcWidth = m_LevelWidth[level - 1];
+        int srcHeight = m_LevelHeight[level - 1];
+        int width = m_LevelWidth[level];
+        int height = m_LevelHeight[level];
+
+        for (int y = 0; y < height; ++y)
+        {
+            int y0 = 2 * y;
+            int y1 = (std::min)(y0 + 1, srcHeight - 1);
+            for (int x = 0; x < width; ++x)
+            {
+                int x0 = 2 * x;
+                int x1 = (std::min)(x0 + 1, srcWidth - 1);
+                float a = (std::max)(src[y0 * srcWidth + x0], src[y0 * srcWidth + x1]);
+                float b = (std::max)(src[y1 * srcWidth + x0], src[y1 * srcWidth + x1]);
+                dst[y * width + x] = (std::max)(a, b);
+            }
+        }
+    }
+}
+
+bool RainDX::OcclusionCuller::IsVisible(const DirectX::BoundingBox& box) const
+{
+    float minX = static_cast<float>(m_Width);
+    float minY = static_cast<float>(m_Height);
+    float maxX = 0.0f;
+    float maxY = 0.0f;
+    float minZ = 1.0f;
+
+    // 投影八个角点, 取屏幕矩形和最近的深度
+    for (int i = 0; i < 8; ++i)
+    {
+        float x = box.Center.x + ((i & 1) ? box.Extents.x : -box.Extents.x);
+        float y = box.Center.y + ((i & 2) ? box.Extents.y : -box.Extents.y);
+        float z = box.Center.z + ((i & 4) ? box.Extents.z : -box.Extents.z);
+        float clip[4];
+        Transform(m_ViewProj, x, y, z, clip);
+        if (clip[3] < g_MinW)
+            return true;
+
+        float invW = 1.0f / clip[3];
+        float sx = (clip[0] * invW * 0.5f + 0.5f) * m_Width;
+        float sy = (0.5f - clip[1] * invW * 0.5f) * m_Height;
+        minX = (std::min)(minX, sx);
+        maxX = (std::max)(maxX, sx);
+        minY = (std::min)(minY, sy);
+        maxY = (std::max)(maxY, sy);
+        minZ = (std::min)(minZ, clip[2] * invW);
+    }
+
+    int x0 = (std::max)(static_cast<int>(std::floor(minX)), 0);
+    int y0 = (std::max)(static_cast<int>(std::floor(minY)), 0);
+    int x1 = (std::min)(static_cast<int>(std::floor(maxX)), m_Width - 1);
+    int y1 = (std::min)(static_cast<int>(std::floor(maxY)), m_Height - 1);
+    // 完全在屏幕外
+    if (x0 > x1 || y0 > y1)
+        return false;
+
+    // 选择覆盖范围不超过 4x4 个像素的层
+    int level = 0;
+    while ((x1 >> level) - (x0 >> level) > 3 || (y1 >> level) - (y0 >> level) > 3)
+        ++level;
+
+    const std::vector<float>& depth = m_Levels[level];
+    int width = m_LevelWidth[level];
+    for (int y = y0 >> level; y <= (y1 >> level); ++y)
+    {
+        for (int x = x0 >> level; x <= (x1 >> level); ++x)
+        {
+            if (minZ <= depth[y * width + x])
+                return true;
+        }
+    }
+    return false;
+}
+
+std::size_t RainDX::OcclusionCuller::Filter(const DirectX::BoundingBox* boxes, const std::uint32_t* indices,
+                                            std::size_t count, std::uint32_t* visible) const
+{
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        std::uint32_t index = indices[i];
+        if (IsVisible(boxes[index]))
+            visible[n++] = index;
+    }
+    return n;
+}
+
+int RainDX::OcclusionCuller::Width() const
+{
+    return m_Width;
+}
+
+int RainDX::OcclusionCuller::Height() const
+{
+    return m_Height;
+}
+
+const float* RainDX::OcclusionCuller::Depth(int level) const
+{
+    return m_Levels[level].data();
+}
+
+int RainDX::OcclusionCuller::LevelCount() const
+{
+    return static_cast<int>(m_Levels.size());
+}
+
+std::uint64_t RainDX::OcclusionCuller::TrianglesRasterized() const
+{
+    return m_Triangles;
+}
+
+std::uint64_t RainDX::OcclusionCuller::DepthHash() const
+{
+    // FNV-1a
+    std::uint64_t hash = 14695981039346656037ull;
+    const auto* bytes = reinterpret_cast<const unsigned char*>(m_Levels[0].data());
+    std::size_t size = m_Levels[0].size() * sizeof(float);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+template <typename Index>
+void RainDX::OcclusionCuller::Rasterize(const void* vertices, std::size_t stride, const Index* indices,
+                                        std::size_t indexCount, const DirectX::XMFLOAT4X4& world)
+{
+    float worldViewProj[4][4];
+    Multiply(world.m, m_ViewProj, worldViewProj);
+
+    const auto* base = static_cast<const unsigned char*>(vertices);
+    for (std::size_t i = 0; i + 2 < indexCount; i += 3)
+    {
+        float screen[3][3];
+        bool clipped = false;
+        for (int k = 0; k < 3; ++k)
+        {
+            const auto* p = reinterpret_cast<const float*>(base + indices[i + k] * stride);
+            float clip[4];
+            Transform(worldViewProj, p[0], p[1], p[2], clip);
+            // 穿过近平面的三角形直接跳过, 少画遮挡物只会让结果更保守
+            if (clip[3] < g_MinW || clip[2] < 0.0f)
+            {
+                clipped = true;
+                break;
+            }
+            float invW = 1.0f / clip[3];
+            screen[k][0] = (clip[0] * invW * 0.5f + 0.5f) * m_Width;
+            screen[k][1] = (0.5f - clip[1] * invW * 0.5f) * m_Height;
+            screen[k][2] = clip[2] * invW;
+        }
+        if (!clipped)
+            RasterizeTriangle(screen[0], screen[1], screen[2]);
+    }
+}
+
+void RainDX::OcclusionCuller::RasterizeTriangle(const float* v0, const float* v1, const float* v2)
+{
+    // 屏幕 y 向下时顺时针的面积为正, 其余为背面或退化
+    float area = (v1[0] - v0[0]) * (v2[1] - v0[1]) - (v2[0] - v0[0]) * (v1[1] - v0[1]);
+    if (area <= 0.0f)
+        return;
+
+    int minX = (std::max)(static_cast<int>(std::floor((std::min)({v0[0], v1[0], v2[0]}))), 0);
+    int maxX = (std::min)(static_cast<int>(std::ceil((std::max)({v0[0], v1[0], v2[0]}))), m_Width - 1);
+    int minY = (std::max)(static_cast<int>(std::floor((std::min)({v0[1], v1[1], v2[1]}))), 0);
+    int maxY = (std::min)(static_cast<int>(std::ceil((std::max)({v0[1], v1[1], v2[1]}))), m_Height - 1);
+    if (minX > maxX || minY > maxY)
+        return;
+    ++m_Triangles;
+
+    // 边函数 E(x, y) = A x + B y + C, 在三角形内部三者都非负
+    // E0 对着 v0, 其值与 v0 的重心坐标成正比
+    float a0 = v1[1] - v2[1], b0 = v2[0] - v1[0], c0 = v1[0] * v2[1] - v2[0] * v1[1];
+    float a1 = v2[1] - v0[1], b1 = v0[0] - v2[0], c1 = v2[0] * v0[1] - v0[0] * v2[1];
+    float a2 = v0[1] - v1[1], b2 = v1[0] - v0[0], c2 = v0[0] * v1[1] - v1[0] * v0[1];
+
+    // 深度平面 z = za x + zb y + zc
+    float invArea = 1.0f / area;
+    float za = (a0 * v0[2] + a1 * v1[2] + a2 * v2[2]) * invArea;
+    float zb = (b0 * v0[2] + b1 * v1[2] + b2 * v2[2]) * invArea;
+    float zc = (c0 * v0[2] + c1 * v1[2] + c2 * v2[2]) * invArea;
+
+    // 每次处理一行中相邻的 4 个像素, 在像素中心求值
+    const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 stepE0 = _mm_set1_ps(4.0f * a0);
+    const __m128 stepE1 = _mm_set1_ps(4.0f * a1);
+    const __m128 stepE2 = _mm_set1_ps(4.0f * a2);
+    const __m128 stepZ = _mm_set1_ps(4.0f * za);
+
+    float* depth = m_Levels[0].data();
+    int startX = minX & ~3;
+    for (int y = minY; y <= maxY; ++y)
+    {
+        float py = y + 0.5f;
+        __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(startX)), offsets);
+        __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a0), px), _mm_set1_ps(b0 * py + c0));
+        __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a1), px), _mm_set1_ps(b1 * py + c1));
+        __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a2), px), _mm_set1_ps(b2 * py + c2));
+        __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(za), px), _mm_set1_ps(zb * py + zc));
+
+        float* row = depth + y * m_Width;
+        for (int x = startX; x <= maxX; x += 4)
+        {
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+                                       _mm_cmpge_ps(e2, zero));
+            if (_mm_movemask_ps(inside) != 0)
+            {
+                // 覆盖的像素取较近的深度
+                __m128 old = _mm_loadu_ps(row + x);
+                __m128 nearer = _mm_min_ps(old, z);
+                _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+            }
+
+            e0 = _mm_add_ps(e0, stepE0);
+            e1 = _mm_add_ps(e1, stepE1);
+            e2 = _mm_add_ps(e2, stepE2);
+            z = _mm_add_ps(z, stepZ);
+        }
+    }
+}
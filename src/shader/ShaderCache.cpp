@@ -0,0 +1,248 @@
+#include "shader/ShaderCache.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_set>
+
+namespace
+{
+    // 条目文件头, 之后依次是键的文本和字节码
+    static constexpr std::uint32_t EntryMagic = 0x43534452; // "RDSC"
+    static constexpr std::uint32_t EntryVersion = 1;
+
+    struct EntryHeader
+    {
+        std::uint32_t Magic = EntryMagic;
+        std::uint32_t Version = EntryVersion;
+        std::uint64_t KeyHash = 0;
+        std::uint32_t TextSize = 0;
+        std::uint32_t BytecodeSize = 0;
+    };
+
+    std::string ToHex(std::uint64_t value)
+    {
+        static const char digits[] = "0123456789abcdef";
+        std::string text(16, '0');
+        for (int i = 15; i >= 0; --i)
+        {
+            text[i] = digits[value & 0xf];
+            value >>= 4;
+        }
+        return text;
+    }
+
+    bool IsSpace(char c)
+    {
+        return c == ' ' || c == '\t';
+    }
+
+    // 找出形如 #include "name" 或 #include <name> 的行
+    // 不区分条件编译的分支, 宁可多算依赖也不能漏掉
+    void FindIncludes(const std::string& source, std::vector<std::string>& names)
+    {
+        std::size_t pos = 0;
+        while (pos < source.size())
+        {
+            std::size_t end = source.find('\n', pos);
+            if (end == std::string::npos)
+                end = source.size();
+
+            std::size_t i = pos;
+            while (i < end && IsSpace(source[i]))
+                ++i;
+            if (i < end && source[i] == '#')
+            {
+                ++i;
+                while (i < end && IsSpace(source[i]))
+                    ++i;
+                if (source.compare(i, 7, "include") == 0)
+                {
+                    i += 7;
+                    while (i < end && IsSpace(source[i]))
+                        ++i;
+                    if (i < end && (source[i] == '"' || source[i] == '<'))
+                    {
+                        char close = source[i] == '"' ? '"' : '>';
+                        std::size_t last = source.find(close, i + 1);
+                        if (last != std::string::npos && last < end)
+                            names.push_back(source.substr(i + 1, last - i - 1));
+                    }
+                }
+            }
+            pos = end + 1;
+        }
+    }
+}
+
+RainDX::ShaderCache::ShaderCache(const std::wstring& directory, std::string compiler, SourceReader reader) :
+    m_Directory(directory),
+    m_Compiler(std::move(compiler)),
+    m_Reader(std::move(reader))
+{
+}
+
+RainDX::ShaderKey RainDX::ShaderCache::ComputeKey(const ShaderRequest& request) const
+{
+    ShaderKey key;
+    std::string& text = key.Text;
+    text += "compiler " + m_Compiler + "\n";
+    text += "target " + request.Target + "\n";
+    text += "entry " + request.EntryPoint + "\n";
+    text += "flags " + std::to_string(request.Flags) + "\n";
+    for (const ShaderDefine& define : request.Defines)
+        text += "define " + define.Name + "=" + define.Value + "\n";
+
+    // 深度优先展开 include, 每个文件只算一次
+    std::unordered_set<std::wstring> visited;
+    std::vector<std::wstring> stack;
+    stack.push_back(std::filesystem::path(request.Path).lexically_normal().wstring());
+    std::string contents;
+    std::vector<std::string> includes;
+    while (!stack.empty())
+    {
+        std::wstring file = std::move(stack.back());
+        stack.pop_back();
+        if (!visited.insert(file).second)
+            continue;
+        key.Files.push_back(file);
+
+        contents.clear();
+        bool found = m_Reader(file, contents);
+        text += "file " + ToHex(Hash(file.data(), file.size() * sizeof(wchar_t)));
+        text += found ? " " + ToHex(Hash(contents.data(), contents.size())) + "\n" : " missing\n";
+        if (!found)
+            continue;
+
+        includes.clear();
+        FindIncludes(contents, includes);
+        std::filesystem::path directory = std::filesystem::path(file).parent_path();
+        // 逆序压栈, 按源文件中的顺序展开
+        for (auto it = includes.rbegin(); it != includes.rend(); ++it)
+            stack.push_back((directory / std::filesystem::path(*it)).lexically_normal().wstring());
+    }
+
+    key.Hash = Hash(text.data(), text.size());
+    return key;
+}
+
+bool RainDX::ShaderCache::Load(const ShaderKey& key, std::vector<char>& bytecode) const
+{
+    std::ifstream in(std::filesystem::path(EntryPath(key)), std::ios::binary);
+    if (!in)
+        return false;
+
+    EntryHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)))
+        return false;
+    if (header.Magic != EntryMagic || header.Version != EntryVersion || header.KeyHash != key.Hash
+        || header.TextSize != key.Text.size())
+        return false;
+
+    std::string text(header.TextSize, '\0');
+    if (!in.read(&text[0], header.TextSize) || text != key.Text)
+        return false;
+
+    bytecode.resize(header.BytecodeSize);
+    if (header.BytecodeSize > 0 && !in.read(bytecode.data(), header.BytecodeSize))
+    {
+        bytecode.clear();
+        return false;
+    }
+    return true;
+}
+
+bool RainDX::ShaderCache::Store(const ShaderKey& key, const void* bytecode, std::size_t size)
+{
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(m_Directory), error);
+
+    // 临时文件名带上序号和时间, 多个线程或进程同时写同一个条目时互不覆盖
+    const std::filesystem::path entry(EntryPath(key));
+    std::filesystem::path temp = entry;
+    temp += L"." + std::to_wstring(m_TempCounter.fetch_add(1))
+        + L"." + std::to_wstring(std::chrono::steady_clock::now().time_since_epoch().count()) + L".tmp";
+
+    EntryHeader header;
+    header.KeyHash = key.Hash;
+    header.TextSize = static_cast<std::uint32_t>(key.Text.size());
+    header.BytecodeSize = static_cast<std::uint32_t>(size);
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(key.Text.data(), key.Text.size());
+        out.write(static_cast<const char*>(bytecode), size);
+        if (!out)
+        {
+            out.close();
+            std::filesystem::remove(temp, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temp, entry, error);
+    if (error)
+    {
+        std::filesystem::remove(temp, error);
+        return false;
+    }
+    ++m_Stores;
+    return true;
+}
+
+std::vector<char> RainDX::ShaderCache::GetOrCompile(const ShaderRequest& request, const Compiler& compile)
+{
+    return GetOrCompile(ComputeKey(request), request, compile);
+}
+
+std::vector<char> RainDX::ShaderCache::GetOrCompile(const ShaderKey& key, const ShaderRequest& request,
+                                                    const Compiler& compile)
+{
+    std::vector<char> bytecode;
+    if (Load(key, bytecode))
+    {
+        ++m_Hits;
+        return bytecode;
+    }
+
+    ++m_Misses;
+    bytecode = compile(request);
+    Store(key, bytecode.data(), bytecode.size());
+    return bytecode;
+}
+
+std::wstring RainDX::ShaderCache::EntryPath(const ShaderKey& key) const
+{
+    std::string name = ToHex(key.Hash) + ".cso";
+    return (std::filesystem::path(m_Directory) / std::filesystem::path(name)).wstring();
+}
+
+RainDX::ShaderCacheStats RainDX::ShaderCache::Stats() const
+{
+    ShaderCacheStats stats;
+    stats.Hits = m_Hits.load();
+    stats.Misses = m_Misses.load();
+    stats.Stores = m_Stores.load();
+    return stats;
+}
+
+bool RainDX::ShaderCache::ReadSource(const std::wstring& path, std::string& contents)
+{
+    std::ifstream in(std::filesystem::path(path), std::ios::binary);
+    if (!in)
+        return false;
+    in.seekg(0, std::ios::end);
+    contents.resize(static_cast<std::size_t>(in.tellg()));
+    in.seekg(0, std::ios::beg);
+    in.read(&contents[0], contents.size());
+    return static_cast<bool>(in) || contents.empty();
+}
+
+std::uint64_t RainDX::ShaderCache::Hash(const void* data, std::size_t size, std::uint64_t seed)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    std::uint64_t hash = seed;
+    for (std::size_t i = 0; i < size; ++i)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return hash;
+}
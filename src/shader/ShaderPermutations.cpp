@@ -0,0 +1,444 @@
+#include "shader/ShaderPermutations.h"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include "core/JobSystem.h"
+
+namespace
+{
+    // 排列包文件头, 之后依次是入口表, 排列表和字节码
+    static constexpr std::uint32_t ArchiveMagic = 0x50534452; // "RDSP"
+    static constexpr std::uint32_t ArchiveVersion = 2;
+
+    struct ArchiveHeader
+    {
+        std::uint32_t Magic = ArchiveMagic;
+        std::uint32_t Version = ArchiveVersion;
+        std::uint32_t ShaderCount = 0;
+        std::uint32_t PermutationCount = 0;
+        std::uint64_t DataSize = 0;
+    };
+
+    void WriteU32(std::string& out, std::uint32_t value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void WriteString(std::string& out, const std::string& text)
+    {
+        WriteU32(out, static_cast<std::uint32_t>(text.size()));
+        out += text;
+    }
+
+    // 带边界检查的顺序读取
+    class Reader
+    {
+    public:
+        Reader(const char* data, std::size_t size) : m_Data(data), m_Size(size) {}
+
+        bool Read(void* dst, std::size_t size)
+        {
+            if (size > m_Size - m_Pos)
+                return false;
+            memcpy(dst, m_Data + m_Pos, size);
+            m_Pos += size;
+            return true;
+        }
+
+        bool ReadString(std::string& text)
+        {
+            std::uint32_t size = 0;
+            if (!Read(&size, sizeof(size)) || size > m_Size - m_Pos)
+                return false;
+            text.assign(m_Data + m_Pos, size);
+            m_Pos += size;
+            return true;
+        }
+
+        std::size_t Position() const { return m_Pos; }
+
+    private:
+        const char* m_Data = nullptr;
+        std::size_t m_Size = 0;
+        std::size_t m_Pos = 0;
+    };
+}
+
+bool RainDX::PermutationManifest::Parse(const std::string& text, std::vector<PermutationShader>& shaders, std::string* error)
+{
+    std::vector<PermutationShader> parsed;
+    std::istringstream lines(text);
+    std::string line;
+    int number = 0;
+    auto fail = [&](const std::string& reason)
+    {
+        if (error != nullptr)
+            *error = "line " + std::to_string(number) + ": " + reason;
+        return false;
+    };
+
+    while (std::getline(lines, line))
+    {
+        ++number;
+        std::size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+
+        std::istringstream words(line);
+        PermutationShader shader;
+        if (!(words >> shader.File))
+            continue;
+        if (!(words >> shader.EntryPoint >> shader.Target))
+            return fail("expected <file> <entry> <target> [keywords...]");
+
+        std::string keyword;
+        while (words >> keyword)
+        {
+            for (const std::string& existing : shader.Keywords)
+            {
+                if (existing == keyword)
+                    return fail("duplicate keyword " + keyword);
+            }
+            shader.Keywords.push_back(keyword);
+        }
+        if (shader.Keywords.size() > MaxKeywords)
+            return fail("more than " + std::to_string(MaxKeywords) + " keywords");
+
+        for (const PermutationShader& existing : parsed)
+        {
+            if (existing.Name() == shader.Name())
+                return fail("duplicate entry " + shader.Name());
+        }
+        parsed.push_back(std::move(shader));
+    }
+
+    shaders = std::move(parsed);
+    return true;
+}
+
+bool RainDX::PermutationManifest::Load(const std::wstring& path, std::vector<PermutationShader>& shaders, std::string* error)
+{
+    std::string text;
+    if (!ShaderCache::ReadSource(path, text))
+    {
+        if (error != nullptr)
+            *error = "cannot read manifest";
+        return false;
+    }
+    return Parse(text, shaders, error);
+}
+
+std::uint32_t RainDX::ShaderArchive::AddShader(const std::string& name, const std::vector<std::string>& keywords)
+{
+    assert(keywords.size() <= PermutationManifest::MaxKeywords);
+    assert(m_Index.count(name) == 0);
+
+    Shader shader;
+    shader.Name = name;
+    shader.Keywords = keywords;
+    shader.FirstPermutation = static_cast<std::uint32_t>(m_Permutations.size());
+    shader.MaskBits = (1u << keywords.size()) - 1;
+
+    std::uint32_t index = static_cast<std::uint32_t>(m_Shaders.size());
+    m_Index[name] = index;
+    m_Permutations.resize(m_Permutations.size() + (std::size_t(1) << keywords.size()));
+    m_Shaders.push_back(std::move(shader));
+    return index;
+}
+
+void RainDX::ShaderArchive::SetPermutation(std::uint32_t shader, std::uint32_t mask, const void* data, std::size_t size,
+                                           std::uint64_t key)
+{
+    assert(shader < m_Shaders.size());
+    assert((mask & ~m_Shaders[shader].MaskBits) == 0);
+
+    Permutation& permutation = m_Permutations[m_Shaders[shader].FirstPermutation + mask];
+    permutation.Offset = m_Data.size();
+    permutation.Size = size;
+    permutation.Key = key;
+    const char* bytes = static_cast<const char*>(data);
+    m_Data.insert(m_Data.end(), bytes, bytes + size);
+}
+
+std::uint32_t RainDX::ShaderArchive::Find(const std::string& name) const
+{
+    auto it = m_Index.find(name);
+    return it != m_Index.end() ? it->second : InvalidShader;
+}
+
+std::uint32_t RainDX::ShaderArchive::KeywordMask(std::uint32_t shader, const std::string& keyword) const
+{
+    if (shader >= m_Shaders.size())
+        return 0;
+    const std::vector<std::string>& keywords = m_Shaders[shader].Keywords;
+    for (std::size_t i = 0; i < keywords.size(); ++i)
+    {
+        if (keywords[i] == keyword)
+            return 1u << i;
+    }
+    return 0;
+}
+
+RainDX::ShaderBytecodeView RainDX::ShaderArchive::Get(std::uint32_t shader, std::uint32_t mask) const
+{
+    assert(shader < m_Shaders.size());
+    const Shader& entry = m_Shaders[shader];
+    const Permutation& permutation = m_Permutations[entry.FirstPermutation + (mask & entry.MaskBits)];
+
+    ShaderBytecodeView view;
+    view.Data = m_Data.data() + permutation.Offset;
+    view.Size = static_cast<std::size_t>(permutation.Size);
+    return view;
+}
+
+std::size_t RainDX::ShaderArchive::ShaderCount() const
+{
+    return m_Shaders.size();
+}
+
+std::size_t RainDX::ShaderArchive::PermutationCount() const
+{
+    return m_Permutations.size();
+}
+
+std::size_t RainDX::ShaderArchive::BytecodeSize() const
+{
+    return m_Data.size();
+}
+
+bool RainDX::ShaderArchive::Load(const std::wstring& path)
+{
+    std::string file;
+    if (!ShaderCache::ReadSource(path, file))
+        return false;
+
+    Reader reader(file.data(), file.size());
+    ArchiveHeader header;
+    if (!reader.Read(&header, sizeof(header)) || header.Magic != ArchiveMagic || header.Version != ArchiveVersion)
+        return false;
+
+    ShaderArchive archive;
+    std::string name;
+    std::vector<std::string> keywords;
+    for (std::uint32_t i = 0; i < header.ShaderCount; ++i)
+    {
+        std::uint32_t keywordCount = 0;
+        if (!reader.ReadString(name) || !reader.Read(&keywordCount, sizeof(keywordCount))
+            || keywordCount > PermutationManifest::MaxKeywords || archive.m_Index.count(name) != 0)
+            return false;
+        keywords.resize(keywordCount);
+        for (std::string& keyword : keywords)
+        {
+            if (!reader.ReadString(keyword))
+                return false;
+        }
+        archive.AddShader(name, keywords);
+    }
+
+    if (archive.m_Permutations.size() != header.PermutationCount)
+        return false;
+    for (Permutation& permutation : archive.m_Permutations)
+    {
+        if (!reader.Read(&permutation, sizeof(permutation))
+            || permutation.Offset > header.DataSize || permutation.Size > header.DataSize - permutation.Offset)
+            return false;
+    }
+
+    if (header.DataSize != file.size() - reader.Position())
+        return false;
+    archive.m_Data.assign(file.begin() + reader.Position(), file.end());
+
+    *this = std::move(archive);
+    return true;
+}
+
+bool RainDX::ShaderArchive::Load(const std::wstring& path, const std::vector<PermutationShader>& shaders,
+                                 const std::wstring& directory, std::uint32_t flags, const ShaderCache& cache)
+{
+    ShaderArchive archive;
+    if (!archive.Load(path) || archive.m_Shaders.size() != shaders.size())
+        return false;
+
+    for (std::size_t i = 0; i < shaders.size(); ++i)
+    {
+        const Shader& entry = archive.m_Shaders[i];
+        if (entry.Name != shaders[i].Name() || entry.Keywords != shaders[i].Keywords)
+            return false;
+
+        for (std::uint32_t mask = 0; mask <= entry.MaskBits; ++mask)
+        {
+            ShaderKey key = cache.ComputeKey(PermutationCompiler::Request(shaders[i], mask, directory, flags));
+            if (key.Hash != archive.m_Permutations[entry.FirstPermutation + mask].Key)
+                return false;
+        }
+    }
+
+    *this = std::move(archive);
+    return true;
+}
+
+bool RainDX::ShaderArchive::Save(const std::wstring& path) const
+{
+    ArchiveHeader header;
+    header.ShaderCount = static_cast<std::uint32_t>(m_Shaders.size());
+    header.PermutationCount = static_cast<std::uint32_t>(m_Permutations.size());
+    header.DataSize = m_Data.size();
+
+    std::string table;
+    for (const Shader& shader : m_Shaders)
+    {
+        WriteString(table, shader.Name);
+        WriteU32(table, static_cast<std::uint32_t>(shader.Keywords.size()));
+        for (const std::string& keyword : shader.Keywords)
+            WriteString(table, keyword);
+    }
+
+    std::error_code error;
+    const std::filesystem::path target(path);
+    if (target.has_parent_path())
+        std::filesystem::create_directories(target.parent_path(), error);
+    std::filesystem::path temp = target;
+    temp += L".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(table.data(), table.size());
+        out.write(reinterpret_cast<const char*>(m_Permutations.data()), m_Permutations.size() * sizeof(Permutation));
+        out.write(m_Data.data(), m_Data.size());
+        if (!out)
+        {
+            out.close();
+            std::filesystem::remove(temp, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temp, target, error);
+    if (error)
+    {
+        std::filesystem::remove(temp, error);
+        return false;
+    }
+    return true;
+}
+
+void RainDX::ShaderArchive::Clear()
+{
+    m_Shaders.clear();
+    m_Index.clear();
+    m_Permutations.clear();
+    m_Data.clear();
+}
+
+RainDX::PermutationBuildStats RainDX::PermutationCompiler::Build(
+    const std::vector<PermutationShader>& shaders, const std::wstring& directory, std::uint32_t flags,
+    const ShaderCache::Compiler& compile, ShaderCache* cache, JobSystem& jobs, ShaderArchive& archive)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    // 展开为 (入口, 掩码) 的平铺列表, 每个排列一个任务
+    struct Item
+    {
+        std::size_t Shader = 0;
+        std::uint32_t Mask = 0;
+    };
+    std::vector<Item> items;
+    for (std::size_t i = 0; i < shaders.size(); ++i)
+    {
+        assert(shaders[i].Keywords.size() <= PermutationManifest::MaxKeywords);
+        std::uint32_t count = 1u << shaders[i].Keywords.size();
+        for (std::uint32_t mask = 0; mask < count; ++mask)
+            items.push_back({i, mask});
+    }
+
+    std::vector<std::vector<char>> results(items.size());
+    std::vector<std::uint64_t> keys(items.size());
+    std::atomic<std::size_t> compiled{0};
+    std::mutex errorMutex;
+    std::exception_ptr firstError;
+
+    // 单个排列的编译时间远大于任务开销, 粒度为 1 以便均衡
+    jobs.ParallelFor(0, items.size(), 1, [&](std::size_t first, std::size_t last)
+    {
+        for (std::size_t i = first; i < last; ++i)
+        {
+            ShaderRequest request = Request(shaders[items[i].Shader], items[i].Mask, directory, flags);
+
+            try
+            {
+                if (cache != nullptr)
+                {
+                    // 键写入排列包, 加载时用来判断排列包是否过期
+                    ShaderKey key = cache->ComputeKey(request);
+                    keys[i] = key.Hash;
+                    results[i] = cache->GetOrCompile(key, request, [&](const ShaderRequest& r)
+                    {
+                        ++compiled;
+                        return compile(r);
+                    });
+                }
+                else
+                {
+                    ++compiled;
+                    results[i] = compile(request);
+                }
+            }
+            catch (...)
+            {
+                // 异常不能穿过任务系统, 记下第一个, 其余任务照常完成
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!firstError)
+                    firstError = std::current_exception();
+            }
+        }
+    });
+
+    if (firstError)
+        std::rethrow_exception(firstError);
+
+    archive.Clear();
+    std::size_t next = 0;
+    for (const PermutationShader& shader : shaders)
+    {
+        std::uint32_t index = archive.AddShader(shader.Name(), shader.Keywords);
+        std::uint32_t count = 1u << shader.Keywords.size();
+        for (std::uint32_t mask = 0; mask < count; ++mask, ++next)
+            archive.SetPermutation(index, mask, results[next].data(), results[next].size(), keys[next]);
+    }
+
+    PermutationBuildStats stats;
+    stats.Shaders = shaders.size();
+    stats.Permutations = items.size();
+    stats.CacheHits = cache != nullptr ? items.size() - compiled.load() : 0;
+    stats.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    return stats;
+}
+
+std::vector<RainDX::ShaderDefine> RainDX::PermutationCompiler::Defines(const PermutationShader& shader, std::uint32_t mask)
+{
+    std::vector<ShaderDefine> defines;
+    for (std::size_t i = 0; i < shader.Keywords.size(); ++i)
+    {
+        if (mask & (1u << i))
+            defines.push_back({shader.Keywords[i], "1"});
+    }
+    return defines;
+}
+
+RainDX::ShaderRequest RainDX::PermutationCompiler::Request(const PermutationShader& shader, std::uint32_t mask,
+                                                           const std::wstring& directory, std::uint32_t flags)
+{
+    ShaderRequest request;
+    request.Path = (std::filesystem::path(directory) / std::filesystem::path(shader.File)).wstring();
+    request.EntryPoint = shader.EntryPoint;
+    request.Target = shader.Target;
+    request.Defines = Defines(shader, mask);
+    request.Flags = flags;
+    return request;
+}